@@ -0,0 +1,58 @@
+struct Meshlet {
+    float3 center;
+    float radius;
+    float3 cone_axis;
+    float cone_cutoff;
+    uint index_offset;
+    uint index_count;
+    uint vertex_count;
+    uint padding;
+};
+
+struct DrawIndexedIndirectCommand {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+// Object space inputs, see ClusterCullConstants
+struct CullUBO {
+    float4 planes[6];
+    float4 camera_position;
+    uint meshlet_offset;
+    uint meshlet_count;
+    uint2 padding;
+};
+
+[[vk::binding(0,0)]] ConstantBuffer<CullUBO> cull;
+[[vk::binding(1,0)]] StructuredBuffer<Meshlet> meshlets;
+[[vk::binding(2,0)]] RWStructuredBuffer<DrawIndexedIndirectCommand> draws;
+
+[numthreads(64, 1, 1)]
+void mainCS(uint3 id : SV_DispatchThreadID) {
+    // One draw per meshlet of the selected LOD
+    uint index = id.x;
+    if (index >= cull.meshlet_count)
+        return;
+
+    Meshlet meshlet = meshlets[cull.meshlet_offset + index];
+
+    bool visible = true;
+    for (uint i = 0; i < 6; i++) {
+        visible = visible && dot(cull.planes[i].xyz, meshlet.center) + cull.planes[i].w >= -meshlet.radius;
+    }
+
+    // Every triangle faces away when the camera lies inside the back side of the normal cone
+    float3 view = meshlet.center - cull.camera_position.xyz;
+    visible = visible && dot(view, meshlet.cone_axis) < meshlet.cone_cutoff * length(view) + meshlet.radius;
+
+    DrawIndexedIndirectCommand draw;
+    draw.index_count = meshlet.index_count;
+    draw.instance_count = visible ? 1 : 0;
+    draw.first_index = meshlet.index_offset;
+    draw.vertex_offset = 0;
+    draw.first_instance = 0;
+    draws[index] = draw;
+}
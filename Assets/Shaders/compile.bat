@@ -2,4 +2,5 @@
 "..\..\Tools\DXC\bin\dxc.exe" -spirv -T ps_6_4 -E mainPS unlit.hlsl -Fo unlit.frag.spv -fvk-use-scalar-layout
 
 "..\..\Tools\DXC\bin\dxc.exe" -spirv -T vs_6_4 -E mainVS imgui.hlsl -Fo imgui.vert.spv -fvk-use-scalar-layout
-"..\..\Tools\DXC\bin\dxc.exe" -spirv -T ps_6_4 -E mainPS imgui.hlsl -Fo imgui.frag.spv -fvk-use-scalar-layout
\ No newline at end of file
+"..\..\Tools\DXC\bin\dxc.exe" -spirv -T ps_6_4 -E mainPS imgui.hlsl -Fo imgui.frag.spv -fvk-use-scalar-layout
+"..\..\Tools\DXC\bin\dxc.exe" -spirv -T cs_6_4 -E mainCS cluster_cull.hlsl -Fo cluster_cull.comp.spv -fvk-use-scalar-layout
\ No newline at end of file
@@ -1,4 +1,15 @@
 glslc shader.comp -o comp.spv
 
 glslc shader.vert -o vert.spv
-glslc shader.frag -o frag.spv
\ No newline at end of file
+glslc shader.frag -o frag.spv
+
+# Engine shaders, the same as compile.bat. The renderer recompiles these on change while it runs.
+DXC=../../Tools/DXC/bin/dxc
+[ -x "$DXC" ] || DXC=dxc
+
+$DXC -spirv -T vs_6_4 -E mainVS unlit.hlsl -Fo unlit.vert.spv -fvk-use-scalar-layout
+$DXC -spirv -T ps_6_4 -E mainPS unlit.hlsl -Fo unlit.frag.spv -fvk-use-scalar-layout
+
+$DXC -spirv -T vs_6_4 -E mainVS imgui.hlsl -Fo imgui.vert.spv -fvk-use-scalar-layout
+$DXC -spirv -T ps_6_4 -E mainPS imgui.hlsl -Fo imgui.frag.spv -fvk-use-scalar-layout
+$DXC -spirv -T cs_6_4 -E mainCS cluster_cull.hlsl -Fo cluster_cull.comp.spv -fvk-use-scalar-layout
@@ -1,8 +1,11 @@
 #pragma once
 #include <atomic>
+#include <cstddef>
 
 namespace Squid {
-namespace Core {
+namespace Benchmarks {
+
+    // Core::SpinLock and Core::RingBuffer as they were before the lock-free queues replaced them
 
     class SpinLock {
     private:
@@ -59,5 +62,5 @@ namespace Core {
         SpinLock lock;
     };
 
-} // namespace Core
-} // namespace Squid
\ No newline at end of file
+} // namespace Benchmarks
+} // namespace Squid
@@ -0,0 +1,107 @@
+#pragma once
+#include <Core/Types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Squid {
+namespace Benchmarks {
+
+    // Core::WorkerPool as it was before the job system replaced it, the helper count is a parameter here so thread
+    // counts can be compared. Fixed helper threads split one range at a time into chunks, the caller takes chunks too.
+    class WorkerPool {
+    public:
+        explicit WorkerPool(u32 helper_count) {
+            for (u32 i = 0; i < helper_count; i++) {
+                threads.emplace_back([this]() { Loop(); });
+            }
+        }
+
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+            }
+            wake.notify_all();
+
+            for (auto &thread : threads) {
+                thread.join();
+            }
+        }
+
+        // Calls function(begin, end) over [0, count) in chunks of grain, returns once every chunk is done
+        void Run(u32 count, u32 grain, const std::function<void(u32, u32)> &function) {
+            if (count <= grain || threads.empty()) {
+                for (u32 begin = 0; begin < count; begin += grain) {
+                    function(begin, std::min(begin + grain, count));
+                }
+                return;
+            }
+
+            std::lock_guard<std::mutex> run_lock(run_mutex);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = &function;
+                job_count = count;
+                job_grain = grain;
+                next = 0;
+                active = u32(threads.size());
+                generation++;
+            }
+            wake.notify_all();
+
+            RunChunks();
+
+            // Every helper checks out, even the ones that woke up after all chunks were taken
+            while (active.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        inline u32 GetThreadCount() const { return u32(threads.size()) + 1; }
+
+    private:
+        void RunChunks() {
+            for (u32 begin = next.fetch_add(job_grain); begin < job_count; begin = next.fetch_add(job_grain)) {
+                (*job)(begin, std::min(begin + job_grain, job_count));
+            }
+        }
+
+        void Loop() {
+            u64 seen = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [&]() { return quit || generation != seen; });
+                    if (quit)
+                        return;
+                    seen = generation;
+                }
+
+                RunChunks();
+                active.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        // Run is not reentrant, callers from different threads take turns
+        std::mutex run_mutex;
+        std::condition_variable wake;
+        u64 generation = 0;
+        bool quit = false;
+
+        const std::function<void(u32, u32)> *job = nullptr;
+        u32 job_count = 0;
+        u32 job_grain = 1;
+        std::atomic<u32> next = 0;
+        std::atomic<u32> active = 0;
+    };
+
+} // namespace Benchmarks
+} // namespace Squid
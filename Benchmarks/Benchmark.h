@@ -0,0 +1,46 @@
+#pragma once
+#include <Core/Types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace Squid {
+namespace Benchmarks {
+
+    // Fastest of repeats runs of function in milliseconds, the minimum is the run least disturbed by the system
+    template <typename Function>
+    f64 Measure(u32 repeats, Function &&function) {
+        f64 best = 1e30;
+        for (u32 i = 0; i < repeats; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<f64, std::milli>(end - start).count());
+        }
+        return best;
+    }
+
+    inline const void *volatile consume_sink = nullptr;
+
+    // Stores a result where the compiler can't prove nobody reads it, so the work producing it stays
+    template <typename T>
+    inline void Consume(const T &value) {
+        consume_sink = &value;
+    }
+
+    // 1, 2, 4, ... up to and including max
+    inline std::vector<u32> GetThreadCounts(u32 max) {
+        std::vector<u32> counts;
+        for (u32 count = 1; count < max; count *= 2) {
+            counts.push_back(count);
+        }
+        counts.push_back(max);
+        return counts;
+    }
+
+    inline u32 GetCoreCount() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+} // namespace Benchmarks
+} // namespace Squid
@@ -0,0 +1,106 @@
+// The sparse set ComponentRegistry and View against the unordered_map registry they replaced.
+// Usage: Benchmark-ComponentRegistry
+#include "Baselines/ComponentRegistry.h"
+#include "Benchmark.h"
+#include <Core/ECS/ComponentRegistry.h>
+#include <Core/ECS/View.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace Squid;
+
+static constexpr u32 ENTITY_COUNT = 1 << 20;
+// Every tenth entity also has bounds, the view joins the two
+static constexpr u32 BOUNDS_STRIDE = 10;
+static constexpr u32 REPEATS = 5;
+
+// Same sizes as the hot data of the scene's transform and bounds components
+struct Transform {
+    f32 values[27] = {};
+};
+
+struct Bounds {
+    f32 values[6] = {};
+};
+
+template <typename Registry>
+static void Fill(Registry &registry, const std::vector<Core::Entity> &entities) {
+    for (const Core::Entity entity : entities) {
+        registry.Create(entity)->values[0] = f32(entity);
+    }
+}
+
+template <template <typename> class Registry>
+static void Run(
+    const char *name, const std::vector<Core::Entity> &entities, const std::vector<Core::Entity> &shuffled) {
+    std::vector<Core::Entity> bounded;
+    for (u32 i = 0; i < ENTITY_COUNT; i += BOUNDS_STRIDE) {
+        bounded.push_back(entities[i]);
+    }
+
+    const f64 create = Benchmarks::Measure(REPEATS, [&]() {
+        Registry<Transform> transforms;
+        Fill(transforms, entities);
+        Benchmarks::Consume(transforms);
+    });
+
+    Registry<Transform> transforms;
+    Registry<Bounds> bounds;
+    Fill(transforms, entities);
+    Fill(bounds, bounded);
+
+    f32 sum = 0.0f;
+    const f64 lookup = Benchmarks::Measure(REPEATS, [&]() {
+        for (const Core::Entity entity : shuffled) {
+            sum += transforms.GetComponent(entity)->values[0];
+        }
+    });
+
+    const f64 linear = Benchmarks::Measure(REPEATS, [&]() {
+        for (size_t i = 0; i < transforms.GetCount(); i++) {
+            sum += transforms[i].values[0];
+        }
+    });
+
+    // The old registry had no View, callers walked one registry and looked entities up in the other
+    const f64 join = Benchmarks::Measure(REPEATS, [&]() {
+        if constexpr (std::is_same_v<Registry<Bounds>, Core::ComponentRegistry<Bounds>>) {
+            Core::View<Transform, Bounds>(transforms, bounds).Each([&](Core::Entity, Transform &t, Bounds &b) {
+                sum += t.values[0] + b.values[0];
+            });
+        } else {
+            for (size_t i = 0; i < bounds.GetCount(); i++) {
+                if (Transform *t = transforms.GetComponent(bounds.GetEntity(i)))
+                    sum += t->values[0] + bounds[i].values[0];
+            }
+        }
+    });
+
+    const f64 remove = Benchmarks::Measure(1, [&]() {
+        for (const Core::Entity entity : shuffled) {
+            transforms.Remove(entity);
+        }
+    });
+
+    Benchmarks::Consume(sum);
+    printf("%-24s %10.2f %10.2f %10.2f %10.2f %10.2f\n", name, create, lookup, linear, join, remove);
+}
+
+int main() {
+    std::vector<Core::Entity> entities(ENTITY_COUNT);
+    std::iota(entities.begin(), entities.end(), 1);
+
+    std::vector<Core::Entity> shuffled = entities;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1234));
+
+    printf("%u entities, %u with bounds, ms\n", ENTITY_COUNT, ENTITY_COUNT / BOUNDS_STRIDE);
+    printf("%-24s %10s %10s %10s %10s %10s\n", "registry", "create", "lookup", "linear", "join", "remove");
+    Run<Benchmarks::ComponentRegistry>("unordered_map (old)", entities, shuffled);
+    Run<Core::ComponentRegistry>("sparse set", entities, shuffled);
+    return 0;
+}
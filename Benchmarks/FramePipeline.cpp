@@ -0,0 +1,145 @@
+// Frame throughput of the pipelined engine loop against rendering inline, and event throughput from worker threads
+// into the dispatcher the loop drains every frame.
+// Usage: Benchmark-FramePipeline
+#include "Benchmark.h"
+#include <Core/Events/EventDispatcher.h>
+#include <Core/Jobs/FramePipeline.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Squid;
+
+static constexpr u32 FRAME_COUNT = 200;
+static constexpr u32 EVENT_ROUNDS = 2000;
+static constexpr u32 MAX_PRODUCERS = 8;
+
+// Frame halves made of CPU work and of waiting, the waits stand in for fences and present
+struct FrameCost {
+    const char *name;
+    f64 simulation_ms;
+    f64 render_ms;
+    f64 render_wait_ms;
+};
+
+static void Spin(f64 ms) {
+    const auto end = std::chrono::steady_clock::now() + std::chrono::duration<f64, std::milli>(ms);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+static void Wait(f64 ms) {
+    if (ms > 0.0)
+        std::this_thread::sleep_for(std::chrono::duration<f64, std::milli>(ms));
+}
+
+// ms per frame, every frame checks that the render half got the buffer the simulation wrote
+static f64 RunFrames(const FrameCost &cost, u32 latency) {
+    u64 written[Core::FramePipeline::BUFFER_COUNT] = {};
+    u64 expected = 0;
+
+    Core::FramePipeline pipeline(
+        [&](u32 index) {
+            if (written[index] != expected++) {
+                fprintf(stderr, "frames were rendered out of order!\n");
+                std::exit(1);
+            }
+            Spin(cost.render_ms);
+            Wait(cost.render_wait_ms);
+        },
+        latency);
+
+    return Benchmarks::Measure(1, [&]() {
+               for (u64 frame = 0; frame < FRAME_COUNT; frame++) {
+                   Spin(cost.simulation_ms);
+                   written[pipeline.GetWriteIndex()] = frame;
+                   pipeline.Submit();
+               }
+               pipeline.Flush();
+           }) /
+           FRAME_COUNT;
+}
+
+struct EventCount {
+    u64 delivered = 0;
+};
+
+static void OnMouseMotion(void *user_data, const Core::MouseMotionEvent *, u32 count) {
+    static_cast<EventCount *>(user_data)->delivered += count;
+}
+
+int main() {
+    printf("%u cores\n", Benchmarks::GetCoreCount());
+
+    const FrameCost costs[] = {
+        {"handoff only", 0.0, 0.0, 0.0},
+        {"sim 4 + render 4 ms CPU", 4.0, 4.0, 0.0},
+        {"sim 4 + render 2 ms CPU + 4 ms wait", 4.0, 2.0, 4.0},
+        {"sim 6 + render 1 ms CPU + 6 ms wait", 6.0, 1.0, 6.0},
+    };
+
+    printf("\n%u frames, ms per frame\n", FRAME_COUNT);
+    printf("%-38s %10s %10s %9s\n", "frame", "latency 0", "latency 1", "speedup");
+    for (const FrameCost &cost : costs) {
+        const f64 inline_ms = RunFrames(cost, 0);
+        const f64 pipelined_ms = RunFrames(cost, 1);
+        printf("%-38s %10.3f %10.3f %8.2fx\n", cost.name, inline_ms, pipelined_ms, inline_ms / pipelined_ms);
+    }
+
+    // Every round the producers fill the queue between them and the main thread drains it, like a frame's worth of
+    // events from worker threads. Each round stays within the capacity so nothing is dropped.
+    constexpr u32 ROUND_EVENTS = Core::MouseMotionEvent::CAPACITY;
+    printf("\n%u rounds of %u events published by worker threads and drained by the main thread\n", EVENT_ROUNDS,
+           ROUND_EVENTS);
+    printf("%10s %14s %12s\n", "producers", "events/s", "ns/event");
+    for (u32 producers : Benchmarks::GetThreadCounts(MAX_PRODUCERS)) {
+        auto dispatcher = std::make_unique<Core::EventDispatcher>();
+        EventCount count;
+        dispatcher->Subscribe<Core::MouseMotionEvent>(&OnMouseMotion, &count);
+
+        std::atomic<u32> round = 0;
+        std::atomic<u32> finished = 0;
+        std::vector<std::thread> threads;
+        for (u32 i = 0; i < producers; i++) {
+            threads.emplace_back([&, i]() {
+                const u32 share = ROUND_EVENTS / producers + (i < ROUND_EVENTS % producers ? 1 : 0);
+                for (u32 r = 1; r <= EVENT_ROUNDS; r++) {
+                    while (round.load(std::memory_order_acquire) < r) {
+                        std::this_thread::yield();
+                    }
+                    for (u32 e = 0; e < share; e++) {
+                        dispatcher->Publish(Core::MouseMotionEvent{0, 0, 1, 0, 0});
+                    }
+                    finished.fetch_add(1, std::memory_order_release);
+                }
+            });
+        }
+
+        const f64 ms = Benchmarks::Measure(1, [&]() {
+            for (u32 r = 1; r <= EVENT_ROUNDS; r++) {
+                round.store(r, std::memory_order_release);
+                while (finished.load(std::memory_order_acquire) < r * producers) {
+                    std::this_thread::yield();
+                }
+                dispatcher->Dispatch(Core::EVENT_PHASE_FRAME_START);
+            }
+        });
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        if (count.delivered != u64(EVENT_ROUNDS) * ROUND_EVENTS) {
+            fprintf(stderr, "events were lost!\n");
+            return 1;
+        }
+        printf("%10u %14.0f %12.1f\n", producers, count.delivered / (ms / 1000.0), ms * 1e6 / f64(count.delivered));
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Scheduling overhead and scaling of Core::JobSystem against the WorkerPool it replaced.
+// Usage: Benchmark-JobSystem
+#include "Baselines/WorkerPool.h"
+#include "Benchmark.h"
+#include <Core/Jobs/JobSystem.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Squid;
+
+// Stays below the job slots of one thread so Run never falls back to the heap
+static constexpr u32 JOB_COUNT = 4000;
+static constexpr u32 ITEM_COUNT = 1 << 20;
+static constexpr u32 GRAIN = 1024;
+static constexpr u32 REPEATS = 10;
+
+// A few dozen cycles per item, uneven work costs grow with the index so the last chunks are the slowest
+static void Work(std::vector<f32> &output, u32 begin, u32 end, bool uneven) {
+    for (u32 i = begin; i < end; i++) {
+        const u32 iterations = uneven ? 1 + i / (ITEM_COUNT / 32) : 16;
+        f32 x = f32(i);
+        for (u32 k = 0; k < iterations; k++) {
+            x = std::sqrt(x * 0.999f + 1.0f);
+        }
+        output[i] = x;
+    }
+}
+
+int main() {
+    const std::vector<u32> thread_counts = Benchmarks::GetThreadCounts(Benchmarks::GetCoreCount());
+    std::vector<f32> output(ITEM_COUNT);
+
+    printf("scheduling overhead of %u empty jobs, ns per job\n", JOB_COUNT);
+    printf("%8s %12s %16s %16s\n", "threads", "Run + Wait", "ParallelFor(1)", "WorkerPool(1)");
+    for (u32 threads : thread_counts) {
+        Core::JobSystem system(threads - 1);
+        Benchmarks::WorkerPool pool(threads - 1);
+
+        const f64 run_ms = Benchmarks::Measure(REPEATS, [&]() {
+            Core::JobCounter counter;
+            for (u32 i = 0; i < JOB_COUNT; i++) {
+                system.Run(counter, []() {});
+            }
+            system.Wait(counter);
+        });
+        const f64 range_ms = Benchmarks::Measure(
+            REPEATS, [&]() { Core::ParallelFor(system, JOB_COUNT, 1, [](u32, u32) {}); });
+        const f64 pool_ms = Benchmarks::Measure(REPEATS, [&]() { pool.Run(JOB_COUNT, 1, [](u32, u32) {}); });
+
+        const f64 to_ns = 1e6 / JOB_COUNT;
+        printf("%8u %12.1f %16.1f %16.1f\n", threads, run_ms * to_ns, range_ms * to_ns, pool_ms * to_ns);
+    }
+
+    for (bool uneven : {false, true}) {
+        printf("\n%s work over %u items, ms\n", uneven ? "uneven" : "even", ITEM_COUNT);
+        printf("%8s %12s %16s %16s %10s\n", "threads", "WorkerPool", "ParallelFor", "ParallelFor(0)", "speedup");
+
+        for (u32 threads : thread_counts) {
+            Core::JobSystem system(threads - 1);
+            Benchmarks::WorkerPool pool(threads - 1);
+
+            const f64 pool_ms = Benchmarks::Measure(REPEATS, [&]() {
+                pool.Run(ITEM_COUNT, GRAIN, [&](u32 begin, u32 end) { Work(output, begin, end, uneven); });
+            });
+            const f64 jobs_ms = Benchmarks::Measure(REPEATS, [&]() {
+                Core::ParallelFor(
+                    system, ITEM_COUNT, GRAIN, [&](u32 begin, u32 end) { Work(output, begin, end, uneven); });
+            });
+            const f64 auto_ms = Benchmarks::Measure(REPEATS, [&]() {
+                Core::ParallelFor(system, ITEM_COUNT, 0, [&](u32 begin, u32 end) { Work(output, begin, end, uneven); });
+            });
+
+            printf("%8u %12.2f %16.2f %16.2f %9.2fx\n", threads, pool_ms, jobs_ms, auto_ms, pool_ms / jobs_ms);
+        }
+    }
+
+    Benchmarks::Consume(output);
+    return 0;
+}
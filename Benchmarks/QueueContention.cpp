@@ -0,0 +1,173 @@
+// Contention of the lock-free queues and the backoff SpinLock against the spinlocked RingBuffer they replaced,
+// from 1 to 32 threads. Every run checks that each pushed item was popped exactly once.
+// Usage: Benchmark-QueueContention
+#include "Baselines/RingBuffer.h"
+#include "Benchmark.h"
+#include <Core/Jobs/LockFreeQueue.h>
+#include <Core/Jobs/SpinLock.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Squid;
+
+static constexpr u32 ITEM_COUNT = 1 << 20;
+static constexpr u32 CAPACITY = 1024;
+static constexpr u32 MAX_THREADS = 32;
+static constexpr u32 REPEATS = 3;
+
+// Same interface over the old and the new queues
+template <typename T, size_t capacity>
+static inline bool Push(Benchmarks::RingBuffer<T, capacity> &queue, T item) {
+    return queue.push_back(item);
+}
+
+template <typename T, size_t capacity>
+static inline bool Pop(Benchmarks::RingBuffer<T, capacity> &queue, T &item) {
+    return queue.pop_front(item);
+}
+
+template <typename Queue, typename T>
+static inline bool Push(Queue &queue, T item) {
+    return queue.Push(item);
+}
+
+template <typename Queue, typename T>
+static inline bool Pop(Queue &queue, T &item) {
+    return queue.Pop(item);
+}
+
+// Starts the threads together and returns the time until the last one finished
+template <typename Function>
+static f64 RunThreads(u32 count, Function &&function) {
+    std::atomic<bool> go = false;
+    std::vector<std::thread> threads;
+    for (u32 i = 0; i < count; i++) {
+        threads.emplace_back([&, i]() {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            function(i);
+        });
+    }
+
+    return Benchmarks::Measure(1, [&]() {
+        go.store(true, std::memory_order_release);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    });
+}
+
+// ns per item moved through the queue by producers threads pushing and consumers threads popping. A single
+// thread alternates between the two, which measures the uncontended cost.
+template <typename Queue>
+static f64 Contend(u32 producers, u32 consumers) {
+    const u64 expected = u64(ITEM_COUNT) * (ITEM_COUNT + 1) / 2;
+
+    return Benchmarks::Measure(REPEATS, [&]() {
+        auto queue = std::make_unique<Queue>();
+        std::atomic<u64> sum = 0;
+
+        if (consumers == 0) {
+            u64 item = 0, local_sum = 0;
+            for (u64 i = 1; i <= ITEM_COUNT; i++) {
+                Push(*queue, i);
+                Pop(*queue, item);
+                local_sum += item;
+            }
+            sum = local_sum;
+        } else {
+            std::atomic<u32> popped = 0;
+            RunThreads(producers + consumers, [&](u32 thread) {
+                if (thread < producers) {
+                    for (u64 i = 1 + thread; i <= ITEM_COUNT; i += producers) {
+                        while (!Push(*queue, i)) {
+                            std::this_thread::yield();
+                        }
+                    }
+                    return;
+                }
+
+                u64 item = 0, local_sum = 0;
+                while (popped.load(std::memory_order_relaxed) < ITEM_COUNT) {
+                    if (Pop(*queue, item)) {
+                        local_sum += item;
+                        popped.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                sum += local_sum;
+            });
+        }
+
+        if (sum != expected) {
+            fprintf(stderr, "items were lost or duplicated!\n");
+            std::exit(1);
+        }
+    }) * 1e6 / ITEM_COUNT;
+}
+
+// ns per lock and unlock pair, every thread increments one shared counter under the lock
+template <typename Lock>
+static f64 ContendLock(u32 threads) {
+    return Benchmarks::Measure(REPEATS, [&]() {
+        Lock lock;
+        u64 counter = 0;
+        RunThreads(threads, [&](u32) {
+            for (u32 i = 0; i < ITEM_COUNT / threads; i++) {
+                std::lock_guard<Lock> guard(lock);
+                counter++;
+            }
+        });
+        Benchmarks::Consume(counter);
+    }) * 1e6 / (ITEM_COUNT / threads * threads);
+}
+
+int main() {
+    using RingBuffer = Benchmarks::RingBuffer<u64, CAPACITY>;
+    const std::vector<u32> thread_counts = Benchmarks::GetThreadCounts(MAX_THREADS);
+
+    printf("%u cores, ns per item\n", Benchmarks::GetCoreCount());
+    printf("\nhalf the threads push, half pop\n");
+    printf("%8s %12s %12s\n", "threads", "RingBuffer", "MpmcQueue");
+    for (u32 threads : thread_counts) {
+        const u32 producers = std::max(1u, threads / 2);
+        const u32 consumers = threads - producers;
+        printf("%8u %12.1f %12.1f\n",
+               threads,
+               Contend<RingBuffer>(producers, consumers),
+               Contend<Core::MpmcQueue<u64, CAPACITY>>(producers, consumers));
+    }
+
+    printf("\nevery thread but one pushes, one pops\n");
+    printf("%8s %12s %12s\n", "threads", "RingBuffer", "MpscQueue");
+    for (u32 threads : thread_counts) {
+        const u32 producers = std::max(1u, threads - 1);
+        const u32 consumers = threads - producers;
+        printf("%8u %12.1f %12.1f\n",
+               threads,
+               Contend<RingBuffer>(producers, consumers),
+               Contend<Core::MpscQueue<u64, CAPACITY>>(producers, consumers));
+    }
+
+    printf("\none thread pushes, one pops\n");
+    printf("%8s %12s %12s\n", "threads", "RingBuffer", "SpscQueue");
+    printf("%8u %12.1f %12.1f\n", 2u, Contend<RingBuffer>(1, 1), Contend<Core::SpscQueue<u64, CAPACITY>>(1, 1));
+
+    printf("\nevery thread increments one counter under the lock\n");
+    printf("%8s %12s %12s\n", "threads", "old SpinLock", "SpinLock");
+    for (u32 threads : thread_counts) {
+        printf("%8u %12.1f %12.1f\n",
+               threads,
+               ContendLock<Benchmarks::SpinLock>(threads),
+               ContendLock<Core::SpinLock>(threads));
+    }
+
+    return 0;
+}
@@ -0,0 +1,280 @@
+// The SIMD math kernels against the same work written with plain GLM, in ns per item over batches that stay in
+// cache. The difference column is the largest absolute difference between the two results.
+// Usage: Benchmark-SimdMath
+#include "Benchmark.h"
+#include <Core/Math/SimdMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/transform.hpp>
+
+using namespace Squid;
+
+static constexpr u32 COUNT = 4096;
+// Passes over the batch per measurement, keeps each measurement well above the timer resolution
+static constexpr u32 PASSES = 100;
+static constexpr u32 REPEATS = 5;
+
+// Element streams of matrices, columns[c][r] like glm::mat4
+struct MatrixBuffer {
+    std::vector<f32> values[4][4];
+
+    explicit MatrixBuffer(const std::vector<glm::mat4> &matrices) {
+        for (u32 column = 0; column < 4; column++) {
+            for (u32 row = 0; row < 4; row++) {
+                values[column][row].resize(matrices.size());
+                for (size_t i = 0; i < matrices.size(); i++) {
+                    values[column][row][i] = matrices[i][column][row];
+                }
+            }
+        }
+    }
+
+    Core::MatrixStreams GetStreams() const {
+        Core::MatrixStreams streams;
+        for (u32 column = 0; column < 4; column++) {
+            for (u32 row = 0; row < 4; row++) {
+                streams.columns[column][row] = values[column][row].data();
+            }
+        }
+        return streams;
+    }
+
+    Core::MatrixOutputStreams GetOutputStreams() {
+        Core::MatrixOutputStreams streams;
+        for (u32 column = 0; column < 4; column++) {
+            for (u32 row = 0; row < 4; row++) {
+                streams.columns[column][row] = values[column][row].data();
+            }
+        }
+        return streams;
+    }
+
+    f32 GetDifference(const std::vector<glm::mat4> &matrices) const {
+        f32 difference = 0.0f;
+        for (u32 column = 0; column < 4; column++) {
+            for (u32 row = 0; row < 4; row++) {
+                for (size_t i = 0; i < matrices.size(); i++) {
+                    difference = std::max(difference, fabsf(values[column][row][i] - matrices[i][column][row]));
+                }
+            }
+        }
+        return difference;
+    }
+};
+
+static f32 GetDifference(const std::vector<glm::mat4> &a, const std::vector<glm::mat4> &b) {
+    f32 difference = 0.0f;
+    for (size_t i = 0; i < a.size(); i++) {
+        for (u32 column = 0; column < 4; column++) {
+            for (u32 row = 0; row < 4; row++) {
+                difference = std::max(difference, fabsf(a[i][column][row] - b[i][column][row]));
+            }
+        }
+    }
+    return difference;
+}
+
+static f32 GetDifference(const std::vector<glm::vec3> &a, const std::vector<glm::vec3> &b) {
+    f32 difference = 0.0f;
+    for (size_t i = 0; i < a.size(); i++) {
+        for (u32 axis = 0; axis < 3; axis++) {
+            difference = std::max(difference, fabsf(a[i][axis] - b[i][axis]));
+        }
+    }
+    return difference;
+}
+
+template <typename Function>
+static f64 NsPerItem(Function &&function) {
+    return Benchmarks::Measure(REPEATS, [&]() {
+               for (u32 pass = 0; pass < PASSES; pass++) {
+                   function();
+               }
+           }) *
+           1e6 / (f64(COUNT) * PASSES);
+}
+
+static void Print(const char *kernel, const char *variant, f64 glm_ns, f64 simd_ns, f32 difference) {
+    printf("%-16s %-10s %10.2f %10.2f %8.2fx %12.2e\n", kernel, variant, glm_ns, simd_ns, glm_ns / simd_ns, difference);
+}
+
+int main() {
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<f32> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<f32> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<f32> size(0.1f, 4.0f);
+
+    // Random TRS transforms like the scene's, and boxes and spheres around the origin
+    std::vector<f32> trs[10];
+    std::vector<glm::mat4> a(COUNT), b(COUNT);
+    std::vector<glm::vec3> box_min(COUNT), box_max(COUNT);
+    std::vector<f32> spheres[4];
+    for (auto &stream : trs) {
+        stream.resize(COUNT);
+    }
+    for (auto &stream : spheres) {
+        stream.resize(COUNT);
+    }
+
+    for (u32 i = 0; i < COUNT; i++) {
+        glm::quat rotation;
+        rotation.x = unit(random);
+        rotation.y = unit(random);
+        rotation.z = unit(random);
+        rotation.w = unit(random);
+        const f32 length = sqrtf(
+            rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z + rotation.w * rotation.w);
+
+        for (u32 axis = 0; axis < 3; axis++) {
+            trs[axis][i] = position(random);
+            trs[7 + axis][i] = size(random);
+        }
+        trs[3][i] = rotation.x / length;
+        trs[4][i] = rotation.y / length;
+        trs[5][i] = rotation.z / length;
+        trs[6][i] = rotation.w / length;
+
+        const glm::vec3 center(position(random), position(random), position(random));
+        const glm::vec3 extent(size(random), size(random), size(random));
+        box_min[i] = center - extent;
+        box_max[i] = center + extent;
+
+        for (u32 axis = 0; axis < 3; axis++) {
+            spheres[axis][i] = position(random);
+        }
+        spheres[3][i] = size(random);
+    }
+
+    printf("%u items, ns per item\n", COUNT);
+    printf("%-16s %-10s %10s %10s %9s %12s\n", "kernel", "layout", "glm", "simd", "speedup", "difference");
+
+    // == TRS composition ==
+    const Core::TransformStreams transform_streams = {
+        {trs[0].data(), trs[1].data(), trs[2].data()},
+        {trs[3].data(), trs[4].data(), trs[5].data(), trs[6].data()},
+        {trs[7].data(), trs[8].data(), trs[9].data()}};
+
+    std::vector<glm::mat4> glm_result(COUNT), simd_result(COUNT);
+    const f64 compose_glm = NsPerItem([&]() {
+        for (u32 i = 0; i < COUNT; i++) {
+            glm::quat rotation;
+            rotation.x = trs[3][i];
+            rotation.y = trs[4][i];
+            rotation.z = trs[5][i];
+            rotation.w = trs[6][i];
+            glm_result[i] = glm::translate(glm::mat4(1.0f), glm::vec3(trs[0][i], trs[1][i], trs[2][i])) *
+                            glm::mat4_cast(rotation) *
+                            glm::scale(glm::mat4(1.0f), glm::vec3(trs[7][i], trs[8][i], trs[9][i]));
+        }
+    });
+    const f64 compose_simd =
+        NsPerItem([&]() { Core::ComposeTransforms(transform_streams, simd_result.data(), COUNT); });
+    Print("ComposeTransform", "SoA", compose_glm, compose_simd, GetDifference(glm_result, simd_result));
+    a = simd_result;
+
+    // == Matrix products ==
+    std::shuffle(simd_result.begin(), simd_result.end(), random);
+    b = simd_result;
+
+    const f64 multiply_glm = NsPerItem([&]() {
+        for (u32 i = 0; i < COUNT; i++) {
+            glm_result[i] = a[i] * b[i];
+        }
+    });
+    const f64 multiply_aos =
+        NsPerItem([&]() { Core::MultiplyMatrices(a.data(), b.data(), simd_result.data(), COUNT); });
+    Print("MultiplyMatrix", "AoS", multiply_glm, multiply_aos, GetDifference(glm_result, simd_result));
+
+    const MatrixBuffer a_streams(a), b_streams(b);
+    MatrixBuffer result_streams(a);
+    const Core::MatrixOutputStreams result_view = result_streams.GetOutputStreams();
+    const f64 multiply_soa = NsPerItem([&]() {
+        Core::MultiplyMatrices(a_streams.GetStreams(), b_streams.GetStreams(), result_view, COUNT);
+    });
+    Print("MultiplyMatrix", "SoA", multiply_glm, multiply_soa, result_streams.GetDifference(glm_result));
+
+    // == Bounds ==
+    std::vector<glm::vec3> glm_min(COUNT), glm_max(COUNT), simd_min(COUNT), simd_max(COUNT);
+    const f64 aabb_glm = NsPerItem([&]() {
+        for (u32 i = 0; i < COUNT; i++) {
+            const glm::vec3 center = (box_min[i] + box_max[i]) * 0.5f;
+            const glm::vec3 extent = (box_max[i] - box_min[i]) * 0.5f;
+            const glm::vec3 world_center = glm::vec3(a[i] * glm::vec4(center, 1.0f));
+
+            glm::vec3 world_extent(0.0f);
+            for (u32 axis = 0; axis < 3; axis++) {
+                const glm::vec3 column(a[i][axis]);
+                world_extent += glm::vec3(fabsf(column.x), fabsf(column.y), fabsf(column.z)) * extent[axis];
+            }
+            glm_min[i] = world_center - world_extent;
+            glm_max[i] = world_center + world_extent;
+        }
+    });
+    const f64 aabb_aos = NsPerItem([&]() {
+        Core::TransformAabbs(a.data(), box_min.data(), box_max.data(), simd_min.data(), simd_max.data(), COUNT);
+    });
+    Print("TransformAabb",
+          "AoS",
+          aabb_glm,
+          aabb_aos,
+          std::max(GetDifference(glm_min, simd_min), GetDifference(glm_max, simd_max)));
+
+    std::vector<f32> box_streams[6], world_streams[6];
+    for (u32 axis = 0; axis < 3; axis++) {
+        for (u32 i = 0; i < COUNT; i++) {
+            box_streams[axis].push_back(box_min[i][axis]);
+            box_streams[3 + axis].push_back(box_max[i][axis]);
+        }
+    }
+    for (auto &stream : world_streams) {
+        stream.resize(COUNT);
+    }
+
+    const Core::AabbStreams boxes = {
+        {box_streams[0].data(), box_streams[1].data(), box_streams[2].data()},
+        {box_streams[3].data(), box_streams[4].data(), box_streams[5].data()}};
+    const Core::AabbOutputStreams world = {
+        {world_streams[0].data(), world_streams[1].data(), world_streams[2].data()},
+        {world_streams[3].data(), world_streams[4].data(), world_streams[5].data()}};
+    const f64 aabb_soa = NsPerItem([&]() { Core::TransformAabbs(a_streams.GetStreams(), boxes, world, COUNT); });
+
+    f32 aabb_difference = 0.0f;
+    for (u32 axis = 0; axis < 3; axis++) {
+        for (u32 i = 0; i < COUNT; i++) {
+            aabb_difference = std::max(aabb_difference, fabsf(world_streams[axis][i] - glm_min[i][axis]));
+            aabb_difference = std::max(aabb_difference, fabsf(world_streams[3 + axis][i] - glm_max[i][axis]));
+        }
+    }
+    Print("TransformAabb", "SoA", aabb_glm, aabb_soa, aabb_difference);
+
+    // == Culling ==
+    glm::vec4 planes[6];
+    Core::ExtractFrustumPlanes(glm::perspective(1.0f, 16.0f / 9.0f, 0.1f, 200.0f), planes);
+
+    std::vector<u8> glm_visible(COUNT), simd_visible(COUNT);
+    const f64 cull_glm = NsPerItem([&]() {
+        for (u32 i = 0; i < COUNT; i++) {
+            const glm::vec4 center(spheres[0][i], spheres[1][i], spheres[2][i], 1.0f);
+            bool inside = true;
+            for (u32 plane = 0; plane < 6; plane++) {
+                inside = inside && glm::dot(planes[plane], center) >= -spheres[3][i];
+            }
+            glm_visible[i] = inside ? 1 : 0;
+        }
+    });
+
+    const Core::SphereStreams sphere_streams = {{spheres[0].data(), spheres[1].data(), spheres[2].data()},
+                                                spheres[3].data()};
+    const f64 cull_simd = NsPerItem(
+        [&]() { Core::TestSpheresFrustum(planes, sphere_streams, simd_visible.data(), COUNT); });
+    Print("SphereFrustum", "SoA", cull_glm, cull_simd, f32(glm_visible != simd_visible));
+
+    Benchmarks::Consume(glm_result);
+    return 0;
+}
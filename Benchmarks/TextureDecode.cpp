@@ -0,0 +1,68 @@
+// Decode throughput of the batched texture import against the number of job system threads.
+// Usage: Benchmark-TextureDecode [image...], run from the repository root to use the renderer's textures.
+#include "Benchmark.h"
+#include <Renderer/ImageDecode.h>
+#include <Core/IO/AsyncIo.h>
+
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+using namespace Squid;
+
+// Enough images per batch to keep every thread busy, the set of files is repeated to reach it
+static constexpr u32 MIN_BATCH_SIZE = 32;
+static constexpr u32 REPEATS = 3;
+
+int main(int argc, char **argv) {
+    std::vector<std::string> paths(argv + 1, argv + argc);
+    if (paths.empty()) {
+        paths = {"Assets/Textures/Glock_01_Albedo.png", "Assets/Textures/Glock_01_Normal.png",
+                 "Assets/Textures/px_1k.hdr",           "Assets/Textures/nx_1k.hdr",
+                 "Assets/Textures/py_1k.hdr",           "Assets/Textures/ny_1k.hdr",
+                 "Assets/Textures/pz_1k.hdr",           "Assets/Textures/nz_1k.hdr"};
+    }
+
+    try {
+        const std::vector<std::vector<u8>> files = Core::ReadFiles(paths);
+
+        std::vector<Renderer::ImageDecode> images;
+        u64 decoded_size = 0;
+        while (images.size() < MIN_BATCH_SIZE) {
+            for (size_t i = 0; i < files.size(); i++) {
+                Renderer::ImageDecode image;
+                image.file = &files[i];
+                image.hdr = std::filesystem::path(paths[i]).extension() == ".hdr";
+                Renderer::ReadImageInfo(image);
+                image.offset = decoded_size;
+                decoded_size += image.GetDecodedSize();
+                images.push_back(image);
+            }
+        }
+
+        std::vector<u8> destination(decoded_size);
+        printf("%zu images, %.1f MB decoded per batch\n", images.size(), decoded_size / (1024.0 * 1024.0));
+        printf("%8s %10s %10s %8s\n", "threads", "ms", "MB/s", "speedup");
+
+        f64 single_thread = 0.0;
+        for (u32 threads : Benchmarks::GetThreadCounts(Benchmarks::GetCoreCount())) {
+            Core::JobSystem system(threads - 1);
+            const f64 ms = Benchmarks::Measure(
+                REPEATS, [&]() { Renderer::DecodeImages(images, destination.data(), system); });
+
+            single_thread = threads == 1 ? ms : single_thread;
+            printf("%8u %10.1f %10.1f %7.2fx\n", threads, ms, decoded_size / (1024.0 * 1024.0) / (ms / 1000.0),
+                   single_thread / ms);
+        }
+    } catch (const std::exception &error) {
+        fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -7,6 +7,8 @@
 #include <imgui.h>
 #include <sstream>
 
+#include "UiSnapshot.h"
+
 namespace Squid {
 namespace EditorCore {
 
@@ -19,19 +21,36 @@ namespace EditorCore {
     public:
         Module(EngineContext* ctx) : IModule(ctx) {}
         bool Initialize() override;
+        // Update and Render back to back on the calling thread
         void Tick(float delta) override;
 
+        // Builds the ImGui frame on the simulation thread and copies its draw data into the snapshot
+        void Update(UiSnapshot &ui);
+        // Records the copied draw data into the backbuffer pass, may run on the render thread a frame behind
+        void Render(UiSnapshot &ui);
+
+        // Undocked panels live in platform windows. ImGui creates, renders and destroys them through the device on
+        // the simulation thread, the render thread has to be idle meanwhile.
+        bool HasPlatformWindows() const;
+
         // TODO smart pointer
-        ~Module() { delete editor; }
+        ~Module();
 
         ImGuiContext *GetContext() const { return ctx; };
 
     private:
+        // Keyboard and wheel input for ImGui, the mouse position and buttons are read in ImGui_ImplSDL2_NewFrame
+        void OnKey(const Core::KeyEvent *events, u32 count);
+        void OnTextInput(const Core::TextInputEvent *events, u32 count);
+        void OnMouseWheel(const Core::MouseWheelEvent *events, u32 count);
+
         std::shared_ptr<RHI::Module> rhi;
         std::shared_ptr<Renderer::Module> renderer;
 
         ImGuiContext *ctx = nullptr;
         Editor *editor;
+        // Used by Tick
+        UiSnapshot tick_snapshot;
         std::stringstream buffer;
     };
 
@@ -0,0 +1,26 @@
+#pragma once
+#include <imgui.h>
+#include <vector>
+
+namespace Squid {
+namespace EditorCore {
+
+    // Copy of the main viewport's ImGui draw data, taken on the simulation thread after ImGui::Render so the render
+    // thread can record it while the next ImGui frame is built. Its draw lists keep their buffers between frames.
+    class UiSnapshot {
+    public:
+        UiSnapshot() = default;
+        ~UiSnapshot();
+        UiSnapshot(const UiSnapshot &) = delete;
+        UiSnapshot &operator=(const UiSnapshot &) = delete;
+
+        void Capture(const ImDrawData *source);
+        inline ImDrawData *GetDrawData() { return &draw_data; }
+
+    private:
+        ImDrawData draw_data;
+        std::vector<ImDrawList *> lists;
+    };
+
+} // namespace EditorCore
+} // namespace Squid
@@ -4,6 +4,7 @@
 
 #include "Widgets/Dockspace.h"
 #include "Widgets/LogWidget.h"
+#include "Widgets/MemoryWidget.h"
 #include "Widgets/SceneWidget.h"
 #include "Widgets/PropertiesWidget.h"
 #include "Widgets/ViewportWidget.h"
@@ -25,6 +26,7 @@ namespace EditorCore {
         this->viewport_widget = std::make_unique<ViewportWidget>(renderer.get());
         this->properties_widget = std::make_unique<PropertiesWidget>();
         this->log_widget = std::make_unique<LogWidget>();
+        this->memory_widget = std::make_unique<MemoryWidget>();
     }
 
     Editor::~Editor() {}
@@ -54,7 +56,7 @@ namespace EditorCore {
          ImGui::End();*/
 
         EditorBegin();
-        std::vector<std::string> filters = {"Image Files", "*.png *.jpg *.jpeg *.bmp"};
+        static const std::vector<std::string> filters = {"Image Files", "*.png *.jpg *.jpeg *.bmp"};
 
         ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f);
         if (ImGui::BeginMainMenuBar()) {
@@ -74,6 +76,9 @@ namespace EditorCore {
                 if (ImGui::MenuItem("Log", nullptr, &log_widget->GetVisible()))
                     log_widget->SetVisible(!log_widget->GetVisible());
 
+                if (ImGui::MenuItem("Memory", nullptr, &memory_widget->GetVisible()))
+                    memory_widget->SetVisible(!memory_widget->GetVisible());
+
                 if (ImGui::MenuItem("Properties", nullptr, &properties_widget->GetVisible()))
                     properties_widget->SetVisible(!properties_widget->GetVisible());
 
@@ -94,16 +99,12 @@ namespace EditorCore {
         scene_widget->Tick();
         properties_widget->Tick();
         log_widget->Tick();
+        memory_widget->Tick();
 
         auto t = true;
-        std::stringstream ss;
-        std::stringstream ss2;
         ImGui::Begin("Test", &t, 0);
-        ss << renderer->GetFrameHeight() << " " << renderer->GetFrameWidth() << std::endl;
-        ss2 << renderer->GetFrame().height << " " << renderer->GetFrame().width << std::endl;
-
-        ImGui::Text(ss.str().c_str());
-        ImGui::Text(ss2.str().c_str());
+        ImGui::Text("%u %u", renderer->GetFrameHeight(), renderer->GetFrameWidth());
+        ImGui::Text("%u %u", u32(renderer->GetFrame().height), u32(renderer->GetFrame().width));
         ImGui::End();
         // ImGui::PushItemFlag(ImGuiItemFlags_Disabled, (bool)open_file);
 
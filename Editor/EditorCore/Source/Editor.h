@@ -7,6 +7,7 @@ namespace EditorCore {
 
     class Dockspace;
     class LogWidget;
+    class MemoryWidget;
     class SceneWidget;
     class ViewportWidget;
     class PropertiesWidget;
@@ -27,6 +28,7 @@ namespace EditorCore {
         std::unique_ptr<SceneWidget> scene_widget;
         std::unique_ptr<ViewportWidget> viewport_widget;
         std::unique_ptr<LogWidget> log_widget;
+        std::unique_ptr<MemoryWidget> memory_widget;
         std::unique_ptr<PropertiesWidget> properties_widget;
 
         std::shared_ptr<Renderer::Module> renderer;
@@ -108,6 +108,7 @@ static void ImGui_ImplRHI_CreateFontsTexture() {
     RHI::CommandList transfer_list = g_device->BeginTransferList();
     g_device->Copy(transfer_list, staging_fonts_texture, g_fonts_texture);
     g_device->QueueSubmit(RHI::QueueType::GRAPHICS, transfer_list);
+    g_device->Wait(transfer_list);
 
     g_device->UnloadBuffer(staging_fonts_texture);
 
@@ -174,7 +175,7 @@ void ImGui_ImplRHI_CreateDeviceObjects() {
     g_pso.vertex_layout.inputs[1].type = RHI::VertexType::FLOAT2;
     g_pso.vertex_layout.inputs[1].offset = offsetof(ImDrawVert, uv);
     g_pso.vertex_layout.inputs[1].binding = 1;
-    g_pso.vertex_layout.inputs[2].type = RHI::VertexType::FLOAT4;
+    g_pso.vertex_layout.inputs[2].type = RHI::VertexType::UNORM8_4;
     g_pso.vertex_layout.inputs[2].offset = offsetof(ImDrawVert, col);
     g_pso.vertex_layout.inputs[2].binding = 2;
 
@@ -1,6 +1,9 @@
 #include <Public/EditorCore/Module.h>
 #include "Widgets/LogWidget.h"
 #include "Editor.h"
+#include <Core/Events/EventDispatcher.h>
+#include <Core/Memory/MemoryTracker.h>
+#include <Core/Profiling.h>
 
 #include "ImGui/imgui_impl_rhi.h"
 #include "ImGui/imgui_impl_sdl.h"
@@ -10,6 +13,8 @@
 namespace Squid {
 namespace EditorCore {
     bool Module::Initialize() {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_EDITOR);
+
         // std::cout.rdbuf(buffer.rdbuf());
         rhi = context->GetModule<RHI::Module>("RHI");
         renderer = context->GetModule<Renderer::Module>("Renderer");
@@ -31,19 +36,68 @@ namespace EditorCore {
         ImGui_ImplRHI_Init(renderer->GetDevice().get());
 
         this->editor = new Editor(renderer);
+
+        Core::EventDispatcher &events = Core::GetEventDispatcher();
+        events.Subscribe<&Module::OnKey>(this);
+        events.Subscribe<&Module::OnTextInput>(this);
+        events.Subscribe<&Module::OnMouseWheel>(this);
         return true;
     };
 
-    void Module::Tick(float delta) {
-        auto& device = renderer->GetDevice();
+    Module::~Module() {
+        Core::EventDispatcher &events = Core::GetEventDispatcher();
+        events.Unsubscribe<&Module::OnKey>(this);
+        events.Unsubscribe<&Module::OnTextInput>(this);
+        events.Unsubscribe<&Module::OnMouseWheel>(this);
 
-        
+        delete editor;
+    }
 
-        
+    void Module::OnKey(const Core::KeyEvent *events, u32 count) {
+        ImGuiIO &io = ImGui::GetIO();
+        for (u32 i = 0; i < count; i++) {
+            const Core::KeyEvent &event = events[i];
+            // The key map set up by the SDL backend uses scancodes
+            if (event.scancode < IM_ARRAYSIZE(io.KeysDown))
+                io.KeysDown[event.scancode] = event.down;
+        }
+
+        const u16 modifiers = events[count - 1].modifiers;
+        io.KeyShift = (modifiers & Core::KEY_MODIFIER_SHIFT) != 0;
+        io.KeyCtrl = (modifiers & Core::KEY_MODIFIER_CTRL) != 0;
+        io.KeyAlt = (modifiers & Core::KEY_MODIFIER_ALT) != 0;
+#ifdef SQUID_WIN32
+        io.KeySuper = false;
+#else
+        io.KeySuper = (modifiers & Core::KEY_MODIFIER_SUPER) != 0;
+#endif
+    }
+
+    void Module::OnTextInput(const Core::TextInputEvent *events, u32 count) {
+        ImGuiIO &io = ImGui::GetIO();
+        for (u32 i = 0; i < count; i++) {
+            io.AddInputCharactersUTF8(events[i].text);
+        }
+    }
 
+    void Module::OnMouseWheel(const Core::MouseWheelEvent *events, u32 count) {
         ImGuiIO &io = ImGui::GetIO();
-        (void)io;
+        for (u32 i = 0; i < count; i++) {
+            io.MouseWheelH += f32((events[i].x > 0) - (events[i].x < 0));
+            io.MouseWheel += f32((events[i].y > 0) - (events[i].y < 0));
+        }
+    }
 
+    void Module::Tick(float delta) {
+        Update(tick_snapshot);
+        Render(tick_snapshot);
+    }
+
+    void Module::Update(UiSnapshot &ui) {
+        PROFILING_SCOPE
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_EDITOR);
+
+        // Creates the device objects on the first frame only, before there is anything to render
         ImGui_ImplRHI_NewFrame();
         ImGui_ImplSDL2_NewFrame((SDL_Window *)renderer->GetWindow());
 
@@ -51,13 +105,25 @@ namespace EditorCore {
         editor->Tick();
         ImGui::Render();
 
+        ui.Capture(ImGui::GetDrawData());
+    }
+
+    void Module::Render(UiSnapshot &ui) {
+        PROFILING_SCOPE
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_EDITOR);
+
+        auto &device = renderer->GetDevice();
+
         RHI::CommandList list = device->BeginCommandListEXP();
         g_device->BeginRenderPass(list, renderer->GetSwapchain().backbuffer);
-        ImGui_ImplRHI_RenderDrawData(ImGui::GetDrawData(), list);
+        ImGui_ImplRHI_RenderDrawData(ui.GetDrawData(), list);
         g_device->EndRenderPass(list);
+    }
 
-        // renderer->GetDevice();
-    };
+    bool Module::HasPlatformWindows() const {
+        ImGuiContext *context = ImGui::GetCurrentContext();
+        return (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) && context->Viewports.Size > 1;
+    }
 
     // NOTE disabled support for dynamic link
     // IMPLEMENT_MODULE(Module, EditorCore)
@@ -0,0 +1,40 @@
+#include <Public/EditorCore/UiSnapshot.h>
+#include <cstring>
+
+namespace Squid {
+namespace EditorCore {
+
+    // Grows like ImVector does and never shrinks, operator= would free and allocate every frame
+    template <typename T>
+    static void CopyVector(ImVector<T> &destination, const ImVector<T> &source) {
+        destination.resize(source.Size);
+        if (source.Size > 0)
+            std::memcpy(destination.Data, source.Data, size_t(source.Size) * sizeof(T));
+    }
+
+    UiSnapshot::~UiSnapshot() {
+        for (ImDrawList *list : lists) {
+            IM_DELETE(list);
+        }
+    }
+
+    void UiSnapshot::Capture(const ImDrawData *source) {
+        while (lists.size() < size_t(source->CmdListsCount)) {
+            lists.push_back(IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData()));
+        }
+
+        for (int i = 0; i < source->CmdListsCount; i++) {
+            const ImDrawList *from = source->CmdLists[i];
+            ImDrawList *to = lists[i];
+            CopyVector(to->CmdBuffer, from->CmdBuffer);
+            CopyVector(to->IdxBuffer, from->IdxBuffer);
+            CopyVector(to->VtxBuffer, from->VtxBuffer);
+            to->Flags = from->Flags;
+        }
+
+        draw_data = *source;
+        draw_data.CmdLists = lists.data();
+    }
+
+} // namespace EditorCore
+} // namespace Squid
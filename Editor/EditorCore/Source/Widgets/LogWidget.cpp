@@ -1,18 +1,138 @@
 #include "LogWidget.h"
 #include <Core/Profiling.h>
 
+#include <algorithm>
+#include <ctime>
+
 namespace Squid {
 namespace EditorCore {
 
-    LogWidget::LogWidget() { title = "Log"; }
+    // Indexed by spdlog::level::level_enum
+    static const char *LOG_LEVEL_NAMES[spdlog::level::n_levels] = {
+        "trace", "debug", "info", "warning", "error", "critical", "off"};
+    static const ImVec4 LOG_LEVEL_COLORS[spdlog::level::n_levels] = {
+        ImVec4(0.5f, 0.5f, 0.5f, 1.0f),
+        ImVec4(0.6f, 0.7f, 0.8f, 1.0f),
+        ImVec4(0.9f, 0.9f, 0.9f, 1.0f),
+        ImVec4(1.0f, 0.8f, 0.3f, 1.0f),
+        ImVec4(1.0f, 0.4f, 0.4f, 1.0f),
+        ImVec4(1.0f, 0.2f, 0.6f, 1.0f),
+        ImVec4(0.5f, 0.5f, 0.5f, 1.0f)};
+
+    LogWidget::LogWidget() : ring(Core::GetLogRing()) { title = "Log"; }
+
+    void LogWidget::Clear() {
+        cleared = ring.GetEnd();
+        scanned = cleared;
+        lines.clear();
+    }
+
+    bool LogWidget::PassFilter(const Core::LogEntry &entry) const {
+        if (!show_levels[entry.level])
+            return false;
+        if (!filter.IsActive())
+            return true;
+
+        // The module is searched along with the text
+        char line[Core::LogEntry::MODULE_SIZE + Core::LogEntry::TEXT_SIZE + 1];
+        const i32 length = snprintf(line, sizeof(line), "%s %.*s", entry.module, i32(entry.length), entry.text);
+        return filter.PassFilter(line, line + std::clamp<i32>(length, 0, sizeof(line) - 1));
+    }
+
+    void LogWidget::UpdateLines(bool filter_changed) {
+        const u64 end = ring.GetEnd();
+        const u64 first = std::max(ring.GetFirst(), cleared);
+
+        if (filter_changed) {
+            lines.clear();
+            scanned = first;
+        }
+
+        // Lines overwritten before they were looked at are skipped
+        scanned = std::max(scanned, first);
+
+        Core::LogEntry entry;
+        for (; scanned < end; scanned++) {
+            if (ring.Read(scanned, entry) && PassFilter(entry))
+                lines.push_back(scanned);
+        }
+
+        while (!lines.empty() && lines.front() < first)
+            lines.pop_front();
+    }
+
+    void LogWidget::DrawLine(const Core::LogEntry &entry) const {
+        const auto since_epoch = entry.time.time_since_epoch();
+        const std::time_t seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch).count();
+        const i32 milliseconds = i32(std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch).count() % 1000);
+        const std::tm *local = std::localtime(&seconds);
+
+        ImGui::TextDisabled("%02d:%02d:%02d.%03d", local->tm_hour, local->tm_min, local->tm_sec, milliseconds);
+        ImGui::SameLine();
+        ImGui::TextColored(LOG_LEVEL_COLORS[entry.level], "%-8s", LOG_LEVEL_NAMES[entry.level]);
+        ImGui::SameLine();
+        ImGui::TextDisabled("%-10s %6zu", entry.module, entry.thread_id);
+        ImGui::SameLine();
+
+        if (entry.level >= spdlog::level::warn)
+            ImGui::PushStyleColor(ImGuiCol_Text, LOG_LEVEL_COLORS[entry.level]);
+        ImGui::TextUnformatted(entry.text, entry.text + entry.length);
+        if (entry.level >= spdlog::level::warn)
+            ImGui::PopStyleColor();
+
+        if (entry.truncated) {
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::TextDisabled("...");
+        }
+    }
 
     void LogWidget::Tick() {
         PROFILING_SCOPE
 
         if (Begin()) {
+            bool filter_changed = false;
+
+            if (ImGui::Button("Clear"))
+                Clear();
+            ImGui::SameLine();
+            ImGui::Checkbox("Auto-scroll", &auto_scroll);
+
+            for (i32 level = spdlog::level::debug; level <= spdlog::level::critical; level++) {
+                ImGui::SameLine();
+                filter_changed |= ImGui::Checkbox(LOG_LEVEL_NAMES[level], &show_levels[level]);
+            }
+
+            ImGui::SameLine();
+            filter_changed |= filter.Draw("Search", -1.0f);
+
+            UpdateLines(filter_changed);
+
+            ImGui::Separator();
+            ImGui::BeginChild("Lines", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+
+            // Rows out of view are never read from the ring
+            ImGuiListClipper clipper;
+            clipper.Begin(i32(lines.size()));
+            Core::LogEntry entry;
+            while (clipper.Step()) {
+                for (i32 row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                    if (ring.Read(lines[row], entry))
+                        DrawLine(entry);
+                    else
+                        ImGui::TextDisabled("(overwritten)");
+                }
+            }
+            clipper.End();
+
+            // Keeps following new lines while scrolled to the bottom
+            if (auto_scroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+                ImGui::SetScrollHereY(1.0f);
+
+            ImGui::EndChild();
+
             End();
         }
     }
 
 } // namespace EditorCore
-} // namespace Squid
\ No newline at end of file
+} // namespace Squid
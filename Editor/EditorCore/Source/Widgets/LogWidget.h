@@ -1,20 +1,40 @@
 #pragma once
 #include "Widget.h"
 #include <pch.h>
+#include <Core/LogRing.h>
+
+#include <deque>
 
 namespace Squid {
 namespace EditorCore {
 
+    // Shows the shared LogRing. Only the rows in view are read and drawn, the filtered line numbers are updated with
+    // the lines logged since the last frame and rebuilt when the filter changes.
     class LogWidget : public Widget {
     public:
         LogWidget();
         void Tick() override;
 
-        void AddLogMessage(std::string msg);
+        // Hides everything logged so far
         void Clear();
 
     private:
+        bool PassFilter(const Core::LogEntry &entry) const;
+        void UpdateLines(bool filter_changed);
+        void DrawLine(const Core::LogEntry &entry) const;
+
+        Core::LogRing &ring;
+
+        ImGuiTextFilter filter;
+        bool show_levels[spdlog::level::n_levels] = {true, true, true, true, true, true, true};
+        bool auto_scroll = true;
+
+        // Numbers of the lines passing the filter, never more than the ring holds
+        std::deque<u64> lines;
+        // Lines before scanned have been filtered, lines before cleared are hidden
+        u64 scanned = 0;
+        u64 cleared = 0;
     };
 
 } // namespace EditorCore
-} // namespace Squid
\ No newline at end of file
+} // namespace Squid
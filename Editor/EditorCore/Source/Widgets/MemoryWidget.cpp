@@ -0,0 +1,154 @@
+#include "MemoryWidget.h"
+#include <Core/Profiling.h>
+
+#include <algorithm>
+
+namespace Squid {
+namespace EditorCore {
+
+    // Where the JSON dump is written, next to profile.res
+    static const char *MEMORY_DUMP_PATH = "memory.json";
+    // Callstack groups kept by a refresh
+    static constexpr u32 MAX_CALLSTACKS = 64;
+
+    // Prints bytes with a binary unit, such as "12.3 MiB"
+    static void TextBytes(f64 bytes) {
+        static const char *UNITS[] = {"B", "KiB", "MiB", "GiB"};
+        u32 unit = 0;
+        while (bytes >= 1024.0 && unit < 3) {
+            bytes /= 1024.0;
+            unit++;
+        }
+        ImGui::Text(unit == 0 ? "%.0f %s" : "%.1f %s", bytes, UNITS[unit]);
+    }
+
+    MemoryWidget::MemoryWidget() {
+        title = "Memory";
+        sample_rate = i32(Core::GetMemorySampleRate());
+    }
+
+    void MemoryWidget::Tick() {
+        PROFILING_SCOPE
+
+        if (Begin()) {
+            if (!Core::IsTrackingMemory()) {
+                ImGui::TextDisabled("Memory tracking is off, build with TRACK_MEMORY to turn it on");
+                End();
+                return;
+            }
+
+            if (ImGui::Button("Dump JSON")) {
+                try {
+                    Core::DumpMemoryStats(MEMORY_DUMP_PATH);
+                    dump_status = std::string("written to ") + MEMORY_DUMP_PATH;
+                } catch (const std::exception &error) {
+                    dump_status = error.what();
+                }
+            }
+            if (!dump_status.empty()) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("%s", dump_status.c_str());
+            }
+
+            DrawStats(Core::GetMemoryStats());
+
+            ImGui::Separator();
+            DrawCallstacks();
+
+            End();
+        }
+    }
+
+    void MemoryWidget::DrawStats(const Core::MemoryStats &stats) const {
+        ImGui::Columns(6, "MemoryStats");
+        ImGui::Text("Tag");
+        ImGui::NextColumn();
+        ImGui::Text("Live");
+        ImGui::NextColumn();
+        ImGui::Text("Peak");
+        ImGui::NextColumn();
+        ImGui::Text("Allocations");
+        ImGui::NextColumn();
+        ImGui::Text("Allocations/s");
+        ImGui::NextColumn();
+        ImGui::Text("Allocated/s");
+        ImGui::NextColumn();
+        ImGui::Separator();
+
+        Core::MemoryTagStats total;
+        for (u32 tag = 0; tag <= Core::MEMORY_TAG_COUNT; tag++) {
+            const bool is_total = tag == Core::MEMORY_TAG_COUNT;
+            const Core::MemoryTagStats &tag_stats = is_total ? total : stats.tags[tag];
+
+            if (!is_total) {
+                total.live_bytes += tag_stats.live_bytes;
+                total.live_allocations += tag_stats.live_allocations;
+                total.peak_bytes += tag_stats.peak_bytes;
+                total.allocations_per_second += tag_stats.allocations_per_second;
+                total.bytes_per_second += tag_stats.bytes_per_second;
+            } else {
+                ImGui::Separator();
+            }
+
+            ImGui::Text("%s", is_total ? "Total" : Core::GetMemoryTagName(Core::MemoryTag(tag)));
+            ImGui::NextColumn();
+            TextBytes(f64(tag_stats.live_bytes));
+            ImGui::NextColumn();
+            // Peaks of the tags are reached at different times, their sum is an upper bound
+            TextBytes(f64(tag_stats.peak_bytes));
+            ImGui::NextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(tag_stats.live_allocations));
+            ImGui::NextColumn();
+            ImGui::Text("%.0f", tag_stats.allocations_per_second);
+            ImGui::NextColumn();
+            TextBytes(tag_stats.bytes_per_second);
+            ImGui::NextColumn();
+        }
+
+        ImGui::Columns(1);
+    }
+
+    void MemoryWidget::DrawCallstacks() {
+        ImGui::SetNextItemWidth(120.0f);
+        if (ImGui::InputInt("Sample every nth allocation", &sample_rate)) {
+            sample_rate = std::max(sample_rate, 0);
+            Core::SetMemorySampleRate(u32(sample_rate));
+        }
+
+        if (sample_rate == 0) {
+            ImGui::TextDisabled("Callstacks aren't sampled");
+            return;
+        }
+
+        ImGui::SameLine();
+        if (ImGui::Button("Refresh callstacks"))
+            RefreshCallstacks();
+
+        for (size_t i = 0; i < callstacks.size(); i++) {
+            const Callstack &entry = callstacks[i];
+            ImGui::PushID(i32(i));
+
+            const bool open = ImGui::TreeNode(
+                "callstack", "%s  %.1f KiB in %llu sampled allocations", Core::GetMemoryTagName(entry.callstack.tag),
+                f64(entry.callstack.bytes) / 1024.0, static_cast<unsigned long long>(entry.callstack.allocations));
+            if (open) {
+                for (const std::string &line : entry.lines) {
+                    ImGui::TextUnformatted(line.c_str());
+                }
+                ImGui::TreePop();
+            }
+
+            ImGui::PopID();
+        }
+    }
+
+    void MemoryWidget::RefreshCallstacks() {
+        callstacks.clear();
+        for (Core::MemoryCallstack &callstack : Core::GetLiveCallstacks(MAX_CALLSTACKS)) {
+            std::vector<std::string> lines = Core::SymbolizeCallstack(callstack.frames);
+            callstacks.push_back({std::move(callstack), std::move(lines)});
+        }
+    }
+
+} // namespace EditorCore
+} // namespace Squid
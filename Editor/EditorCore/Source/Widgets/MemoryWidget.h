@@ -0,0 +1,35 @@
+#pragma once
+#include "Widget.h"
+#include <pch.h>
+#include <Core/Memory/MemoryTracker.h>
+
+#include <string>
+#include <vector>
+
+namespace Squid {
+namespace EditorCore {
+
+    // Live and peak memory per tag from the last SampleMemoryStats, and the biggest live sampled callstacks. The
+    // callstacks are only gathered and symbolized on request, drawing the stats doesn't allocate.
+    class MemoryWidget : public Widget {
+    public:
+        MemoryWidget();
+        void Tick() override;
+
+    private:
+        void DrawStats(const Core::MemoryStats &stats) const;
+        void DrawCallstacks();
+        void RefreshCallstacks();
+
+        struct Callstack {
+            Core::MemoryCallstack callstack;
+            std::vector<std::string> lines;
+        };
+
+        std::vector<Callstack> callstacks;
+        i32 sample_rate = 0;
+        std::string dump_status;
+    };
+
+} // namespace EditorCore
+} // namespace Squid
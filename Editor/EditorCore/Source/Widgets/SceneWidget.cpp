@@ -1,24 +1,40 @@
 #include "SceneWidget.h"
+#include <Core/Events/EventDispatcher.h>
 #include <Core/Profiling.h>
 
+#include <algorithm>
+
 namespace Squid {
 namespace EditorCore {
 
-    SceneWidget::SceneWidget(Renderer::Module *renderer) : renderer(renderer) { title = "SceneGraph"; }
+    SceneWidget::SceneWidget(Renderer::Module *renderer) : renderer(renderer) {
+        title = "SceneGraph";
+        Core::GetEventDispatcher().Subscribe<&SceneWidget::OnSceneChanged>(this);
+    }
 
-    void SceneWidget::DrawChildrens(Core::Entity current, const std::string &name, u32 &index) {
-        index++;
-        auto &h = renderer->GetScene()->hierarchy;
+    SceneWidget::~SceneWidget() { Core::GetEventDispatcher().Unsubscribe<&SceneWidget::OnSceneChanged>(this); }
+
+    void SceneWidget::OnSceneChanged(const Core::SceneChangedEvent *events, u32 count) {
+        const Core::SceneGraph *scene = renderer->GetScene();
+        for (u32 i = 0; i < count; i++) {
+            if (events[i].scene != scene || events[i].change != Core::SCENE_CHANGE_ATTACHED)
+                continue;
 
-        // Collect childrens
-        std::vector<Core::Entity> childrens;
-        for (int i = 0; i < h.GetCount(); i++) {
-            if (h[i].parent_id == current) {
-                childrens.push_back(h.GetEntity(i));
+            for (Core::Entity parent = events[i].parent; parent != Core::INVALID_ENTITY;) {
+                if (std::find(reveal.begin(), reveal.end(), parent) == reveal.end())
+                    reveal.push_back(parent);
+                const Core::HierarchyComponent *node = scene->hierarchy.GetComponent(parent);
+                parent = node ? node->parent_id : Core::INVALID_ENTITY;
             }
         }
+    }
 
-        bool has_children = childrens.size() != 0;
+    void SceneWidget::DrawChildrens(Core::Entity current, const std::string &name, u32 &index) {
+        index++;
+        Core::SceneGraph *scene = renderer->GetScene();
+        const Core::HierarchyComponent *node = scene->hierarchy.GetComponent(current);
+
+        bool has_children = node && node->first_child != Core::INVALID_ENTITY;
         bool tree_opened = false;
 
         ImVec4 color_odd = ImVec4(0.5f, 0.5f, 0.5f, 1.0f);
@@ -27,11 +43,15 @@ namespace EditorCore {
         // draw
         ImGui::PushStyleColor(ImGuiCol_Header, index % 2 != 0 ? color_odd : color_even);
         if (has_children) {
+            if (std::find(reveal.begin(), reveal.end(), current) != reveal.end())
+                ImGui::SetNextItemOpen(true);
+
             if (ImGui::TreeNode(name.c_str())) {
-                for (auto i = 0; i < childrens.size(); i++) {
-                    auto child = childrens[i];
-                    auto name = renderer->GetScene()->transforms.GetComponent(child)->name;
-                    DrawChildrens(child, name, index);
+                // Children are linked from the first one through their siblings
+                for (Core::Entity child = node->first_child; child != Core::INVALID_ENTITY;
+                     child = scene->hierarchy.GetComponent(child)->next_sibling) {
+                    const Core::NameComponent *name = scene->names.GetComponent(child);
+                    DrawChildrens(child, name ? name->name : std::string("Entity"), index);
                 }
 
                 ImGui::TreePop();
@@ -56,6 +76,8 @@ namespace EditorCore {
 
             u32 index = 0;
             DrawChildrens(renderer->GetSceneRoot(), "Root", index);
+            // Kept while the window is hidden, so the tree opens once it is shown
+            reveal.clear();
 
             ImGui::EndChild();
 
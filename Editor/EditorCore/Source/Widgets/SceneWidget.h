@@ -10,11 +10,16 @@ namespace EditorCore {
     class SceneWidget : public Widget {
     public:
         SceneWidget(Renderer::Module* renderer);
+        ~SceneWidget();
         void Tick() override;
         void DrawChildrens(Core::Entity current, const std::string &name, u32 &index);
 
     private:
+        // Opens the tree down to newly attached entities
+        void OnSceneChanged(const Core::SceneChangedEvent *events, u32 count);
+
         Renderer::Module* renderer;
+        std::vector<Core::Entity> reveal;
     };
 
 } // namespace EditorCore
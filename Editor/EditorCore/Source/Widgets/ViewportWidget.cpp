@@ -39,7 +39,7 @@ namespace EditorCore {
 
             if (current_width != width || current_height != height) {
                 // TODO: avoid negative value to passed to this function
-                LOG_INFO("renderer->SetViewportSize({},{})", width, height)
+                LOG_INFO_EVERY(500, "renderer->SetViewportSize({},{})", width, height)
                 renderer->SetViewportSize(width, height);
             }
 
@@ -47,6 +47,16 @@ namespace EditorCore {
                 (uint64_t *)&renderer->GetFrame(), ImVec2(static_cast<f32>(width), static_cast<f32>(height)),
                 ImVec2(0, 0), ImVec2(1, 1));
 
+            // Picking walks the scene BVH with a ray through the clicked pixel
+            if (ImGui::IsItemClicked(0) && width > 0 && height > 0) {
+                const ImVec2 origin = ImGui::GetItemRectMin();
+                const ImVec2 mouse = ImGui::GetMousePos();
+                picked = renderer->Pick((mouse.x - origin.x) / f32(width), (mouse.y - origin.y) / f32(height));
+
+                const Core::NameComponent *name = renderer->GetScene()->names.GetComponent(picked);
+                LOG_INFO("Picked entity {} ({})", picked, name ? name->name : std::string("None"))
+            }
+
             End();
         }
     }
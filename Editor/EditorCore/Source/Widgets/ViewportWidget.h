@@ -14,6 +14,7 @@ namespace EditorCore {
     private:
         Renderer::Module *renderer;
         ImVec2 v_size;
+        Core::Entity picked = Core::INVALID_ENTITY;
     };
 
 } // namespace EditorCore
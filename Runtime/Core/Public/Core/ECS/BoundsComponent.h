@@ -0,0 +1,44 @@
+#pragma once
+#include "../Types.h"
+
+#include <glm/glm.hpp>
+
+namespace Squid {
+namespace Core {
+
+    // Axis aligned box of an entity. The owner sets the local box, SceneGraph::Update keeps the world box in
+    // sync with the transform and the scene BVH in sync with the world box.
+    struct BoundsComponent {
+        enum Flags {
+            EMPTY = 0,
+            DIRTY = 1 << 0,
+        };
+
+        uint32_t flags = DIRTY;
+
+        glm::vec3 local_min = glm::vec3(0.0f);
+        glm::vec3 local_max = glm::vec3(0.0f);
+
+        glm::vec3 world_min = glm::vec3(0.0f);
+        glm::vec3 world_max = glm::vec3(0.0f);
+
+        // Leaf in the scene BVH, owned by the scene
+        u32 proxy = ~0u;
+
+        inline bool IsDirty() const { return flags & DIRTY; }
+        inline void SetDirty(bool value = true) {
+            if (value)
+                flags |= DIRTY;
+            else
+                flags &= ~DIRTY;
+        }
+
+        inline void SetLocalBounds(const glm::vec3 &min, const glm::vec3 &max) {
+            local_min = min;
+            local_max = max;
+            SetDirty();
+        }
+    };
+
+} // namespace Core
+} // namespace Squid
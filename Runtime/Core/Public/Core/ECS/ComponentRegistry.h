@@ -1,40 +1,62 @@
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <cassert>
 #include <vector>
 #include "Entity.h"
+#include "../Memory/MemoryTracker.h"
 
-#include "TransformComponent.h"
+#include "BoundsComponent.h"
 #include "HierarchyComponent.h"
+#include "NameComponent.h"
+#include "TransformComponent.h"
 
 namespace Squid {
 namespace Core {
 
+    // Sparse set storage: components and their entities are packed in dense arrays, a paged sparse array maps
+    // entities to dense indices. Lookups are two array reads and iterating the dense array is a linear pass.
     template <typename ComponentType>
     class ComponentRegistry {
     public:
         ComponentRegistry() = default;
         ~ComponentRegistry() = default;
 
-        inline bool Contains(Entity entity) const { return lookup.find(entity) != lookup.end(); }
+        inline bool Contains(Entity entity) const { return GetIndex(entity) != INVALID_INDEX; }
         inline size_t GetCount() const { return components.size(); }
         inline Entity GetEntity(size_t index) const { return entities[index]; }
+        inline const std::vector<Entity> &GetEntities() const { return entities; }
 
         ComponentType &operator[](size_t index) { return components[index]; }
+        const ComponentType &operator[](size_t index) const { return components[index]; }
+
+        inline typename std::vector<ComponentType>::iterator begin() { return components.begin(); }
+        inline typename std::vector<ComponentType>::iterator end() { return components.end(); }
+        inline typename std::vector<ComponentType>::const_iterator begin() const { return components.begin(); }
+        inline typename std::vector<ComponentType>::const_iterator end() const { return components.end(); }
+
+        // Dense index of the entity's component or INVALID_INDEX
+        inline u32 GetIndex(Entity entity) const {
+            const size_t page = entity / PAGE_SIZE;
+            if (page >= sparse.size() || sparse[page].empty())
+                return INVALID_INDEX;
+            return sparse[page][entity % PAGE_SIZE];
+        }
 
         ComponentType *Create(Entity entity) {
             // INVALID_ENTITY is not allowed!
             assert(entity != INVALID_ENTITY);
 
             // Only one of this component type per entity is allowed!
-            assert(lookup.find(entity) == lookup.end());
+            assert(!Contains(entity));
 
             // Entity count must always be the same as the number of components!
             assert(entities.size() == components.size());
-            assert(lookup.size() == components.size());
+
+            MemoryTagScope memory_tag(MEMORY_TAG_ECS);
 
             // Update the entity lookup table:
-            lookup[entity] = components.size();
+            SetIndex(entity, u32(components.size()));
 
             // New components are always pushed to the end:
             components.push_back(ComponentType());
@@ -46,13 +68,16 @@ namespace Core {
         }
 
         ComponentType *GetComponent(Entity entity) {
-            auto it = lookup.find(entity);
-            if (it != lookup.end()) {
-                return &components[it->second];
-            }
-            return nullptr;
+            const u32 index = GetIndex(entity);
+            return index != INVALID_INDEX ? &components[index] : nullptr;
         }
 
+        const ComponentType *GetComponent(Entity entity) const {
+            const u32 index = GetIndex(entity);
+            return index != INVALID_INDEX ? &components[index] : nullptr;
+        }
+
+        // Moves an item to index_to, shifting everything in between by one while keeping their order
         void MoveItem(size_t index_from, size_t index_to) {
             assert(index_from < GetCount());
             assert(index_to < GetCount());
@@ -60,53 +85,88 @@ namespace Core {
                 return;
             }
 
-            // Save the moved component and entity:
-            ComponentType component = std::move(components[index_from]);
-            Entity entity = entities[index_from];
-
-            // Every other entity-component that's in the way gets moved by one and lut is kept
-            // updated:
-            const int direction = index_from < index_to ? 1 : -1;
-            for (size_t i = index_from; i != index_to; i += direction) {
-                const size_t next = i + direction;
-                components[i] = std::move(components[next]);
-                entities[i] = entities[next];
-                lookup[entities[i]] = i;
+            const size_t first = std::min(index_from, index_to);
+            const size_t last = std::max(index_from, index_to) + 1;
+
+            if (index_from < index_to) {
+                std::rotate(components.begin() + first, components.begin() + first + 1, components.begin() + last);
+                std::rotate(entities.begin() + first, entities.begin() + first + 1, entities.begin() + last);
+            } else {
+                std::rotate(components.begin() + first, components.begin() + last - 1, components.begin() + last);
+                std::rotate(entities.begin() + first, entities.begin() + last - 1, entities.begin() + last);
+            }
+
+            for (size_t i = first; i < last; i++) {
+                SetIndex(entities[i], u32(i));
+            }
+        }
+
+        // Stable sort of the components, entities follow their components
+        template <typename Compare>
+        void Sort(Compare less) {
+            MemoryTagScope memory_tag(MEMORY_TAG_ECS);
+            std::vector<u32> order(components.size());
+            for (u32 i = 0; i < u32(order.size()); i++) {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+                return less(components[a], components[b]);
+            });
+
+            std::vector<ComponentType> sorted_components;
+            std::vector<Entity> sorted_entities;
+            sorted_components.reserve(components.size());
+            sorted_entities.reserve(entities.size());
+            for (const u32 index : order) {
+                sorted_components.push_back(std::move(components[index]));
+                sorted_entities.push_back(entities[index]);
             }
 
-            // Saved entity-component moved to the required position:
-            components[index_to] = std::move(component);
-            entities[index_to] = entity;
-            lookup[entity] = index_to;
+            components.swap(sorted_components);
+            entities.swap(sorted_entities);
+            for (size_t i = 0; i < entities.size(); i++) {
+                SetIndex(entities[i], u32(i));
+            }
         }
 
         void Remove(Entity entity) {
-            auto it = lookup.find(entity);
-            if (it != lookup.end()) {
-                // Directly index into components and entities array:
-                const size_t index = it->second;
-                const Entity entity = entities[index];
-
-                if (index < components.size() - 1) {
-                    // Swap out the dead element with the last one:
-                    components[index] = std::move(components.back()); // try to use move
-                    entities[index] = entities.back();
-
-                    // Update the lookup table:
-                    lookup[entities[index]] = index;
-                }
-
-                // Shrink the container:
-                components.pop_back();
-                entities.pop_back();
-                lookup.erase(entity);
+            const u32 index = GetIndex(entity);
+            if (index == INVALID_INDEX)
+                return;
+
+            if (index < components.size() - 1) {
+                // Swap out the dead element with the last one:
+                components[index] = std::move(components.back());
+                entities[index] = entities.back();
+
+                // Update the lookup table:
+                SetIndex(entities[index], index);
             }
+
+            // Shrink the container:
+            components.pop_back();
+            entities.pop_back();
+            SetIndex(entity, INVALID_INDEX);
         }
 
+        static constexpr u32 INVALID_INDEX = ~0u;
+
     private:
+        // Entities are handed out sequentially, so pages fill up densely
+        static constexpr size_t PAGE_SIZE = 4096;
+
+        void SetIndex(Entity entity, u32 index) {
+            const size_t page = entity / PAGE_SIZE;
+            if (page >= sparse.size())
+                sparse.resize(page + 1);
+            if (sparse[page].empty())
+                sparse[page].resize(PAGE_SIZE, INVALID_INDEX);
+            sparse[page][entity % PAGE_SIZE] = index;
+        }
+
         std::vector<ComponentType> components;
         std::vector<Entity> entities;
-        std::unordered_map<Entity, size_t> lookup;
+        std::vector<std::vector<u32>> sparse;
     };
 
 } // namespace Core
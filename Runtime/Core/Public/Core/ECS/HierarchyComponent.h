@@ -4,9 +4,16 @@
 namespace Squid {
 namespace Core {
 
+    // Intrusive tree links maintained by SceneGraph. Children form a list through next_sibling, and the first
+    // child's previous_sibling wraps around to the last child so appending and unlinking are O(1).
+    // Parents always carry a component of their own, the top nodes have no parent and depth 0.
     struct HierarchyComponent {
         Entity parent_id = INVALID_ENTITY;
+        Entity first_child = INVALID_ENTITY;
+        Entity next_sibling = INVALID_ENTITY;
+        Entity previous_sibling = INVALID_ENTITY;
+        u32 depth = 0;
     };
 
 } // namespace Core
-} // namespace Squid
\ No newline at end of file
+} // namespace Squid
@@ -0,0 +1,13 @@
+#pragma once
+#include <string>
+
+namespace Squid {
+namespace Core {
+
+    // Kept apart from the transforms so their hot data stays tightly packed
+    struct NameComponent {
+        std::string name;
+    };
+
+} // namespace Core
+} // namespace Squid
@@ -4,6 +4,8 @@
 #include <vector>
 
 #include "../ECS/ComponentRegistry.h"
+#include "../ECS/View.h"
+#include "../Math/DynamicBvh.h"
 
 namespace Squid {
 namespace Core {
@@ -13,14 +15,60 @@ namespace Core {
         SceneGraph();
         ~SceneGraph();
 
-        void Update() const;
+        // Recomputes world matrices of dirty transforms and everything below them. Runs level by level over
+        // the hierarchy, each level split across worker threads. Then refits the world bounds of everything that
+        // moved and updates their leaves in the BVH.
+        void Update();
 
+        // Entities whose world bounds touch the six normalized, inward facing world space planes,
+        // as of the last Update. The order is unspecified.
+        void CullFrustum(const glm::vec4 *planes, FrameVector<Entity> &visible) const;
+
+        // Closest entity whose world bounds the ray hits within max_distance or INVALID_ENTITY
+        Entity RayCast(const glm::vec3 &origin, const glm::vec3 &direction, f32 max_distance, f32 *distance = nullptr)
+            const;
+
+        // Structural changes below are published as SceneChangedEvents
+
+        // Drops the bounds of the entity together with its BVH leaf
+        void RemoveBounds(Entity entity);
+
+        // Moves entity below parent, O(depth) plus the size of the moved subtree
         void Attach(Entity entity, Entity parent, bool child_already_in_local_space = false);
-		void Detach(Entity entity);
-		void DetachChildren(Entity parent);
+        // Attaches entities[i] below parents[i] and re-sorts the hierarchy by depth once at the end,
+        // so the next update walks it front to back. Meant for imports.
+        void AttachBulk(
+            const Entity *entities, const Entity *parents, size_t count, bool child_already_in_local_space = false);
+        // Makes entity a top node, keeping its world transform
+        void Detach(Entity entity);
+        void DetachChildren(Entity parent);
 
         ComponentRegistry<TransformComponent> transforms;
         ComponentRegistry<HierarchyComponent> hierarchy;
+        ComponentRegistry<NameComponent> names;
+        ComponentRegistry<BoundsComponent> bounds;
+
+    private:
+        void Link(Entity entity, Entity parent);
+        void Unlink(Entity entity);
+        void SetSubtreeDepth(Entity entity, u32 depth);
+        void AttachTransform(Entity entity, Entity parent, bool child_already_in_local_space);
+
+        void RebuildLevels();
+        void UpdateBounds();
+
+        // Hierarchy indices grouped by depth, level n spans level_offsets[n]..level_offsets[n + 1]
+        std::vector<u32> level_order;
+        std::vector<u32> level_offsets;
+        size_t levels_hierarchy_count = 0;
+        bool levels_dirty = true;
+
+        // Per transform index, set when the world matrix was rewritten during this update
+        std::vector<u8> world_changed;
+
+        // Leaves carry the entity as user data
+        DynamicBvh bvh;
+        std::vector<u8> bounds_moved;
     };
 
 } // namespace Core
@@ -1,7 +1,7 @@
 #pragma once
 #include "Entity.h"
+#include "../Math/SimdMath.h"
 
-#include <string>
 #include <glm/glm.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -16,14 +16,14 @@ namespace Core {
             DIRTY = 1 << 0,
         };
 
-        std::string name;
-
         uint32_t flags = DIRTY;
 
         glm::vec3 scale_local = glm::vec3(1.0f);
         glm::quat rotation_local = glm::quat();
         glm::vec3 translation_local = glm::vec3(0.0f);
 
+        // Cached composition of the local TRS, refreshed whenever the transform is dirty
+        glm::mat4 local = glm::mat4(1.0f);
         glm::mat4 world = glm::mat4(1.0f);
 
         inline bool IsDirty() const { return flags & DIRTY; }
@@ -34,60 +34,41 @@ namespace Core {
                 flags &= ~DIRTY;
         }
 
-        // TODO
-        glm::vec3 GetPosition() const {
-            glm::vec3 skew;
-            glm::vec4 persp;
-            glm::vec3 scale;
-            glm::quat rotation;
-            glm::vec3 translation;
-            glm::decompose(world, scale, rotation, translation, skew, persp);
-            return translation;
-        };
+        // Read straight from the world matrix, the rotation assumes no shear
+        glm::vec3 GetPosition() const { return glm::vec3(world[3]); };
 
         glm::quat GetRotation() const {
-            glm::vec3 skew;
-            glm::vec4 persp;
-            glm::vec3 scale;
-            glm::quat rotation;
-            glm::vec3 translation;
-            glm::decompose(world, scale, rotation, translation, skew, persp);
-            return rotation;
+            const glm::vec3 scale = GetScale();
+            const glm::mat3 rotation(
+                glm::vec3(world[0]) / scale.x, glm::vec3(world[1]) / scale.y, glm::vec3(world[2]) / scale.z);
+            return glm::quat_cast(rotation);
         };
 
         glm::vec3 GetScale() const {
-            glm::vec3 skew;
-            glm::vec4 persp;
-            glm::vec3 scale;
-            glm::quat rotation;
-            glm::vec3 translation;
-            glm::decompose(world, scale, rotation, translation, skew, persp);
-            return scale;
+            return glm::vec3(
+                glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])));
         };
 
-        glm::mat4 GetLocalMatrix() const {
-            // Identity
-            glm::mat4 matrix = glm::mat4(1.0f);
+        glm::mat4 GetLocalMatrix() const { return ComposeTransform(translation_local, rotation_local, scale_local); }
 
-            matrix = glm::translate(matrix, translation_local);
-            matrix *= glm::mat4_cast(rotation_local);
-            matrix = glm::scale(matrix, scale_local);
+        // Returns whether the local matrix changed
+        bool UpdateLocalMatrix() {
+            if (!IsDirty())
+                return false;
 
-            return matrix;
+            SetDirty(false);
+            local = GetLocalMatrix();
+            return true;
         }
 
         void UpdateTransform() {
-            if (IsDirty()) {
-                SetDirty(false);
-                world = GetLocalMatrix();
-            }
+            if (UpdateLocalMatrix())
+                world = local;
         };
 
+        // Leaves the dirty flag alone, SceneGraph::Update still has to see it to refresh the subtree below
         void UpdateTransformParented(const TransformComponent &parent) {
-            glm::mat4 w = GetLocalMatrix();
-            glm::mat4 w_parent = parent.world;
-            w = w * w_parent;
-            world = w;
+            MultiplyMatrix(parent.world, IsDirty() ? GetLocalMatrix() : local, world);
         };
 
         void ApplyTransform() {
@@ -0,0 +1,43 @@
+#pragma once
+#include <tuple>
+
+#include "ComponentRegistry.h"
+
+namespace Squid {
+namespace Core {
+
+    // Entities having every one of the components. Iteration walks the smallest registry and
+    // looks the entity up in the others.
+    template <typename... ComponentTypes>
+    class View {
+    public:
+        View(ComponentRegistry<ComponentTypes> &...registries) : registries(registries...) {}
+
+        // Calls function(Entity, ComponentTypes &...) for every match, the registries must not change meanwhile
+        template <typename Function>
+        void Each(Function &&function) {
+            const std::vector<Entity> *smallest = nullptr;
+            std::apply(
+                [&](auto &...registry) {
+                    ((smallest = !smallest || registry.GetCount() < smallest->size() ? &registry.GetEntities()
+                                                                                        : smallest),
+                     ...);
+                },
+                registries);
+
+            for (const Entity entity : *smallest) {
+                std::apply(
+                    [&](auto &...registry) {
+                        if ((registry.Contains(entity) && ...))
+                            function(entity, *registry.GetComponent(entity)...);
+                    },
+                    registries);
+            }
+        }
+
+    private:
+        std::tuple<ComponentRegistry<ComponentTypes> &...> registries;
+    };
+
+} // namespace Core
+} // namespace Squid
@@ -1,30 +1,91 @@
 #pragma once
+#include "../Jobs/LockFreeQueue.h"
+#include "../Types.h"
 
-#include <string>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include <vector>
 
 namespace Squid {
 namespace Core {
 
-    enum class EventType { WINDOW_CLOSE };
+    // Points of the frame where queued events are handed to their handlers, every event type belongs to one
+    enum EventPhase : u8 {
+        // Before the modules tick, platform input, window and asset events
+        EVENT_PHASE_FRAME_START,
+        // After the modules ticked, changes they made during the frame
+        EVENT_PHASE_FRAME_END,
+        EVENT_PHASE_COUNT
+    };
 
-    // Forward declares
-    class EventDispatcher;
+    // Gets every event of a drained batch at once, the events of each publishing thread stay in order
+    template <typename T>
+    using EventFunction = void (*)(void *user_data, const T *events, u32 count);
 
-    class Event {
-        friend class EventDispatcher;
+    // Events of one type. Events are small trivially copyable structs declaring NAME, PHASE and CAPACITY, they are
+    // copied into a fixed ring and drained into a contiguous batch, nothing is allocated per event. Any thread can
+    // publish, only the dispatching thread drains. A full queue drops the event and counts it.
+    template <typename T>
+    class EventQueue {
+        static_assert(std::is_trivially_copyable<T>::value, "events are copied in and out of the queue");
 
     public:
-        virtual EventType GetType() const = 0;
-        virtual const char *GetName() const = 0;
-        virtual std::string ToString() const { return GetName(); };
+        inline bool Publish(const T &event) {
+            if (queue.Push(event))
+                return true;
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Not while the queue is being drained
+        void Subscribe(EventFunction<T> function, void *user_data) { handlers.push_back({function, user_data}); }
+
+        void Unsubscribe(EventFunction<T> function, void *user_data) {
+            handlers.erase(std::remove_if(handlers.begin(), handlers.end(),
+                                          [&](const Handler &handler) {
+                                              return handler.function == function && handler.user_data == user_data;
+                                          }),
+                           handlers.end());
+        }
+
+        // Hands what was queued so far to every handler, events published by the handlers wait for the next drain
+        u32 Drain() {
+            u32 count = 0;
+            while (count < T::CAPACITY && queue.Pop(batch[count])) {
+                count++;
+            }
 
-    protected:
-        bool handled = false;
+            if (count > 0) {
+                for (const Handler &handler : handlers) {
+                    handler.function(handler.user_data, batch, count);
+                }
+            }
+            return count;
+        }
+
+        // Events dropped since the last call
+        inline u32 TakeDropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+
+    private:
+        struct Handler {
+            EventFunction<T> function;
+            void *user_data;
+        };
+
+        MpscQueue<T, T::CAPACITY> queue;
+        T batch[T::CAPACITY];
+        std::vector<Handler> handlers;
+        std::atomic<u32> dropped = 0;
     };
 
-    class EventDispatcher {
-        public:
-        
+    // Event type taken by a handler method, void Owner::Method(const T *events, u32 count)
+    template <typename Method>
+    struct EventMethod;
+
+    template <typename Owner, typename T>
+    struct EventMethod<void (Owner::*)(const T *, u32)> {
+        using Event = T;
     };
 
 } // namespace Core
@@ -0,0 +1,71 @@
+#pragma once
+#include "Event.h"
+#include "SystemEvents.h"
+
+#include <tuple>
+
+namespace Squid {
+namespace Core {
+
+    // Typed event bus. Every event type has its own queue, producers on any thread publish into it without locks and
+    // Dispatch hands each queue to its handlers as one batch at the phase the type belongs to. Handlers are plain
+    // function pointers, subscribe and unsubscribe outside of Dispatch, usually while initializing.
+    class EventDispatcher {
+    public:
+        EventDispatcher() = default;
+        EventDispatcher(const EventDispatcher &) = delete;
+        EventDispatcher &operator=(const EventDispatcher &) = delete;
+
+        // False when the queue was full and the event got dropped
+        template <typename T>
+        inline bool Publish(const T &event) {
+            return GetQueue<T>().Publish(event);
+        }
+
+        template <typename T>
+        void Subscribe(EventFunction<T> function, void *user_data) {
+            GetQueue<T>().Subscribe(function, user_data);
+        }
+
+        template <typename T>
+        void Unsubscribe(EventFunction<T> function, void *user_data) {
+            GetQueue<T>().Unsubscribe(function, user_data);
+        }
+
+        // Subscribe<&Owner::OnEvent>(this) with void Owner::OnEvent(const T *events, u32 count)
+        template <auto method, typename Owner>
+        void Subscribe(Owner *owner) {
+            using T = typename EventMethod<decltype(method)>::Event;
+            GetQueue<T>().Subscribe(&CallMethod<method, Owner, T>, owner);
+        }
+
+        template <auto method, typename Owner>
+        void Unsubscribe(Owner *owner) {
+            using T = typename EventMethod<decltype(method)>::Event;
+            GetQueue<T>().Unsubscribe(&CallMethod<method, Owner, T>, owner);
+        }
+
+        // Drains the queues of the phase's event types, called by the engine loop on the main thread
+        void Dispatch(EventPhase phase);
+
+    private:
+        template <auto method, typename Owner, typename T>
+        static void CallMethod(void *owner, const T *events, u32 count) {
+            (static_cast<Owner *>(owner)->*method)(events, count);
+        }
+
+        template <typename T>
+        inline EventQueue<T> &GetQueue() {
+            return std::get<EventQueue<T>>(queues);
+        }
+
+        std::tuple<EventQueue<WindowResizeEvent>, EventQueue<QuitEvent>, EventQueue<KeyEvent>,
+                   EventQueue<TextInputEvent>, EventQueue<MouseButtonEvent>, EventQueue<MouseMotionEvent>,
+                   EventQueue<MouseWheelEvent>, EventQueue<AssetReloadEvent>, EventQueue<SceneChangedEvent>>
+            queues;
+    };
+
+    EventDispatcher &GetEventDispatcher();
+
+} // namespace Core
+} // namespace Squid
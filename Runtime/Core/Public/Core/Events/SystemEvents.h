@@ -1,35 +1,138 @@
 #pragma once
+#include "../ECS/Entity.h"
+#include "../FileWatcher.h"
 #include "Event.h"
 
+#include <cstring>
+#include <string>
+
 namespace Squid {
 namespace Core {
 
-    class KeyEvent : public Event {
-    public:
-        inline int GetKeycode() const { return key_code }
+    // The main window was resized, sizes in pixels
+    struct WindowResizeEvent {
+        static constexpr const char *NAME = "WindowResize";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_START;
+        static constexpr u32 CAPACITY = 16;
 
-    protected:
-        KeyEvent(int key_code) : key_code(key_code) {}
-        int key_code;
+        u32 width;
+        u32 height;
     };
 
-    class KeyDownEvent : public KeyEvent {
-    public:
-        KeyDownEvent(int key_code, uint32_t repeat) : KeyEvent(key_code), repeat(repeat) {}
-        inline int GetRepeatCount() const { return repeat }
+    // The application or its main window was asked to close
+    struct QuitEvent {
+        static constexpr const char *NAME = "Quit";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_START;
+        static constexpr u32 CAPACITY = 4;
+    };
 
-    private:
-        uint32_t repeat;
+    enum KeyModifier : u16 {
+        KEY_MODIFIER_SHIFT = 1 << 0,
+        KEY_MODIFIER_CTRL = 1 << 1,
+        KEY_MODIFIER_ALT = 1 << 2,
+        KEY_MODIFIER_SUPER = 1 << 3
     };
 
-    class KeyUpEvent : public KeyEvent {
-    public:
-        KeyUpEvent(int key_code) : KeyEvent(key_code) {}
+    // Scancodes and keycodes are SDL's
+    struct KeyEvent {
+        static constexpr const char *NAME = "Key";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_START;
+        static constexpr u32 CAPACITY = 256;
 
-    private:
-        uint32_t count;
+        u32 scancode;
+        i32 keycode;
+        // KeyModifier flags held at the time
+        u16 modifiers;
+        bool down;
+        bool repeat;
     };
 
-} // namespace Core
+    struct TextInputEvent {
+        static constexpr const char *NAME = "TextInput";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_START;
+        static constexpr u32 CAPACITY = 64;
+
+        // UTF-8, null terminated
+        char text[32];
+    };
+
+    enum MouseButton : u8 { MOUSE_BUTTON_LEFT, MOUSE_BUTTON_RIGHT, MOUSE_BUTTON_MIDDLE, MOUSE_BUTTON_X1, MOUSE_BUTTON_X2 };
+
+    // Positions in window pixels
+    struct MouseButtonEvent {
+        static constexpr const char *NAME = "MouseButton";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_START;
+        static constexpr u32 CAPACITY = 256;
+
+        i32 x;
+        i32 y;
+        MouseButton button;
+        bool down;
+        u8 clicks;
+    };
+
+    struct MouseMotionEvent {
+        static constexpr const char *NAME = "MouseMotion";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_START;
+        static constexpr u32 CAPACITY = 1024;
+
+        i32 x;
+        i32 y;
+        i32 delta_x;
+        i32 delta_y;
+        // Held buttons, bit n is MouseButton n
+        u32 buttons;
+    };
+
+    // Scrolled wheel ticks, positive y is away from the user
+    struct MouseWheelEvent {
+        static constexpr const char *NAME = "MouseWheel";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_START;
+        static constexpr u32 CAPACITY = 256;
 
+        i32 x;
+        i32 y;
+    };
+
+    // A watched asset file changed on disk
+    struct AssetReloadEvent {
+        static constexpr const char *NAME = "AssetReload";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_START;
+        static constexpr u32 CAPACITY = 64;
+
+        // False when the path doesn't fit
+        inline bool SetPath(const std::string &file) {
+            if (file.size() >= sizeof(path))
+                return false;
+            std::memcpy(path, file.c_str(), file.size() + 1);
+            return true;
+        }
+
+        char path[256];
+        FileStatus status;
+    };
+
+    class SceneGraph;
+
+    enum SceneChange : u8 {
+        SCENE_CHANGE_ATTACHED,
+        SCENE_CHANGE_DETACHED,
+        SCENE_CHANGE_BOUNDS_REMOVED,
+        // Many entities were attached at once, entity and parent are INVALID_ENTITY
+        SCENE_CHANGE_BULK_ATTACHED
+    };
+
+    struct SceneChangedEvent {
+        static constexpr const char *NAME = "SceneChanged";
+        static constexpr EventPhase PHASE = EVENT_PHASE_FRAME_END;
+        static constexpr u32 CAPACITY = 1024;
+
+        const SceneGraph *scene;
+        Entity entity;
+        // New parent when attached
+        Entity parent;
+        SceneChange change;
+    };
+
+} // namespace Core
 } // namespace Squid
@@ -1,36 +1,93 @@
 #pragma once
-#include <filesystem>
+#include "Types.h"
+
+#include <atomic>
 #include <chrono>
-#include <map>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
 #include <string>
-#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+namespace Squid {
+namespace Core {
 
-namespace Squid { namespace  Core {
+    enum class FileStatus { CREATED, UPDATED, DELETED };
 
-    enum class FileStatus {
-        CREATED,
-        UPDATED,
-        DELETED
+    struct FileChange {
+        std::string path;
+        FileStatus status;
     };
 
+    // Watches a directory tree on its own thread. On Linux it listens to inotify, elsewhere or when inotify is not
+    // available it compares write times every interval. Changes to the same file are merged until the tree has been
+    // quiet for the latency and then handed over as one batch, which the main loop collects with Poll.
     class FileWatcher {
     public:
-        FileWatcher(const std::string &path, std::chrono::duration<int, std::milli> intervall);
+        FileWatcher(
+            const std::string &path,
+            std::chrono::milliseconds latency = std::chrono::milliseconds(100),
+            std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
         ~FileWatcher();
-        void start(const std::function<void (std::string, FileStatus)> &action);
+
+        FileWatcher(const FileWatcher &) = delete;
+        FileWatcher &operator=(const FileWatcher &) = delete;
+
+        void Start();
+        // Wakes the watcher thread and joins it, batches not collected yet are kept
+        void Stop();
+
+        // Appends the changes of every finished batch, returns false when there were none
+        bool Poll(std::vector<FileChange> &changes);
+
+        inline bool IsRunning() const { return running.load(std::memory_order_relaxed); }
+        // False while polling, either on this platform or after inotify failed
+        inline bool IsEventDriven() const { return event_driven.load(std::memory_order_relaxed); }
+        inline const std::string &GetPath() const { return path; }
 
     private:
+        // Merges a change into the batch being collected, watcher thread only
+        void Record(const std::string &file, FileStatus status);
+        void Flush();
+
+        void PollLoop();
+        void Scan(bool report);
+
         std::string path;
-        std::chrono::duration<int, std::milli> intervall;
-        bool running = true;
+        std::chrono::milliseconds latency;
+        std::chrono::milliseconds interval;
+
+        std::thread thread;
+        std::atomic<bool> running = false;
+        std::atomic<bool> event_driven = false;
+        std::mutex stop_mutex;
+        std::condition_variable stop_signal;
+
+        std::unordered_map<std::string, FileStatus> batch;
+        std::mutex ready_mutex;
+        std::vector<FileChange> ready;
+
+        // Polling state, last write times seen by the previous scan
+        struct PolledFile {
+            std::filesystem::file_time_type last_write;
+            u32 scan = 0;
+        };
+        std::unordered_map<std::string, PolledFile> files;
+        u32 scan = 0;
 
-        inline bool contains(const std::string &key) {
-            auto el = paths.find(key);
-            return el != paths.end();
-        }
+#ifdef SQUID_LINUX
+        bool OpenInotify();
+        bool WatchDirectory(const std::string &directory, bool report);
+        void InotifyLoop();
 
-        std::unordered_map<std::string, std::filesystem::file_time_type> paths;
+        int inotify_fd = -1;
+        // Written by Stop to wake the thread out of poll()
+        int stop_fd = -1;
+        std::unordered_map<int, std::string> watches;
+#endif
     };
 
-}} // namespace Squid::Core
+} // namespace Core
+} // namespace Squid
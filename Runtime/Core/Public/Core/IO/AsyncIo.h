@@ -0,0 +1,150 @@
+#pragma once
+#include "../Types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef SQUID_LINUX
+struct io_uring_sqe;
+struct io_uring_cqe;
+#endif
+
+namespace Squid {
+namespace Core {
+
+    // Read only file for AsyncIo, closed on destruction
+    class IoFile {
+    public:
+        IoFile() = default;
+        explicit IoFile(const std::string &path);
+        ~IoFile();
+
+        IoFile(const IoFile &) = delete;
+        IoFile &operator=(const IoFile &) = delete;
+        IoFile(IoFile &&other) noexcept;
+        IoFile &operator=(IoFile &&other) noexcept;
+
+        bool IsValid() const;
+        inline u64 GetSize() const { return size; }
+
+    private:
+        friend class AsyncIo;
+        void Close();
+
+#ifdef SQUID_WIN32
+        void *handle = nullptr;
+#else
+        int fd = -1;
+#endif
+        u64 size = 0;
+    };
+
+    // Reads that are waited for together
+    class IoBatch {
+    public:
+        inline bool IsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+        // A read failed or hit the end of the file early, its buffer is left incomplete
+        inline bool HasFailed() const { return failed.load(std::memory_order_relaxed); }
+
+    private:
+        friend class AsyncIo;
+
+        std::atomic<u32> pending = 0;
+        std::atomic<bool> failed = false;
+    };
+
+    // Batched file reads into caller provided memory, such as a mapped staging buffer. On Linux the reads go
+    // through io_uring and a single thread reaps the completions, elsewhere or on kernels without it a few
+    // worker threads issue blocking positional reads. Large reads are split so their pieces are in flight
+    // together and a deep NVMe queue stays busy.
+    class AsyncIo {
+    public:
+        explicit AsyncIo(u32 queue_depth = 64, u32 worker_count = 4);
+        ~AsyncIo();
+
+        AsyncIo(const AsyncIo &) = delete;
+        AsyncIo &operator=(const AsyncIo &) = delete;
+
+        // Queues a read of size bytes at offset. File and buffer have to stay alive until the batch is done.
+        // Reads are only guaranteed to be issued by Submit or Wait.
+        void Read(IoBatch &batch, const IoFile &file, u64 offset, u64 size, void *buffer);
+
+        // Issues the queued reads, never blocks on them
+        void Submit();
+        // Submits and blocks until every read of the batch has completed
+        void Wait(IoBatch &batch);
+
+        inline bool IsUring() const { return uring_fd >= 0; }
+
+        // Pieces larger reads are split into
+        static constexpr u64 MAX_READ_SIZE = 1 << 20;
+
+    private:
+        struct Request {
+            IoBatch *batch;
+#ifdef SQUID_WIN32
+            void *handle;
+#else
+            int fd;
+#endif
+            u64 offset;
+            u64 size;
+            u8 *buffer;
+        };
+
+        // Advances the request past result bytes, returns true when it still has to be read further
+        bool Complete(Request &request, i64 result);
+        void Finish(IoBatch &batch);
+        void WorkerLoop();
+
+        std::mutex queue_mutex;
+        std::condition_variable queue_signal;
+        std::deque<Request> queued;
+        bool quit = false;
+
+        std::mutex finish_mutex;
+        std::condition_variable finish_signal;
+
+        std::vector<std::thread> threads;
+
+        // io_uring state, uring_fd is -1 when running on the worker threads
+        int uring_fd = -1;
+#ifdef SQUID_LINUX
+        bool SetupUring(u32 queue_depth);
+        void PumpUring();
+        void ReapLoop();
+
+        struct UringRing {
+            void *memory = nullptr;
+            u64 memory_size = 0;
+            u32 *head = nullptr;
+            u32 *tail = nullptr;
+            u32 mask = 0;
+            u32 entries = 0;
+        };
+
+        UringRing submission;
+        UringRing completion;
+        u32 *submission_array = nullptr;
+        ::io_uring_sqe *sqes = nullptr;
+        u64 sqes_size = 0;
+        ::io_uring_cqe *cqes = nullptr;
+        // Requests the kernel owns, the user data of an entry is its slot index + 1
+        std::vector<Request> slots;
+        std::vector<u32> free_slots;
+#endif
+    };
+
+    // Shared service, created on first use
+    AsyncIo &GetAsyncIo();
+
+    // Reads whole files with every read in flight at once, throws when one can't be read
+    std::vector<std::vector<u8>> ReadFiles(const std::vector<std::string> &paths);
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,94 @@
+#pragma once
+#include "../MappedFile.h"
+#include "../Types.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Squid {
+namespace Core {
+
+    // Layout of a .sqpak file: header, entry data, then the table of contents and the names it points into. Entry
+    // data starts on PACK_ALIGNMENT boundaries so stored entries can be mapped and handed out in place. The table
+    // is sorted by path hash and looked up with a binary search.
+    static constexpr u32 PACK_MAGIC = 0x4b505153; // SQPK
+    static constexpr u32 PACK_VERSION = 1;
+    static constexpr u64 PACK_ALIGNMENT = 4096;
+
+    enum PackCompression : u8 {
+        PACK_COMPRESSION_NONE,
+        PACK_COMPRESSION_LZ4,
+        PACK_COMPRESSION_ZSTD,
+    };
+
+    struct PackHeader {
+        u32 magic = PACK_MAGIC;
+        u32 version = PACK_VERSION;
+        u32 entry_count = 0;
+        u32 names_size = 0;
+        u64 toc_offset = 0;
+        u64 names_offset = 0;
+    };
+
+    struct PackEntry {
+        // murmur64 of the path relative to the packed directory, '/' separated
+        u64 path_hash;
+        // murmur64 of the uncompressed data
+        u64 content_hash;
+        u64 offset;
+        u64 stored_size;
+        u64 size;
+        u32 name_offset;
+        u32 name_length;
+        PackCompression compression;
+        u8 padding[7];
+    };
+
+    static_assert(sizeof(PackHeader) == 32, "PackHeader layout changed");
+    static_assert(sizeof(PackEntry) == 56, "PackEntry layout changed");
+
+    // Hash entries are looked up by, seed shared by every pack
+    u64 HashPackPath(std::string_view path);
+    // Whether entries with this codec can be read and written by this build
+    bool IsPackCompressionSupported(PackCompression compression);
+
+    // A mounted .sqpak, the whole file is mapped read only
+    class PackFile {
+    public:
+        PackFile() = default;
+        explicit PackFile(const std::string &path);
+
+        PackFile(const PackFile &) = delete;
+        PackFile &operator=(const PackFile &) = delete;
+
+        inline bool IsValid() const { return header != nullptr; }
+        inline u32 GetEntryCount() const { return header ? header->entry_count : 0; }
+        inline const PackEntry &GetEntry(u32 index) const { return entries[index]; }
+        std::string_view GetName(const PackEntry &entry) const;
+
+        // Null when the pack has no such file
+        const PackEntry *Find(std::string_view path) const;
+
+        // Stored data in the mapping, the file itself for entries without compression
+        inline const u8 *GetStoredData(const PackEntry &entry) const { return file.GetData() + entry.offset; }
+        // Decompresses into data, false when the entry is corrupt or its codec isn't built in
+        bool Decompress(const PackEntry &entry, std::vector<u8> &data) const;
+        // Checks the content hash of uncompressed data
+        static bool Verify(const PackEntry &entry, const u8 *data);
+
+    private:
+        MappedFile file;
+        const PackHeader *header = nullptr;
+        const PackEntry *entries = nullptr;
+        const char *names = nullptr;
+    };
+
+    // Packs every file under directory into a new pack at path, throws on failure. Files are added in path order
+    // without timestamps so the same input always produces the same pack. Compressed entries that don't get
+    // smaller are stored as is.
+    void WritePack(
+        const std::string &directory, const std::string &path, PackCompression compression = PACK_COMPRESSION_NONE);
+
+} // namespace Core
+} // namespace Squid
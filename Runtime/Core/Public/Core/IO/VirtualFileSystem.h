@@ -0,0 +1,81 @@
+#pragma once
+#include "../MappedFile.h"
+#include "../Types.h"
+#include "PackFile.h"
+
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace Squid {
+namespace Core {
+
+    // Contents of a file opened through the VirtualFileSystem. Loose files and uncompressed pack entries are views
+    // of a mapping, compressed entries are decompressed into memory the file owns.
+    class VfsFile {
+    public:
+        inline bool IsValid() const { return valid; }
+        inline const u8 *GetData() const { return data; }
+        inline u64 GetSize() const { return size; }
+        // False when the data had to be decompressed
+        inline bool IsMapped() const { return storage.empty(); }
+
+    private:
+        friend class VirtualFileSystem;
+
+        const u8 *data = nullptr;
+        u64 size = 0;
+        bool valid = false;
+
+        // One of these backs data, a pack stays mapped while any of its files is open
+        MappedFile mapping;
+        std::shared_ptr<const PackFile> pack;
+        std::vector<u8> storage;
+    };
+
+    // Resolves '/' separated asset paths such as "Assets/Shaders/unlit.vert.spv" against mounted directories and
+    // packs. Mounted directories overlay packs so loose files win during development, within each kind the latest
+    // mount wins. Lookups can run on any thread while nothing is being mounted.
+    class VirtualFileSystem {
+    public:
+        // Files under directory show up below mount_point, an empty mount point is the root
+        bool MountDirectory(const std::string &directory, const std::string &mount_point = "");
+        bool MountPack(const std::string &pack, const std::string &mount_point = "");
+        // Removes every mount of a directory or pack, open files keep their data
+        void Unmount(const std::string &source);
+
+        bool Exists(const std::string &path) const;
+        // True when a pack provides the file and no mounted directory overlays it
+        bool IsPacked(const std::string &path) const;
+
+        // Invalid when no mount has the file or a packed file is corrupt
+        VfsFile Open(const std::string &path) const;
+        // Throws when no mount has the file
+        std::string ReadTextFile(const std::string &path) const;
+
+    private:
+        struct Mount {
+            std::string source;
+            std::string mount_point;
+            std::shared_ptr<const PackFile> pack;
+        };
+
+        // Path below the mount point, false when path is elsewhere
+        static bool GetRelativePath(const Mount &mount, const std::string &path, std::string &relative);
+        // Disk path of the topmost loose file, empty when no mounted directory has it
+        std::string FindLoose(const std::string &path) const;
+        // Topmost pack with the file, entry is set when one is found
+        const Mount *FindPacked(const std::string &path, const PackEntry *&entry) const;
+
+        mutable std::shared_mutex mutex;
+        // Latest mount last
+        std::vector<Mount> directories;
+        std::vector<Mount> packs;
+    };
+
+    // Shared file system, nothing is mounted until the engine mounts its assets
+    VirtualFileSystem &GetFileSystem();
+
+} // namespace Core
+} // namespace Squid
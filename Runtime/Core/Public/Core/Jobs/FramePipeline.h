@@ -0,0 +1,68 @@
+#pragma once
+#include "../Types.h"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Squid {
+namespace Core {
+
+    // Splits every frame into a simulation half on the calling thread and a render half on a render thread. Frames
+    // are handed over through BUFFER_COUNT buffers the caller owns: the simulation fills GetWriteIndex() and Submits
+    // it, the render function gets that index while the simulation fills the other buffer. With latency 0 there is
+    // no render thread, Submit renders inline and only buffer 0 is used.
+    class FramePipeline {
+    public:
+        static constexpr u32 BUFFER_COUNT = 2;
+        static constexpr u32 MAX_LATENCY = BUFFER_COUNT - 1;
+
+        using RenderFunction = std::function<void(u32 index)>;
+
+        FramePipeline(RenderFunction render, u32 latency = MAX_LATENCY);
+        ~FramePipeline();
+        FramePipeline(const FramePipeline &) = delete;
+        FramePipeline &operator=(const FramePipeline &) = delete;
+
+        // Buffer the simulation writes the next frame into
+        inline u32 GetWriteIndex() const { return write_index; }
+
+        // Hands the written buffer to the render half. Waits for the frame before it first, so the simulation is at
+        // most latency frames ahead. Rethrows what the render function threw.
+        void Submit();
+
+        // Waits until everything submitted was rendered, the render thread touches nothing until the next Submit
+        void Flush();
+
+        // 0 renders on the calling thread, 1 on the render thread one frame behind
+        void SetLatency(u32 latency);
+        inline u32 GetLatency() const { return latency; }
+
+        // Time the last Submit waited for the render thread, in milliseconds
+        inline f64 GetWaitTime() const { return wait_time; }
+
+    private:
+        void Start();
+        void Stop();
+        void RenderLoop();
+        void WaitRendered(std::unique_lock<std::mutex> &lock);
+
+        RenderFunction render;
+        u32 latency;
+        u32 write_index = 0;
+        f64 wait_time = 0.0;
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable submitted_signal;
+        std::condition_variable rendered_signal;
+        u64 submitted = 0;
+        u64 rendered = 0;
+        bool quit = false;
+        std::exception_ptr error;
+    };
+
+} // namespace Core
+} // namespace Squid
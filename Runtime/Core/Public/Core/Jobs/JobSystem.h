@@ -0,0 +1,134 @@
+#pragma once
+#include "../Memory/MemoryTracker.h"
+#include "../Types.h"
+#include "SpinLock.h"
+#include "WorkStealingDeque.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Squid {
+namespace Core {
+
+    struct Job;
+
+    using JobFunction = std::function<void()>;
+    using RangeFunction = std::function<void(u32 begin, u32 end)>;
+
+    // Unfinished jobs of a group. Waiting on it helps running jobs, and jobs can be held back until it reaches zero.
+    class JobCounter {
+    public:
+        inline bool IsDone() const { return value.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<u32> value = 0;
+        SpinLock lock;
+        std::vector<Job *> waiting;
+        // First exception thrown by one of the jobs, rethrown by Wait
+        std::exception_ptr error;
+    };
+
+    struct Job {
+        JobFunction function;
+        // Ranges of one ParallelFor share the caller's function
+        const RangeFunction *range_function = nullptr;
+        u32 begin = 0;
+        u32 end = 0;
+        u32 grain = 1;
+
+        JobCounter *counter = nullptr;
+        const char *name = nullptr;
+        // Allocations of the job are charged to the tag of the thread that queued it
+        MemoryTag memory_tag = MEMORY_TAG_UNTAGGED;
+        // Slot flag in the allocating thread's queue, cleared once the job has run. Jobs without a slot,
+        // queued from foreign threads or while every slot is taken, live on the heap.
+        std::atomic<u8> *busy = nullptr;
+    };
+
+    // Fixed worker threads pinned one per core, each with a Chase-Lev deque. Threads push and pop their own jobs
+    // at the bottom and steal the oldest jobs of the others when they run dry. Workers spin briefly and then sleep
+    // until new work is queued. The constructing thread becomes thread 0 and only runs jobs while waiting.
+    class JobSystem {
+    public:
+        explicit JobSystem(u32 worker_count);
+        ~JobSystem();
+
+        // Queues function, the counter counts it until it has returned or thrown. With a dependency the job is held
+        // back until that counter reaches zero. Named jobs get a profiler scope on the thread that runs them.
+        void Run(
+            JobCounter &counter,
+            JobFunction function,
+            const char *name = nullptr,
+            JobCounter *dependency = nullptr);
+
+        // Queues function(begin, end) over [0, count). Ranges bigger than grain split in halves when they are
+        // picked up and idle threads steal the big halves, so the chunking follows the load. A grain of 0 picks
+        // one from the thread count. function must stay alive until the counter is done.
+        void ParallelFor(
+            JobCounter &counter, u32 count, u32 grain, const RangeFunction &function, const char *name = nullptr);
+
+        // Runs queued jobs on the calling thread until the counter is done, then rethrows the first exception
+        // thrown by its jobs
+        void Wait(JobCounter &counter);
+
+        inline u32 GetThreadCount() const { return u32(threads.size()) + 1; }
+        // Index of the calling thread in this system, INVALID_THREAD for threads it doesn't own
+        u32 GetThreadIndex() const;
+        u32 GetGrain(u32 count, u32 grain) const;
+
+        static constexpr u32 INVALID_THREAD = ~0u;
+        // Job slots and deque capacity per thread
+        static constexpr u32 MAX_JOBS_PER_THREAD = 4096;
+
+    private:
+        struct ThreadQueue {
+            WorkStealingDeque<Job, MAX_JOBS_PER_THREAD> deque;
+            Job jobs[MAX_JOBS_PER_THREAD];
+            std::atomic<u8> busy[MAX_JOBS_PER_THREAD] = {};
+            u32 next_job = 0;
+        };
+
+        Job *AllocateJob();
+        void Submit(Job *job);
+        void Execute(Job *job);
+        void Finish(JobCounter &counter);
+        Job *FindJob(u32 thread);
+        void WorkerLoop(u32 thread);
+
+        // One per thread, 0 belongs to the constructing thread
+        std::vector<std::unique_ptr<ThreadQueue>> queues;
+        std::vector<std::thread> threads;
+
+        // Jobs queued from foreign threads
+        std::mutex shared_mutex;
+        std::vector<Job *> shared_jobs;
+        std::atomic<u32> shared_count = 0;
+
+        // Queued jobs nobody picked up yet, sleeping workers wait for it to rise
+        std::atomic<u32> pending = 0;
+        std::atomic<u32> sleeping = 0;
+        std::mutex sleep_mutex;
+        std::condition_variable wake;
+        bool quit = false;
+    };
+
+    // Shared system with one thread per core, the first call creates it and should come from the main thread
+    JobSystem &GetJobSystem();
+
+    // ParallelFor on the shared system that waits for the result. The first exception thrown by function is
+    // rethrown once every range has finished.
+    void ParallelFor(u32 count, u32 grain, const RangeFunction &function, const char *name = nullptr);
+    // Same on the given system, benchmarks use it to compare thread counts
+    void ParallelFor(
+        JobSystem &system, u32 count, u32 grain, const RangeFunction &function, const char *name = nullptr);
+
+} // namespace Core
+} // namespace Squid
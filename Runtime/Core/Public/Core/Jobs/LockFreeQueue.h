@@ -0,0 +1,214 @@
+#pragma once
+#include "../Types.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace Squid {
+namespace Core {
+
+    // Bounded queues with a fixed, power of two capacity, all of it usable. Push returns false when full and Pop
+    // returns false when empty, neither ever blocks. Producer and consumer positions live on separate cache lines.
+
+    // Any number of producers and consumers, after "Bounded MPMC queue" (Vyukov). Each cell carries a sequence
+    // number telling whose turn it is, so producers and consumers only contend on their own position.
+    template <typename T, u32 capacity>
+    class MpmcQueue {
+        static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+        MpmcQueue() {
+            for (u32 i = 0; i < capacity; i++) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpmcQueue(const MpmcQueue &) = delete;
+        MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+        bool Push(T item) {
+            size_t position = push_position.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &cells[position & MASK];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const intptr_t difference = intptr_t(sequence) - intptr_t(position);
+
+                if (difference == 0) {
+                    if (push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                } else if (difference < 0) {
+                    // The consumer of the previous lap hasn't taken this cell yet
+                    return false;
+                } else {
+                    position = push_position.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->item = std::move(item);
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool Pop(T &item) {
+            size_t position = pop_position.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &cells[position & MASK];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const intptr_t difference = intptr_t(sequence) - intptr_t(position + 1);
+
+                if (difference == 0) {
+                    if (pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = pop_position.load(std::memory_order_relaxed);
+                }
+            }
+
+            item = std::move(cell->item);
+            cell->sequence.store(position + capacity, std::memory_order_release);
+            return true;
+        }
+
+        // Approximate while other threads are pushing or popping
+        inline size_t Size() const {
+            const size_t pushed = push_position.load(std::memory_order_relaxed);
+            const size_t popped = pop_position.load(std::memory_order_relaxed);
+            return pushed > popped ? pushed - popped : 0;
+        }
+
+    private:
+        static constexpr size_t MASK = capacity - 1;
+
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T item;
+        };
+
+        alignas(64) Cell cells[capacity];
+        alignas(64) std::atomic<size_t> push_position = 0;
+        alignas(64) std::atomic<size_t> pop_position = 0;
+    };
+
+    // Any number of producers, one consumer. Same cells as MpmcQueue, the consumer owns its position and never
+    // has to compare and swap.
+    template <typename T, u32 capacity>
+    class MpscQueue {
+        static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+        MpscQueue() {
+            for (u32 i = 0; i < capacity; i++) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscQueue(const MpscQueue &) = delete;
+        MpscQueue &operator=(const MpscQueue &) = delete;
+
+        bool Push(T item) {
+            size_t position = push_position.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &cells[position & MASK];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const intptr_t difference = intptr_t(sequence) - intptr_t(position);
+
+                if (difference == 0) {
+                    if (push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        break;
+                } else if (difference < 0) {
+                    return false;
+                } else {
+                    position = push_position.load(std::memory_order_relaxed);
+                }
+            }
+
+            cell->item = std::move(item);
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only
+        bool Pop(T &item) {
+            Cell &cell = cells[pop_position & MASK];
+            if (cell.sequence.load(std::memory_order_acquire) != pop_position + 1)
+                return false;
+
+            item = std::move(cell.item);
+            cell.sequence.store(pop_position + capacity, std::memory_order_release);
+            pop_position++;
+            return true;
+        }
+
+    private:
+        static constexpr size_t MASK = capacity - 1;
+
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T item;
+        };
+
+        alignas(64) Cell cells[capacity];
+        alignas(64) std::atomic<size_t> push_position = 0;
+        alignas(64) size_t pop_position = 0;
+    };
+
+    // One producer, one consumer. Each side keeps a cached copy of the other's position and only reloads it when
+    // the queue looks full or empty, so in steady state neither touches the other's cache line.
+    template <typename T, u32 capacity>
+    class SpscQueue {
+        static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+        SpscQueue() = default;
+        SpscQueue(const SpscQueue &) = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        // Producer only
+        bool Push(T item) {
+            const size_t position = push_position.load(std::memory_order_relaxed);
+            if (position - cached_pop_position == capacity) {
+                cached_pop_position = pop_position.load(std::memory_order_acquire);
+                if (position - cached_pop_position == capacity)
+                    return false;
+            }
+
+            items[position & MASK] = std::move(item);
+            push_position.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only
+        bool Pop(T &item) {
+            const size_t position = pop_position.load(std::memory_order_relaxed);
+            if (position == cached_push_position) {
+                cached_push_position = push_position.load(std::memory_order_acquire);
+                if (position == cached_push_position)
+                    return false;
+            }
+
+            item = std::move(items[position & MASK]);
+            pop_position.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        static constexpr size_t MASK = capacity - 1;
+
+        alignas(64) T items[capacity];
+        // Producer side
+        alignas(64) std::atomic<size_t> push_position = 0;
+        size_t cached_pop_position = 0;
+        // Consumer side
+        alignas(64) std::atomic<size_t> pop_position = 0;
+        size_t cached_push_position = 0;
+    };
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,63 @@
+#pragma once
+#include "../Types.h"
+
+#include <atomic>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SQUID_CPU_PAUSE() _mm_pause()
+#else
+#define SQUID_CPU_PAUSE() std::this_thread::yield()
+#endif
+
+namespace Squid {
+namespace Core {
+
+    // Exponential backoff for spin loops. Pauses double up to a limit, after that the thread yields its time slice
+    // so a preempted owner gets to run.
+    class Backoff {
+    public:
+        inline void Pause() {
+            if (spins <= MAX_SPINS) {
+                for (u32 i = 0; i < spins; i++) {
+                    SQUID_CPU_PAUSE();
+                }
+                spins *= 2;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        inline void Reset() { spins = 1; }
+
+    private:
+        static constexpr u32 MAX_SPINS = 64;
+        u32 spins = 1;
+    };
+
+    // Test and test-and-set lock for short critical sections. Waiters spin on a plain load so the cache line stays
+    // shared until the owner releases it.
+    class SpinLock {
+    public:
+        void lock() {
+            Backoff backoff;
+            while (!try_lock()) {
+                while (locked.load(std::memory_order_relaxed)) {
+                    backoff.Pause();
+                }
+            }
+        }
+
+        bool try_lock() {
+            return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock() { locked.store(false, std::memory_order_release); }
+
+    private:
+        std::atomic<bool> locked = false;
+    };
+
+} // namespace Core
+} // namespace Squid
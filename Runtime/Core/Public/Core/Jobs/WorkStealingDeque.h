@@ -0,0 +1,86 @@
+#pragma once
+#include "../Types.h"
+
+#include <atomic>
+
+namespace Squid {
+namespace Core {
+
+    // Chase-Lev deque with a fixed capacity, ordering as in "Correct and Efficient Work-Stealing for Weak Memory
+    // Models" (Le et al.). The owning thread pushes and pops at the bottom, any other thread steals from the top.
+    template <typename T, u32 capacity>
+    class WorkStealingDeque {
+        static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+    public:
+        WorkStealingDeque() {
+            for (auto &item : items) {
+                item.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        // Owner only, returns false when full
+        bool Push(T *item) {
+            const i64 b = bottom.load(std::memory_order_relaxed);
+            const i64 t = top.load(std::memory_order_acquire);
+            if (b - t >= i64(capacity))
+                return false;
+
+            items[b & MASK].store(item, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Owner only, newest item first
+        T *Pop() {
+            const i64 b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            i64 t = top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            T *item = items[b & MASK].load(std::memory_order_relaxed);
+            if (t == b) {
+                // Last item, race the thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    item = nullptr;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        // Any thread, oldest item first. Returns nullptr when empty or when another thread won the item.
+        T *Steal() {
+            i64 t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const i64 b = bottom.load(std::memory_order_acquire);
+
+            if (t >= b)
+                return nullptr;
+
+            T *item = items[t & MASK].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return item;
+        }
+
+        inline bool IsEmpty() const {
+            return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr i64 MASK = i64(capacity) - 1;
+
+        // Thieves and the owner hammer different ends, keep them on separate cache lines
+        alignas(64) std::atomic<i64> top = 0;
+        alignas(64) std::atomic<i64> bottom = 0;
+        alignas(64) std::atomic<T *> items[capacity];
+    };
+
+} // namespace Core
+} // namespace Squid
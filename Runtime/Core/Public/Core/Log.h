@@ -1,12 +1,41 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 
 #include <spdlog/spdlog.h>
+#include <spdlog/details/os.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include "spdlog/sinks/base_sink.h"
 #include "spdlog/details/null_mutex.h"
 #include <mutex>
 
+#include "Types.h"
+
+// Messages below SQUID_LOG_LEVEL are compiled out, their arguments are never evaluated
+#define SQUID_LOG_LEVEL_DEBUG 1
+#define SQUID_LOG_LEVEL_INFO 2
+#define SQUID_LOG_LEVEL_WARN 3
+#define SQUID_LOG_LEVEL_ERROR 4
+#define SQUID_LOG_LEVEL_CRITICAL 5
+#define SQUID_LOG_LEVEL_OFF 6
+
+#ifndef SQUID_LOG_LEVEL
+#ifdef NDEBUG
+#define SQUID_LOG_LEVEL SQUID_LOG_LEVEL_INFO
+#else
+#define SQUID_LOG_LEVEL SQUID_LOG_LEVEL_DEBUG
+#endif
+#endif
+
 namespace Squid {
 namespace Core {
 
@@ -15,7 +44,7 @@ namespace Core {
     protected:
         void sink_it_(const spdlog::details::log_msg &msg) override {
             spdlog::memory_buf_t formatted;
-            base_sink<Mutex>::formatter_->format(msg, formatted);
+            spdlog::sinks::base_sink<Mutex>::formatter_->format(msg, formatted);
             std::cout << "custom > " << fmt::to_string(formatted);
         }
 
@@ -25,13 +54,269 @@ namespace Core {
     using sink_mt = CustomSink<std::mutex>;
     using sink_st = CustomSink<spdlog::details::null_mutex>;
 
-    void InitializeLogger(std::string name);
-}; // namespace Core
+    enum class LogMode : u8 {
+        // Messages are formatted and written on the calling thread
+        SYNC,
+        // Callers only copy the arguments into a per thread buffer, the logger thread formats and writes them
+        ASYNC
+    };
+
+    void InitializeLogger(std::string name, LogMode mode = LogMode::ASYNC);
+
+    // Sinks can be added and removed while other threads log, they receive messages from then on
+    void AddLogSink(std::shared_ptr<spdlog::sinks::sink> sink);
+    void RemoveLogSink(std::shared_ptr<spdlog::sinks::sink> sink);
+
+    // A message waiting for the logger thread. The arguments are constructed in storage and never move, strings are
+    // copied in behind them.
+    struct LogRecord {
+        // Formats the arguments into buffer and destroys them
+        using FormatFunction = void (*)(LogRecord &record, spdlog::memory_buf_t &buffer);
+
+        static constexpr size_t STORAGE_SIZE = 192;
+
+        FormatFunction format;
+        const char *text;
+        spdlog::log_clock::time_point time;
+        size_t thread_id;
+        spdlog::source_loc location;
+        spdlog::level::level_enum level;
+        alignas(16) u8 storage[STORAGE_SIZE];
+    };
+
+    // Single producer, single consumer ring of records owned by one logging thread. Records are filled and read in
+    // place, so unlike SpscQueue nothing is copied in or out.
+    class LogBuffer {
+    public:
+        static constexpr u32 CAPACITY = 512;
+
+        // Producer, null when the logger thread is a whole buffer behind
+        inline LogRecord *Reserve() {
+            const u32 position = push_position.load(std::memory_order_relaxed);
+            if (position - cached_pop_position == CAPACITY) {
+                cached_pop_position = pop_position.load(std::memory_order_acquire);
+                if (position - cached_pop_position == CAPACITY)
+                    return nullptr;
+            }
+            return &records[position & MASK];
+        }
+
+        inline void Publish() {
+            push_position.store(push_position.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Consumer, null when empty
+        inline LogRecord *Peek() {
+            const u32 position = pop_position.load(std::memory_order_relaxed);
+            if (position == push_position.load(std::memory_order_acquire))
+                return nullptr;
+            return &records[position & MASK];
+        }
+
+        inline void Release() {
+            pop_position.store(pop_position.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Messages lost to a full buffer, reported by the logger thread
+        std::atomic<u64> dropped = 0;
+        // Set when the owning thread exits, the buffer is freed once drained
+        std::atomic<bool> retired = false;
+
+    private:
+        static constexpr u32 MASK = CAPACITY - 1;
+
+        std::unique_ptr<LogRecord[]> records = std::make_unique<LogRecord[]>(CAPACITY);
+        // Producer side
+        alignas(64) std::atomic<u32> push_position = 0;
+        u32 cached_pop_position = 0;
+        // Consumer side
+        alignas(64) std::atomic<u32> pop_position = 0;
+    };
+
+    // Staging buffer of the calling thread, null while logging synchronously
+    LogBuffer *GetThreadLogBuffer();
+    // Wakes the logger thread instead of letting it find the message on its next pass
+    void WakeLogger();
+
+    // Strings are captured as views of a copy in the record, everything else by value
+    template <typename T>
+    using LogArgument = std::conditional_t<
+        std::is_convertible_v<const std::decay_t<T> &, std::string_view> &&
+            !std::is_same_v<std::decay_t<T>, std::nullptr_t>,
+        std::string_view,
+        std::decay_t<T>>;
+
+    template <typename... Args>
+    inline void FormatLogMessage(spdlog::memory_buf_t &buffer, const char *text, Args &...values) {
+        fmt::vformat_to(std::back_inserter(buffer), text, fmt::make_format_args(values...));
+    }
+
+    template <typename Arguments>
+    void FormatLogRecord(LogRecord &record, spdlog::memory_buf_t &buffer) {
+        Arguments &arguments = *(Arguments *)record.storage;
+        try {
+            std::apply([&](auto &...values) { FormatLogMessage(buffer, record.text, values...); }, arguments);
+        } catch (const std::exception &error) {
+            buffer.clear();
+            buffer.append(std::string_view("log format error: "));
+            buffer.append(std::string_view(error.what()));
+        }
+        arguments.~Arguments();
+    }
+
+    template <typename T>
+    inline size_t GetLogArgumentSize(const T &value) {
+        if constexpr (std::is_same_v<LogArgument<T>, std::string_view>)
+            return std::string_view(value).size();
+        else
+            return 0;
+    }
+
+    template <typename T>
+    inline LogArgument<T> CaptureLogArgument(T &&value, u8 *&cursor) {
+        if constexpr (std::is_same_v<LogArgument<T>, std::string_view>) {
+            const std::string_view text(value);
+            memcpy(cursor, text.data(), text.size());
+            cursor += text.size();
+            return std::string_view((const char *)cursor - text.size(), text.size());
+        } else {
+            return std::forward<T>(value);
+        }
+    }
+
+    template <typename... Args>
+    void Log(spdlog::level::level_enum level, spdlog::source_loc location, const char *text, Args &&...values) {
+        spdlog::logger *logger = spdlog::default_logger_raw();
+        if (!logger->should_log(level))
+            return;
+
+        LogBuffer *staging = GetThreadLogBuffer();
+        LogRecord *record = staging ? staging->Reserve() : nullptr;
+
+        if (!record) {
+            // A full buffer drops anything below errors rather than stall the caller
+            if (staging && level < spdlog::level::err) {
+                staging->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            spdlog::memory_buf_t buffer;
+            FormatLogMessage(buffer, text, values...);
+            logger->log(location, level, spdlog::string_view_t(buffer.data(), buffer.size()));
+            return;
+        }
+
+        record->level = level;
+        record->location = location;
+        record->time = spdlog::log_clock::now();
+        record->thread_id = spdlog::details::os::thread_id();
+
+        using Arguments = std::tuple<LogArgument<Args>...>;
+        static_assert(alignof(Arguments) <= alignof(LogRecord), "log argument is over aligned");
+
+        if (sizeof(Arguments) + (GetLogArgumentSize(values) + ... + 0) <= LogRecord::STORAGE_SIZE) {
+            [[maybe_unused]] u8 *cursor = record->storage + sizeof(Arguments);
+            new (record->storage) Arguments{CaptureLogArgument(std::forward<Args>(values), cursor)...};
+            record->text = text;
+            record->format = &FormatLogRecord<Arguments>;
+        } else {
+            // Long messages are formatted up front into a string the record owns
+            using Text = std::tuple<std::string>;
+            spdlog::memory_buf_t buffer;
+            FormatLogMessage(buffer, text, values...);
+
+            new (record->storage) Text{std::string(buffer.data(), buffer.size())};
+            record->text = "{}";
+            record->format = &FormatLogRecord<Text>;
+        }
+
+        staging->Publish();
+
+        if (level >= spdlog::level::err)
+            WakeLogger();
+    }
+
+    // Lets a call site through at most once per interval and counts what it held back
+    class LogRateLimiter {
+    public:
+        inline bool Allow(i64 interval_ms, u64 &suppressed) {
+            const i64 now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch())
+                                .count();
+
+            i64 next = next_time.load(std::memory_order_relaxed);
+            if (now < next || !next_time.compare_exchange_strong(next, now + interval_ms)) {
+                skipped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            suppressed = skipped.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+
+    private:
+        std::atomic<i64> next_time = 0;
+        std::atomic<u64> skipped = 0;
+    };
+
+} // namespace Core
 } // namespace Squid
 
-#define LOG(text, ...) spdlog::info(text, __VA_ARGS__);
-#define LOG_DEBUG(text, ...) spdlog::debug(text, __VA_ARGS__);
-#define LOG_INFO(text, ...) spdlog::info(text, __VA_ARGS__);
-#define LOG_WARN(text, ...) spdlog::warn(text, __VA_ARGS__);
-#define LOG_ERROR(text, ...) spdlog::error(text, __VA_ARGS__);
-#define LOG_CRITICAL(text, ...) spdlog::critical(text, __VA_ARGS__);
\ No newline at end of file
+#define SQUID_LOG_LOCATION                                                                                             \
+    spdlog::source_loc { __FILE__, __LINE__, SPDLOG_FUNCTION }
+
+#define SQUID_LOG(level, text, ...) ::Squid::Core::Log(level, SQUID_LOG_LOCATION, text, ##__VA_ARGS__);
+
+#define SQUID_LOG_EVERY(level, interval_ms, text, ...)                                                                \
+    do {                                                                                                               \
+        static ::Squid::Core::LogRateLimiter squid_log_limiter;                                                        \
+        u64 squid_log_suppressed;                                                                                      \
+        if (squid_log_limiter.Allow(interval_ms, squid_log_suppressed)) {                                              \
+            ::Squid::Core::Log(level, SQUID_LOG_LOCATION, text, ##__VA_ARGS__);                                        \
+            if (squid_log_suppressed)                                                                                  \
+                ::Squid::Core::Log(                                                                                    \
+                    level, SQUID_LOG_LOCATION, "{} similar messages suppressed", squid_log_suppressed);                \
+        }                                                                                                              \
+    } while (false);
+
+#define SQUID_LOG_STRIPPED (void)0;
+
+#if SQUID_LOG_LEVEL <= SQUID_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(text, ...) SQUID_LOG(spdlog::level::debug, text, ##__VA_ARGS__)
+#define LOG_DEBUG_EVERY(interval_ms, text, ...) SQUID_LOG_EVERY(spdlog::level::debug, interval_ms, text, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(text, ...) SQUID_LOG_STRIPPED
+#define LOG_DEBUG_EVERY(interval_ms, text, ...) SQUID_LOG_STRIPPED
+#endif
+
+#if SQUID_LOG_LEVEL <= SQUID_LOG_LEVEL_INFO
+#define LOG(text, ...) SQUID_LOG(spdlog::level::info, text, ##__VA_ARGS__)
+#define LOG_INFO(text, ...) SQUID_LOG(spdlog::level::info, text, ##__VA_ARGS__)
+#define LOG_INFO_EVERY(interval_ms, text, ...) SQUID_LOG_EVERY(spdlog::level::info, interval_ms, text, ##__VA_ARGS__)
+#else
+#define LOG(text, ...) SQUID_LOG_STRIPPED
+#define LOG_INFO(text, ...) SQUID_LOG_STRIPPED
+#define LOG_INFO_EVERY(interval_ms, text, ...) SQUID_LOG_STRIPPED
+#endif
+
+#if SQUID_LOG_LEVEL <= SQUID_LOG_LEVEL_WARN
+#define LOG_WARN(text, ...) SQUID_LOG(spdlog::level::warn, text, ##__VA_ARGS__)
+#define LOG_WARN_EVERY(interval_ms, text, ...) SQUID_LOG_EVERY(spdlog::level::warn, interval_ms, text, ##__VA_ARGS__)
+#else
+#define LOG_WARN(text, ...) SQUID_LOG_STRIPPED
+#define LOG_WARN_EVERY(interval_ms, text, ...) SQUID_LOG_STRIPPED
+#endif
+
+#if SQUID_LOG_LEVEL <= SQUID_LOG_LEVEL_ERROR
+#define LOG_ERROR(text, ...) SQUID_LOG(spdlog::level::err, text, ##__VA_ARGS__)
+#define LOG_ERROR_EVERY(interval_ms, text, ...) SQUID_LOG_EVERY(spdlog::level::err, interval_ms, text, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(text, ...) SQUID_LOG_STRIPPED
+#define LOG_ERROR_EVERY(interval_ms, text, ...) SQUID_LOG_STRIPPED
+#endif
+
+#if SQUID_LOG_LEVEL <= SQUID_LOG_LEVEL_CRITICAL
+#define LOG_CRITICAL(text, ...) SQUID_LOG(spdlog::level::critical, text, ##__VA_ARGS__)
+#else
+#define LOG_CRITICAL(text, ...) SQUID_LOG_STRIPPED
+#endif
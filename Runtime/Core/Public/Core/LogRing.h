@@ -0,0 +1,85 @@
+#pragma once
+#include "Log.h"
+#include "Types.h"
+
+#include <atomic>
+#include <memory>
+#include <string_view>
+
+namespace Squid {
+namespace Core {
+
+    // One line of a log message as kept by the LogRing
+    struct LogEntry {
+        static constexpr size_t MODULE_SIZE = 16;
+        static constexpr size_t TEXT_SIZE = 200;
+
+        spdlog::log_clock::time_point time;
+        size_t thread_id;
+        spdlog::level::level_enum level;
+        // Set when the line was longer than TEXT_SIZE
+        bool truncated;
+        u16 length;
+        // Module directory the message was logged from, such as "Renderer"
+        char module[MODULE_SIZE];
+        char text[TEXT_SIZE];
+
+        inline std::string_view GetText() const { return std::string_view(text, length); }
+        inline std::string_view GetModule() const { return std::string_view(module); }
+    };
+
+    // Keeps the last CAPACITY log lines in fixed memory. Lines are numbered from zero as they are pushed, a reader
+    // looks them up by number while the writer keeps going and finds out when a line it wanted was overwritten.
+    class LogRing {
+    public:
+        static constexpr u64 CAPACITY = 16384;
+
+        LogRing();
+        LogRing(const LogRing &) = delete;
+        LogRing &operator=(const LogRing &) = delete;
+
+        // Single writer, the sink serializes its callers
+        void Push(const LogEntry &entry);
+
+        // Lines still held are numbered [GetFirst(), GetEnd())
+        inline u64 GetEnd() const { return end.load(std::memory_order_acquire); }
+        inline u64 GetFirst() const {
+            const u64 count = GetEnd();
+            return count > CAPACITY ? count - CAPACITY : 0;
+        }
+
+        // Copies a line, false when it was overwritten or is being written
+        bool Read(u64 index, LogEntry &entry) const;
+
+    private:
+        static constexpr u64 MASK = CAPACITY - 1;
+        static_assert((CAPACITY & MASK) == 0, "capacity must be a power of two");
+
+        // The sequence is odd while the slot is written and 2 * (index + 1) once it holds line index
+        struct Slot {
+            std::atomic<u64> sequence = 0;
+            LogEntry entry;
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        alignas(64) std::atomic<u64> end = 0;
+    };
+
+    // Shared ring the editor shows, only filled once a LogRingSink is added
+    LogRing &GetLogRing();
+
+    // Splits messages into lines and pushes them into a ring along with their level, module and thread
+    class LogRingSink : public spdlog::sinks::base_sink<std::mutex> {
+    public:
+        explicit LogRingSink(LogRing &ring) : ring(ring) {}
+
+    protected:
+        void sink_it_(const spdlog::details::log_msg &msg) override;
+        void flush_() override {}
+
+    private:
+        LogRing &ring;
+    };
+
+} // namespace Core
+} // namespace Squid
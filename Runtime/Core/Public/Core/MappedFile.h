@@ -0,0 +1,37 @@
+#pragma once
+#include "Types.h"
+#include <string>
+
+namespace Squid {
+namespace Core {
+
+    // Read only memory mapping of a whole file, unmapped on destruction
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const std::string &path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        inline bool IsValid() const { return data != nullptr; }
+        inline const u8 *GetData() const { return data; }
+        inline u64 GetSize() const { return size; }
+
+    private:
+        void Close();
+
+        const u8 *data = nullptr;
+        u64 size = 0;
+
+#ifdef SQUID_WIN32
+        void *file_handle = nullptr;
+        void *mapping_handle = nullptr;
+#endif
+    };
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,73 @@
+#pragma once
+#include "../Memory/StlAllocator.h"
+#include "../Types.h"
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Squid {
+namespace Core {
+
+    // Dynamic AABB tree over moving boxes. Leaves keep the exact box plus a fattened one the tree is built from,
+    // so small motions inside the fat box cost nothing and bigger ones reinsert the leaf. Insertions pick the
+    // sibling by surface area and the tree is kept height balanced with rotations.
+    class DynamicBvh {
+    public:
+        static constexpr u32 INVALID_NODE = ~0u;
+
+        // Returns the proxy of the new leaf
+        u32 Insert(const glm::vec3 &min, const glm::vec3 &max, u32 user_data);
+        void Remove(u32 proxy);
+
+        // Updates the exact box, returns whether the leaf had to be reinserted
+        bool Move(u32 proxy, const glm::vec3 &min, const glm::vec3 &max);
+
+        inline u32 GetUserData(u32 proxy) const { return nodes[proxy].user_data; }
+        inline u32 GetLeafCount() const { return leaf_count; }
+        u32 GetHeight() const { return root != INVALID_NODE ? u32(nodes[root].height) : 0; }
+
+        // Appends the user data of every leaf whose box touches the six normalized, inward facing planes.
+        // Big trees are split into subtrees that the job system walks in parallel, the order is unspecified.
+        // Scratch lists of the parallel walk come from the frame allocator as well.
+        void QueryFrustum(const glm::vec4 *planes, FrameVector<u32> &results) const;
+
+        // User data of the closest leaf the ray enters within max_distance or INVALID_NODE,
+        // direction does not need to be normalized, distances are in units of its length
+        u32 RayCast(const glm::vec3 &origin, const glm::vec3 &direction, f32 max_distance, f32 *distance = nullptr)
+            const;
+
+    private:
+        struct Node {
+            glm::vec3 min;
+            u32 parent = INVALID_NODE; // next free node while on the free list
+            glm::vec3 max;
+            i32 height = 0;            // 0 for leaves, -1 for free nodes
+            u32 children[2] = {INVALID_NODE, INVALID_NODE};
+            u32 user_data = 0;
+            u32 padding = 0;
+            glm::vec3 leaf_min; // exact box of leaves
+            glm::vec3 leaf_max;
+
+            inline bool IsLeaf() const { return children[0] == INVALID_NODE; }
+        };
+
+        u32 AllocateNode();
+        void FreeNode(u32 index);
+
+        void InsertLeaf(u32 leaf);
+        void RemoveLeaf(u32 leaf);
+        // Walks from index to the root rebalancing and refitting every ancestor
+        void Refit(u32 index);
+        u32 Balance(u32 index);
+
+        void QueryFrustum(u32 index, const glm::vec4 *planes, FrameVector<u32> &results) const;
+        void CollectLeaves(u32 index, FrameVector<u32> &results) const;
+
+        std::vector<Node> nodes;
+        u32 root = INVALID_NODE;
+        u32 free_list = INVALID_NODE;
+        u32 leaf_count = 0;
+    };
+
+} // namespace Core
+} // namespace Squid
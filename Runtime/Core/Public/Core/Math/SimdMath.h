@@ -0,0 +1,131 @@
+#pragma once
+#include "../Types.h"
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SQUID_SIMD_SSE
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SQUID_SIMD_AVX2
+#endif
+
+namespace Squid {
+namespace Core {
+
+    // Batch kernels for transforms and bounds. They take structure of arrays streams where it pays off
+    // and run 8 wide with AVX2, 4 wide with SSE and scalar otherwise, picked at compile time.
+
+    struct TransformStreams {
+        const f32 *translation[3];
+        const f32 *rotation[4]; // normalized quaternion x, y, z, w
+        const f32 *scale[3];
+    };
+
+    struct SphereStreams {
+        const f32 *center[3];
+        const f32 *radius;
+    };
+
+    // One stream per matrix element, columns[c][r] is row r of column c like glm::mat4
+    struct MatrixStreams {
+        const f32 *columns[4][4];
+    };
+
+    struct MatrixOutputStreams {
+        f32 *columns[4][4];
+    };
+
+    struct AabbStreams {
+        const f32 *min[3];
+        const f32 *max[3];
+    };
+
+    struct AabbOutputStreams {
+        f32 *min[3];
+        f32 *max[3];
+    };
+
+    // Same matrix as translate(translation) * mat4_cast(rotation) * scale(scale), without the two products
+    inline glm::mat4 ComposeTransform(const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale) {
+        const f32 x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+
+        glm::mat4 matrix;
+        matrix[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f);
+        matrix[1] = glm::vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f);
+        matrix[2] = glm::vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+        matrix[0] *= scale.x;
+        matrix[1] *= scale.y;
+        matrix[2] *= scale.z;
+        matrix[3] = glm::vec4(translation, 1.0f);
+        return matrix;
+    }
+
+    // result = a * b, result must not alias the inputs
+    inline void MultiplyMatrix(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &result) {
+#ifdef SQUID_SIMD_SSE
+        const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+        const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+        const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+        const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+        for (u32 column = 0; column < 4; column++) {
+            const f32 *bc = &b[column][0];
+            __m128 r = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+            r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+            r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+            r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+            _mm_storeu_ps(&result[column][0], r);
+        }
+#else
+        result = a * b;
+#endif
+    }
+
+    // Planes of the clip volume of clip = projection * view * model in the space model maps from, normalized and
+    // facing inward. Near uses the wider -w <= z of the two depth conventions so it never culls anything visible.
+    inline void ExtractFrustumPlanes(const glm::mat4 &clip, glm::vec4 *planes) {
+        auto row = [&](u32 i) { return glm::vec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]); };
+
+        planes[0] = row(3) + row(0);
+        planes[1] = row(3) - row(0);
+        planes[2] = row(3) + row(1);
+        planes[3] = row(3) - row(1);
+        planes[4] = row(3) + row(2);
+        planes[5] = row(3) - row(2);
+
+        for (u32 i = 0; i < 6; i++) {
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+        }
+    }
+
+    void ComposeTransforms(const TransformStreams &transforms, glm::mat4 *matrices, size_t count);
+
+    // result[i] = a[i] * b[i], result must not alias the inputs
+    void MultiplyMatrices(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *result, size_t count);
+    // Same over streams, a full register of products per iteration
+    void MultiplyMatrices(
+        const MatrixStreams &a, const MatrixStreams &b, const MatrixOutputStreams &result, size_t count);
+
+    // Box around each local box transformed by its matrix, the outputs may alias the inputs
+    void TransformAabbs(
+        const glm::mat4 *matrices,
+        const glm::vec3 *min,
+        const glm::vec3 *max,
+        glm::vec3 *out_min,
+        glm::vec3 *out_max,
+        size_t count);
+    // Same over streams, a full register of boxes per iteration. Only the top three rows of the matrices are read,
+    // the bottom row streams may be null.
+    void TransformAabbs(
+        const MatrixStreams &matrices, const AabbStreams &boxes, const AabbOutputStreams &out, size_t count);
+
+    // visible[i] is 1 when sphere i reaches inside all six normalized, inward facing planes (xyz normal, w distance)
+    void TestSpheresFrustum(const glm::vec4 *planes, const SphereStreams &spheres, u8 *visible, size_t count);
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,21 @@
+#pragma once
+#include "../Types.h"
+
+namespace Squid {
+namespace Core {
+
+    // Heap allocations made through operator new so far, by any thread. Only counted when built with
+    // SQUID_COUNT_ALLOCATIONS, always zero otherwise. The global operator new is replaced with this or
+    // SQUID_TRACK_MEMORY, see MemoryTracker.h.
+    u64 GetHeapAllocationCount();
+
+    inline constexpr bool IsCountingAllocations() {
+#ifdef SQUID_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,65 @@
+#pragma once
+#include "../Jobs/SpinLock.h"
+#include "../Types.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Squid {
+namespace Core {
+
+    // Frames the renderer keeps in flight, the swapchain has as many backbuffers
+    static constexpr u32 MAX_FRAMES_IN_FLIGHT = 3;
+
+    // Linear memory for data that lives until its frame slot comes around again, MAX_FRAMES_IN_FLIGHT frames later.
+    // BeginFrame is called by the render half of the main loop once the GPU is done with the slot it reuses. Any
+    // thread can allocate, also while BeginFrame runs: the simulation building the next frame gets the old or the new
+    // slot and both stay valid until that frame was rendered.
+    class FrameAllocator {
+    public:
+        static constexpr u64 DEFAULT_FRAME_SIZE = 4 * 1024 * 1024;
+
+        explicit FrameAllocator(u64 frame_size = DEFAULT_FRAME_SIZE);
+        ~FrameAllocator();
+        FrameAllocator(const FrameAllocator &) = delete;
+        FrameAllocator &operator=(const FrameAllocator &) = delete;
+
+        void *Allocate(u64 size, u64 alignment = alignof(std::max_align_t));
+        // Single allocations aren't freed, the whole frame is
+        inline void Deallocate(void *, u64) {}
+
+        // Moves to the next slot and frees everything allocated in it. Only the render half of the main loop calls it.
+        void BeginFrame();
+
+        inline u32 GetFrameIndex() const { return current.load(std::memory_order_relaxed); }
+        // Bytes allocated in the current frame, without the heap fallback
+        inline u64 GetUsed() const {
+            return frames[GetFrameIndex()].offset.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Overflow {
+            void *memory;
+            u64 alignment;
+        };
+
+        struct Frame {
+            u8 *data = nullptr;
+            std::atomic<u64> offset = 0;
+            // Allocations that didn't fit, taken from the heap and freed with the frame
+            std::vector<Overflow> overflow;
+        };
+
+        Frame frames[MAX_FRAMES_IN_FLIGHT];
+        std::atomic<u32> current = 0;
+        u64 frame_size;
+
+        SpinLock overflow_lock;
+    };
+
+    // Shared allocator the main loop advances every frame
+    FrameAllocator &GetFrameAllocator();
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,78 @@
+#pragma once
+#include "../Types.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace Squid {
+namespace Core {
+
+    // Bump allocator over a chain of blocks, for a single thread. Memory is only given back by rewinding to a marker
+    // or by Reset. Blocks are kept for reuse, so a steady workload stops allocating once it has reached its peak.
+    class LinearAllocator {
+    public:
+        static constexpr u64 DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        struct Marker {
+            u32 block;
+            u64 offset;
+        };
+
+        explicit LinearAllocator(u64 block_size = DEFAULT_BLOCK_SIZE);
+        ~LinearAllocator();
+        LinearAllocator(const LinearAllocator &) = delete;
+        LinearAllocator &operator=(const LinearAllocator &) = delete;
+
+        void *Allocate(u64 size, u64 alignment = alignof(std::max_align_t));
+        // Single allocations aren't freed, see Rewind
+        inline void Deallocate(void *, u64) {}
+
+        inline Marker GetMarker() const { return {current, offset}; }
+        // Frees everything allocated since the marker was taken
+        inline void Rewind(Marker marker) {
+            current = marker.block;
+            offset = marker.offset;
+        }
+        inline void Reset() { Rewind({0, 0}); }
+
+        // Bytes held in blocks, used or not
+        u64 GetCapacity() const;
+
+    private:
+        struct Block {
+            u8 *data;
+            u64 size;
+        };
+
+        std::vector<Block> blocks;
+        u32 current = 0;
+        u64 offset = 0;
+        u64 block_size;
+    };
+
+    // The calling thread's allocator for temporaries, use it through a ScratchScope
+    LinearAllocator &GetScratchAllocator();
+
+    // Rewinds the thread's scratch allocator when the scope ends. A container that takes memory from the outer scope
+    // must not grow while an inner scope is open, its new storage would be freed with the inner scope.
+    class ScratchScope {
+    public:
+        ScratchScope() : allocator(GetScratchAllocator()), marker(allocator.GetMarker()) {}
+        ~ScratchScope() { allocator.Rewind(marker); }
+        ScratchScope(const ScratchScope &) = delete;
+        ScratchScope &operator=(const ScratchScope &) = delete;
+
+        // Uninitialized storage for count objects
+        template <typename T> inline T *Allocate(u64 count) {
+            return static_cast<T *>(allocator.Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        inline LinearAllocator &GetAllocator() { return allocator; }
+
+    private:
+        LinearAllocator &allocator;
+        LinearAllocator::Marker marker;
+    };
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,94 @@
+#pragma once
+#include "../Types.h"
+
+#include <string>
+#include <vector>
+
+namespace Squid {
+namespace Core {
+
+    // Subsystem an allocation is charged to, taken from the allocating thread's MemoryTagScope
+    enum MemoryTag : u8 {
+        MEMORY_TAG_UNTAGGED,
+        MEMORY_TAG_RHI,
+        MEMORY_TAG_RENDERER,
+        MEMORY_TAG_ECS,
+        MEMORY_TAG_EDITOR,
+        MEMORY_TAG_ASSETS,
+        MEMORY_TAG_COUNT
+    };
+
+    const char *GetMemoryTagName(MemoryTag tag);
+
+    // Tracking replaces the global operator new and is only built with SQUID_TRACK_MEMORY, everything below is
+    // empty otherwise
+    inline constexpr bool IsTrackingMemory() {
+#ifdef SQUID_TRACK_MEMORY
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Tag of the allocations the calling thread makes
+    MemoryTag GetMemoryTag();
+    void SetMemoryTag(MemoryTag tag);
+
+    // Charges the thread's allocations to tag until the scope ends
+    class MemoryTagScope {
+    public:
+        explicit MemoryTagScope(MemoryTag tag) : previous(GetMemoryTag()) { SetMemoryTag(tag); }
+        ~MemoryTagScope() { SetMemoryTag(previous); }
+        MemoryTagScope(const MemoryTagScope &) = delete;
+        MemoryTagScope &operator=(const MemoryTagScope &) = delete;
+
+    private:
+        MemoryTag previous;
+    };
+
+    struct MemoryTagStats {
+        u64 live_bytes = 0;
+        u64 live_allocations = 0;
+        // Highest live bytes seen by SampleMemoryStats
+        u64 peak_bytes = 0;
+        u64 total_allocations = 0;
+        u64 total_bytes = 0;
+        // Over the last full second of samples
+        f64 allocations_per_second = 0.0;
+        f64 bytes_per_second = 0.0;
+    };
+
+    struct MemoryStats {
+        MemoryTagStats tags[MEMORY_TAG_COUNT];
+    };
+
+    // Sums the per thread counters into the stats GetMemoryStats returns, meant to be called once a frame
+    void SampleMemoryStats();
+    MemoryStats GetMemoryStats();
+
+    // Captures the callstack of every nth allocation to find out where live memory came from, 0 turns it off.
+    // Samples are dropped when their allocation is freed, what's left after a while points at leaks.
+    void SetMemorySampleRate(u32 every);
+    u32 GetMemorySampleRate();
+
+    // Live sampled allocations with the same callstack, biggest first
+    struct MemoryCallstack {
+        MemoryTag tag;
+        u64 bytes = 0;
+        u64 allocations = 0;
+        std::vector<void *> frames;
+    };
+
+    std::vector<MemoryCallstack> GetLiveCallstacks(u32 max_count);
+    // One readable line per frame, bare addresses where there are no symbols
+    std::vector<std::string> SymbolizeCallstack(const std::vector<void *> &frames);
+
+    // Writes the last stats and the live callstacks as JSON, throws when the file can't be written
+    void DumpMemoryStats(const std::string &path);
+
+    // Allocation hooks of the operator new replacement, they keep a header in front of every allocation
+    void *TrackedAllocate(size_t size, size_t alignment);
+    void TrackedFree(void *memory);
+
+} // namespace Core
+} // namespace Squid
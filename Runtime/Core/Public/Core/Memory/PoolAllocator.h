@@ -0,0 +1,72 @@
+#pragma once
+#include "../Types.h"
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Squid {
+namespace Core {
+
+    // Fixed size blocks carved from chunks that are kept until the pool is destroyed. Freed blocks are handed out
+    // again first, so objects that come and go every frame stop allocating once the pool has grown. Not thread safe.
+    class PoolAllocator {
+    public:
+        PoolAllocator(u64 block_size, u64 alignment = alignof(std::max_align_t), u32 blocks_per_chunk = 256);
+        ~PoolAllocator();
+        PoolAllocator(const PoolAllocator &) = delete;
+        PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+        void *Allocate();
+        void Free(void *block);
+
+        // Same as above for StlAllocator, the size can't be more than a block
+        inline void *Allocate(u64 size, u64 alignment) {
+            assert(size <= block_size && alignment <= this->alignment);
+            return Allocate();
+        }
+        inline void Deallocate(void *block, u64) { Free(block); }
+
+        inline u64 GetBlockSize() const { return block_size; }
+        // Blocks currently handed out
+        inline u64 GetAllocatedCount() const { return allocated; }
+
+    private:
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+
+        void AddChunk();
+
+        FreeBlock *free_list = nullptr;
+        std::vector<u8 *> chunks;
+
+        u64 block_size;
+        u64 alignment;
+        u32 blocks_per_chunk;
+        u64 allocated = 0;
+    };
+
+    // Pool of objects of a single type
+    template <typename T> class TypedPool {
+    public:
+        explicit TypedPool(u32 blocks_per_chunk = 256) : pool(sizeof(T), alignof(T), blocks_per_chunk) {}
+
+        template <typename... Args> inline T *Create(Args &&...args) {
+            return new (pool.Allocate()) T(std::forward<Args>(args)...);
+        }
+
+        inline void Destroy(T *object) {
+            object->~T();
+            pool.Free(object);
+        }
+
+        inline u64 GetAllocatedCount() const { return pool.GetAllocatedCount(); }
+
+    private:
+        PoolAllocator pool;
+    };
+
+} // namespace Core
+} // namespace Squid
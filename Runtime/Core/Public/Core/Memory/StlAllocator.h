@@ -0,0 +1,45 @@
+#pragma once
+#include "FrameAllocator.h"
+#include "LinearAllocator.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace Squid {
+namespace Core {
+
+    // Lets STL containers take their memory from one of the Core allocators. Arenas that free in bulk ignore
+    // deallocate, the container's memory is reclaimed along with the rest of the arena.
+    template <typename T, typename Arena> class StlAllocator {
+    public:
+        using value_type = T;
+
+        StlAllocator(Arena &arena) noexcept : arena(&arena) {}
+        template <typename U> StlAllocator(const StlAllocator<U, Arena> &other) noexcept : arena(other.arena) {}
+
+        inline T *allocate(size_t count) {
+            return static_cast<T *>(arena->Allocate(count * sizeof(T), alignof(T)));
+        }
+        inline void deallocate(T *pointer, size_t count) noexcept { arena->Deallocate(pointer, count * sizeof(T)); }
+
+        template <typename U, typename OtherArena> friend class StlAllocator;
+        template <typename U>
+        friend inline bool operator==(const StlAllocator &a, const StlAllocator<U, Arena> &b) noexcept {
+            return a.arena == b.arena;
+        }
+        template <typename U>
+        friend inline bool operator!=(const StlAllocator &a, const StlAllocator<U, Arena> &b) noexcept {
+            return a.arena != b.arena;
+        }
+
+    private:
+        Arena *arena;
+    };
+
+    // Freed with the frame slot, see FrameAllocator
+    template <typename T> using FrameVector = std::vector<T, StlAllocator<T, FrameAllocator>>;
+    // Freed when the enclosing ScratchScope ends, reserve up front where inner scopes are opened
+    template <typename T> using ScratchVector = std::vector<T, StlAllocator<T, LinearAllocator>>;
+
+} // namespace Core
+} // namespace Squid
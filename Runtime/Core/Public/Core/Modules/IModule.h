@@ -30,7 +30,6 @@ namespace Core {
         IModule(EngineContext *context) { this->context = context; }
         virtual ~IModule() = default;
         virtual bool Initialize() { return true; };
-        virtual void Event(){};
         virtual void Tick(float delta_time){};
 
     protected:
@@ -1,5 +1,6 @@
 #pragma once
 #include "Types.h"
+#include <cstring>
 #include <functional>
 
 // File uses code from:
@@ -41,6 +42,45 @@ inline u32 murmur3(const u32 *key, size_t wordCount, u32 seed) {
     return h;
 }
 
+// MurmurHash64A, for byte streams of any length such as paths and file contents
+inline u64 murmur64(const void *key, size_t length, u64 seed) {
+    const u64 m = 0xc6a4a7935bd1e995ull;
+    const u32 r = 47;
+
+    u64 h = seed ^ (length * m);
+
+    const u8 *data = (const u8 *)key;
+    const u8 *end = data + (length & ~size_t(7));
+    for (; data != end; data += 8) {
+        u64 k;
+        memcpy(&k, data, sizeof(k));
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    switch (length & 7) {
+    case 7: h ^= u64(data[6]) << 48u; [[fallthrough]];
+    case 6: h ^= u64(data[5]) << 40u; [[fallthrough]];
+    case 5: h ^= u64(data[4]) << 32u; [[fallthrough]];
+    case 4: h ^= u64(data[3]) << 24u; [[fallthrough]];
+    case 3: h ^= u64(data[2]) << 16u; [[fallthrough]];
+    case 2: h ^= u64(data[1]) << 8u; [[fallthrough]];
+    case 1:
+        h ^= u64(data[0]);
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
 template <typename T>
 struct MurmurHash {
     std::size_t operator()(const T &key) const {
@@ -1,21 +1,21 @@
 #pragma once
 #include "Types.h"
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <fstream>
 #include <chrono>
 #include <vector>
 
+// Scope names are built once per call site, NAME has to be the same every time the scope is entered
 #define PROFILING_SCOPE                                                                                                \
-    std::ostringstream _profiling_oss;                                                                                 \
-    _profiling_oss << /*__FILE__ << ":" << */ __FUNCTION__ << ":" << __LINE__;                                         \
-    Squid::Core::ScopedProfile _sco_pro(_profiling_oss.str());
+    static const std::string _profiling_name = std::string(__FUNCTION__) + ":" + std::to_string(__LINE__);            \
+    Squid::Core::ScopedProfile _sco_pro(_profiling_name);
 
 #define PROFILING_NAMED_SCOPE(NAME)                                                                                    \
-    std::ostringstream _profiling_oss;                                                                                 \
-    _profiling_oss << (NAME);                                                                                          \
-    Squid::Core::ScopedProfile _sco_pro(_profiling_oss.str());
+    static const std::string _profiling_name(NAME);                                                                    \
+    Squid::Core::ScopedProfile _sco_pro(_profiling_name);
 
 namespace Squid {
 namespace Core {
@@ -46,7 +46,7 @@ namespace Core {
         bool Stop();
 
         inline u32 GetCallCount() const { return call_count; }
-        inline std::string GetName() const { return name; }
+        inline const std::string &GetName() const { return name; }
         inline void GetTimes(f64 &wall) const { wall = wall_time; };
         inline std::map<std::string, Profile *> &GetSubProfiles() { return sub_profiles; };
 
@@ -67,6 +67,7 @@ namespace Core {
         Profile *profile;
     };
 
+    // Every thread records into its own tree, only the first profile on a thread takes the lock
     class Profiler {
         friend class Profile;
         friend class ScopedProfile;
@@ -74,32 +75,34 @@ namespace Core {
     public:
         static void PrintStats();
 
+        // Label of the calling thread in the stats
+        static void SetThreadName(const std::string &name);
+
     private:
+        struct ThreadProfiles {
+            std::string name;
+            std::map<std::string, Profile *> profiles;
+            std::vector<Profile *> profile_stack;
+        };
+
         Profiler();
         ~Profiler();
 
-        static Profiler *GetInstance() {
-            if (instance == nullptr) {
-                instance = new Profiler();
-                atexit(PrintStats);
-            }
-            return instance;
-        };
-
-        static Profiler *instance;
+        static Profiler *GetInstance();
 
+        ThreadProfiles &GetThreadProfiles();
         Profile *GetProfile(const std::string &name);
 
         void PushProfile(Profile *p);
         void PopProfile();
         bool IsInStack(const std::string &name);
-        std::map<std::string, Profile *> &Profiler::GetCurrentProfilesRoot();
+        std::map<std::string, Profile *> &GetCurrentProfilesRoot();
 
         static void CollectStats(std::ofstream &fs, std::map<std::string, Profile *> *p, int depth);
 
         // TODO: Maybe unordered?
-        std::map<std::string, Profile *> profiles;
-        std::vector<Profile *> profile_stack;
+        std::mutex mutex;
+        std::vector<ThreadProfiles *> threads;
     };
 
 } // namespace Core
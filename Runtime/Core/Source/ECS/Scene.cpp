@@ -1,50 +1,383 @@
 #include <Public/Core/ECS/Scene.h>
+#include <Public/Core/Events/EventDispatcher.h>
+#include <Public/Core/Profiling.h>
+#include <Public/Core/Jobs/JobSystem.h>
+
+#include <algorithm>
 
 namespace Squid {
 namespace Core {
 
+    // Gathers the TRS of the dirty transforms into streams and recomposes their local matrices in batches.
+    // Null entries are skipped, changed[i] tells whether transforms[i] got a new local matrix.
+    static void UpdateLocalMatrices(TransformComponent *const *transforms, u32 count, u8 *changed) {
+        static constexpr u32 BATCH = 64;
+
+        f32 streams[10][BATCH];
+        glm::mat4 matrices[BATCH];
+        TransformComponent *batch[BATCH];
+        u32 batch_count = 0;
+
+        const TransformStreams view = {
+            {streams[0], streams[1], streams[2]},
+            {streams[3], streams[4], streams[5], streams[6]},
+            {streams[7], streams[8], streams[9]}};
+
+        auto flush = [&]() {
+            ComposeTransforms(view, matrices, batch_count);
+            for (u32 i = 0; i < batch_count; i++) {
+                batch[i]->local = matrices[i];
+            }
+            batch_count = 0;
+        };
+
+        for (u32 i = 0; i < count; i++) {
+            TransformComponent *transform = transforms[i];
+            changed[i] = transform && transform->IsDirty() ? 1 : 0;
+            if (!changed[i])
+                continue;
+
+            transform->SetDirty(false);
+            for (u32 axis = 0; axis < 3; axis++) {
+                streams[axis][batch_count] = transform->translation_local[axis];
+                streams[7 + axis][batch_count] = transform->scale_local[axis];
+            }
+            streams[3][batch_count] = transform->rotation_local.x;
+            streams[4][batch_count] = transform->rotation_local.y;
+            streams[5][batch_count] = transform->rotation_local.z;
+            streams[6][batch_count] = transform->rotation_local.w;
+
+            batch[batch_count++] = transform;
+            if (batch_count == BATCH)
+                flush();
+        }
+
+        if (batch_count > 0)
+            flush();
+    }
+
+    // Transforms the local boxes of a batch of bounds by their world matrices through streams, the batch is at most
+    // the stream size
+    static constexpr u32 BOUNDS_BATCH = 64;
+
+    static void UpdateWorldBounds(BoundsComponent *const *bounds, const glm::mat4 *const *matrices, u32 count) {
+        f32 matrix_streams[12][BOUNDS_BATCH];
+        f32 box_streams[6][BOUNDS_BATCH];
+
+        MatrixStreams matrix_view = {};
+        for (u32 column = 0; column < 4; column++) {
+            for (u32 row = 0; row < 3; row++) {
+                matrix_view.columns[column][row] = matrix_streams[column * 3 + row];
+            }
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            for (u32 column = 0; column < 4; column++) {
+                for (u32 row = 0; row < 3; row++) {
+                    matrix_streams[column * 3 + row][i] = (*matrices[i])[column][row];
+                }
+            }
+            for (u32 axis = 0; axis < 3; axis++) {
+                box_streams[axis][i] = bounds[i]->local_min[axis];
+                box_streams[3 + axis][i] = bounds[i]->local_max[axis];
+            }
+        }
+
+        // World boxes overwrite the local ones in place
+        const AabbStreams boxes = {
+            {box_streams[0], box_streams[1], box_streams[2]}, {box_streams[3], box_streams[4], box_streams[5]}};
+        const AabbOutputStreams world = {
+            {box_streams[0], box_streams[1], box_streams[2]}, {box_streams[3], box_streams[4], box_streams[5]}};
+        TransformAabbs(matrix_view, boxes, world, count);
+
+        for (u32 i = 0; i < count; i++) {
+            for (u32 axis = 0; axis < 3; axis++) {
+                bounds[i]->world_min[axis] = box_streams[axis][i];
+                bounds[i]->world_max[axis] = box_streams[3 + axis][i];
+            }
+        }
+    }
+
+    // Entities per chunk handed to a worker
+    static constexpr u32 TRANSFORM_UPDATE_GRAIN = 1024;
+    static constexpr u32 BOUNDS_UPDATE_GRAIN = 1024;
+
     SceneGraph::SceneGraph() {}
     SceneGraph::~SceneGraph() {}
 
-    void SceneGraph::Update() const {}
+    void SceneGraph::RebuildLevels() {
+        const size_t count = hierarchy.GetCount();
 
-    void SceneGraph::Attach(Entity entity, Entity parent, bool child_already_in_local_space) {
-        assert(entity != parent);
+        // Depths are kept up to date by the links, parents always sit on a lower level than their children
+        u32 max_depth = 0;
+        for (size_t i = 0; i < count; i++) {
+            max_depth = std::max(max_depth, hierarchy[i].depth);
+        }
+
+        // Counting sort by depth, keeping the hierarchy order inside every level
+        level_offsets.assign(count > 0 ? max_depth + 2 : 1, 0);
+        for (size_t i = 0; i < count; i++) {
+            level_offsets[hierarchy[i].depth + 1]++;
+        }
+        for (size_t level = 1; level < level_offsets.size(); level++) {
+            level_offsets[level] += level_offsets[level - 1];
+        }
+
+        level_order.resize(count);
+        std::vector<u32> fill(level_offsets.begin(), level_offsets.end() - 1);
+        for (size_t i = 0; i < count; i++) {
+            level_order[fill[hierarchy[i].depth]++] = u32(i);
+        }
+
+        levels_hierarchy_count = count;
+        levels_dirty = false;
+    }
+
+    void SceneGraph::Update() {
+        PROFILING_SCOPE
+
+        if (levels_dirty || levels_hierarchy_count != hierarchy.GetCount())
+            RebuildLevels();
+
+        world_changed.assign(transforms.GetCount(), 0);
+
+        // Roots, every transform outside of the hierarchy
+        ParallelFor(u32(transforms.GetCount()), TRANSFORM_UPDATE_GRAIN, [&](u32 begin, u32 end) {
+            TransformComponent *chunk[TRANSFORM_UPDATE_GRAIN];
+            u8 local_changed[TRANSFORM_UPDATE_GRAIN];
+
+            for (u32 i = begin; i < end; i++) {
+                chunk[i - begin] = hierarchy.Contains(transforms.GetEntity(i)) ? nullptr : &transforms[i];
+            }
+
+            UpdateLocalMatrices(chunk, end - begin, local_changed);
 
-        if (hierarchy.Contains(entity)) {
-            Detach(entity);
+            for (u32 i = begin; i < end; i++) {
+                if (local_changed[i - begin]) {
+                    transforms[i].world = transforms[i].local;
+                    world_changed[i] = 1;
+                }
+            }
+        });
+
+        // A level only reads the world matrices of the one above, which is complete by now
+        for (size_t level = 0; level + 1 < level_offsets.size(); level++) {
+            const u32 level_begin = level_offsets[level];
+            const u32 level_count = level_offsets[level + 1] - level_begin;
+
+            ParallelFor(level_count, TRANSFORM_UPDATE_GRAIN, [&](u32 begin, u32 end) {
+                TransformComponent *chunk[TRANSFORM_UPDATE_GRAIN];
+                u32 indices[TRANSFORM_UPDATE_GRAIN];
+                u8 local_changed[TRANSFORM_UPDATE_GRAIN];
+
+                for (u32 k = begin; k < end; k++) {
+                    const u32 index = transforms.GetIndex(hierarchy.GetEntity(level_order[level_begin + k]));
+                    indices[k - begin] = index;
+                    chunk[k - begin] =
+                        index != ComponentRegistry<TransformComponent>::INVALID_INDEX ? &transforms[index] : nullptr;
+                }
+
+                UpdateLocalMatrices(chunk, end - begin, local_changed);
+
+                for (u32 k = begin; k < end; k++) {
+                    if (!chunk[k - begin])
+                        continue;
+
+                    const u32 node = level_order[level_begin + k];
+                    const u32 index = indices[k - begin];
+                    const u32 parent = transforms.GetIndex(hierarchy[node].parent_id);
+                    const bool has_parent = parent != ComponentRegistry<TransformComponent>::INVALID_INDEX;
+
+                    TransformComponent &transform = transforms[index];
+
+                    // Untouched subtrees fall through here without any matrix work
+                    if (!local_changed[k - begin] && !(has_parent && world_changed[parent]))
+                        continue;
+
+                    if (has_parent)
+                        MultiplyMatrix(transforms[parent].world, transform.local, transform.world);
+                    else
+                        transform.world = transform.local;
+
+                    world_changed[index] = 1;
+                }
+            });
         }
 
-        // Add a new hierarchy component to the end of container:
-        hierarchy.Create(entity)->parent_id = parent;
+        UpdateBounds();
+    }
+
+    void SceneGraph::UpdateBounds() {
+        PROFILING_SCOPE
+
+        bounds_moved.assign(bounds.GetCount(), 0);
 
-        // Detect breaks in the tree and fix them:
-        // when children are before parents, we move the parents before the children while keeping
-        // ordering of other components intact
-        if (hierarchy.GetCount() > 1) {
-            for (auto i = hierarchy.GetCount() - 1; i > 0; --i) {
+        // World boxes of everything new, dirty or moved by its transform
+        ParallelFor(u32(bounds.GetCount()), BOUNDS_UPDATE_GRAIN, [&](u32 begin, u32 end) {
+            BoundsComponent *batch[BOUNDS_BATCH];
+            const glm::mat4 *matrices[BOUNDS_BATCH];
+            u32 batch_count = 0;
 
-                Entity parent_candidate_entity = hierarchy.GetEntity(i);
-                const HierarchyComponent &parent_candidate = hierarchy[i];
+            for (u32 i = begin; i < end; i++) {
+                BoundsComponent &component = bounds[i];
+                const u32 transform = transforms.GetIndex(bounds.GetEntity(i));
+                const bool has_transform = transform != ComponentRegistry<TransformComponent>::INVALID_INDEX;
 
-                for (auto j = 0; j < i; ++j) {
-                    const HierarchyComponent &child_candidate = hierarchy[j];
+                if (!component.IsDirty() && component.proxy != DynamicBvh::INVALID_NODE &&
+                    !(has_transform && world_changed[transform]))
+                    continue;
 
-                    if (child_candidate.parent_id == parent_candidate_entity) {
-                        hierarchy.MoveItem(i, j);
-                        ++i;
-                        // next outer iteration will check the same index again as parent
-                        // candidate, however things were moved upwards, so it will be a
-                        // different entity!
-                        break;
+                component.SetDirty(false);
+                if (has_transform) {
+                    batch[batch_count] = &component;
+                    matrices[batch_count++] = &transforms[transform].world;
+                    if (batch_count == BOUNDS_BATCH) {
+                        UpdateWorldBounds(batch, matrices, batch_count);
+                        batch_count = 0;
                     }
+                } else {
+                    component.world_min = component.local_min;
+                    component.world_max = component.local_max;
                 }
+                bounds_moved[i] = 1;
             }
+
+            if (batch_count > 0)
+                UpdateWorldBounds(batch, matrices, batch_count);
+        });
+
+        // The tree itself is updated on this thread, most moves stay inside their fat boxes
+        for (size_t i = 0; i < bounds.GetCount(); i++) {
+            if (!bounds_moved[i])
+                continue;
+
+            BoundsComponent &component = bounds[i];
+            if (component.proxy == DynamicBvh::INVALID_NODE)
+                component.proxy = bvh.Insert(component.world_min, component.world_max, bounds.GetEntity(i));
+            else
+                bvh.Move(component.proxy, component.world_min, component.world_max);
         }
+    }
+
+    void SceneGraph::CullFrustum(const glm::vec4 *planes, FrameVector<Entity> &visible) const {
+        PROFILING_SCOPE
+
+        static_assert(sizeof(Entity) == sizeof(u32), "BVH user data holds entities");
+        bvh.QueryFrustum(planes, visible);
+    }
+
+    Entity SceneGraph::RayCast(const glm::vec3 &origin, const glm::vec3 &direction, f32 max_distance, f32 *distance)
+        const {
+        const u32 hit = bvh.RayCast(origin, direction, max_distance, distance);
+        return hit != DynamicBvh::INVALID_NODE ? Entity(hit) : INVALID_ENTITY;
+    }
+
+    void SceneGraph::RemoveBounds(Entity entity) {
+        const BoundsComponent *component = bounds.GetComponent(entity);
+        if (component == nullptr)
+            return;
+
+        if (component->proxy != DynamicBvh::INVALID_NODE)
+            bvh.Remove(component->proxy);
+        bounds.Remove(entity);
+
+        GetEventDispatcher().Publish(SceneChangedEvent{this, entity, INVALID_ENTITY, SCENE_CHANGE_BOUNDS_REMOVED});
+    }
+
+    void SceneGraph::Link(Entity entity, Entity parent) {
+        // Top nodes get a component as well, it holds their child list
+        if (!hierarchy.Contains(parent))
+            hierarchy.Create(parent);
+        if (!hierarchy.Contains(entity))
+            hierarchy.Create(entity);
+
+#ifndef NDEBUG
+        // The entity must not end up below itself
+        for (Entity ancestor = parent; ancestor != INVALID_ENTITY;
+             ancestor = hierarchy.GetComponent(ancestor)->parent_id) {
+            assert(ancestor != entity);
+        }
+#endif
+
+        Unlink(entity);
+
+        // Pointers are taken after the creates above, they may move the components
+        HierarchyComponent &component = *hierarchy.GetComponent(entity);
+        HierarchyComponent &parent_component = *hierarchy.GetComponent(parent);
+
+        component.parent_id = parent;
+        component.next_sibling = INVALID_ENTITY;
+
+        // Append, the first child knows the last one
+        if (parent_component.first_child == INVALID_ENTITY) {
+            parent_component.first_child = entity;
+            component.previous_sibling = entity;
+        } else {
+            HierarchyComponent &first = *hierarchy.GetComponent(parent_component.first_child);
+            const Entity last = first.previous_sibling;
+            hierarchy.GetComponent(last)->next_sibling = entity;
+            component.previous_sibling = last;
+            first.previous_sibling = entity;
+        }
+
+        SetSubtreeDepth(entity, parent_component.depth + 1);
+        levels_dirty = true;
+    }
+
+    void SceneGraph::Unlink(Entity entity) {
+        HierarchyComponent &component = *hierarchy.GetComponent(entity);
+        if (component.parent_id == INVALID_ENTITY)
+            return;
+
+        HierarchyComponent &parent = *hierarchy.GetComponent(component.parent_id);
+        HierarchyComponent *next =
+            component.next_sibling != INVALID_ENTITY ? hierarchy.GetComponent(component.next_sibling) : nullptr;
+
+        if (parent.first_child == entity) {
+            parent.first_child = component.next_sibling;
+            // The new first child inherits the link to the last one
+            if (next)
+                next->previous_sibling = component.previous_sibling;
+        } else {
+            hierarchy.GetComponent(component.previous_sibling)->next_sibling = component.next_sibling;
+            if (next)
+                next->previous_sibling = component.previous_sibling;
+            else
+                hierarchy.GetComponent(parent.first_child)->previous_sibling = component.previous_sibling;
+        }
+
+        component.parent_id = INVALID_ENTITY;
+        component.next_sibling = INVALID_ENTITY;
+        component.previous_sibling = INVALID_ENTITY;
+        levels_dirty = true;
+    }
 
-        // Re-query parent after potential MoveItem(), because it invalidates references:
-        HierarchyComponent &parent_component = *hierarchy.GetComponent(entity);
+    void SceneGraph::SetSubtreeDepth(Entity entity, u32 depth) {
+        HierarchyComponent &component = *hierarchy.GetComponent(entity);
+        if (component.depth == depth)
+            return;
 
+        component.depth = depth;
+        if (component.first_child == INVALID_ENTITY)
+            return;
+
+        // Whole subtree moves by the same amount
+        std::vector<Entity> stack = {component.first_child};
+        while (!stack.empty()) {
+            const Entity current = stack.back();
+            stack.pop_back();
+
+            HierarchyComponent &node = *hierarchy.GetComponent(current);
+            node.depth = hierarchy.GetComponent(node.parent_id)->depth + 1;
+
+            if (node.next_sibling != INVALID_ENTITY)
+                stack.push_back(node.next_sibling);
+            if (node.first_child != INVALID_ENTITY)
+                stack.push_back(node.first_child);
+        }
+    }
+
+    void SceneGraph::AttachTransform(Entity entity, Entity parent, bool child_already_in_local_space) {
         TransformComponent *transform_parent = transforms.GetComponent(parent);
         if (transform_parent == nullptr) {
             transform_parent = transforms.Create(parent);
@@ -61,12 +394,73 @@ namespace Core {
         if (!child_already_in_local_space) {
             auto b = glm::inverse(transform_parent->world);
             transform_child->MatrixTransform(b);
-            transform_child->UpdateTransform();
         }
+
+        // The world matrix is usable right away, the flag makes the next Update move descendants and bounds along
+        transform_child->SetDirty();
         transform_child->UpdateTransformParented(*transform_parent);
     }
 
-    void SceneGraph::Detach(Entity entity) {}
+    void SceneGraph::Attach(Entity entity, Entity parent, bool child_already_in_local_space) {
+        assert(entity != parent);
+
+        Link(entity, parent);
+        AttachTransform(entity, parent, child_already_in_local_space);
+
+        GetEventDispatcher().Publish(SceneChangedEvent{this, entity, parent, SCENE_CHANGE_ATTACHED});
+    }
+
+    void SceneGraph::AttachBulk(
+        const Entity *entities, const Entity *parents, size_t count, bool child_already_in_local_space) {
+        PROFILING_SCOPE
+
+        for (size_t i = 0; i < count; i++) {
+            assert(entities[i] != parents[i]);
+
+            Link(entities[i], parents[i]);
+            AttachTransform(entities[i], parents[i], child_already_in_local_space);
+        }
+
+        hierarchy.Sort([](const HierarchyComponent &a, const HierarchyComponent &b) { return a.depth < b.depth; });
+
+        // One event for the whole import, it would flood the queue otherwise
+        GetEventDispatcher().Publish(
+            SceneChangedEvent{this, INVALID_ENTITY, INVALID_ENTITY, SCENE_CHANGE_BULK_ATTACHED});
+    }
+
+    void SceneGraph::Detach(Entity entity) {
+        HierarchyComponent *component = hierarchy.GetComponent(entity);
+        if (component == nullptr || component->parent_id == INVALID_ENTITY)
+            return;
+
+        Unlink(entity);
+        SetSubtreeDepth(entity, 0);
+
+        // The world matrix becomes the local one
+        TransformComponent *transform = transforms.GetComponent(entity);
+        if (transform) {
+            transform->MatrixTransform(transform->world);
+            transform->UpdateTransform();
+        }
+
+        // Leaves don't need the component anymore
+        if (hierarchy.GetComponent(entity)->first_child == INVALID_ENTITY)
+            hierarchy.Remove(entity);
+
+        GetEventDispatcher().Publish(SceneChangedEvent{this, entity, INVALID_ENTITY, SCENE_CHANGE_DETACHED});
+    }
+
+    void SceneGraph::DetachChildren(Entity parent) {
+        const HierarchyComponent *component = hierarchy.GetComponent(parent);
+        if (component == nullptr)
+            return;
+
+        while (component->first_child != INVALID_ENTITY) {
+            Detach(component->first_child);
+            // Detach may remove components and move this one
+            component = hierarchy.GetComponent(parent);
+        }
+    }
 
 } // namespace Core
 } // namespace Squid
\ No newline at end of file
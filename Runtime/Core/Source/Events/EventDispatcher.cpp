@@ -0,0 +1,32 @@
+#include <Public/Core/Events/EventDispatcher.h>
+#include <Public/Core/Log.h>
+#include <Public/Core/Profiling.h>
+
+namespace Squid {
+namespace Core {
+
+    template <typename T>
+    static void DrainQueue(EventQueue<T> &queue, EventPhase phase) {
+        if (T::PHASE != phase)
+            return;
+
+        queue.Drain();
+
+        const u32 dropped = queue.TakeDropped();
+        if (dropped > 0)
+            LOG_WARN_EVERY(1000, "dropped {} {} events, the queue holds {}", dropped, T::NAME, T::CAPACITY)
+    }
+
+    void EventDispatcher::Dispatch(EventPhase phase) {
+        PROFILING_SCOPE
+
+        std::apply([phase](auto &...queue) { (DrainQueue(queue, phase), ...); }, queues);
+    }
+
+    EventDispatcher &GetEventDispatcher() {
+        static EventDispatcher dispatcher;
+        return dispatcher;
+    }
+
+} // namespace Core
+} // namespace Squid
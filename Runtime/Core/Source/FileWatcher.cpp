@@ -1,49 +1,309 @@
 #include <Public/Core/FileWatcher.h>
-#include <thread>
+#include <Public/Core/Log.h>
+#include <Public/Core/Profiling.h>
 
-namespace Squid { namespace Core {
+#include <algorithm>
+#include <optional>
+
+#ifdef SQUID_LINUX
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Squid {
+namespace Core {
+
+    namespace fs = std::filesystem;
+    using Clock = std::chrono::steady_clock;
+
+    // A batch that never goes quiet is still handed over after this many latencies
+    static constexpr u32 MAX_BATCH_LATENCIES = 10;
 
     FileWatcher::FileWatcher(
-        const std::string &path, std::chrono::duration<int, std::milli> intervall)
-        : intervall(intervall), path(path) {
-            // Get the initial files to watch
-            for(auto& file : std::filesystem::recursive_directory_iterator(path)) {
-                paths[file.path().string()] = std::filesystem::last_write_time(file);
+        const std::string &path, std::chrono::milliseconds latency, std::chrono::milliseconds interval)
+        : path(path), latency(latency), interval(interval) {}
+
+    FileWatcher::~FileWatcher() { Stop(); }
+
+    void FileWatcher::Start() {
+        if (running.exchange(true))
+            return;
+
+#ifdef SQUID_LINUX
+        if (OpenInotify()) {
+            event_driven = true;
+            thread = std::thread([this]() { InotifyLoop(); });
+            return;
+        }
+        LOG_WARN("inotify is not available, polling {} instead", path)
+#endif
+
+        event_driven = false;
+        thread = std::thread([this]() { PollLoop(); });
+    }
+
+    void FileWatcher::Stop() {
+        {
+            std::lock_guard<std::mutex> lock(stop_mutex);
+            if (!running.exchange(false))
+                return;
+        }
+        stop_signal.notify_all();
+
+#ifdef SQUID_LINUX
+        if (stop_fd >= 0) {
+            const u64 wake = 1;
+            [[maybe_unused]] ssize_t written = write(stop_fd, &wake, sizeof(wake));
+        }
+#endif
+
+        if (thread.joinable())
+            thread.join();
+
+#ifdef SQUID_LINUX
+        if (inotify_fd >= 0)
+            close(inotify_fd);
+        if (stop_fd >= 0)
+            close(stop_fd);
+        inotify_fd = -1;
+        stop_fd = -1;
+        watches.clear();
+#endif
+    }
+
+    bool FileWatcher::Poll(std::vector<FileChange> &changes) {
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        if (ready.empty())
+            return false;
+
+        changes.insert(changes.end(), std::make_move_iterator(ready.begin()), std::make_move_iterator(ready.end()));
+        ready.clear();
+        return true;
+    }
+
+    // Change a file keeps in the batch when status follows the one already recorded, [previous][status]. A file
+    // created and deleted within one batch is dropped, one replaced within a batch is an update.
+    static constexpr std::optional<FileStatus> MERGED_STATUS[3][3] = {
+        // followed by CREATED, UPDATED, DELETED
+        {FileStatus::CREATED, FileStatus::CREATED, std::nullopt},        // CREATED
+        {FileStatus::UPDATED, FileStatus::UPDATED, FileStatus::DELETED}, // UPDATED
+        {FileStatus::UPDATED, FileStatus::UPDATED, FileStatus::DELETED}, // DELETED
+    };
+
+    void FileWatcher::Record(const std::string &file, FileStatus status) {
+        auto [it, inserted] = batch.emplace(file, status);
+        if (inserted)
+            return;
+
+        const std::optional<FileStatus> merged = MERGED_STATUS[u32(it->second)][u32(status)];
+        if (merged)
+            it->second = *merged;
+        else
+            batch.erase(it);
+    }
+
+    void FileWatcher::Flush() {
+        if (batch.empty())
+            return;
+
+        std::lock_guard<std::mutex> lock(ready_mutex);
+        for (auto &[file, status] : batch) {
+            ready.push_back({file, status});
+        }
+        batch.clear();
+    }
+
+    void FileWatcher::PollLoop() {
+        Profiler::SetThreadName("File Watcher");
+
+        Scan(false);
+
+        std::unique_lock<std::mutex> lock(stop_mutex);
+        while (!stop_signal.wait_for(lock, interval, [this]() { return !running.load(); })) {
+            lock.unlock();
+            Scan(true);
+            Flush();
+            lock.lock();
+        }
+    }
+
+    void FileWatcher::Scan(bool report) {
+        // Files not stamped with this scan are gone
+        scan++;
+
+        std::error_code error;
+        for (fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, error), end;
+             it != end;
+             it.increment(error)) {
+            if (error)
+                break;
+            if (!it->is_regular_file(error))
+                continue;
+
+            const fs::file_time_type last_write = it->last_write_time(error);
+            if (error)
+                continue;
+
+            auto [file, inserted] = files.try_emplace(it->path().string());
+            if (report && inserted)
+                Record(file->first, FileStatus::CREATED);
+            else if (report && file->second.last_write != last_write)
+                Record(file->first, FileStatus::UPDATED);
+
+            file->second.last_write = last_write;
+            file->second.scan = scan;
+        }
+
+        for (auto it = files.begin(); it != files.end();) {
+            if (it->second.scan == scan) {
+                it++;
+                continue;
             }
+
+            if (report)
+                Record(it->first, FileStatus::DELETED);
+            it = files.erase(it);
         }
+    }
 
-    FileWatcher::~FileWatcher() {}
+#ifdef SQUID_LINUX
+    // Writes are reported once the writer closes the file, so half written files are never picked up
+    static constexpr u32 INOTIFY_MASK =
+        IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW;
 
-    void FileWatcher::start(const std::function<void(std::string, FileStatus)> &action) {
-        while (running) {
-            std::this_thread::sleep_for(intervall);
+    bool FileWatcher::OpenInotify() {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0)
+            return false;
 
-            auto it = paths.begin();
+        stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stop_fd < 0) {
+            close(inotify_fd);
+            inotify_fd = -1;
+            return false;
+        }
 
-            while(it != paths.end()) {
-                if(!std::filesystem::exists(it->first)) {
-                    action(it->first, FileStatus::DELETED);
-                    it = paths.erase(it);
-                } else {
-                    it++;
-                }
+        return true;
+    }
+
+    bool FileWatcher::WatchDirectory(const std::string &directory, bool report) {
+        const int watch = inotify_add_watch(inotify_fd, directory.c_str(), INOTIFY_MASK);
+        if (watch < 0) {
+            LOG_WARN("failed to watch {}, errno {}", directory, errno)
+            return false;
+        }
+        watches[watch] = directory;
+
+        // Only directories are listed, files are never stat'ed. Anything that appeared before the watch was in
+        // place is reported as created.
+        bool result = true;
+        std::error_code error;
+        for (fs::directory_iterator it(directory, fs::directory_options::skip_permission_denied, error), end;
+             it != end;
+             it.increment(error)) {
+            if (error)
+                break;
+
+            if (it->is_directory(error) && !it->is_symlink(error))
+                result &= WatchDirectory(it->path().string(), report);
+            else if (report)
+                Record(it->path().string(), FileStatus::CREATED);
+        }
+        return result;
+    }
+
+    void FileWatcher::InotifyLoop() {
+        Profiler::SetThreadName("File Watcher");
+
+        if (!WatchDirectory(path, false) && watches.empty()) {
+            // Nothing could be watched, fall back to polling on this thread
+            LOG_WARN("inotify could not watch {}, polling instead", path)
+            event_driven = false;
+            PollLoop();
+            return;
+        }
+
+        alignas(inotify_event) char buffer[64 * 1024];
+        pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+
+        Clock::time_point batch_start;
+        Clock::time_point last_event;
+
+        while (running.load()) {
+            int timeout = -1;
+            if (!batch.empty()) {
+                const Clock::time_point now = Clock::now();
+                const Clock::time_point flush =
+                    std::min(last_event + latency, batch_start + latency * MAX_BATCH_LATENCIES);
+                timeout = i32(std::max<i64>(
+                    0, std::chrono::duration_cast<std::chrono::milliseconds>(flush - now).count()));
+            }
+
+            const int result = poll(fds, 2, timeout);
+            if (result < 0 && errno != EINTR) {
+                LOG_WARN("file watcher poll failed, errno {}", errno)
+                break;
             }
+            if (fds[1].revents & POLLIN)
+                break;
 
-            for(auto& file : std::filesystem::recursive_directory_iterator(path)) {
-                auto last_write = std::filesystem::last_write_time(file);
-                auto path_string = file.path().string();
-
-                if(!contains(path_string)) {
-                    paths[path_string] = last_write;
-                    action(path_string, FileStatus::CREATED);
-                } else {
-                    if(paths[path_string] != last_write) {
-                        action(path_string, FileStatus::UPDATED);
-                        paths[path_string] = last_write;
+            if (result > 0 && (fds[0].revents & POLLIN)) {
+                PROFILING_NAMED_SCOPE("Read Events")
+
+                ssize_t length;
+                while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+                    for (char *data = buffer; data < buffer + length;) {
+                        const inotify_event *event = (const inotify_event *)data;
+                        data += sizeof(inotify_event) + event->len;
+
+                        if (event->mask & IN_Q_OVERFLOW) {
+                            LOG_WARN("file watcher queue overflowed, changes in {} were lost", path)
+                            continue;
+                        }
+
+                        auto watch = watches.find(event->wd);
+                        if (watch == watches.end())
+                            continue;
+                        if (event->mask & IN_IGNORED) {
+                            watches.erase(watch);
+                            continue;
+                        }
+                        if (event->len == 0)
+                            continue;
+
+                        const std::string file = (fs::path(watch->second) / event->name).string();
+                        if (batch.empty())
+                            batch_start = Clock::now();
+
+                        if (event->mask & IN_ISDIR) {
+                            // New directories get their own watch, removed ones drop it through IN_IGNORED
+                            if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                                WatchDirectory(file, true);
+                            continue;
+                        }
+
+                        if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                            Record(file, FileStatus::CREATED);
+                        else if (event->mask & IN_CLOSE_WRITE)
+                            Record(file, FileStatus::UPDATED);
+                        else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                            Record(file, FileStatus::DELETED);
                     }
                 }
+
+                last_event = Clock::now();
             }
+
+            const Clock::time_point now = Clock::now();
+            if (!batch.empty() &&
+                (now - last_event >= latency || now - batch_start >= latency * MAX_BATCH_LATENCIES))
+                Flush();
         }
     }
+#endif
 
-}} // namespace Squid::Core
+} // namespace Core
+} // namespace Squid
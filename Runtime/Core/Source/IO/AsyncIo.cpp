@@ -0,0 +1,437 @@
+#include <Public/Core/IO/AsyncIo.h>
+#include <Public/Core/Log.h>
+#include <Public/Core/Profiling.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef SQUID_WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef SQUID_LINUX
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace Squid {
+namespace Core {
+
+    // == IoFile ===================================================================
+
+#ifdef SQUID_WIN32
+    IoFile::IoFile(const std::string &path) {
+        HANDLE file = CreateFileA(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            return;
+        }
+
+        handle = file;
+        size = u64(file_size.QuadPart);
+    }
+
+    bool IoFile::IsValid() const { return handle != nullptr; }
+
+    void IoFile::Close() {
+        if (handle)
+            CloseHandle(handle);
+        handle = nullptr;
+        size = 0;
+    }
+
+    IoFile::IoFile(IoFile &&other) noexcept
+        : handle(std::exchange(other.handle, nullptr)), size(std::exchange(other.size, 0)) {}
+
+    IoFile &IoFile::operator=(IoFile &&other) noexcept {
+        if (this != &other) {
+            Close();
+            handle = std::exchange(other.handle, nullptr);
+            size = std::exchange(other.size, 0);
+        }
+        return *this;
+    }
+#else
+    IoFile::IoFile(const std::string &path) {
+        const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0)
+            return;
+
+        struct stat info;
+        if (fstat(file, &info) != 0) {
+            close(file);
+            return;
+        }
+
+        fd = file;
+        size = u64(info.st_size);
+    }
+
+    bool IoFile::IsValid() const { return fd >= 0; }
+
+    void IoFile::Close() {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+        size = 0;
+    }
+
+    IoFile::IoFile(IoFile &&other) noexcept : fd(std::exchange(other.fd, -1)), size(std::exchange(other.size, 0)) {}
+
+    IoFile &IoFile::operator=(IoFile &&other) noexcept {
+        if (this != &other) {
+            Close();
+            fd = std::exchange(other.fd, -1);
+            size = std::exchange(other.size, 0);
+        }
+        return *this;
+    }
+#endif
+
+    IoFile::~IoFile() { Close(); }
+
+    // == AsyncIo ==================================================================
+
+    AsyncIo::AsyncIo(u32 queue_depth, u32 worker_count) {
+#ifdef SQUID_LINUX
+        if (SetupUring(queue_depth)) {
+            threads.emplace_back([this]() { ReapLoop(); });
+            return;
+        }
+        LOG_WARN("io_uring is not available, reading on {} threads", worker_count)
+#endif
+
+        for (u32 i = 0; i < std::max(worker_count, 1u); i++) {
+            threads.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    AsyncIo::~AsyncIo() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            quit = true;
+
+#ifdef SQUID_LINUX
+            if (uring_fd >= 0) {
+                // A no-op with user data 0 wakes the reaper out of its wait
+                const u32 tail = *submission.tail;
+                assert(tail - __atomic_load_n(submission.head, __ATOMIC_ACQUIRE) < submission.entries);
+
+                const u32 index = tail & submission.mask;
+                memset(&sqes[index], 0, sizeof(io_uring_sqe));
+                sqes[index].opcode = IORING_OP_NOP;
+                submission_array[index] = index;
+                __atomic_store_n(submission.tail, tail + 1, __ATOMIC_RELEASE);
+                syscall(__NR_io_uring_enter, uring_fd, 1, 0, 0, nullptr, 0);
+            }
+#endif
+        }
+        queue_signal.notify_all();
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+#ifdef SQUID_LINUX
+        if (uring_fd >= 0) {
+            munmap(sqes, sqes_size);
+            if (completion.memory != submission.memory)
+                munmap(completion.memory, completion.memory_size);
+            munmap(submission.memory, submission.memory_size);
+            close(uring_fd);
+        }
+#endif
+    }
+
+    void AsyncIo::Read(IoBatch &batch, const IoFile &file, u64 offset, u64 size, void *buffer) {
+        assert(file.IsValid());
+        if (size == 0)
+            return;
+
+        const u32 pieces = u32((size + MAX_READ_SIZE - 1) / MAX_READ_SIZE);
+        batch.pending.fetch_add(pieces, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        for (u64 begin = 0; begin < size; begin += MAX_READ_SIZE) {
+            Request request;
+            request.batch = &batch;
+#ifdef SQUID_WIN32
+            request.handle = file.handle;
+#else
+            request.fd = file.fd;
+#endif
+            request.offset = offset + begin;
+            request.size = std::min(MAX_READ_SIZE, size - begin);
+            request.buffer = (u8 *)buffer + begin;
+            queued.push_back(request);
+        }
+    }
+
+    void AsyncIo::Submit() {
+#ifdef SQUID_LINUX
+        if (uring_fd >= 0) {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            PumpUring();
+            return;
+        }
+#endif
+        queue_signal.notify_all();
+    }
+
+    void AsyncIo::Wait(IoBatch &batch) {
+        Submit();
+
+        std::unique_lock<std::mutex> lock(finish_mutex);
+        finish_signal.wait(lock, [&batch]() { return batch.IsDone(); });
+    }
+
+    bool AsyncIo::Complete(Request &request, i64 result) {
+        // Interrupted before anything was read, issue it again
+        if (result == -EINTR || result == -EAGAIN)
+            return true;
+
+        if (result <= 0) {
+            request.batch->failed.store(true, std::memory_order_relaxed);
+            Finish(*request.batch);
+            return false;
+        }
+
+        // Short reads continue where they stopped
+        request.offset += u64(result);
+        request.buffer += result;
+        request.size -= u64(result);
+        if (request.size > 0)
+            return true;
+
+        Finish(*request.batch);
+        return false;
+    }
+
+    void AsyncIo::Finish(IoBatch &batch) {
+        // The batch may be gone as soon as the count reaches zero
+        if (batch.pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        { std::lock_guard<std::mutex> lock(finish_mutex); }
+        finish_signal.notify_all();
+    }
+
+    void AsyncIo::WorkerLoop() {
+        Profiler::SetThreadName("Async IO");
+
+        while (true) {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_signal.wait(lock, [this]() { return quit || !queued.empty(); });
+                if (queued.empty())
+                    return;
+
+                request = queued.front();
+                queued.pop_front();
+            }
+
+            i64 result;
+            do {
+#ifdef SQUID_WIN32
+                OVERLAPPED overlapped = {};
+                overlapped.Offset = DWORD(request.offset);
+                overlapped.OffsetHigh = DWORD(request.offset >> 32);
+
+                DWORD read = 0;
+                result = ReadFile(request.handle, request.buffer, DWORD(request.size), &read, &overlapped) ? read : -1;
+#else
+                const ssize_t read = pread(request.fd, request.buffer, request.size, off_t(request.offset));
+                result = read < 0 ? -errno : read;
+#endif
+            } while (Complete(request, result));
+        }
+    }
+
+#ifdef SQUID_LINUX
+    bool AsyncIo::SetupUring(u32 queue_depth) {
+        io_uring_params params = {};
+        const int fd = int(syscall(__NR_io_uring_setup, queue_depth, &params));
+        if (fd < 0)
+            return false;
+
+        // IORING_OP_READ came with 5.6, which is also the first kernel reporting this feature
+        if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+            close(fd);
+            return false;
+        }
+
+        submission.memory_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+        completion.memory_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        // Both rings share one mapping on 5.4 and later
+        const bool single_mapping = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mapping) {
+            submission.memory_size = std::max(submission.memory_size, completion.memory_size);
+            completion.memory_size = submission.memory_size;
+        }
+
+        const auto map = [fd](u64 size, u64 offset) {
+            void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, off_t(offset));
+            return memory == MAP_FAILED ? nullptr : memory;
+        };
+
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        submission.memory = map(submission.memory_size, IORING_OFF_SQ_RING);
+        completion.memory = single_mapping ? submission.memory : map(completion.memory_size, IORING_OFF_CQ_RING);
+        sqes = (io_uring_sqe *)map(sqes_size, IORING_OFF_SQES);
+
+        if (!submission.memory || !completion.memory || !sqes) {
+            if (sqes)
+                munmap(sqes, sqes_size);
+            if (completion.memory && completion.memory != submission.memory)
+                munmap(completion.memory, completion.memory_size);
+            if (submission.memory)
+                munmap(submission.memory, submission.memory_size);
+            close(fd);
+            return false;
+        }
+
+        u8 *sq = (u8 *)submission.memory;
+        submission.head = (u32 *)(sq + params.sq_off.head);
+        submission.tail = (u32 *)(sq + params.sq_off.tail);
+        submission.mask = *(u32 *)(sq + params.sq_off.ring_mask);
+        submission.entries = params.sq_entries;
+        submission_array = (u32 *)(sq + params.sq_off.array);
+
+        u8 *cq = (u8 *)completion.memory;
+        completion.head = (u32 *)(cq + params.cq_off.head);
+        completion.tail = (u32 *)(cq + params.cq_off.tail);
+        completion.mask = *(u32 *)(cq + params.cq_off.ring_mask);
+        completion.entries = params.cq_entries;
+        cqes = (io_uring_cqe *)(cq + params.cq_off.cqes);
+
+        // No more reads in flight than the completion ring holds, so completions are never dropped
+        slots.resize(params.cq_entries);
+        for (u32 i = params.cq_entries; i > 0; i--) {
+            free_slots.push_back(i - 1);
+        }
+
+        uring_fd = fd;
+        return true;
+    }
+
+    void AsyncIo::PumpUring() {
+        // Called with queue_mutex held, this is the only writer of the submission tail
+        u32 tail = *submission.tail;
+        const u32 head = __atomic_load_n(submission.head, __ATOMIC_ACQUIRE);
+
+        while (!queued.empty() && !free_slots.empty() && tail - head < submission.entries) {
+            const u32 slot = free_slots.back();
+            free_slots.pop_back();
+
+            const Request &request = slots[slot] = queued.front();
+            queued.pop_front();
+
+            const u32 index = tail & submission.mask;
+            io_uring_sqe &sqe = sqes[index];
+            memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = request.fd;
+            sqe.off = request.offset;
+            sqe.addr = u64(request.buffer);
+            sqe.len = u32(request.size);
+            sqe.user_data = u64(slot) + 1;
+
+            submission_array[index] = index;
+            tail++;
+        }
+
+        __atomic_store_n(submission.tail, tail, __ATOMIC_RELEASE);
+
+        // Entries the kernel didn't take last time are submitted along with the new ones
+        const u32 unsubmitted = tail - __atomic_load_n(submission.head, __ATOMIC_ACQUIRE);
+        if (unsubmitted > 0)
+            syscall(__NR_io_uring_enter, uring_fd, unsubmitted, 0, 0, nullptr, 0);
+    }
+
+    void AsyncIo::ReapLoop() {
+        Profiler::SetThreadName("Async IO");
+
+        while (true) {
+            const long result = syscall(__NR_io_uring_enter, uring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result < 0 && errno != EINTR) {
+                LOG_ERROR("io_uring wait failed, errno {}", errno)
+            }
+
+            std::lock_guard<std::mutex> lock(queue_mutex);
+
+            u32 head = *completion.head;
+            const u32 tail = __atomic_load_n(completion.tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                const io_uring_cqe &cqe = cqes[head & completion.mask];
+                if (cqe.user_data == 0)
+                    continue;
+
+                const u32 slot = u32(cqe.user_data - 1);
+                Request request = slots[slot];
+                free_slots.push_back(slot);
+
+                if (Complete(request, cqe.res))
+                    queued.push_front(request);
+            }
+            __atomic_store_n(completion.head, head, __ATOMIC_RELEASE);
+
+            if (quit && queued.empty() && free_slots.size() == slots.size())
+                return;
+
+            PumpUring();
+        }
+    }
+#endif
+
+    AsyncIo &GetAsyncIo() {
+        static AsyncIo io;
+        return io;
+    }
+
+    std::vector<std::vector<u8>> ReadFiles(const std::vector<std::string> &paths) {
+        // Everything is opened before the first read is queued, a throw can't leave reads behind
+        std::vector<IoFile> files;
+        files.reserve(paths.size());
+        for (const auto &path : paths) {
+            files.emplace_back(path);
+            if (!files.back().IsValid()) {
+                throw std::runtime_error("failed to open " + path);
+            }
+        }
+
+        AsyncIo &io = GetAsyncIo();
+        IoBatch batch;
+
+        std::vector<std::vector<u8>> data(paths.size());
+        for (size_t i = 0; i < files.size(); i++) {
+            data[i].resize(files[i].GetSize());
+            io.Read(batch, files[i], 0, files[i].GetSize(), data[i].data());
+        }
+
+        io.Wait(batch);
+
+        if (batch.HasFailed()) {
+            throw std::runtime_error("failed to read files!");
+        }
+        return data;
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,249 @@
+#include <Public/Core/IO/PackFile.h>
+#include <Public/Core/Murmur.h>
+#include <Public/Core/Profiling.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef SQUID_WITH_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#ifdef SQUID_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Squid {
+namespace Core {
+
+    namespace fs = std::filesystem;
+
+    static constexpr u64 PACK_HASH_SEED = 0x5351504b;
+    // Packs are written once per shipping build, so the slow high ratio levels are worth it
+    static constexpr i32 PACK_ZSTD_LEVEL = 19;
+
+    u64 HashPackPath(std::string_view path) { return murmur64(path.data(), path.size(), PACK_HASH_SEED); }
+
+    bool IsPackCompressionSupported(PackCompression compression) {
+        switch (compression) {
+        case PACK_COMPRESSION_NONE: return true;
+#ifdef SQUID_WITH_LZ4
+        case PACK_COMPRESSION_LZ4: return true;
+#endif
+#ifdef SQUID_WITH_ZSTD
+        case PACK_COMPRESSION_ZSTD: return true;
+#endif
+        default: return false;
+        }
+    }
+
+    PackFile::PackFile(const std::string &path) : file(path) {
+        if (!file.IsValid() || file.GetSize() < sizeof(PackHeader))
+            return;
+
+        const u8 *data = file.GetData();
+        const u64 size = file.GetSize();
+        const PackHeader *mapped_header = (const PackHeader *)data;
+
+        if (mapped_header->magic != PACK_MAGIC || mapped_header->version != PACK_VERSION)
+            return;
+
+        if (mapped_header->toc_offset % alignof(PackEntry) != 0 ||
+            mapped_header->toc_offset + u64(mapped_header->entry_count) * sizeof(PackEntry) > size ||
+            mapped_header->names_offset + mapped_header->names_size > size)
+            return;
+
+        const PackEntry *mapped_entries = (const PackEntry *)(data + mapped_header->toc_offset);
+        for (u32 i = 0; i < mapped_header->entry_count; i++) {
+            const PackEntry &entry = mapped_entries[i];
+            if (entry.offset + entry.stored_size > size ||
+                u64(entry.name_offset) + entry.name_length > mapped_header->names_size)
+                return;
+            if (entry.compression == PACK_COMPRESSION_NONE && entry.stored_size != entry.size)
+                return;
+        }
+
+        header = mapped_header;
+        entries = mapped_entries;
+        names = (const char *)(data + mapped_header->names_offset);
+    }
+
+    std::string_view PackFile::GetName(const PackEntry &entry) const {
+        return std::string_view(names + entry.name_offset, entry.name_length);
+    }
+
+    const PackEntry *PackFile::Find(std::string_view path) const {
+        if (!header)
+            return nullptr;
+
+        const u64 hash = HashPackPath(path);
+        const PackEntry *end = entries + header->entry_count;
+        const PackEntry *entry = std::lower_bound(
+            entries, end, hash, [](const PackEntry &entry, u64 hash) { return entry.path_hash < hash; });
+
+        // The writer rejects colliding hashes, the name check only guards against paths that aren't in the pack
+        if (entry == end || entry->path_hash != hash || GetName(*entry) != path)
+            return nullptr;
+        return entry;
+    }
+
+    bool PackFile::Decompress(const PackEntry &entry, std::vector<u8> &data) const {
+        data.resize(entry.size);
+        const u8 *stored = GetStoredData(entry);
+
+        switch (entry.compression) {
+        case PACK_COMPRESSION_NONE:
+            memcpy(data.data(), stored, entry.size);
+            return true;
+#ifdef SQUID_WITH_LZ4
+        case PACK_COMPRESSION_LZ4:
+            return LZ4_decompress_safe(
+                       (const char *)stored, (char *)data.data(), i32(entry.stored_size), i32(entry.size)) ==
+                   i32(entry.size);
+#endif
+#ifdef SQUID_WITH_ZSTD
+        case PACK_COMPRESSION_ZSTD: {
+            const size_t result = ZSTD_decompress(data.data(), entry.size, stored, entry.stored_size);
+            return !ZSTD_isError(result) && result == entry.size;
+        }
+#endif
+        default: return false;
+        }
+    }
+
+    bool PackFile::Verify(const PackEntry &entry, const u8 *data) {
+        return murmur64(data, entry.size, 0) == entry.content_hash;
+    }
+
+    // Compresses data into stored, false when the codec isn't built in or the result isn't smaller
+    static bool Compress(PackCompression compression, const u8 *data, u64 size, std::vector<u8> &stored) {
+        switch (compression) {
+#ifdef SQUID_WITH_LZ4
+        case PACK_COMPRESSION_LZ4: {
+            if (size > u64(LZ4_MAX_INPUT_SIZE))
+                return false;
+
+            stored.resize(LZ4_compressBound(i32(size)));
+            const i32 result = LZ4_compress_HC(
+                (const char *)data, (char *)stored.data(), i32(size), i32(stored.size()), LZ4HC_CLEVEL_DEFAULT);
+            stored.resize(std::max(result, 0));
+            return result > 0 && u64(result) < size;
+        }
+#endif
+#ifdef SQUID_WITH_ZSTD
+        case PACK_COMPRESSION_ZSTD: {
+            stored.resize(ZSTD_compressBound(size));
+            const size_t result = ZSTD_compress(stored.data(), stored.size(), data, size, PACK_ZSTD_LEVEL);
+            if (ZSTD_isError(result))
+                return false;
+
+            stored.resize(result);
+            return result < size;
+        }
+#endif
+        default: return false;
+        }
+    }
+
+    void WritePack(const std::string &directory, const std::string &path, PackCompression compression) {
+        PROFILING_SCOPE
+
+        if (!IsPackCompressionSupported(compression)) {
+            throw std::runtime_error("pack compression is not built in!");
+        }
+
+        std::error_code error;
+        const fs::path pack_path = fs::weakly_canonical(path, error);
+
+        std::vector<std::string> names;
+        for (fs::recursive_directory_iterator it(directory, error), end; it != end; it.increment(error)) {
+            if (error) {
+                throw std::runtime_error("failed to list " + directory);
+            }
+
+            // An older pack written into the same directory is not part of the new one
+            if (it->is_regular_file() && fs::weakly_canonical(it->path(), error) != pack_path)
+                names.push_back(fs::relative(it->path(), directory).generic_string());
+        }
+        std::sort(names.begin(), names.end());
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("failed to create " + path);
+        }
+
+        // Header is written last, once the table is in place
+        static const char padding[PACK_ALIGNMENT] = {};
+        out.write(padding, PACK_ALIGNMENT);
+        u64 offset = PACK_ALIGNMENT;
+
+        std::vector<PackEntry> entries;
+        std::string name_table;
+        std::vector<u8> stored;
+
+        for (const auto &name : names) {
+            const std::string source = (fs::path(directory) / name).string();
+            MappedFile file(source);
+            if (!file.IsValid() && fs::file_size(source, error) != 0) {
+                throw std::runtime_error("failed to read " + source);
+            }
+
+            PackEntry entry = {};
+            entry.path_hash = HashPackPath(name);
+            entry.content_hash = murmur64(file.GetData(), file.GetSize(), 0);
+            entry.offset = offset;
+            entry.size = file.GetSize();
+            entry.name_offset = u32(name_table.size());
+            entry.name_length = u32(name.size());
+
+            const u8 *data = file.GetData();
+            entry.stored_size = entry.size;
+            entry.compression = PACK_COMPRESSION_NONE;
+            if (compression != PACK_COMPRESSION_NONE && Compress(compression, file.GetData(), file.GetSize(), stored)) {
+                data = stored.data();
+                entry.stored_size = stored.size();
+                entry.compression = compression;
+            }
+
+            out.write((const char *)data, entry.stored_size);
+
+            const u64 aligned = (offset + entry.stored_size + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+            out.write(padding, aligned - offset - entry.stored_size);
+            offset = aligned;
+
+            name_table += name;
+            entries.push_back(entry);
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const PackEntry &a, const PackEntry &b) {
+            return a.path_hash < b.path_hash;
+        });
+        for (size_t i = 1; i < entries.size(); i++) {
+            if (entries[i].path_hash == entries[i - 1].path_hash) {
+                throw std::runtime_error("pack path hash collision!");
+            }
+        }
+
+        PackHeader header;
+        header.entry_count = u32(entries.size());
+        header.toc_offset = offset;
+        header.names_offset = offset + entries.size() * sizeof(PackEntry);
+        header.names_size = u32(name_table.size());
+
+        out.write((const char *)entries.data(), entries.size() * sizeof(PackEntry));
+        out.write(name_table.data(), name_table.size());
+
+        out.seekp(0);
+        out.write((const char *)&header, sizeof(header));
+
+        if (!out) {
+            throw std::runtime_error("failed to write " + path);
+        }
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,178 @@
+#include <Public/Core/IO/VirtualFileSystem.h>
+#include <Public/Core/Log.h>
+#include <Public/Core/Memory/MemoryTracker.h>
+#include <Public/Core/Profiling.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+
+namespace Squid {
+namespace Core {
+
+    namespace fs = std::filesystem;
+
+    // "./Assets//Shaders/" and "Assets\Shaders" both become "Assets/Shaders", the root is ""
+    static std::string NormalizePath(const std::string &path) {
+        std::string normal = fs::path(path).lexically_normal().generic_string();
+        while (!normal.empty() && normal.back() == '/')
+            normal.pop_back();
+        return normal == "." ? std::string() : normal;
+    }
+
+    bool VirtualFileSystem::MountDirectory(const std::string &directory, const std::string &mount_point) {
+        std::error_code error;
+        if (!fs::is_directory(directory, error)) {
+            LOG_WARN("failed to mount {}, it is not a directory", directory)
+            return false;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        directories.push_back({directory, NormalizePath(mount_point), nullptr});
+        return true;
+    }
+
+    bool VirtualFileSystem::MountPack(const std::string &pack, const std::string &mount_point) {
+        PROFILING_SCOPE
+
+        auto file = std::make_shared<const PackFile>(pack);
+        if (!file->IsValid()) {
+            LOG_WARN("failed to mount {}, it is missing or not a valid pack", pack)
+            return false;
+        }
+
+        LOG_INFO("mounted {} with {} files", pack, file->GetEntryCount())
+
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        packs.push_back({pack, NormalizePath(mount_point), std::move(file)});
+        return true;
+    }
+
+    void VirtualFileSystem::Unmount(const std::string &source) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto is_source = [&](const Mount &mount) { return mount.source == source; };
+        directories.erase(std::remove_if(directories.begin(), directories.end(), is_source), directories.end());
+        packs.erase(std::remove_if(packs.begin(), packs.end(), is_source), packs.end());
+    }
+
+    bool VirtualFileSystem::GetRelativePath(const Mount &mount, const std::string &path, std::string &relative) {
+        if (mount.mount_point.empty()) {
+            relative = path;
+            return true;
+        }
+
+        const size_t length = mount.mount_point.size();
+        if (path.size() <= length || path[length] != '/' || path.compare(0, length, mount.mount_point) != 0)
+            return false;
+
+        relative = path.substr(length + 1);
+        return true;
+    }
+
+    std::string VirtualFileSystem::FindLoose(const std::string &path) const {
+        std::string relative;
+        std::error_code error;
+        for (auto mount = directories.rbegin(); mount != directories.rend(); mount++) {
+            if (!GetRelativePath(*mount, path, relative))
+                continue;
+
+            const fs::path file = fs::path(mount->source) / relative;
+            if (fs::is_regular_file(file, error))
+                return file.string();
+        }
+        return {};
+    }
+
+    const VirtualFileSystem::Mount *VirtualFileSystem::FindPacked(
+        const std::string &path, const PackEntry *&entry) const {
+        std::string relative;
+        for (auto mount = packs.rbegin(); mount != packs.rend(); mount++) {
+            if (!GetRelativePath(*mount, path, relative))
+                continue;
+
+            entry = mount->pack->Find(relative);
+            if (entry)
+                return &*mount;
+        }
+        return nullptr;
+    }
+
+    bool VirtualFileSystem::Exists(const std::string &path) const {
+        const std::string normal = NormalizePath(path);
+
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const PackEntry *entry;
+        return !FindLoose(normal).empty() || FindPacked(normal, entry);
+    }
+
+    bool VirtualFileSystem::IsPacked(const std::string &path) const {
+        const std::string normal = NormalizePath(path);
+
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        const PackEntry *entry;
+        return FindLoose(normal).empty() && FindPacked(normal, entry);
+    }
+
+    VfsFile VirtualFileSystem::Open(const std::string &path) const {
+        PROFILING_SCOPE
+        MemoryTagScope memory_tag(MEMORY_TAG_ASSETS);
+
+        const std::string normal = NormalizePath(path);
+        VfsFile file;
+
+        std::shared_lock<std::shared_mutex> lock(mutex);
+
+        const std::string loose = FindLoose(normal);
+        if (!loose.empty()) {
+            file.mapping = MappedFile(loose);
+            file.data = file.mapping.GetData();
+            file.size = file.mapping.GetSize();
+
+            // Empty files can't be mapped
+            std::error_code error;
+            file.valid = file.mapping.IsValid() || fs::file_size(loose, error) == 0;
+            return file;
+        }
+
+        const PackEntry *entry;
+        const Mount *mount = FindPacked(normal, entry);
+        if (!mount)
+            return file;
+
+        file.pack = mount->pack;
+        file.size = entry->size;
+
+        if (entry->compression == PACK_COMPRESSION_NONE) {
+            // Handed out in place, hashing here would fault in every page of the entry up front
+            file.data = file.pack->GetStoredData(*entry);
+            file.valid = true;
+            return file;
+        }
+
+        // Decompressed data is already in cache, checking it is cheap next to the decompression
+        if (!file.pack->Decompress(*entry, file.storage) || !PackFile::Verify(*entry, file.storage.data())) {
+            LOG_ERROR("{} is corrupt in {}", normal, mount->source)
+            return VfsFile();
+        }
+
+        file.data = file.storage.data();
+        file.valid = true;
+        return file;
+    }
+
+    std::string VirtualFileSystem::ReadTextFile(const std::string &path) const {
+        const VfsFile file = Open(path);
+        if (!file.IsValid()) {
+            throw std::runtime_error("failed to open " + path);
+        }
+        return std::string((const char *)file.GetData(), file.GetSize());
+    }
+
+    VirtualFileSystem &GetFileSystem() {
+        static VirtualFileSystem file_system;
+        return file_system;
+    }
+
+} // namespace Core
+} // namespace Squid
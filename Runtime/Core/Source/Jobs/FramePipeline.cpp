@@ -0,0 +1,117 @@
+#include <Public/Core/Jobs/FramePipeline.h>
+#include <Public/Core/Profiling.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace Squid {
+namespace Core {
+
+    FramePipeline::FramePipeline(RenderFunction render, u32 latency)
+        : render(std::move(render)), latency(std::min(latency, MAX_LATENCY)) {
+        if (this->latency > 0)
+            Start();
+    }
+
+    FramePipeline::~FramePipeline() { Stop(); }
+
+    void FramePipeline::Start() {
+        quit = false;
+        thread = std::thread(&FramePipeline::RenderLoop, this);
+    }
+
+    void FramePipeline::Stop() {
+        if (!thread.joinable())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        submitted_signal.notify_one();
+        thread.join();
+    }
+
+    void FramePipeline::WaitRendered(std::unique_lock<std::mutex> &lock) {
+        rendered_signal.wait(lock, [&]() { return rendered == submitted; });
+
+        if (error) {
+            std::exception_ptr thrown = error;
+            error = nullptr;
+            std::rethrow_exception(thrown);
+        }
+    }
+
+    void FramePipeline::Submit() {
+        PROFILING_SCOPE
+
+        if (latency == 0) {
+            render(write_index);
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // The previous frame's buffer is written next, it has to be rendered first
+            WaitRendered(lock);
+            submitted++;
+        }
+        submitted_signal.notify_one();
+        wait_time = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        write_index = (write_index + 1) % BUFFER_COUNT;
+    }
+
+    void FramePipeline::Flush() {
+        if (latency == 0)
+            return;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        WaitRendered(lock);
+    }
+
+    void FramePipeline::SetLatency(u32 latency) {
+        latency = std::min(latency, MAX_LATENCY);
+        if (latency == this->latency)
+            return;
+
+        Flush();
+        Stop();
+
+        this->latency = latency;
+        write_index = 0;
+        if (latency > 0)
+            Start();
+    }
+
+    void FramePipeline::RenderLoop() {
+        Profiler::SetThreadName("Render");
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            submitted_signal.wait(lock, [&]() { return quit || submitted > rendered; });
+            // Submitted frames are rendered before quitting
+            if (submitted == rendered)
+                return;
+
+            const u32 index = u32(rendered % BUFFER_COUNT);
+            lock.unlock();
+
+            std::exception_ptr thrown;
+            try {
+                render(index);
+            } catch (...) {
+                thrown = std::current_exception();
+            }
+
+            lock.lock();
+            if (thrown && !error)
+                error = thrown;
+            rendered++;
+            rendered_signal.notify_one();
+        }
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,334 @@
+#include <Public/Core/Jobs/JobSystem.h>
+#include <Public/Core/Profiling.h>
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <optional>
+#include <string>
+
+#ifdef SQUID_WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Squid {
+namespace Core {
+
+    // Failed find attempts before a worker goes to sleep
+    static constexpr u32 IDLE_SPINS = 64;
+    // Ranges handed out per thread when ParallelFor picks the grain
+    static constexpr u32 RANGES_PER_THREAD = 8;
+
+    struct ThreadSlot {
+        const JobSystem *system = nullptr;
+        u32 index = JobSystem::INVALID_THREAD;
+    };
+
+    static thread_local ThreadSlot current_thread;
+
+    static void PinThread(std::thread &thread, u32 core) {
+#ifdef SQUID_WIN32
+        SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << core);
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+    }
+
+    JobSystem::JobSystem(u32 worker_count) {
+        const u32 cores = std::max(1u, std::thread::hardware_concurrency());
+
+        for (u32 i = 0; i < worker_count + 1; i++) {
+            queues.push_back(std::make_unique<ThreadQueue>());
+        }
+
+        current_thread = {this, 0};
+
+        // Workers start at core 1, so with one worker less than cores the first core has none of them. The main,
+        // simulation and render threads aren't pinned, the scheduler moves them where there is room.
+        for (u32 i = 1; i <= worker_count; i++) {
+            threads.emplace_back([this, i]() { WorkerLoop(i); });
+            if (cores > 1)
+                PinThread(threads.back(), i % cores);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            quit = true;
+        }
+        wake.notify_all();
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        if (current_thread.system == this)
+            current_thread = {};
+    }
+
+    u32 JobSystem::GetThreadIndex() const {
+        return current_thread.system == this ? current_thread.index : INVALID_THREAD;
+    }
+
+    u32 JobSystem::GetGrain(u32 count, u32 grain) const {
+        if (grain > 0)
+            return grain;
+        return std::max(1u, count / (GetThreadCount() * RANGES_PER_THREAD));
+    }
+
+    Job *JobSystem::AllocateJob() {
+        const u32 thread = GetThreadIndex();
+        if (thread != INVALID_THREAD) {
+            // Slots free up roughly in order, so the next one is almost always available
+            ThreadQueue &queue = *queues[thread];
+            for (u32 i = 0; i < MAX_JOBS_PER_THREAD; i++) {
+                const u32 slot = queue.next_job++ % MAX_JOBS_PER_THREAD;
+                if (queue.busy[slot].load(std::memory_order_acquire))
+                    continue;
+
+                queue.busy[slot].store(1, std::memory_order_relaxed);
+                Job *job = &queue.jobs[slot];
+                *job = Job();
+                job->busy = &queue.busy[slot];
+                return job;
+            }
+        }
+
+        return new Job();
+    }
+
+    void JobSystem::Submit(Job *job) {
+        const u32 thread = GetThreadIndex();
+
+        if (thread == INVALID_THREAD) {
+            std::lock_guard<std::mutex> lock(shared_mutex);
+            shared_jobs.push_back(job);
+            shared_count.fetch_add(1, std::memory_order_release);
+        } else if (!queues[thread]->deque.Push(job)) {
+            // Deque is full, the caller does the work itself
+            Execute(job);
+            return;
+        }
+
+        pending.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            wake.notify_one();
+        }
+    }
+
+    void JobSystem::Run(JobCounter &counter, JobFunction function, const char *name, JobCounter *dependency) {
+        counter.value.fetch_add(1, std::memory_order_relaxed);
+
+        Job *job = AllocateJob();
+        job->function = std::move(function);
+        job->counter = &counter;
+        job->name = name;
+        job->memory_tag = GetMemoryTag();
+
+        if (dependency) {
+            // Checked under the lock, the last Finish on the dependency takes the waiting list under it too
+            std::lock_guard<SpinLock> lock(dependency->lock);
+            if (!dependency->IsDone()) {
+                dependency->waiting.push_back(job);
+                return;
+            }
+        }
+
+        Submit(job);
+    }
+
+    void JobSystem::ParallelFor(
+        JobCounter &counter, u32 count, u32 grain, const RangeFunction &function, const char *name) {
+        if (count == 0)
+            return;
+
+        counter.value.fetch_add(1, std::memory_order_relaxed);
+
+        Job *job = AllocateJob();
+        job->range_function = &function;
+        job->begin = 0;
+        job->end = count;
+        job->grain = GetGrain(count, grain);
+        job->counter = &counter;
+        job->name = name;
+        job->memory_tag = GetMemoryTag();
+
+        Submit(job);
+    }
+
+    void JobSystem::Finish(JobCounter &counter) {
+        if (counter.value.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        std::vector<Job *> released;
+        {
+            std::lock_guard<SpinLock> lock(counter.lock);
+            released.swap(counter.waiting);
+        }
+
+        for (Job *job : released) {
+            Submit(job);
+        }
+    }
+
+    void JobSystem::Execute(Job *job) {
+        MemoryTagScope memory_tag(job->memory_tag);
+
+        std::optional<ScopedProfile> profile;
+        if (job->name)
+            profile.emplace(job->name);
+
+        try {
+            if (job->range_function) {
+                // Keep the lower half and offer the upper one to thieves until the range fits the grain
+                while (job->end - job->begin > job->grain) {
+                    const u32 middle = job->begin + (job->end - job->begin) / 2;
+
+                    job->counter->value.fetch_add(1, std::memory_order_relaxed);
+
+                    Job *split = AllocateJob();
+                    split->range_function = job->range_function;
+                    split->begin = middle;
+                    split->end = job->end;
+                    split->grain = job->grain;
+                    split->counter = job->counter;
+                    split->name = job->name;
+                    split->memory_tag = job->memory_tag;
+
+                    job->end = middle;
+                    Submit(split);
+                }
+
+                (*job->range_function)(job->begin, job->end);
+            } else {
+                job->function();
+            }
+        } catch (...) {
+            // The worker carries on, Wait on the counter reports it
+            std::lock_guard<SpinLock> lock(job->counter->lock);
+            if (!job->counter->error)
+                job->counter->error = std::current_exception();
+        }
+
+        profile.reset();
+
+        JobCounter &counter = *job->counter;
+        if (job->busy)
+            job->busy->store(0, std::memory_order_release);
+        else
+            delete job;
+
+        Finish(counter);
+    }
+
+    Job *JobSystem::FindJob(u32 thread) {
+        Job *job = nullptr;
+
+        if (thread != INVALID_THREAD)
+            job = queues[thread]->deque.Pop();
+
+        if (!job && shared_count.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(shared_mutex);
+            if (!shared_jobs.empty()) {
+                job = shared_jobs.back();
+                shared_jobs.pop_back();
+                shared_count.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Steal round robin starting next to ourselves
+        const u32 count = u32(queues.size());
+        const u32 first = thread != INVALID_THREAD ? thread + 1 : 0;
+        for (u32 i = 0; !job && i < count; i++) {
+            const u32 victim = (first + i) % count;
+            if (victim != thread)
+                job = queues[victim]->deque.Steal();
+        }
+
+        if (job)
+            pending.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    void JobSystem::Wait(JobCounter &counter) {
+        const u32 thread = GetThreadIndex();
+
+        while (!counter.IsDone()) {
+            if (Job *job = FindJob(thread))
+                Execute(job);
+            else
+                std::this_thread::yield();
+        }
+
+        if (counter.error) {
+            std::exception_ptr error = counter.error;
+            counter.error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    void JobSystem::WorkerLoop(u32 thread) {
+        current_thread = {this, thread};
+        Profiler::SetThreadName("Worker " + std::to_string(thread));
+
+        u32 idle = 0;
+        while (true) {
+            if (Job *job = FindJob(thread)) {
+                Execute(job);
+                idle = 0;
+                continue;
+            }
+
+            if (++idle < IDLE_SPINS) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleeping.fetch_add(1, std::memory_order_seq_cst);
+            wake.wait(lock, [&]() { return quit || pending.load(std::memory_order_seq_cst) > 0; });
+            sleeping.fetch_sub(1, std::memory_order_seq_cst);
+            idle = 0;
+
+            if (quit)
+                return;
+        }
+    }
+
+    JobSystem &GetJobSystem() {
+        static JobSystem system(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return system;
+    }
+
+    void ParallelFor(u32 count, u32 grain, const RangeFunction &function, const char *name) {
+        ParallelFor(GetJobSystem(), count, grain, function, name);
+    }
+
+    void ParallelFor(JobSystem &system, u32 count, u32 grain, const RangeFunction &function, const char *name) {
+        grain = system.GetGrain(count, grain);
+
+        // Not worth a job, or nobody to share it with
+        if (count <= grain || system.GetThreadCount() == 1) {
+            for (u32 begin = 0; begin < count; begin += grain) {
+                function(begin, std::min(begin + grain, count));
+            }
+            return;
+        }
+
+        // Exceptions are rethrown by Wait
+        JobCounter counter;
+        system.ParallelFor(counter, count, grain, function, name);
+        system.Wait(counter);
+    }
+
+} // namespace Core
+} // namespace Squid
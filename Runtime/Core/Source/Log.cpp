@@ -1,15 +1,182 @@
 #include <pch.h>
 #include <Public/Core/Log.h>
+#include <Public/Core/Profiling.h>
+
+#include <spdlog/sinks/dist_sink.h>
+
+#include <condition_variable>
+#include <thread>
+#include <vector>
 
 namespace Squid {
 namespace Core {
 
-    void InitializeLogger(std::string name) {
+    // How long the logger thread sleeps between passes when nothing wakes it
+    static constexpr std::chrono::milliseconds LOGGER_INTERVAL(10);
+
+    // Drains the per thread buffers in timestamp order and writes them to the sinks of the default logger
+    class AsyncLogger {
+    public:
+        explicit AsyncLogger(std::shared_ptr<spdlog::logger> logger) : logger(std::move(logger)) {
+            thread = std::thread([this]() { Run(); });
+        }
+
+        ~AsyncLogger() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+            }
+            signal.notify_one();
+            thread.join();
+        }
+
+        std::shared_ptr<LogBuffer> Register() {
+            auto buffer = std::make_shared<LogBuffer>();
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(buffer);
+            return buffer;
+        }
+
+        void Wake() { signal.notify_one(); }
+
+    private:
+        void Run() {
+            Profiler::SetThreadName("Logger");
+
+            std::vector<std::shared_ptr<LogBuffer>> active;
+            spdlog::memory_buf_t buffer;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                const bool stopping = quit;
+                active = buffers;
+                lock.unlock();
+
+                Drain(active, buffer);
+
+                lock.lock();
+                // Drained buffers of exited threads are freed
+                buffers.erase(
+                    std::remove_if(buffers.begin(), buffers.end(),
+                                   [](const auto &buffer) { return buffer->retired.load() && !buffer->Peek(); }),
+                    buffers.end());
+
+                if (stopping)
+                    break;
+                signal.wait_for(lock, LOGGER_INTERVAL);
+            }
+        }
+
+        void Drain(std::vector<std::shared_ptr<LogBuffer>> &active, spdlog::memory_buf_t &buffer) {
+            for (const auto &staging : active) {
+                if (const u64 dropped = staging->dropped.exchange(0, std::memory_order_relaxed)) {
+                    Write(spdlog::level::warn, spdlog::log_clock::now(), spdlog::details::os::thread_id(), {},
+                          fmt::format("logging fell behind, {} messages were dropped", dropped));
+                }
+            }
+
+            // Records of different threads are merged by time. A pass is bounded so threads that keep logging can't
+            // hold off new buffers and the flush.
+            size_t written = 0;
+            const size_t limit = active.size() * LogBuffer::CAPACITY;
+            for (; written < limit; written++) {
+                LogBuffer *next = nullptr;
+                LogRecord *oldest = nullptr;
+                for (const auto &staging : active) {
+                    LogRecord *record = staging->Peek();
+                    if (record && (!oldest || record->time < oldest->time)) {
+                        next = staging.get();
+                        oldest = record;
+                    }
+                }
+
+                if (!oldest)
+                    break;
+
+                buffer.clear();
+                oldest->format(*oldest, buffer);
+                Write(oldest->level, oldest->time, oldest->thread_id, oldest->location,
+                      std::string_view(buffer.data(), buffer.size()));
+                next->Release();
+            }
+
+            if (written > 0) {
+                for (const auto &sink : logger->sinks()) {
+                    sink->flush();
+                }
+            }
+        }
+
+        void Write(spdlog::level::level_enum level, spdlog::log_clock::time_point time, size_t thread_id,
+                   spdlog::source_loc location, std::string_view text) {
+            spdlog::details::log_msg message(time, location, logger->name(), level, text);
+            message.thread_id = thread_id;
 
-        auto sink = std::make_shared<sink_mt>();
+            for (const auto &sink : logger->sinks()) {
+                if (sink->should_log(level))
+                    sink->log(message);
+            }
+        }
+
+        std::shared_ptr<spdlog::logger> logger;
+
+        std::mutex mutex;
+        std::condition_variable signal;
+        std::vector<std::shared_ptr<LogBuffer>> buffers;
+        bool quit = false;
+
+        std::thread thread;
+    };
+
+    static std::unique_ptr<AsyncLogger> async_logger;
+
+    // The logger's only sink, forwards to the others under its own lock
+    static std::shared_ptr<spdlog::sinks::dist_sink_mt> GetDistributionSink() {
+        static auto sink = std::make_shared<spdlog::sinks::dist_sink_mt>();
+        return sink;
+    }
+
+    // Owns the staging buffer of a thread and retires it when the thread exits
+    struct ThreadLogBuffer {
+        std::shared_ptr<LogBuffer> buffer;
+
+        ~ThreadLogBuffer() {
+            if (buffer)
+                buffer->retired.store(true);
+        }
+    };
+
+    LogBuffer *GetThreadLogBuffer() {
+        if (!async_logger)
+            return nullptr;
+
+        thread_local ThreadLogBuffer staging;
+        if (!staging.buffer)
+            staging.buffer = async_logger->Register();
+        return staging.buffer.get();
+    }
+
+    void WakeLogger() {
+        if (async_logger)
+            async_logger->Wake();
+    }
+
+    // Meant to be called once at startup, before other threads log
+    void InitializeLogger(std::string name, LogMode mode) {
+
+        auto sink = GetDistributionSink();
+        sink->set_sinks({std::make_shared<sink_mt>()});
         auto logger = std::make_shared<spdlog::logger>(name, sink);
         spdlog::set_default_logger(logger);
+
+        async_logger.reset();
+        if (mode == LogMode::ASYNC)
+            async_logger = std::make_unique<AsyncLogger>(logger);
     };
 
+    void AddLogSink(std::shared_ptr<spdlog::sinks::sink> sink) { GetDistributionSink()->add_sink(sink); }
+
+    void RemoveLogSink(std::shared_ptr<spdlog::sinks::sink> sink) { GetDistributionSink()->remove_sink(sink); }
+
 }; // namespace Core
 } // namespace Squid
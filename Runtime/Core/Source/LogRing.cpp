@@ -0,0 +1,88 @@
+#include <Public/Core/LogRing.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Squid {
+namespace Core {
+
+    LogRing::LogRing() : slots(std::make_unique<Slot[]>(CAPACITY)) {}
+
+    void LogRing::Push(const LogEntry &entry) {
+        const u64 index = end.load(std::memory_order_relaxed);
+        Slot &slot = slots[index & MASK];
+
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot.entry, &entry, sizeof(LogEntry));
+        slot.sequence.store(2 * (index + 1), std::memory_order_release);
+
+        end.store(index + 1, std::memory_order_release);
+    }
+
+    bool LogRing::Read(u64 index, LogEntry &entry) const {
+        const Slot &slot = slots[index & MASK];
+
+        if (slot.sequence.load(std::memory_order_acquire) != 2 * (index + 1))
+            return false;
+
+        memcpy(&entry, &slot.entry, sizeof(LogEntry));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        // Overwritten while it was copied
+        return slot.sequence.load(std::memory_order_relaxed) == 2 * (index + 1);
+    }
+
+    LogRing &GetLogRing() {
+        static LogRing ring;
+        return ring;
+    }
+
+    // "Runtime/Renderer/Source/Module.cpp" is logged from Renderer
+    static std::string_view GetModuleName(const char *file) {
+        if (!file)
+            return {};
+
+        const std::string_view path(file);
+        for (std::string_view root : {"Runtime/", "Runtime\\", "Editor/", "Editor\\"}) {
+            const size_t start = path.rfind(root);
+            if (start == std::string_view::npos)
+                continue;
+
+            const std::string_view rest = path.substr(start + root.size());
+            return rest.substr(0, rest.find_first_of("/\\"));
+        }
+        return {};
+    }
+
+    void LogRingSink::sink_it_(const spdlog::details::log_msg &msg) {
+        LogEntry entry;
+        entry.time = msg.time;
+        entry.thread_id = msg.thread_id;
+        entry.level = msg.level;
+
+        const std::string_view module = GetModuleName(msg.source.filename);
+        const size_t module_length = std::min(module.size(), LogEntry::MODULE_SIZE - 1);
+        memcpy(entry.module, module.data(), module_length);
+        entry.module[module_length] = '\0';
+
+        // Every line is a row of its own, compiler output and the like stay readable
+        std::string_view text(msg.payload.data(), msg.payload.size());
+        do {
+            const size_t line_end = text.find('\n');
+            std::string_view line = text.substr(0, line_end);
+            text = line_end == std::string_view::npos ? std::string_view() : text.substr(line_end + 1);
+
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+
+            entry.truncated = line.size() > LogEntry::TEXT_SIZE;
+            entry.length = u16(std::min(line.size(), LogEntry::TEXT_SIZE));
+            memcpy(entry.text, line.data(), entry.length);
+
+            ring.Push(entry);
+        } while (!text.empty());
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,113 @@
+#include <Public/Core/MappedFile.h>
+#include <utility>
+
+#ifdef SQUID_WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Squid {
+namespace Core {
+
+#ifdef SQUID_WIN32
+    MappedFile::MappedFile(const std::string &path) {
+        HANDLE file = CreateFileA(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(file);
+            return;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return;
+        }
+
+        data = (const u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return;
+        }
+
+        size = u64(file_size.QuadPart);
+        file_handle = file;
+        mapping_handle = mapping;
+    }
+
+    void MappedFile::Close() {
+        if (data)
+            UnmapViewOfFile(data);
+        if (mapping_handle)
+            CloseHandle(mapping_handle);
+        if (file_handle)
+            CloseHandle(file_handle);
+
+        data = nullptr;
+        size = 0;
+        mapping_handle = nullptr;
+        file_handle = nullptr;
+    }
+#else
+    MappedFile::MappedFile(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return;
+        }
+
+        void *mapping = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping keeps its own reference to the file
+        close(fd);
+
+        if (mapping == MAP_FAILED)
+            return;
+
+        madvise(mapping, size_t(info.st_size), MADV_SEQUENTIAL);
+
+        data = (const u8 *)mapping;
+        size = u64(info.st_size);
+    }
+
+    void MappedFile::Close() {
+        if (data)
+            munmap((void *)data, size_t(size));
+
+        data = nullptr;
+        size = 0;
+    }
+#endif
+
+    MappedFile::~MappedFile() { Close(); }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            Close();
+            std::swap(data, other.data);
+            std::swap(size, other.size);
+#ifdef SQUID_WIN32
+            std::swap(file_handle, other.file_handle);
+            std::swap(mapping_handle, other.mapping_handle);
+#endif
+        }
+        return *this;
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,456 @@
+#include <Public/Core/Math/DynamicBvh.h>
+#include <Public/Core/Jobs/JobSystem.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace Squid {
+namespace Core {
+
+    // Fat boxes grow by this fraction of their size plus a constant on every side
+    static constexpr f32 FAT_MARGIN_SCALE = 0.1f;
+    static constexpr f32 FAT_MARGIN = 0.01f;
+
+    // Trees with fewer leaves are queried on the calling thread
+    static constexpr u32 PARALLEL_QUERY_LEAVES = 1024;
+    // Subtrees handed out per job system thread
+    static constexpr u32 SUBTREES_PER_THREAD = 4;
+
+    enum class FrustumTest { OUTSIDE, INTERSECTS, INSIDE };
+
+    static inline f32 SurfaceArea(const glm::vec3 &min, const glm::vec3 &max) {
+        const glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    static FrustumTest TestBoxFrustum(const glm::vec3 &min, const glm::vec3 &max, const glm::vec4 *planes) {
+        FrustumTest result = FrustumTest::INSIDE;
+        for (u32 i = 0; i < 6; i++) {
+            const glm::vec3 normal = glm::vec3(planes[i]);
+
+            // Corners furthest along and against the plane normal
+            const glm::vec3 positive(
+                normal.x >= 0.0f ? max.x : min.x, normal.y >= 0.0f ? max.y : min.y, normal.z >= 0.0f ? max.z : min.z);
+            const glm::vec3 negative(
+                normal.x >= 0.0f ? min.x : max.x, normal.y >= 0.0f ? min.y : max.y, normal.z >= 0.0f ? min.z : max.z);
+
+            if (glm::dot(normal, positive) + planes[i].w < 0.0f)
+                return FrustumTest::OUTSIDE;
+            if (glm::dot(normal, negative) + planes[i].w < 0.0f)
+                result = FrustumTest::INTERSECTS;
+        }
+        return result;
+    }
+
+    // Distance at which the ray enters the box, clamped to 0 when it starts inside, infinity on a miss
+    static f32 IntersectRayBox(
+        const glm::vec3 &origin, const glm::vec3 &inverse_direction, const glm::vec3 &min, const glm::vec3 &max) {
+        f32 enter = 0.0f;
+        f32 exit = std::numeric_limits<f32>::infinity();
+        for (u32 axis = 0; axis < 3; axis++) {
+            f32 t0 = (min[axis] - origin[axis]) * inverse_direction[axis];
+            f32 t1 = (max[axis] - origin[axis]) * inverse_direction[axis];
+            if (t0 > t1)
+                std::swap(t0, t1);
+            // Written so NaNs from a zero direction on the slab border leave the interval as is
+            enter = t0 > enter ? t0 : enter;
+            exit = t1 < exit ? t1 : exit;
+        }
+        return enter <= exit ? enter : std::numeric_limits<f32>::infinity();
+    }
+
+    // Traversal stack that lives on the call stack while the tree is as shallow as balancing keeps it and moves to
+    // the heap for anything deeper
+    class NodeStack {
+    public:
+        NodeStack(const NodeStack &) = delete;
+        NodeStack &operator=(const NodeStack &) = delete;
+        explicit NodeStack(u32 node) { local[size++] = node; }
+
+        inline void Push(u32 node) {
+            if (size == capacity)
+                Grow();
+            data[size++] = node;
+        }
+        inline u32 Pop() { return data[--size]; }
+        inline bool IsEmpty() const { return size == 0; }
+
+    private:
+        void Grow() {
+            std::vector<u32> grown(capacity * 2);
+            std::copy(data, data + size, grown.data());
+            heap.swap(grown);
+            data = heap.data();
+            capacity *= 2;
+        }
+
+        static constexpr u32 LOCAL_CAPACITY = 64;
+
+        u32 local[LOCAL_CAPACITY];
+        std::vector<u32> heap;
+        u32 *data = local;
+        u32 size = 0;
+        u32 capacity = LOCAL_CAPACITY;
+    };
+
+    u32 DynamicBvh::AllocateNode() {
+        if (free_list == INVALID_NODE) {
+            nodes.emplace_back();
+            return u32(nodes.size() - 1);
+        }
+
+        const u32 index = free_list;
+        free_list = nodes[index].parent;
+        nodes[index] = Node();
+        return index;
+    }
+
+    void DynamicBvh::FreeNode(u32 index) {
+        nodes[index].parent = free_list;
+        nodes[index].height = -1;
+        free_list = index;
+    }
+
+    u32 DynamicBvh::Insert(const glm::vec3 &min, const glm::vec3 &max, u32 user_data) {
+        const u32 leaf = AllocateNode();
+        Node &node = nodes[leaf];
+        node.user_data = user_data;
+        node.leaf_min = min;
+        node.leaf_max = max;
+
+        const glm::vec3 margin = (max - min) * FAT_MARGIN_SCALE + FAT_MARGIN;
+        node.min = min - margin;
+        node.max = max + margin;
+
+        InsertLeaf(leaf);
+        leaf_count++;
+        return leaf;
+    }
+
+    void DynamicBvh::Remove(u32 proxy) {
+        assert(proxy < nodes.size() && nodes[proxy].IsLeaf() && nodes[proxy].height == 0);
+
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+        leaf_count--;
+    }
+
+    bool DynamicBvh::Move(u32 proxy, const glm::vec3 &min, const glm::vec3 &max) {
+        assert(proxy < nodes.size() && nodes[proxy].IsLeaf() && nodes[proxy].height == 0);
+
+        Node &node = nodes[proxy];
+        node.leaf_min = min;
+        node.leaf_max = max;
+
+        if (glm::all(glm::lessThanEqual(node.min, min)) && glm::all(glm::lessThanEqual(max, node.max)))
+            return false;
+
+        RemoveLeaf(proxy);
+
+        const glm::vec3 margin = (max - min) * FAT_MARGIN_SCALE + FAT_MARGIN;
+        nodes[proxy].min = min - margin;
+        nodes[proxy].max = max + margin;
+
+        InsertLeaf(proxy);
+        return true;
+    }
+
+    void DynamicBvh::InsertLeaf(u32 leaf) {
+        if (root == INVALID_NODE) {
+            root = leaf;
+            nodes[leaf].parent = INVALID_NODE;
+            return;
+        }
+
+        const glm::vec3 leaf_min = nodes[leaf].min;
+        const glm::vec3 leaf_max = nodes[leaf].max;
+
+        // Descend towards the sibling that grows the total surface area the least
+        u32 index = root;
+        while (!nodes[index].IsLeaf()) {
+            const Node &node = nodes[index];
+
+            const f32 area = SurfaceArea(node.min, node.max);
+            const f32 combined_area = SurfaceArea(glm::min(node.min, leaf_min), glm::max(node.max, leaf_max));
+
+            // Making a new parent here, or the growth every ancestor below has to take
+            const f32 cost = 2.0f * combined_area;
+            const f32 inheritance_cost = 2.0f * (combined_area - area);
+
+            f32 child_costs[2];
+            for (u32 i = 0; i < 2; i++) {
+                const Node &child = nodes[node.children[i]];
+                const f32 child_area = SurfaceArea(glm::min(child.min, leaf_min), glm::max(child.max, leaf_max));
+                child_costs[i] = (child.IsLeaf() ? child_area : child_area - SurfaceArea(child.min, child.max)) +
+                                 inheritance_cost;
+            }
+
+            if (cost < child_costs[0] && cost < child_costs[1])
+                break;
+
+            index = child_costs[0] < child_costs[1] ? node.children[0] : node.children[1];
+        }
+
+        const u32 sibling = index;
+        const u32 old_parent = nodes[sibling].parent;
+        const u32 new_parent = AllocateNode();
+
+        Node &parent = nodes[new_parent];
+        parent.parent = old_parent;
+        parent.min = glm::min(nodes[sibling].min, leaf_min);
+        parent.max = glm::max(nodes[sibling].max, leaf_max);
+        parent.height = nodes[sibling].height + 1;
+        parent.children[0] = sibling;
+        parent.children[1] = leaf;
+
+        if (old_parent != INVALID_NODE) {
+            Node &grand_parent = nodes[old_parent];
+            grand_parent.children[grand_parent.children[0] == sibling ? 0 : 1] = new_parent;
+        } else {
+            root = new_parent;
+        }
+
+        nodes[sibling].parent = new_parent;
+        nodes[leaf].parent = new_parent;
+
+        Refit(new_parent);
+    }
+
+    void DynamicBvh::RemoveLeaf(u32 leaf) {
+        if (leaf == root) {
+            root = INVALID_NODE;
+            return;
+        }
+
+        const u32 parent = nodes[leaf].parent;
+        const u32 grand_parent = nodes[parent].parent;
+        const u32 sibling = nodes[parent].children[nodes[parent].children[0] == leaf ? 1 : 0];
+
+        // The sibling takes the place of the parent
+        if (grand_parent != INVALID_NODE) {
+            Node &node = nodes[grand_parent];
+            node.children[node.children[0] == parent ? 0 : 1] = sibling;
+            nodes[sibling].parent = grand_parent;
+            FreeNode(parent);
+
+            Refit(grand_parent);
+        } else {
+            root = sibling;
+            nodes[sibling].parent = INVALID_NODE;
+            FreeNode(parent);
+        }
+    }
+
+    void DynamicBvh::Refit(u32 index) {
+        while (index != INVALID_NODE) {
+            index = Balance(index);
+
+            Node &node = nodes[index];
+            const Node &a = nodes[node.children[0]];
+            const Node &b = nodes[node.children[1]];
+
+            node.height = 1 + std::max(a.height, b.height);
+            node.min = glm::min(a.min, b.min);
+            node.max = glm::max(a.max, b.max);
+
+            index = node.parent;
+        }
+    }
+
+    // Rotates the taller grandchild up when the children of index differ in height by more than one,
+    // returns the node that now sits where index was
+    u32 DynamicBvh::Balance(u32 index_a) {
+        Node &a = nodes[index_a];
+        if (a.IsLeaf() || a.height < 2)
+            return index_a;
+
+        const u32 index_b = a.children[0];
+        const u32 index_c = a.children[1];
+        Node &b = nodes[index_b];
+        Node &c = nodes[index_c];
+
+        const i32 balance = c.height - b.height;
+        if (balance >= -1 && balance <= 1)
+            return index_a;
+
+        // Lift the taller child, rotating towards the b or the c side
+        const bool lift_c = balance > 1;
+        const u32 index_up = lift_c ? index_c : index_b;
+        const u32 index_other = lift_c ? index_b : index_c;
+        Node &up = nodes[index_up];
+        const Node &other = nodes[index_other];
+
+        const u32 index_f = up.children[0];
+        const u32 index_g = up.children[1];
+        Node &f = nodes[index_f];
+        Node &g = nodes[index_g];
+
+        // up replaces a, a becomes its first child
+        up.children[0] = index_a;
+        up.parent = a.parent;
+        a.parent = index_up;
+
+        if (up.parent != INVALID_NODE) {
+            Node &parent = nodes[up.parent];
+            parent.children[parent.children[0] == index_a ? 0 : 1] = index_up;
+        } else {
+            root = index_up;
+        }
+
+        // The taller grandchild stays with up, the shorter one moves down into the slot up left in a
+        const bool keep_f = f.height > g.height;
+        const u32 index_keep = keep_f ? index_f : index_g;
+        const u32 index_move = keep_f ? index_g : index_f;
+        Node &keep = nodes[index_keep];
+        Node &move = nodes[index_move];
+
+        up.children[1] = index_keep;
+        a.children[lift_c ? 1 : 0] = index_move;
+        move.parent = index_a;
+
+        a.min = glm::min(other.min, move.min);
+        a.max = glm::max(other.max, move.max);
+        a.height = 1 + std::max(other.height, move.height);
+
+        up.min = glm::min(a.min, keep.min);
+        up.max = glm::max(a.max, keep.max);
+        up.height = 1 + std::max(a.height, keep.height);
+
+        return index_up;
+    }
+
+    void DynamicBvh::CollectLeaves(u32 index, FrameVector<u32> &results) const {
+        NodeStack stack(index);
+        while (!stack.IsEmpty()) {
+            const Node &node = nodes[stack.Pop()];
+            if (node.IsLeaf()) {
+                results.push_back(node.user_data);
+                continue;
+            }
+            stack.Push(node.children[0]);
+            stack.Push(node.children[1]);
+        }
+    }
+
+    void DynamicBvh::QueryFrustum(u32 index, const glm::vec4 *planes, FrameVector<u32> &results) const {
+        NodeStack stack(index);
+        while (!stack.IsEmpty()) {
+            const u32 current = stack.Pop();
+            const Node &node = nodes[current];
+
+            if (node.IsLeaf()) {
+                if (TestBoxFrustum(node.leaf_min, node.leaf_max, planes) != FrustumTest::OUTSIDE)
+                    results.push_back(node.user_data);
+                continue;
+            }
+
+            const FrustumTest test = TestBoxFrustum(node.min, node.max, planes);
+            if (test == FrustumTest::OUTSIDE)
+                continue;
+
+            // Exact boxes sit inside the fat ones, so everything below is visible
+            if (test == FrustumTest::INSIDE) {
+                CollectLeaves(current, results);
+                continue;
+            }
+
+            stack.Push(node.children[0]);
+            stack.Push(node.children[1]);
+        }
+    }
+
+    void DynamicBvh::QueryFrustum(const glm::vec4 *planes, FrameVector<u32> &results) const {
+        if (root == INVALID_NODE)
+            return;
+
+        const u32 thread_count = GetJobSystem().GetThreadCount();
+        if (leaf_count < PARALLEL_QUERY_LEAVES || thread_count == 1) {
+            QueryFrustum(root, planes, results);
+            return;
+        }
+
+        // Open the top of the tree breadth first until there are enough intersecting subtrees to go around
+        const u32 target = thread_count * SUBTREES_PER_THREAD;
+        FrameVector<u32> subtrees(GetFrameAllocator());
+        subtrees.reserve(2 * target);
+        subtrees.push_back(root);
+        size_t head = 0;
+
+        while (head < subtrees.size() && subtrees.size() - head < target) {
+            const u32 current = subtrees[head++];
+            const Node &node = nodes[current];
+
+            if (node.IsLeaf()) {
+                if (TestBoxFrustum(node.leaf_min, node.leaf_max, planes) != FrustumTest::OUTSIDE)
+                    results.push_back(node.user_data);
+                continue;
+            }
+
+            const FrustumTest test = TestBoxFrustum(node.min, node.max, planes);
+            if (test == FrustumTest::INSIDE) {
+                CollectLeaves(current, results);
+            } else if (test == FrustumTest::INTERSECTS) {
+                subtrees.push_back(node.children[0]);
+                subtrees.push_back(node.children[1]);
+            }
+        }
+
+        std::mutex mutex;
+        ParallelFor(u32(subtrees.size() - head), 1, [&](u32 begin, u32 end) {
+            FrameVector<u32> local(GetFrameAllocator());
+            for (u32 i = begin; i < end; i++) {
+                QueryFrustum(subtrees[head + i], planes, local);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            results.insert(results.end(), local.begin(), local.end());
+        });
+    }
+
+    u32 DynamicBvh::RayCast(const glm::vec3 &origin, const glm::vec3 &direction, f32 max_distance, f32 *distance)
+        const {
+        if (root == INVALID_NODE)
+            return INVALID_NODE;
+
+        const glm::vec3 inverse_direction = 1.0f / direction;
+
+        f32 closest = max_distance;
+        u32 hit = INVALID_NODE;
+
+        NodeStack stack(root);
+        while (!stack.IsEmpty()) {
+            const Node &node = nodes[stack.Pop()];
+            // Misses come back as infinity, which max_distance may be as well
+            const f32 enter = IntersectRayBox(origin, inverse_direction, node.min, node.max);
+            if (!std::isfinite(enter) || enter > closest)
+                continue;
+
+            if (node.IsLeaf()) {
+                const f32 t = IntersectRayBox(origin, inverse_direction, node.leaf_min, node.leaf_max);
+                if (std::isfinite(t) && t <= closest) {
+                    closest = t;
+                    hit = node.user_data;
+                }
+                continue;
+            }
+
+            // Nearer child last so it pops first and tightens the bound early
+            const Node &a = nodes[node.children[0]];
+            const Node &b = nodes[node.children[1]];
+            const bool a_first = IntersectRayBox(origin, inverse_direction, a.min, a.max) <=
+                                 IntersectRayBox(origin, inverse_direction, b.min, b.max);
+
+            stack.Push(a_first ? node.children[1] : node.children[0]);
+            stack.Push(a_first ? node.children[0] : node.children[1]);
+        }
+
+        if (hit != INVALID_NODE && distance)
+            *distance = closest;
+        return hit;
+    }
+
+} // namespace Core
+} // namespace Squid
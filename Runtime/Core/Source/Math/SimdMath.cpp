@@ -0,0 +1,303 @@
+#include <Public/Core/Math/SimdMath.h>
+
+#include <cmath>
+
+namespace Squid {
+namespace Core {
+
+    // One register of lanes, the kernels below are written once against this
+#if defined(SQUID_SIMD_AVX2)
+    struct Lanes {
+        using Type = __m256;
+        static constexpr size_t WIDTH = 8;
+
+        static inline Type Load(const f32 *p) { return _mm256_loadu_ps(p); }
+        static inline void Store(f32 *p, Type v) { _mm256_storeu_ps(p, v); }
+        static inline Type Set(f32 v) { return _mm256_set1_ps(v); }
+        static inline Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+        static inline Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+        static inline Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+        static inline Type GreaterEqual(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        static inline Type And(Type a, Type b) { return _mm256_and_ps(a, b); }
+        static inline Type Abs(Type v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+        static inline u32 Mask(Type v) { return u32(_mm256_movemask_ps(v)); }
+    };
+#elif defined(SQUID_SIMD_SSE)
+    struct Lanes {
+        using Type = __m128;
+        static constexpr size_t WIDTH = 4;
+
+        static inline Type Load(const f32 *p) { return _mm_loadu_ps(p); }
+        static inline void Store(f32 *p, Type v) { _mm_storeu_ps(p, v); }
+        static inline Type Set(f32 v) { return _mm_set1_ps(v); }
+        static inline Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+        static inline Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+        static inline Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+        static inline Type GreaterEqual(Type a, Type b) { return _mm_cmpge_ps(a, b); }
+        static inline Type And(Type a, Type b) { return _mm_and_ps(a, b); }
+        static inline Type Abs(Type v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+        static inline u32 Mask(Type v) { return u32(_mm_movemask_ps(v)); }
+    };
+#endif
+
+    // == TRS COMPOSITION ==============================
+
+    void ComposeTransforms(const TransformStreams &transforms, glm::mat4 *matrices, size_t count) {
+        size_t i = 0;
+
+#if defined(SQUID_SIMD_AVX2) || defined(SQUID_SIMD_SSE)
+        using L = Lanes;
+        const L::Type one = L::Set(1.0f);
+        const L::Type two = L::Set(2.0f);
+
+        for (; i + L::WIDTH <= count; i += L::WIDTH) {
+            const L::Type x = L::Load(transforms.rotation[0] + i);
+            const L::Type y = L::Load(transforms.rotation[1] + i);
+            const L::Type z = L::Load(transforms.rotation[2] + i);
+            const L::Type w = L::Load(transforms.rotation[3] + i);
+            const L::Type sx = L::Load(transforms.scale[0] + i);
+            const L::Type sy = L::Load(transforms.scale[1] + i);
+            const L::Type sz = L::Load(transforms.scale[2] + i);
+
+            const L::Type xx = L::Mul(x, x), yy = L::Mul(y, y), zz = L::Mul(z, z);
+            const L::Type xy = L::Mul(x, y), xz = L::Mul(x, z), yz = L::Mul(y, z);
+            const L::Type wx = L::Mul(w, x), wy = L::Mul(w, y), wz = L::Mul(w, z);
+
+            // The scaled 3x3 part, column major
+            f32 columns[9][L::WIDTH];
+            L::Store(columns[0], L::Mul(L::Sub(one, L::Mul(two, L::Add(yy, zz))), sx));
+            L::Store(columns[1], L::Mul(L::Mul(two, L::Add(xy, wz)), sx));
+            L::Store(columns[2], L::Mul(L::Mul(two, L::Sub(xz, wy)), sx));
+            L::Store(columns[3], L::Mul(L::Mul(two, L::Sub(xy, wz)), sy));
+            L::Store(columns[4], L::Mul(L::Sub(one, L::Mul(two, L::Add(xx, zz))), sy));
+            L::Store(columns[5], L::Mul(L::Mul(two, L::Add(yz, wx)), sy));
+            L::Store(columns[6], L::Mul(L::Mul(two, L::Add(xz, wy)), sz));
+            L::Store(columns[7], L::Mul(L::Mul(two, L::Sub(yz, wx)), sz));
+            L::Store(columns[8], L::Mul(L::Sub(one, L::Mul(two, L::Add(xx, yy))), sz));
+
+            for (size_t lane = 0; lane < L::WIDTH; lane++) {
+                glm::mat4 &matrix = matrices[i + lane];
+                matrix[0] = glm::vec4(columns[0][lane], columns[1][lane], columns[2][lane], 0.0f);
+                matrix[1] = glm::vec4(columns[3][lane], columns[4][lane], columns[5][lane], 0.0f);
+                matrix[2] = glm::vec4(columns[6][lane], columns[7][lane], columns[8][lane], 0.0f);
+                matrix[3] = glm::vec4(
+                    transforms.translation[0][i + lane],
+                    transforms.translation[1][i + lane],
+                    transforms.translation[2][i + lane],
+                    1.0f);
+            }
+        }
+#endif
+
+        for (; i < count; i++) {
+            const glm::vec3 translation(
+                transforms.translation[0][i], transforms.translation[1][i], transforms.translation[2][i]);
+            const glm::vec3 scale(transforms.scale[0][i], transforms.scale[1][i], transforms.scale[2][i]);
+
+            glm::quat rotation;
+            rotation.x = transforms.rotation[0][i];
+            rotation.y = transforms.rotation[1][i];
+            rotation.z = transforms.rotation[2][i];
+            rotation.w = transforms.rotation[3][i];
+
+            matrices[i] = ComposeTransform(translation, rotation, scale);
+        }
+    }
+
+    // == MATRIX PRODUCTS ==============================
+
+    void MultiplyMatrices(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *result, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            MultiplyMatrix(a[i], b[i], result[i]);
+        }
+    }
+
+    void MultiplyMatrices(
+        const MatrixStreams &a, const MatrixStreams &b, const MatrixOutputStreams &result, size_t count) {
+        size_t i = 0;
+
+#if defined(SQUID_SIMD_AVX2) || defined(SQUID_SIMD_SSE)
+        using L = Lanes;
+
+        for (; i + L::WIDTH <= count; i += L::WIDTH) {
+            for (u32 column = 0; column < 4; column++) {
+                const L::Type b0 = L::Load(b.columns[column][0] + i);
+                const L::Type b1 = L::Load(b.columns[column][1] + i);
+                const L::Type b2 = L::Load(b.columns[column][2] + i);
+                const L::Type b3 = L::Load(b.columns[column][3] + i);
+
+                for (u32 row = 0; row < 4; row++) {
+                    L::Type r = L::Mul(L::Load(a.columns[0][row] + i), b0);
+                    r = L::Add(r, L::Mul(L::Load(a.columns[1][row] + i), b1));
+                    r = L::Add(r, L::Mul(L::Load(a.columns[2][row] + i), b2));
+                    r = L::Add(r, L::Mul(L::Load(a.columns[3][row] + i), b3));
+                    L::Store(result.columns[column][row] + i, r);
+                }
+            }
+        }
+#endif
+
+        for (; i < count; i++) {
+            for (u32 column = 0; column < 4; column++) {
+                for (u32 row = 0; row < 4; row++) {
+                    f32 r = 0.0f;
+                    for (u32 k = 0; k < 4; k++) {
+                        r += a.columns[k][row][i] * b.columns[column][k][i];
+                    }
+                    result.columns[column][row][i] = r;
+                }
+            }
+        }
+    }
+
+    // == BOUNDS =======================================
+
+    void TransformAabbs(
+        const glm::mat4 *matrices,
+        const glm::vec3 *min,
+        const glm::vec3 *max,
+        glm::vec3 *out_min,
+        glm::vec3 *out_max,
+        size_t count) {
+
+        // Arvo: the center goes through the full matrix, the extent through the absolute 3x3 part
+        for (size_t i = 0; i < count; i++) {
+            const glm::mat4 &m = matrices[i];
+            const glm::vec3 center = (min[i] + max[i]) * 0.5f;
+            const glm::vec3 extent = (max[i] - min[i]) * 0.5f;
+
+#ifdef SQUID_SIMD_SSE
+            const __m128 sign = _mm_set1_ps(-0.0f);
+            const __m128 c0 = _mm_loadu_ps(&m[0][0]);
+            const __m128 c1 = _mm_loadu_ps(&m[1][0]);
+            const __m128 c2 = _mm_loadu_ps(&m[2][0]);
+            const __m128 c3 = _mm_loadu_ps(&m[3][0]);
+
+            __m128 world_center = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_set1_ps(center.x)));
+            world_center = _mm_add_ps(world_center, _mm_mul_ps(c1, _mm_set1_ps(center.y)));
+            world_center = _mm_add_ps(world_center, _mm_mul_ps(c2, _mm_set1_ps(center.z)));
+
+            __m128 world_extent = _mm_mul_ps(_mm_andnot_ps(sign, c0), _mm_set1_ps(extent.x));
+            world_extent = _mm_add_ps(world_extent, _mm_mul_ps(_mm_andnot_ps(sign, c1), _mm_set1_ps(extent.y)));
+            world_extent = _mm_add_ps(world_extent, _mm_mul_ps(_mm_andnot_ps(sign, c2), _mm_set1_ps(extent.z)));
+
+            f32 lower[4], upper[4];
+            _mm_storeu_ps(lower, _mm_sub_ps(world_center, world_extent));
+            _mm_storeu_ps(upper, _mm_add_ps(world_center, world_extent));
+            out_min[i] = glm::vec3(lower[0], lower[1], lower[2]);
+            out_max[i] = glm::vec3(upper[0], upper[1], upper[2]);
+#else
+            glm::vec3 world_center = glm::vec3(m[3]);
+            glm::vec3 world_extent(0.0f);
+            for (u32 axis = 0; axis < 3; axis++) {
+                const glm::vec3 column(m[axis]);
+                world_center += column * center[axis];
+                world_extent += glm::vec3(fabsf(column.x), fabsf(column.y), fabsf(column.z)) * extent[axis];
+            }
+            out_min[i] = world_center - world_extent;
+            out_max[i] = world_center + world_extent;
+#endif
+        }
+    }
+
+    void TransformAabbs(
+        const MatrixStreams &matrices, const AabbStreams &boxes, const AabbOutputStreams &out, size_t count) {
+        size_t i = 0;
+
+#if defined(SQUID_SIMD_AVX2) || defined(SQUID_SIMD_SSE)
+        using L = Lanes;
+        const L::Type half = L::Set(0.5f);
+
+        for (; i + L::WIDTH <= count; i += L::WIDTH) {
+            // Every input of the lanes is read before the first store, so the outputs can alias the boxes
+            L::Type center[3], extent[3];
+            for (u32 axis = 0; axis < 3; axis++) {
+                const L::Type min = L::Load(boxes.min[axis] + i);
+                const L::Type max = L::Load(boxes.max[axis] + i);
+                center[axis] = L::Mul(L::Add(min, max), half);
+                extent[axis] = L::Mul(L::Sub(max, min), half);
+            }
+
+            L::Type lower[3], upper[3];
+            for (u32 row = 0; row < 3; row++) {
+                L::Type world_center = L::Load(matrices.columns[3][row] + i);
+                L::Type world_extent = L::Set(0.0f);
+                for (u32 axis = 0; axis < 3; axis++) {
+                    const L::Type m = L::Load(matrices.columns[axis][row] + i);
+                    world_center = L::Add(world_center, L::Mul(m, center[axis]));
+                    world_extent = L::Add(world_extent, L::Mul(L::Abs(m), extent[axis]));
+                }
+                lower[row] = L::Sub(world_center, world_extent);
+                upper[row] = L::Add(world_center, world_extent);
+            }
+
+            for (u32 row = 0; row < 3; row++) {
+                L::Store(out.min[row] + i, lower[row]);
+                L::Store(out.max[row] + i, upper[row]);
+            }
+        }
+#endif
+
+        for (; i < count; i++) {
+            f32 center[3], extent[3];
+            for (u32 axis = 0; axis < 3; axis++) {
+                center[axis] = (boxes.min[axis][i] + boxes.max[axis][i]) * 0.5f;
+                extent[axis] = (boxes.max[axis][i] - boxes.min[axis][i]) * 0.5f;
+            }
+
+            for (u32 row = 0; row < 3; row++) {
+                f32 world_center = matrices.columns[3][row][i];
+                f32 world_extent = 0.0f;
+                for (u32 axis = 0; axis < 3; axis++) {
+                    const f32 m = matrices.columns[axis][row][i];
+                    world_center += m * center[axis];
+                    world_extent += fabsf(m) * extent[axis];
+                }
+                out.min[row][i] = world_center - world_extent;
+                out.max[row][i] = world_center + world_extent;
+            }
+        }
+    }
+
+    // == CULLING ======================================
+
+    void TestSpheresFrustum(const glm::vec4 *planes, const SphereStreams &spheres, u8 *visible, size_t count) {
+        size_t i = 0;
+
+#if defined(SQUID_SIMD_AVX2) || defined(SQUID_SIMD_SSE)
+        using L = Lanes;
+
+        for (; i + L::WIDTH <= count; i += L::WIDTH) {
+            const L::Type x = L::Load(spheres.center[0] + i);
+            const L::Type y = L::Load(spheres.center[1] + i);
+            const L::Type z = L::Load(spheres.center[2] + i);
+            const L::Type negative_radius = L::Sub(L::Set(0.0f), L::Load(spheres.radius + i));
+
+            L::Type inside = L::GreaterEqual(L::Set(0.0f), L::Set(0.0f));
+            for (u32 plane = 0; plane < 6; plane++) {
+                L::Type distance = L::Add(L::Mul(L::Set(planes[plane].x), x), L::Set(planes[plane].w));
+                distance = L::Add(distance, L::Mul(L::Set(planes[plane].y), y));
+                distance = L::Add(distance, L::Mul(L::Set(planes[plane].z), z));
+                inside = L::And(inside, L::GreaterEqual(distance, negative_radius));
+            }
+
+            const u32 mask = L::Mask(inside);
+            for (size_t lane = 0; lane < L::WIDTH; lane++) {
+                visible[i + lane] = u8((mask >> lane) & 1);
+            }
+        }
+#endif
+
+        for (; i < count; i++) {
+            bool inside = true;
+            for (u32 plane = 0; plane < 6; plane++) {
+                const f32 distance = planes[plane].x * spheres.center[0][i] + planes[plane].y * spheres.center[1][i] +
+                                     planes[plane].z * spheres.center[2][i] + planes[plane].w;
+                inside = inside && distance >= -spheres.radius[i];
+            }
+            visible[i] = inside ? 1 : 0;
+        }
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,123 @@
+#include <Public/Core/Memory/AllocationCounter.h>
+#include <Public/Core/Memory/MemoryTracker.h>
+
+#if defined(SQUID_COUNT_ALLOCATIONS) || defined(SQUID_TRACK_MEMORY)
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace Squid {
+namespace Core {
+
+#ifdef SQUID_COUNT_ALLOCATIONS
+    static std::atomic<u64> heap_allocations = 0;
+
+    u64 GetHeapAllocationCount() { return heap_allocations.load(std::memory_order_relaxed); }
+#else
+    u64 GetHeapAllocationCount() { return 0; }
+#endif
+
+    static void *HookAllocate(size_t size, size_t alignment) noexcept {
+#ifdef SQUID_COUNT_ALLOCATIONS
+        heap_allocations.fetch_add(1, std::memory_order_relaxed);
+#endif
+        size = size ? size : 1;
+
+#ifdef SQUID_TRACK_MEMORY
+        return TrackedAllocate(size, alignment);
+#else
+        if (alignment <= alignof(std::max_align_t))
+            return malloc(size);
+#ifdef SQUID_WIN32
+        return _aligned_malloc(size, alignment);
+#else
+        void *memory = nullptr;
+        return posix_memalign(&memory, std::max(alignment, sizeof(void *)), size) == 0 ? memory : nullptr;
+#endif
+#endif
+    }
+
+    static void HookFree(void *memory) noexcept {
+#ifdef SQUID_TRACK_MEMORY
+        TrackedFree(memory);
+#else
+        free(memory);
+#endif
+    }
+
+    static void HookAlignedFree(void *memory) noexcept {
+#if defined(SQUID_TRACK_MEMORY) || !defined(SQUID_WIN32)
+        HookFree(memory);
+#else
+        _aligned_free(memory);
+#endif
+    }
+
+} // namespace Core
+} // namespace Squid
+
+using Squid::Core::HookAlignedFree;
+using Squid::Core::HookAllocate;
+using Squid::Core::HookFree;
+
+// Replacements of the global allocation functions, every variant is replaced so new and delete stay paired
+
+void *operator new(size_t size) {
+    if (void *memory = HookAllocate(size, alignof(std::max_align_t)))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return HookAllocate(size, alignof(std::max_align_t));
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return HookAllocate(size, alignof(std::max_align_t));
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    if (void *memory = HookAllocate(size, size_t(alignment)))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return HookAllocate(size, size_t(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return HookAllocate(size, size_t(alignment));
+}
+
+void operator delete(void *memory) noexcept { HookFree(memory); }
+void operator delete[](void *memory) noexcept { HookFree(memory); }
+void operator delete(void *memory, size_t) noexcept { HookFree(memory); }
+void operator delete[](void *memory, size_t) noexcept { HookFree(memory); }
+void operator delete(void *memory, const std::nothrow_t &) noexcept { HookFree(memory); }
+void operator delete[](void *memory, const std::nothrow_t &) noexcept { HookFree(memory); }
+
+void operator delete(void *memory, std::align_val_t) noexcept { HookAlignedFree(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { HookAlignedFree(memory); }
+void operator delete(void *memory, size_t, std::align_val_t) noexcept { HookAlignedFree(memory); }
+void operator delete[](void *memory, size_t, std::align_val_t) noexcept { HookAlignedFree(memory); }
+void operator delete(void *memory, std::align_val_t, const std::nothrow_t &) noexcept { HookAlignedFree(memory); }
+void operator delete[](void *memory, std::align_val_t, const std::nothrow_t &) noexcept { HookAlignedFree(memory); }
+
+#else
+
+namespace Squid {
+namespace Core {
+
+    u64 GetHeapAllocationCount() { return 0; }
+
+} // namespace Core
+} // namespace Squid
+
+#endif
@@ -0,0 +1,74 @@
+#include <Public/Core/Memory/FrameAllocator.h>
+#include <Public/Core/Log.h>
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+
+namespace Squid {
+namespace Core {
+
+    // Frame memory is aligned for anything up to a cache line, larger alignments are taken from the offset
+    static constexpr u64 FRAME_ALIGNMENT = 64;
+
+    FrameAllocator::FrameAllocator(u64 frame_size) : frame_size(frame_size) {
+        for (Frame &frame : frames) {
+            frame.data = static_cast<u8 *>(::operator new(frame_size, std::align_val_t(FRAME_ALIGNMENT)));
+        }
+    }
+
+    FrameAllocator::~FrameAllocator() {
+        for (Frame &frame : frames) {
+            for (const Overflow &overflow : frame.overflow) {
+                ::operator delete(overflow.memory, std::align_val_t(overflow.alignment));
+            }
+            ::operator delete(frame.data, std::align_val_t(FRAME_ALIGNMENT));
+        }
+    }
+
+    void *FrameAllocator::Allocate(u64 size, u64 alignment) {
+        // Pairs with BeginFrame, a slot is only handed out after it was cleared
+        Frame &frame = frames[current.load(std::memory_order_acquire)];
+        const u64 base = reinterpret_cast<u64>(frame.data);
+
+        u64 offset = frame.offset.load(std::memory_order_relaxed);
+        while (true) {
+            const u64 start = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+            if (start + size > frame_size)
+                break;
+
+            if (frame.offset.compare_exchange_weak(offset, start + size, std::memory_order_relaxed))
+                return frame.data + start;
+        }
+
+        // Out of frame memory, the rest of the frame falls back to the heap
+        LOG_WARN_EVERY(1000, "frame allocator ran out of its {} bytes, falling back to the heap", frame_size)
+
+        alignment = std::max<u64>(alignment, alignof(std::max_align_t));
+        void *memory = ::operator new(size, std::align_val_t(alignment));
+
+        std::lock_guard<SpinLock> lock(overflow_lock);
+        frame.overflow.push_back({memory, alignment});
+        return memory;
+    }
+
+    void FrameAllocator::BeginFrame() {
+        const u32 next = (current.load(std::memory_order_relaxed) + 1) % MAX_FRAMES_IN_FLIGHT;
+        Frame &frame = frames[next];
+
+        for (const Overflow &overflow : frame.overflow) {
+            ::operator delete(overflow.memory, std::align_val_t(overflow.alignment));
+        }
+        frame.overflow.clear();
+        frame.offset.store(0, std::memory_order_relaxed);
+
+        current.store(next, std::memory_order_release);
+    }
+
+    FrameAllocator &GetFrameAllocator() {
+        static FrameAllocator allocator;
+        return allocator;
+    }
+
+} // namespace Core
+} // namespace Squid
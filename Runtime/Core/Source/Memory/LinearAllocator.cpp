@@ -0,0 +1,59 @@
+#include <Public/Core/Memory/LinearAllocator.h>
+
+#include <algorithm>
+#include <new>
+
+namespace Squid {
+namespace Core {
+
+    // Blocks are aligned for anything up to a cache line
+    static constexpr u64 BLOCK_ALIGNMENT = 64;
+
+    LinearAllocator::LinearAllocator(u64 block_size) : block_size(block_size) {}
+
+    LinearAllocator::~LinearAllocator() {
+        for (const Block &block : blocks) {
+            ::operator delete(block.data, std::align_val_t(BLOCK_ALIGNMENT));
+        }
+    }
+
+    void *LinearAllocator::Allocate(u64 size, u64 alignment) {
+        while (true) {
+            if (current < blocks.size()) {
+                const Block &block = blocks[current];
+                const u64 base = reinterpret_cast<u64>(block.data);
+                const u64 start = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+
+                if (start + size <= block.size) {
+                    offset = start + size;
+                    return block.data + start;
+                }
+
+                // The rest of the block is skipped, it's reused after the next rewind
+                current++;
+                offset = 0;
+                continue;
+            }
+
+            // Oversized requests get a block of their own
+            const u64 size_needed = std::max(block_size, size + alignment);
+            u8 *data = static_cast<u8 *>(::operator new(size_needed, std::align_val_t(BLOCK_ALIGNMENT)));
+            blocks.push_back({data, size_needed});
+        }
+    }
+
+    u64 LinearAllocator::GetCapacity() const {
+        u64 capacity = 0;
+        for (const Block &block : blocks) {
+            capacity += block.size;
+        }
+        return capacity;
+    }
+
+    LinearAllocator &GetScratchAllocator() {
+        thread_local LinearAllocator allocator;
+        return allocator;
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,427 @@
+#include <Public/Core/Memory/MemoryTracker.h>
+#include <Public/Core/Jobs/SpinLock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef SQUID_TRACK_MEMORY
+#ifdef SQUID_WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <cxxabi.h>
+#include <execinfo.h>
+#endif
+#endif
+
+namespace Squid {
+namespace Core {
+
+    static const char *MEMORY_TAG_NAMES[MEMORY_TAG_COUNT] = {"Untagged", "RHI", "Renderer", "ECS", "Editor", "Assets"};
+
+    const char *GetMemoryTagName(MemoryTag tag) { return tag < MEMORY_TAG_COUNT ? MEMORY_TAG_NAMES[tag] : "Invalid"; }
+
+    // Plain data so operator new can read it while the thread starts up or exits
+    static thread_local MemoryTag thread_tag = MEMORY_TAG_UNTAGGED;
+
+    MemoryTag GetMemoryTag() { return thread_tag; }
+
+    void SetMemoryTag(MemoryTag tag) { thread_tag = tag; }
+
+    static std::mutex stats_mutex;
+    static MemoryStats stats;
+
+    MemoryStats GetMemoryStats() {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        return stats;
+    }
+
+#ifdef SQUID_TRACK_MEMORY
+
+    static constexpr u32 MAX_TRACKED_THREADS = 256;
+    static constexpr u32 MAX_SAMPLES = 8192;
+    static constexpr u32 MAX_SAMPLE_FRAMES = 24;
+    // Frames of the tracker and operator new on top of every captured callstack
+    static constexpr u32 SKIPPED_FRAMES = 3;
+    static constexpr u32 NO_SAMPLE = ~0u;
+
+    // In front of every allocation. Alignments above 16 leave a gap before the header, offset leads back to the
+    // start of the malloc block.
+    struct AllocationHeader {
+        u64 size;
+        u32 sample;
+        u16 offset;
+        MemoryTag tag;
+        u8 padding;
+    };
+    static_assert(sizeof(AllocationHeader) == 16, "the header keeps 16 byte alignment");
+
+    // Every thread adds to its own counters, threads past MAX_TRACKED_THREADS share the last ones. Frees are counted
+    // by the freeing thread so only the sums over all threads are meaningful.
+    struct alignas(64) ThreadCounters {
+        std::atomic<u64> allocated_bytes[MEMORY_TAG_COUNT];
+        std::atomic<u64> freed_bytes[MEMORY_TAG_COUNT];
+        std::atomic<u64> allocations[MEMORY_TAG_COUNT];
+        std::atomic<u64> frees[MEMORY_TAG_COUNT];
+    };
+
+    static ThreadCounters thread_counters[MAX_TRACKED_THREADS];
+    static std::atomic<u32> thread_counter_count = 0;
+
+    // Counters owned by a single thread are bumped without a locked instruction, readers only need whole values
+    static inline void AddToCounter(std::atomic<u64> &counter, u64 value, bool shared) {
+        if (shared)
+            counter.fetch_add(value, std::memory_order_relaxed);
+        else
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static ThreadCounters &GetThreadCounters(bool &shared) {
+        static thread_local ThreadCounters *counters = nullptr;
+        static thread_local bool counters_shared = false;
+        if (!counters) {
+            const u32 index = thread_counter_count.fetch_add(1, std::memory_order_relaxed);
+            counters = &thread_counters[std::min(index, MAX_TRACKED_THREADS - 1)];
+            counters_shared = index >= MAX_TRACKED_THREADS - 1;
+        }
+        shared = counters_shared;
+        return *counters;
+    }
+
+    struct Sample {
+        // Null while the slot is free
+        void *address;
+        u64 size;
+        MemoryTag tag;
+        u32 frame_count;
+        void *frames[MAX_SAMPLE_FRAMES];
+    };
+
+    static Sample samples[MAX_SAMPLES];
+    static u32 free_samples[MAX_SAMPLES];
+    static u32 free_sample_count = 0;
+    static u32 unused_samples = 0;
+    static SpinLock sample_lock;
+
+    static std::atomic<u32> sample_rate = 0;
+    static thread_local u32 sample_countdown = 0;
+    // Set while the thread is inside the sampler, allocations made there aren't sampled
+    static thread_local bool sampling = false;
+
+    static u32 CaptureCallstack(void **frames) {
+        void *captured[MAX_SAMPLE_FRAMES + SKIPPED_FRAMES];
+#ifdef SQUID_WIN32
+        const u32 count = CaptureStackBackTrace(0, MAX_SAMPLE_FRAMES + SKIPPED_FRAMES, captured, nullptr);
+#else
+        const u32 count = u32(backtrace(captured, MAX_SAMPLE_FRAMES + SKIPPED_FRAMES));
+#endif
+        const u32 kept = count > SKIPPED_FRAMES ? count - SKIPPED_FRAMES : 0;
+        std::copy(captured + SKIPPED_FRAMES, captured + SKIPPED_FRAMES + kept, frames);
+        return kept;
+    }
+
+    static u32 AddSample(void *address, u64 size, MemoryTag tag) {
+        sampling = true;
+
+        void *frames[MAX_SAMPLE_FRAMES];
+        const u32 frame_count = CaptureCallstack(frames);
+
+        u32 index = NO_SAMPLE;
+        {
+            std::lock_guard<SpinLock> lock(sample_lock);
+            if (free_sample_count > 0)
+                index = free_samples[--free_sample_count];
+            else if (unused_samples < MAX_SAMPLES)
+                index = unused_samples++;
+
+            // A full table skips samples until some are freed
+            if (index != NO_SAMPLE) {
+                Sample &sample = samples[index];
+                sample.address = address;
+                sample.size = size;
+                sample.tag = tag;
+                sample.frame_count = frame_count;
+                std::copy(frames, frames + frame_count, sample.frames);
+            }
+        }
+
+        sampling = false;
+        return index;
+    }
+
+    static void RemoveSample(u32 index) {
+        std::lock_guard<SpinLock> lock(sample_lock);
+        samples[index].address = nullptr;
+        free_samples[free_sample_count++] = index;
+    }
+
+    void *TrackedAllocate(size_t size, size_t alignment) {
+        const size_t gap = alignment > sizeof(AllocationHeader) ? alignment : 0;
+        u8 *block = static_cast<u8 *>(malloc(size + sizeof(AllocationHeader) + gap));
+        if (!block)
+            return nullptr;
+
+        const u64 start = reinterpret_cast<u64>(block) + sizeof(AllocationHeader);
+        u8 *memory = reinterpret_cast<u8 *>(gap ? (start + alignment - 1) & ~u64(alignment - 1) : start);
+
+        AllocationHeader *header = reinterpret_cast<AllocationHeader *>(memory) - 1;
+        header->size = size;
+        header->sample = NO_SAMPLE;
+        header->offset = u16(memory - block);
+        header->tag = thread_tag;
+
+        bool shared;
+        ThreadCounters &counters = GetThreadCounters(shared);
+        AddToCounter(counters.allocated_bytes[header->tag], size, shared);
+        AddToCounter(counters.allocations[header->tag], 1, shared);
+
+        const u32 rate = sample_rate.load(std::memory_order_relaxed);
+        if (rate > 0 && !sampling && (sample_countdown == 0 || --sample_countdown == 0)) {
+            sample_countdown = rate;
+            header->sample = AddSample(memory, size, header->tag);
+        }
+
+        return memory;
+    }
+
+    void TrackedFree(void *memory) {
+        if (!memory)
+            return;
+
+        AllocationHeader *header = static_cast<AllocationHeader *>(memory) - 1;
+
+        bool shared;
+        ThreadCounters &counters = GetThreadCounters(shared);
+        AddToCounter(counters.freed_bytes[header->tag], header->size, shared);
+        AddToCounter(counters.frees[header->tag], 1, shared);
+
+        if (header->sample != NO_SAMPLE)
+            RemoveSample(header->sample);
+
+        free(static_cast<u8 *>(memory) - header->offset);
+    }
+
+    void SetMemorySampleRate(u32 every) { sample_rate.store(every, std::memory_order_relaxed); }
+
+    u32 GetMemorySampleRate() { return sample_rate.load(std::memory_order_relaxed); }
+
+    // Rates are measured over windows of at least this long
+    static constexpr std::chrono::seconds RATE_WINDOW(1);
+
+    void SampleMemoryStats() {
+        const u32 thread_count = std::min(thread_counter_count.load(std::memory_order_relaxed), MAX_TRACKED_THREADS);
+
+        // Frees are summed first, allocations summed afterwards include at least everything that was freed
+        u64 freed_bytes[MEMORY_TAG_COUNT] = {};
+        u64 frees[MEMORY_TAG_COUNT] = {};
+        for (u32 thread = 0; thread < thread_count; thread++) {
+            for (u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+                freed_bytes[tag] += thread_counters[thread].freed_bytes[tag].load(std::memory_order_relaxed);
+                frees[tag] += thread_counters[thread].frees[tag].load(std::memory_order_relaxed);
+            }
+        }
+
+        u64 allocated_bytes[MEMORY_TAG_COUNT] = {};
+        u64 allocations[MEMORY_TAG_COUNT] = {};
+        for (u32 thread = 0; thread < thread_count; thread++) {
+            for (u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+                allocated_bytes[tag] += thread_counters[thread].allocated_bytes[tag].load(std::memory_order_relaxed);
+                allocations[tag] += thread_counters[thread].allocations[tag].load(std::memory_order_relaxed);
+            }
+        }
+
+        static auto window_start = std::chrono::steady_clock::now();
+        static u64 window_allocations[MEMORY_TAG_COUNT] = {};
+        static u64 window_bytes[MEMORY_TAG_COUNT] = {};
+
+        const auto now = std::chrono::steady_clock::now();
+        const f64 elapsed = std::chrono::duration<f64>(now - window_start).count();
+        const bool window_done = now - window_start >= RATE_WINDOW;
+
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        for (u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+            MemoryTagStats &tag_stats = stats.tags[tag];
+            tag_stats.live_bytes = allocated_bytes[tag] - std::min(freed_bytes[tag], allocated_bytes[tag]);
+            tag_stats.live_allocations = allocations[tag] - std::min(frees[tag], allocations[tag]);
+            tag_stats.peak_bytes = std::max(tag_stats.peak_bytes, tag_stats.live_bytes);
+            tag_stats.total_allocations = allocations[tag];
+            tag_stats.total_bytes = allocated_bytes[tag];
+
+            if (window_done) {
+                tag_stats.allocations_per_second = f64(allocations[tag] - window_allocations[tag]) / elapsed;
+                tag_stats.bytes_per_second = f64(allocated_bytes[tag] - window_bytes[tag]) / elapsed;
+                window_allocations[tag] = allocations[tag];
+                window_bytes[tag] = allocated_bytes[tag];
+            }
+        }
+
+        if (window_done)
+            window_start = now;
+    }
+
+    std::vector<MemoryCallstack> GetLiveCallstacks(u32 max_count) {
+        // Reserved up front, nothing may be allocated or freed under the lock since the hooks take it too. The
+        // copy isn't sampled, it would show up as live memory of its own.
+        sampling = true;
+        std::vector<Sample> live;
+        live.reserve(MAX_SAMPLES);
+        {
+            std::lock_guard<SpinLock> lock(sample_lock);
+            for (u32 index = 0; index < unused_samples; index++) {
+                if (samples[index].address)
+                    live.push_back(samples[index]);
+            }
+        }
+        sampling = false;
+
+        std::map<std::pair<MemoryTag, std::vector<void *>>, MemoryCallstack> groups;
+        for (const Sample &sample : live) {
+            std::vector<void *> frames(sample.frames, sample.frames + sample.frame_count);
+            MemoryCallstack &callstack = groups[{sample.tag, frames}];
+            callstack.tag = sample.tag;
+            callstack.bytes += sample.size;
+            callstack.allocations++;
+            if (callstack.frames.empty())
+                callstack.frames = std::move(frames);
+        }
+
+        std::vector<MemoryCallstack> callstacks;
+        callstacks.reserve(groups.size());
+        for (auto &group : groups) {
+            callstacks.push_back(std::move(group.second));
+        }
+
+        std::sort(callstacks.begin(), callstacks.end(), [](const auto &a, const auto &b) { return a.bytes > b.bytes; });
+        if (callstacks.size() > max_count)
+            callstacks.resize(max_count);
+        return callstacks;
+    }
+
+    std::vector<std::string> SymbolizeCallstack(const std::vector<void *> &frames) {
+        std::vector<std::string> lines;
+        lines.reserve(frames.size());
+
+#ifdef SQUID_WIN32
+        for (void *frame : frames) {
+            char address[32];
+            snprintf(address, sizeof(address), "0x%llx", static_cast<unsigned long long>(reinterpret_cast<u64>(frame)));
+            lines.push_back(address);
+        }
+#else
+        char **symbols = backtrace_symbols(frames.data(), i32(frames.size()));
+        if (!symbols)
+            return lines;
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            // "binary(mangled+0x1f) [0x...]", the mangled name is replaced when it demangles
+            std::string line = symbols[i];
+            const size_t begin = line.find('(');
+            const size_t end = line.find('+', begin);
+            if (begin != std::string::npos && end != std::string::npos && end > begin + 1) {
+                const std::string mangled = line.substr(begin + 1, end - begin - 1);
+                i32 status = 0;
+                if (char *demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status)) {
+                    line.replace(begin + 1, end - begin - 1, demangled);
+                    free(demangled);
+                }
+            }
+            lines.push_back(std::move(line));
+        }
+        free(symbols);
+#endif
+        return lines;
+    }
+
+#else
+
+    void *TrackedAllocate(size_t size, size_t) { return malloc(size ? size : 1); }
+
+    void TrackedFree(void *memory) { free(memory); }
+
+    void SetMemorySampleRate(u32) {}
+
+    u32 GetMemorySampleRate() { return 0; }
+
+    void SampleMemoryStats() {}
+
+    std::vector<MemoryCallstack> GetLiveCallstacks(u32) { return {}; }
+
+    std::vector<std::string> SymbolizeCallstack(const std::vector<void *> &) { return {}; }
+
+#endif
+
+    static std::string EscapeJson(const std::string &text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (u8(c) < 0x20) {
+                char code[8];
+                snprintf(code, sizeof(code), "\\u%04x", u32(u8(c)));
+                escaped += code;
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    void DumpMemoryStats(const std::string &path) {
+        std::ofstream file(path);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open " + path + " for writing");
+
+        const MemoryStats current = GetMemoryStats();
+
+        file << "{\n";
+        file << "  \"tracking\": " << (IsTrackingMemory() ? "true" : "false") << ",\n";
+        file << "  \"sample_rate\": " << GetMemorySampleRate() << ",\n";
+
+        file << "  \"tags\": [\n";
+        for (u32 tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+            const MemoryTagStats &tag_stats = current.tags[tag];
+            file << "    {\"name\": \"" << GetMemoryTagName(MemoryTag(tag)) << "\""
+                 << ", \"live_bytes\": " << tag_stats.live_bytes
+                 << ", \"live_allocations\": " << tag_stats.live_allocations
+                 << ", \"peak_bytes\": " << tag_stats.peak_bytes
+                 << ", \"total_allocations\": " << tag_stats.total_allocations
+                 << ", \"total_bytes\": " << tag_stats.total_bytes
+                 << ", \"allocations_per_second\": " << tag_stats.allocations_per_second
+                 << ", \"bytes_per_second\": " << tag_stats.bytes_per_second << "}"
+                 << (tag + 1 < MEMORY_TAG_COUNT ? ",\n" : "\n");
+        }
+        file << "  ],\n";
+
+        const std::vector<MemoryCallstack> callstacks = GetLiveCallstacks(~0u);
+        file << "  \"callstacks\": [";
+        for (size_t i = 0; i < callstacks.size(); i++) {
+            const MemoryCallstack &callstack = callstacks[i];
+            file << (i > 0 ? ",\n" : "\n");
+            file << "    {\"tag\": \"" << GetMemoryTagName(callstack.tag) << "\""
+                 << ", \"bytes\": " << callstack.bytes << ", \"allocations\": " << callstack.allocations
+                 << ", \"frames\": [";
+
+            const std::vector<std::string> lines = SymbolizeCallstack(callstack.frames);
+            for (size_t line = 0; line < lines.size(); line++) {
+                file << (line > 0 ? ", " : "") << "\"" << EscapeJson(lines[line]) << "\"";
+            }
+            file << "]}";
+        }
+        file << (callstacks.empty() ? "]\n" : "\n  ]\n");
+        file << "}\n";
+
+        if (!file)
+            throw std::runtime_error("Failed to write " + path);
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -0,0 +1,57 @@
+#include <Public/Core/Memory/PoolAllocator.h>
+
+#include <algorithm>
+#include <new>
+
+namespace Squid {
+namespace Core {
+
+    PoolAllocator::PoolAllocator(u64 block_size, u64 alignment, u32 blocks_per_chunk)
+        : alignment(std::max<u64>(alignment, alignof(FreeBlock))), blocks_per_chunk(blocks_per_chunk) {
+        // Blocks hold the free list link while they are free and follow each other without breaking alignment
+        const u64 size = std::max<u64>(block_size, sizeof(FreeBlock));
+        this->block_size = (size + this->alignment - 1) & ~(this->alignment - 1);
+    }
+
+    PoolAllocator::~PoolAllocator() {
+        assert(allocated == 0 && "blocks are still in use");
+
+        for (u8 *chunk : chunks) {
+            ::operator delete(chunk, std::align_val_t(alignment));
+        }
+    }
+
+    void *PoolAllocator::Allocate() {
+        if (!free_list)
+            AddChunk();
+
+        FreeBlock *block = free_list;
+        free_list = block->next;
+        allocated++;
+        return block;
+    }
+
+    void PoolAllocator::Free(void *block) {
+        if (!block)
+            return;
+
+        FreeBlock *free_block = static_cast<FreeBlock *>(block);
+        free_block->next = free_list;
+        free_list = free_block;
+        allocated--;
+    }
+
+    void PoolAllocator::AddChunk() {
+        u8 *chunk = static_cast<u8 *>(::operator new(block_size * blocks_per_chunk, std::align_val_t(alignment)));
+        chunks.push_back(chunk);
+
+        // Linked back to front so blocks are handed out in address order
+        for (u32 i = blocks_per_chunk; i > 0; i--) {
+            FreeBlock *block = reinterpret_cast<FreeBlock *>(chunk + (i - 1) * block_size);
+            block->next = free_list;
+            free_list = block;
+        }
+    }
+
+} // namespace Core
+} // namespace Squid
@@ -46,24 +46,18 @@ namespace Core {
     // == Scoped Profile ==
 
     ScopedProfile::ScopedProfile(const std::string &name) : profile(nullptr) {
-        std::string n(name);
-
-        if (Profiler::GetInstance()->IsInStack(n)) { // profile is already in stack (probably a recursive call)
-            if (true /*TODO: Profiler::GetInstance().GetOmitRecursiveCalls()*/) {
-                return;
-            } else {
-                n = "RECURSIVE@" + n;
-            }
-        }
+        // Recursive calls are omitted, the name isn't copied so entering a scope doesn't allocate
+        if (Profiler::GetInstance()->IsInStack(name))
+            return;
 
-        profile = Profiler::GetInstance()->GetProfile(n);
+        profile = Profiler::GetInstance()->GetProfile(name);
         if (profile != nullptr) {
             if (!profile->Start()) { // cannot start profiler (probably a recursive call for flat profiler)
                 delete profile;
                 profile = NULL;
             }
         } else {
-            LOG_ERROR("Cannot start scoped profiler: {}", n);
+            LOG_ERROR("Cannot start scoped profiler: {}", name);
         }
     }
 
@@ -74,14 +68,39 @@ namespace Core {
     }
 
     // == Profiler class ==
-    Profiler* Profiler::instance = nullptr;
 
     Profiler::Profiler() {}
 
     Profiler::~Profiler() {}
 
+    Profiler *Profiler::GetInstance() {
+        // Never destroyed, PrintStats runs at exit
+        static Profiler *instance = []() {
+            Profiler *profiler = new Profiler();
+            atexit(PrintStats);
+            return profiler;
+        }();
+        return instance;
+    }
+
+    Profiler::ThreadProfiles &Profiler::GetThreadProfiles() {
+        // Kept alive past the thread, the stats are printed at exit
+        thread_local ThreadProfiles *current = nullptr;
+        if (current == nullptr) {
+            current = new ThreadProfiles();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            current->name = "Thread " + std::to_string(threads.size());
+            threads.push_back(current);
+        }
+        return *current;
+    }
+
+    void Profiler::SetThreadName(const std::string &name) { GetInstance()->GetThreadProfiles().name = name; }
+
     std::map<std::string, Profile *> &Profiler::GetCurrentProfilesRoot() {
-        return profile_stack.empty() ? profiles : profile_stack.back()->GetSubProfiles();
+        ThreadProfiles &thread = GetThreadProfiles();
+        return thread.profile_stack.empty() ? thread.profiles : thread.profile_stack.back()->GetSubProfiles();
     }
 
     Profile *Profiler::GetProfile(const std::string &name) {
@@ -125,22 +144,32 @@ namespace Core {
             return;
         }
 
-        Profiler::CollectStats(fs, &(GetInstance()->profiles), 0);
+        Profiler *profiler = GetInstance();
+        std::lock_guard<std::mutex> lock(profiler->mutex);
+        for (ThreadProfiles *thread : profiler->threads) {
+            if (thread->profiles.empty())
+                continue;
+
+            fs << thread->name << std::endl;
+            Profiler::CollectStats(fs, &thread->profiles, 1);
+        }
         fs.close();
 
         //delete instance;
         //instance = nullptr;
     }
 
-    void Profiler::PushProfile(Profile *p) { profile_stack.push_back(p); }
+    void Profiler::PushProfile(Profile *p) { GetThreadProfiles().profile_stack.push_back(p); }
 
     void Profiler::PopProfile() {
+        std::vector<Profile *> &profile_stack = GetThreadProfiles().profile_stack;
         if (!profile_stack.empty()) {
             profile_stack.pop_back();
         }
     }
 
     bool Profiler::IsInStack(const std::string &name) {
+        const std::vector<Profile *> &profile_stack = GetThreadProfiles().profile_stack;
         for (unsigned int i = 0; i < profile_stack.size(); ++i) {
             if (profile_stack[i]->GetName() == name) {
                 return true;
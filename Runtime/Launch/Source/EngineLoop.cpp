@@ -1,7 +1,13 @@
 #include <pch.h>
 #include "EngineLoop.h"
 #include <Core/ECS/Scene.h>
+#include <Core/Events/EventDispatcher.h>
+#include <Core/Jobs/FramePipeline.h>
+#include <Core/Log.h>
 #include <Core/Profiling.h>
+#include <Core/Memory/AllocationCounter.h>
+#include <Core/Memory/FrameAllocator.h>
+#include <Core/Memory/MemoryTracker.h>
 #include <Core/Modules/ModuleManager.h>
 #include <Core/Modules/EngineContext.h>
 
@@ -10,9 +16,78 @@
 
 #include <EditorCore/Module.h>
 
+#include <cstring>
+
 namespace Squid {
 
-EngineLoop::EngineLoop() {}
+// Frames allowed to allocate while caches, pools and scratch blocks grow to their steady size
+static constexpr u64 ALLOCATION_WARMUP_FRAMES = 120;
+
+// Everything the render half of a frame reads, one per pipeline buffer
+struct FrameSnapshot {
+    Renderer::RenderSnapshot scene;
+    EditorCore::UiSnapshot ui;
+};
+
+static u16 GetKeyModifiers(u16 state) {
+    u16 modifiers = 0;
+    if (state & KMOD_SHIFT)
+        modifiers |= Core::KEY_MODIFIER_SHIFT;
+    if (state & KMOD_CTRL)
+        modifiers |= Core::KEY_MODIFIER_CTRL;
+    if (state & KMOD_ALT)
+        modifiers |= Core::KEY_MODIFIER_ALT;
+    if (state & KMOD_GUI)
+        modifiers |= Core::KEY_MODIFIER_SUPER;
+    return modifiers;
+}
+
+// Translates the SDL events of the main window into engine events, the rest is left to the platform windows
+static void PublishEvent(const SDL_Event &event, u32 window_id) {
+    Core::EventDispatcher &events = Core::GetEventDispatcher();
+
+    switch (event.type) {
+    case SDL_QUIT:
+        events.Publish(Core::QuitEvent{});
+        break;
+    case SDL_WINDOWEVENT:
+        if (event.window.windowID != window_id)
+            break;
+        if (event.window.event == SDL_WINDOWEVENT_RESIZED)
+            events.Publish(Core::WindowResizeEvent{u32(event.window.data1), u32(event.window.data2)});
+        else if (event.window.event == SDL_WINDOWEVENT_CLOSE)
+            events.Publish(Core::QuitEvent{});
+        break;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        events.Publish(Core::KeyEvent{u32(event.key.keysym.scancode), i32(event.key.keysym.sym),
+                                      GetKeyModifiers(event.key.keysym.mod), event.type == SDL_KEYDOWN,
+                                      event.key.repeat != 0});
+        break;
+    case SDL_TEXTINPUT: {
+        Core::TextInputEvent text;
+        static_assert(sizeof(text.text) == sizeof(event.text.text), "SDL's text input holds 32 bytes");
+        std::memcpy(text.text, event.text.text, sizeof(text.text));
+        events.Publish(text);
+        break;
+    }
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        // SDL numbers the buttons from 1 in the same order
+        events.Publish(Core::MouseButtonEvent{event.button.x, event.button.y, Core::MouseButton(event.button.button - 1),
+                                              event.type == SDL_MOUSEBUTTONDOWN, event.button.clicks});
+        break;
+    case SDL_MOUSEMOTION:
+        events.Publish(Core::MouseMotionEvent{event.motion.x, event.motion.y, event.motion.xrel, event.motion.yrel,
+                                              event.motion.state});
+        break;
+    case SDL_MOUSEWHEEL:
+        events.Publish(Core::MouseWheelEvent{event.wheel.x, event.wheel.y});
+        break;
+    }
+}
+
+EngineLoop::EngineLoop(u32 frame_latency) : frame_latency(frame_latency) {}
 
 EngineLoop::~EngineLoop() {}
 
@@ -85,54 +160,85 @@ int EngineLoop::Start() {
 
     SDL_Event event;
     bool running = true;
-    int swap_chain_rebuild = false;
+    const u32 window_id = SDL_GetWindowID(window);
+
+    Core::EventDispatcher &events = Core::GetEventDispatcher();
+    const Core::EventFunction<Core::QuitEvent> stop = [](void *running, const Core::QuitEvent *, u32) {
+        *static_cast<bool *>(running) = false;
+    };
+    events.Subscribe(stop, &running);
+
+    u64 frame_number = 0;
+
+    // The simulation below builds frame N + 1 while the render thread records and submits frame N
+    FrameSnapshot frames[Core::FramePipeline::BUFFER_COUNT];
+    Core::FramePipeline pipeline(
+        [&](u32 index) {
+            FrameSnapshot &frame = frames[index];
+            renderer->BeginFrame(frame.scene);
+            // The slot is reused once its frame has left the GPU, BeginFrame waits for that
+            Core::GetFrameAllocator().BeginFrame();
+
+            renderer->Render(frame.scene);
+            editor->Render(frame.ui);
+
+            renderer->EndFrame();
+        },
+        frame_latency);
+    LOG_INFO("rendering {} frames behind the simulation", pipeline.GetLatency())
 
     // The main engine loop
     while (running) {
         PROFILING_SCOPE
 
+        const u64 heap_allocations = Core::GetHeapAllocationCount();
+
         // Polling window events
         while (SDL_PollEvent(&event) != 0) {
-            // ImGui_ImplSDL2_ProcessEvent(&event);
-            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_RESIZED &&
-                event.window.windowID == SDL_GetWindowID(window)) {
-                swap_chain_rebuild = true;
-            }
-
-            if (event.type == SDL_QUIT)
-                running = false;
-
-            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE &&
-                event.window.windowID == SDL_GetWindowID(window))
-                running = false;
+            PublishEvent(event, window_id);
         }
 
-        // Rebuild swapchain if needed (ex on resize)
-        if (swap_chain_rebuild) {
-            renderer->GetDevice()->RebuildSwapchain(renderer->GetSwapchain());
-            swap_chain_rebuild = false;
-        }
+        // Input, resizes (the renderer rebuilds its swapchain) and asset reloads, also those queued by other threads
+        events.Dispatch(Core::EVENT_PHASE_FRAME_START);
+        if (!running)
+            break;
 
-        // Resize viewport render target on viewporet size change
-        if (renderer->resize) {
-            renderer->ResizeRenderTargets();
-            renderer->resize = false;
-        }
+        FrameSnapshot &frame = frames[pipeline.GetWriteIndex()];
 
-        renderer->GetDevice()->BeginFrameEXP(renderer->GetSwapchain());
+        // ImGui destroys closed platform windows in NewFrame, through the device
+        if (editor->HasPlatformWindows())
+            pipeline.Flush();
 
         rhi->Tick(0);
-        renderer->Tick(0);
-        editor->Tick(0);
+        renderer->Update(frame.scene);
+        editor->Update(frame.ui);
 
-        renderer->GetDevice()->EndFrameEXP(renderer->GetSwapchain());
+        events.Dispatch(Core::EVENT_PHASE_FRAME_END);
+
+        pipeline.Submit();
+
+        // Peaks and rates in the memory stats are as fine grained as this
+        Core::SampleMemoryStats();
 
         if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+            // Only frames with undocked panels wait for the render thread
+            if (editor->HasPlatformWindows())
+                pipeline.Flush();
             ImGui::UpdatePlatformWindows();
             ImGui::RenderPlatformWindowsDefault();
         }
+
+        // Steady state frames are expected to stay off the heap. Only a diagnostic, Tests/FrameAllocations enforces it
+        if (Core::IsCountingAllocations() && ++frame_number > ALLOCATION_WARMUP_FRAMES) {
+            const u64 allocations = Core::GetHeapAllocationCount() - heap_allocations;
+            if (allocations > 0)
+                LOG_WARN_EVERY(1000, "frame {} made {} heap allocations", frame_number, allocations)
+        }
     }
 
+    pipeline.Flush();
+    events.Unsubscribe(stop, &running);
+
     // ImGui_ImplSDL2_Shutdown();
     // ImGui_ImplRHI_Shutdown();
     ImGui::DestroyContext();
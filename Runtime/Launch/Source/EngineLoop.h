@@ -1,14 +1,19 @@
 #pragma once
+#include <Core/Types.h>
 
 namespace Squid {
 
 class EngineLoop {
 public:
-    EngineLoop();
+    // 0 renders every frame right after its simulation, 1 pipelines the simulation one frame ahead of rendering
+    explicit EngineLoop(u32 frame_latency = 1);
     ~EngineLoop();
     int Start();
     // void Pause();
     // void Terminate();
+
+private:
+    u32 frame_latency;
 };
 
 } // namespace Squid
\ No newline at end of file
@@ -1,9 +1,17 @@
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <vector>
 #include <pch.h>
 
+#include <Core/IO/VirtualFileSystem.h>
+#include <Core/Jobs/JobSystem.h>
 #include <Core/Log.h>
+#include <Core/LogRing.h>
+#include <Core/Profiling.h>
 #include <RHI/Module.h>
 
 #include "EngineLoop.h"
@@ -11,11 +19,54 @@
 using namespace Squid;
 using namespace Core;
 
-int main() {
+// Squid --pack <directory> <pack> [none|lz4|zstd] writes a pack for shipping and exits
+static int WritePack(int argc, char **argv) {
+    PackCompression compression = PACK_COMPRESSION_NONE;
+    if (argc > 4 && strcmp(argv[4], "lz4") == 0)
+        compression = PACK_COMPRESSION_LZ4;
+    else if (argc > 4 && strcmp(argv[4], "zstd") == 0)
+        compression = PACK_COMPRESSION_ZSTD;
+
+    try {
+        Core::WritePack(argv[2], argv[3], compression);
+    } catch (const std::exception &error) {
+        LOG_ERROR("failed to pack {}: {}", argv[2], error.what())
+        return 1;
+    }
+
+    LOG_INFO("packed {} into {}", argv[2], argv[3])
+    return 0;
+}
+
+int main(int argc, char **argv) {
     
     Core::InitializeLogger("main");
+#ifdef SQUID_EDITOR
+    // Kept from the start so the log widget shows startup messages too
+    Core::AddLogSink(std::make_shared<Core::LogRingSink>(Core::GetLogRing()));
+#endif
+
+    if (argc > 3 && strcmp(argv[1], "--pack") == 0)
+        return WritePack(argc, argv);
+
+    // Loose assets overlay the pack, shipping builds only have the pack
+    if (std::filesystem::exists("Assets.sqpak"))
+        Core::GetFileSystem().MountPack("Assets.sqpak", "Assets");
+    if (std::filesystem::is_directory("Assets"))
+        Core::GetFileSystem().MountDirectory("Assets", "Assets");
+
+    // Created here so the main thread owns the first job queue
+    Core::Profiler::SetThreadName("Main");
+    LOG_INFO("job system running on {} threads", Core::GetJobSystem().GetThreadCount())
+
+    // Squid --frame-latency 0 renders on the main thread, serially after each simulated frame
+    u32 frame_latency = 1;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--frame-latency") == 0)
+            frame_latency = u32(std::max(0, atoi(argv[i + 1])));
+    }
 
-    auto app = new EngineLoop();
+    auto app = new EngineLoop(frame_latency);
     app->Start();
     delete app;
     return 0;
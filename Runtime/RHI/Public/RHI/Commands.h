@@ -24,6 +24,8 @@ namespace RHI {
     struct CommandList {
         uint8_t id = 0;
         uint32_t _backbuffer_id = 0;
+        // Tells a transfer list apart from later ones recorded into the same slot
+        uint32_t _transfer_serial = 0;
         bool transfer = false;
     };
 
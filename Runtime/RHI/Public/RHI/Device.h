@@ -48,7 +48,13 @@ namespace RHI {
         virtual void BeginFrameEXP(const SwapchainHandle &handle) = 0;
         virtual void EndFrameEXP(const SwapchainHandle &handle) = 0;
 
+        // Transfer lists are fenced instead of waited for, the buffers they copy from have to stay loaded until the
+        // list is complete
         virtual void QueueSubmit(QueueType queue, const CommandList &list) = 0;
+        // Whether a submitted transfer list has finished on the GPU
+        virtual bool IsComplete(const CommandList &list) = 0;
+        // Blocks until a submitted transfer list has finished on the GPU
+        virtual void Wait(const CommandList &list) = 0;
 
         // == Command list =============================================================
         virtual CommandList BeginCommandListEXP() = 0;
@@ -76,28 +82,52 @@ namespace RHI {
             const CommandList &cmd, const GraphicsPipelineHandle &pso, const DescriptorSetHandle &set, u32 index) = 0;
         virtual void BindPipelineState(const CommandList &cmd, const GraphicsPipelineHandle &pso) = 0;
 
+        virtual void BindDescriptorSet(
+            const CommandList &cmd, const ComputePipelineHandle &pso, const DescriptorSetHandle &set, u32 index) = 0;
+        virtual void BindPipelineState(const CommandList &cmd, const ComputePipelineHandle &pso) = 0;
+
         // == Draw, Dispatch ==============================================================
 
         virtual void
         DrawIndexed(const CommandList &cmd, u32 index_count, u32 start_index, u32 vertex_offset) = 0;
 
-        // virtual void
-        // Dispatch(const CommandList &cmd, uint32_t thread_group_x, uint32_t thread_group_y, uint32_t thread_group_z) =
-        // 0;
+        // Issues draw_count draws with DrawIndexedIndirectCommand arguments read from args at offset
+        virtual void DrawIndexedIndirect(
+            const CommandList &cmd,
+            const BufferHandle &args,
+            u64 offset,
+            u32 draw_count,
+            u32 stride = sizeof(DrawIndexedIndirectCommand)) = 0;
+
+        // Must be recorded outside of a render pass
+        virtual void Dispatch(const CommandList &cmd, u32 thread_group_x, u32 thread_group_y, u32 thread_group_z) = 0;
 
         // == Resource Copies ===========================================================
 
         // Buffer -> Buffer
         virtual void Copy(const CommandList &cmd, const BufferHandle &dst, const BufferHandle &src) = 0;
-        // Buffer -> Texture
-        virtual void Copy(const CommandList &cmd, const BufferHandle &dst, const TextureHandle &src, u64 layer_offset = 0) = 0;
+        // Buffer -> Texture, every layer holds mips [base_mip, base_mip + mip_count) tightly packed,
+        // layers start at buffer_offset + layer * layer_offset
+        virtual void Copy(
+            const CommandList &cmd,
+            const BufferHandle &dst,
+            const TextureHandle &src,
+            u64 layer_offset = 0,
+            u32 base_mip = 0,
+            u32 mip_count = 1,
+            u64 buffer_offset = 0) = 0;
         // Texture -> Texture
         // virtual void Copy(const CommandList &cmd, const TextureHandle &dst, const TextureHandle &src) = 0;
         // Texture -> Buffer
         // virtual void Copy(const CommandList &cmd, const TextureHandle &dst, const BufferHandle &src) = 0;
 
+        // Fills mips 1..mip_levels from mip 0 with linear downsampling
+        virtual void GenerateMips(const CommandList &cmd, const TextureHandle &handle) = 0;
+
         // Pipeline Barrier
         virtual void Barrier(const CommandList &cmd, const TextureHandle &handle, ImageLayout new_layout) = 0;
+        // Makes compute shader writes to the buffer visible to indirect draws, vertex and index fetch
+        virtual void Barrier(const CommandList &cmd, const BufferHandle &handle) = 0;
         // virtual void Barrier(const GPUBarrier* barriers, uint32_t numBarriers) = 0;
 
         virtual void BindBuffer(const DescriptorSetHandle &set, u32 bindng, const BufferHandle &handle) = 0;
@@ -107,8 +137,16 @@ namespace RHI {
         virtual void UnmapBuffer(const BufferHandle &handle) = 0;
 
         virtual void ResizeTexture(const TextureHandle &handle, u32 width, u32 height) = 0;
+        // Restricts sampling to mips >= base_mip, used while streaming in the higher mips
+        virtual void SetTextureBaseMip(const TextureHandle &handle, u32 base_mip) = 0;
 
         virtual void RebuildSwapchain(const SwapchainHandle &handle) = 0;
+
+        // Whether textures of the format can be created and sampled, block compressed formats are optional
+        virtual bool IsFormatSupported(Format format) const = 0;
+
+        // Blocks until the GPU has finished all submitted work, objects used by earlier frames can be replaced after
+        virtual void WaitIdle() = 0;
     };
 
 } // namespace RHI
@@ -121,6 +121,127 @@ namespace RHI {
         FORMAT_BC7_UNORM_SRGB
     };
 
+    // Memory footprint of a format, uncompressed formats are 1x1 blocks
+    struct FormatInfo {
+        u8 block_size = 0; // bytes per block
+        u8 block_width = 1;
+        u8 block_height = 1;
+    };
+
+    constexpr FormatInfo GetFormatInfo(Format format) {
+        switch (format) {
+        case FORMAT_R32G32B32A32_FLOAT:
+        case FORMAT_R32G32B32A32_UINT:
+        case FORMAT_R32G32B32A32_SINT:
+            return {16, 1, 1};
+        case FORMAT_R32G32B32_FLOAT:
+        case FORMAT_R32G32B32_UINT:
+        case FORMAT_R32G32B32_SINT:
+            return {12, 1, 1};
+        case FORMAT_R16G16B16A16_FLOAT:
+        case FORMAT_R16G16B16A16_UNORM:
+        case FORMAT_R16G16B16A16_UINT:
+        case FORMAT_R16G16B16A16_SNORM:
+        case FORMAT_R16G16B16A16_SINT:
+        case FORMAT_R32G32_FLOAT:
+        case FORMAT_R32G32_UINT:
+        case FORMAT_R32G32_SINT:
+        case FORMAT_R32G8X24_TYPELESS:
+        case FORMAT_D32_FLOAT_S8X24_UINT:
+            return {8, 1, 1};
+        case FORMAT_R16G16B16_FLOAT:
+            return {6, 1, 1};
+        case FORMAT_R10G10B10A2_UNORM:
+        case FORMAT_R10G10B10A2_UINT:
+        case FORMAT_R11G11B10_FLOAT:
+        case FORMAT_R8G8B8A8_UNORM:
+        case FORMAT_R8G8B8A8_UNORM_SRGB:
+        case FORMAT_R8G8B8A8_UINT:
+        case FORMAT_R8G8B8A8_SNORM:
+        case FORMAT_R8G8B8A8_SINT:
+        case FORMAT_B8G8R8A8_UNORM:
+        case FORMAT_B8G8R8A8_UNORM_SRGB:
+        case FORMAT_R16G16_FLOAT:
+        case FORMAT_R16G16_UNORM:
+        case FORMAT_R16G16_UINT:
+        case FORMAT_R16G16_SNORM:
+        case FORMAT_R16G16_SINT:
+        case FORMAT_R32_FLOAT:
+        case FORMAT_R32_UINT:
+        case FORMAT_R32_SINT:
+        case FORMAT_R32_TYPELESS:
+        case FORMAT_D32_FLOAT:
+        case FORMAT_R24G8_TYPELESS:
+        case FORMAT_D24_UNORM_S8_UINT:
+            return {4, 1, 1};
+        case FORMAT_D16_UNORM:
+        case FORMAT_R16_TYPELESS:
+        case FORMAT_R8G8_UNORM:
+        case FORMAT_R8G8_UINT:
+        case FORMAT_R8G8_SNORM:
+        case FORMAT_R8G8_SINT:
+        case FORMAT_R16_FLOAT:
+        case FORMAT_R16_UNORM:
+        case FORMAT_R16_UINT:
+        case FORMAT_R16_SNORM:
+        case FORMAT_R16_SINT:
+            return {2, 1, 1};
+        case FORMAT_R8_UNORM:
+        case FORMAT_R8_UINT:
+        case FORMAT_R8_SNORM:
+        case FORMAT_R8_SINT:
+            return {1, 1, 1};
+        case FORMAT_BC1_UNORM:
+        case FORMAT_BC1_UNORM_SRGB:
+        case FORMAT_BC4_UNORM:
+        case FORMAT_BC4_SNORM:
+            return {8, 4, 4};
+        case FORMAT_BC2_UNORM:
+        case FORMAT_BC2_UNORM_SRGB:
+        case FORMAT_BC3_UNORM:
+        case FORMAT_BC3_UNORM_SRGB:
+        case FORMAT_BC5_UNORM:
+        case FORMAT_BC5_SNORM:
+        case FORMAT_BC6H_UF16:
+        case FORMAT_BC6H_SF16:
+        case FORMAT_BC7_UNORM:
+        case FORMAT_BC7_UNORM_SRGB:
+            return {16, 4, 4};
+        default:
+            return {};
+        }
+    }
+
+    // Number of mips in a full chain down to 1x1
+    constexpr u32 GetMipCount(u32 width, u32 height) {
+        u32 levels = 1;
+        u32 size = width > height ? width : height;
+        while (size > 1) {
+            size >>= 1;
+            levels++;
+        }
+        return levels;
+    }
+
+    constexpr u32 GetMipDimension(u32 size, u32 mip) { return (size >> mip) > 0 ? (size >> mip) : 1; }
+
+    // Size in bytes of one layer of a mip level
+    constexpr u64 GetMipSize(Format format, u32 width, u32 height, u32 mip) {
+        const FormatInfo info = GetFormatInfo(format);
+        const u64 blocks_x = (GetMipDimension(width, mip) + info.block_width - 1) / info.block_width;
+        const u64 blocks_y = (GetMipDimension(height, mip) + info.block_height - 1) / info.block_height;
+        return blocks_x * blocks_y * info.block_size;
+    }
+
+    // Size in bytes of one layer of the mips [base_mip, base_mip + mip_count)
+    constexpr u64 GetMipChainSize(Format format, u32 width, u32 height, u32 base_mip, u32 mip_count) {
+        u64 size = 0;
+        for (u32 mip = base_mip; mip < base_mip + mip_count; mip++) {
+            size += GetMipSize(format, width, height, mip);
+        }
+        return size;
+    }
+
     /*enum Usage : uint8_t {
         USAGE_DEFAULT,
         USAGE_IMMUTABLE,
@@ -197,7 +318,9 @@ namespace RHI {
             UNIFORM_BUFFER = 1 << 4,
             TRANSFER_SRC = 1 << 5,
             TRANSFER_DST = 1 << 6,
-            ALL = VERTEX_BUFFER | INDEX_BUFFER | STORAGE_BUFFER | UNIFORM_BUFFER | TRANSFER_DST | TRANSFER_SRC
+            INDIRECT_BUFFER = 1 << 7,
+            ALL = VERTEX_BUFFER | INDEX_BUFFER | STORAGE_BUFFER | UNIFORM_BUFFER | TRANSFER_DST | TRANSFER_SRC |
+                  INDIRECT_BUFFER
         };
 
         Usage usage;
@@ -205,6 +328,15 @@ namespace RHI {
         bool cpu_access;
     };
 
+    // Argument layout of indirect indexed draws, matches VkDrawIndexedIndirectCommand
+    struct DrawIndexedIndirectCommand {
+        u32 index_count;
+        u32 instance_count;
+        u32 first_index;
+        i32 vertex_offset;
+        u32 first_instance;
+    };
+
     struct TextureHandle : Handle {
 
         enum class Type : uint8_t {
@@ -286,6 +418,8 @@ namespace RHI {
     struct ComputePipelineHandle : Handle {
         std::vector<DescriptorSetHandle> descriptor_sets;
         std::string compute_shader;
+        // Entry point the SPIR-V was compiled with, dxc keeps the HLSL function name
+        std::string compute_entry = "mainCS";
     };
 
     enum class PrimitiveTopology {
@@ -294,7 +428,41 @@ namespace RHI {
         TRIANGLE_FAN = 3,
     };
 
-    enum class VertexType : uint8_t { FLOAT, FLOAT2, FLOAT3, FLOAT4 };
+    // Normalized types are expanded to float on fetch, shaders read them as floatN
+    enum class VertexType : uint8_t {
+        FLOAT,
+        FLOAT2,
+        FLOAT3,
+        FLOAT4,
+        HALF2,
+        HALF4,
+        SNORM8_4,
+        UNORM8_4,
+        SNORM16_2,
+        SNORM16_4,
+        UNORM10_10_10_2, // xyz 10 bit, w 2 bit
+    };
+
+    constexpr u32 GetVertexTypeSize(VertexType type) {
+        switch (type) {
+        case VertexType::FLOAT:
+        case VertexType::HALF2:
+        case VertexType::SNORM8_4:
+        case VertexType::UNORM8_4:
+        case VertexType::SNORM16_2:
+        case VertexType::UNORM10_10_10_2:
+            return 4;
+        case VertexType::FLOAT2:
+        case VertexType::HALF4:
+        case VertexType::SNORM16_4:
+            return 8;
+        case VertexType::FLOAT3:
+            return 12;
+        case VertexType::FLOAT4:
+            return 16;
+        }
+        return 0;
+    }
 
     struct VertexInput {
         VertexType type;     // 1 byte
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <Core/Types.h>
+#include <RHI/Module.h>
+
+namespace Squid {
+namespace Renderer {
+
+    // Single 4x4 block encoders, pixels are row major RGBA
+    void EncodeBC1Block(const u8 pixels[16 * 4], u8 *block);
+    void EncodeBC3Block(const u8 pixels[16 * 4], u8 *block);
+    void EncodeBC4Block(const u8 pixels[16 * 4], u8 *block, u32 channel = 0);
+    void EncodeBC5Block(const u8 pixels[16 * 4], u8 *block);
+    void EncodeBC7Block(const u8 pixels[16 * 4], u8 *block);
+    // Unsigned half floats, negative values are clamped to zero
+    void EncodeBC6HBlock(const f32 pixels[16 * 4], u8 *block);
+
+    // Compresses a whole surface into the block format, edge blocks repeat the last row / column.
+    // Source is RGBA8 for BC1-BC5 and BC7, RGBA32F for BC6H.
+    std::vector<u8> CompressSurface(const void *pixels, u32 width, u32 height, RHI::Format format);
+
+} // namespace Renderer
+} // namespace Squid
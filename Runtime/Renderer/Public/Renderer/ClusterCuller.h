@@ -0,0 +1,78 @@
+#pragma once
+#include <Core/Memory/FrameAllocator.h>
+#include <RHI/Module.h>
+#include <glm/glm.hpp>
+#include <string>
+
+#include "Mesh.h"
+
+namespace Squid {
+namespace Renderer {
+
+    // Culling inputs in the mesh's object space, laid out like the constant buffer of cluster_cull.hlsl
+    struct ClusterCullConstants {
+        glm::vec4 planes[6]; // inward facing, normalized
+        glm::vec4 camera_position;
+        u32 meshlet_offset;
+        u32 meshlet_count;
+        u32 padding[2];
+    };
+
+    static_assert(sizeof(ClusterCullConstants) == 7 * 16 + 16, "");
+
+    ClusterCullConstants MakeClusterCullConstants(
+        const glm::mat4 &model, const glm::mat4 &view_projection, const glm::vec3 &camera, const CookedLod &lod);
+
+    // Writes one indirect draw per meshlet of the LOD, culled meshlets get an instance count of zero.
+    // Returns the visible count.
+    u32 CullClusters(
+        const CookedMeshlet *meshlets, const ClusterCullConstants &constants, RHI::DrawIndexedIndirectCommand *draws);
+
+    // Frustum and normal cone culling of the meshlets of one mesh LOD into an indirect draw buffer.
+    // Runs as a compute pass when the compiled cull shader is present and on the CPU otherwise.
+    class ClusterCuller {
+    public:
+        ClusterCuller(RHI::Device *device, const Mesh &mesh, const std::string &shader);
+        ~ClusterCuller();
+
+        // Records the compute pass, has to happen outside of a render pass. Draw uses the same LOD.
+        void Cull(
+            const RHI::CommandList &list,
+            u32 lod,
+            const glm::mat4 &model,
+            const glm::mat4 &view_projection,
+            const glm::vec3 &camera);
+
+        // Expects the mesh's vertex and index buffers to be bound
+        void Draw(const RHI::CommandList &list);
+
+        inline bool IsComputeCulling() const { return compute; }
+        // Null when culling on the CPU
+        inline RHI::ComputePipelineHandle *GetPipeline() { return compute ? &pipeline : nullptr; }
+        // Only known when culling on the CPU
+        inline u32 GetVisibleCount() const { return visible_count; }
+
+    private:
+        // Rewritten every frame, so every frame in flight gets its own
+        struct FrameBuffers {
+            RHI::BufferHandle draw_buffer;
+            RHI::BufferHandle constants_buffer;
+            RHI::DescriptorSetHandle descriptor_set;
+        };
+
+        RHI::Device *device;
+        const Mesh &mesh;
+        bool compute = false;
+        u32 visible_count = 0;
+        u32 lod = 0;
+        // Slot of the last Cull, Draw reads the same one
+        u32 frame = 0;
+
+        FrameBuffers frames[Core::MAX_FRAMES_IN_FLIGHT];
+        RHI::ComputePipelineHandle pipeline;
+
+        static constexpr u32 THREAD_GROUP_SIZE = 64;
+    };
+
+} // namespace Renderer
+} // namespace Squid
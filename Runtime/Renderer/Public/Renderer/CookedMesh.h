@@ -0,0 +1,109 @@
+#pragma once
+#include <string>
+#include <Core/Types.h>
+
+namespace Squid {
+namespace Renderer {
+
+    // Cooked mesh container (.sqmesh)
+    //
+    // [CookedMeshHeader][CookedSubmesh * submesh_count][CookedLod * lod_count]
+    // [vertex stream][index stream][meshlet stream]
+    //
+    // Streams start at STREAM_ALIGNMENT and hold exactly what the GPU buffers get, so loading
+    // is a memory map plus a copy per stream into staging. The index and meshlet streams hold every
+    // LOD back to back, finest first, each LOD listing its submeshes in order.
+
+    static constexpr u32 COOKED_MESH_MAGIC = 0x534d5153; // "SQMS"
+    static constexpr u32 COOKED_MESH_VERSION = 7;
+    static constexpr u64 COOKED_MESH_STREAM_ALIGNMENT = 64;
+
+    static constexpr u32 MESHLET_MAX_VERTICES = 64;
+    static constexpr u32 MESHLET_MAX_TRIANGLES = 124;
+
+    static constexpr u32 MESH_MAX_LODS = 5;
+    // Simplification stops once a LOD would deviate more than this fraction of the mesh radius from the source
+    static constexpr f32 MESH_LOD_MAX_ERROR = 0.05f;
+
+    struct MeshBounds {
+        f32 min[3] = {};
+        f32 max[3] = {};
+        f32 center[3] = {};
+        f32 radius = 0.0f;
+    };
+
+    struct CookedMeshHeader {
+        u32 magic = COOKED_MESH_MAGIC;
+        u32 version = COOKED_MESH_VERSION;
+
+        u32 vertex_stride = 0;
+        u32 vertex_count = 0;
+        u32 index_stride = sizeof(u32);
+        u32 index_count = 0;
+        u32 submesh_count = 0;
+        u32 meshlet_count = 0;
+        u32 lod_count = 0;
+        u32 padding = 0;
+
+        u64 submesh_offset = 0;
+        u64 lod_offset = 0;
+        u64 vertex_offset = 0;
+        u64 index_offset = 0;
+        u64 meshlet_offset = 0;
+
+        MeshBounds bounds;
+    };
+
+    // Submesh ranges refer to LOD 0
+    struct CookedSubmesh {
+        u32 index_offset = 0;
+        u32 index_count = 0;
+        u32 meshlet_offset = 0;
+        u32 meshlet_count = 0;
+        u32 material = 0;
+        u32 padding = 0;
+        MeshBounds bounds;
+    };
+
+    // One level of detail of the whole mesh
+    struct CookedLod {
+        u32 index_offset = 0;
+        u32 index_count = 0;
+        u32 meshlet_offset = 0;
+        u32 meshlet_count = 0;
+        f32 error = 0.0f; // sum of the per-step maximum deviations in object units, at most MESH_LOD_MAX_ERROR * radius
+        u32 padding[3] = {};
+    };
+
+    // Contiguous run of triangles in the index stream, uploaded as is to the cluster buffer.
+    // Culled when the sphere is outside the frustum or when every triangle faces away from the camera:
+    // dot(center - camera, cone_axis) >= cone_cutoff * length(center - camera) + radius
+    struct CookedMeshlet {
+        f32 center[3] = {};
+        f32 radius = 0.0f;
+        f32 cone_axis[3] = {};
+        f32 cone_cutoff = 1.0f; // 1 never passes the test above, used when normals spread too far
+        u32 index_offset = 0;
+        u32 index_count = 0;
+        u32 vertex_count = 0;
+        u32 padding = 0;
+    };
+
+    static_assert(sizeof(CookedMeshHeader) == 120, "");
+    static_assert(sizeof(CookedSubmesh) == 64, "");
+    static_assert(sizeof(CookedLod) == 32, "");
+    static_assert(sizeof(CookedMeshlet) == 48, "");
+
+    inline std::string GetCookedMeshPath(const std::string &source) { return source + ".sqmesh"; }
+
+    // Cooked file is missing, has an older version or is older than the source
+    bool IsCookedMeshStale(const std::string &cooked, const std::string &source);
+
+    // Offline import of an OBJ file, one submesh per shape with exactly deduplicated vertices.
+    // Triangles are reordered for the vertex cache and overdraw, vertices for fetch locality,
+    // then up to MESH_MAX_LODS - 1 simplified LODs are generated, each with about half the triangles of the previous,
+    // and every submesh of every LOD is cut into meshlets of MESHLET_MAX_VERTICES / MESHLET_MAX_TRIANGLES.
+    void CookMeshFromObj(const std::string &source, const std::string &cooked);
+
+} // namespace Renderer
+} // namespace Squid
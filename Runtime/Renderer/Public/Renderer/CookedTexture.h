@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Core/Types.h>
+#include <RHI/Module.h>
+
+#include "MipChain.h"
+
+namespace Squid {
+namespace Renderer {
+
+    // Cooked texture container (.sqtex)
+    //
+    // [CookedTextureHeader][CookedTextureMip * mip_count][padding][layer 0 mips][layer 1 mips]...
+    //
+    // Every layer stores its full mip chain tightly packed from the largest mip, so the data section
+    // can be copied into a staging buffer as is and uploaded with layer_size as the layer stride.
+
+    static constexpr u32 COOKED_TEXTURE_MAGIC = 0x58545153; // "SQTX"
+    static constexpr u32 COOKED_TEXTURE_VERSION = 1;
+
+    struct CookedTextureHeader {
+        u32 magic = COOKED_TEXTURE_MAGIC;
+        u32 version = COOKED_TEXTURE_VERSION;
+        u16 format = RHI::FORMAT_UNKNOWN;
+        u8 type = u8(RHI::TextureHandle::Type::TEXTURE_2D);
+        u8 layers = 1;
+        u32 width = 0;
+        u32 height = 0;
+        u32 mip_count = 0;
+        u64 layer_size = 0;  // bytes of one layer with all its mips
+        u64 data_offset = 0; // first byte of layer 0
+    };
+
+    static_assert(sizeof(CookedTextureHeader) == 40, "");
+
+    struct CookedTextureMip {
+        u64 offset = 0; // relative to the start of a layer
+        u64 size = 0;
+    };
+
+    inline std::string GetCookedTexturePath(const std::string &source) { return source + ".sqtex"; }
+
+    // Cooked file is missing, has an older version, was cooked to another format or is older than any of its sources
+    bool IsCookedTextureStale(const std::string &cooked, const std::vector<std::string> &sources, RHI::Format format);
+
+    // Encodes one source per layer with a full mip chain into the block compressed format.
+    // BC6H reads the sources as HDR, every other format as RGBA8.
+    void CookTexture(
+        const std::vector<std::string> &sources,
+        const std::string &cooked,
+        RHI::Format format,
+        RHI::TextureHandle::Type type = RHI::TextureHandle::Type::TEXTURE_2D);
+
+    CookedTextureHeader ReadCookedTextureHeader(const std::string &cooked);
+    // Reads the data section of all layers, dst has to hold layer_size * layers bytes
+    void ReadCookedTextureData(const std::string &cooked, const CookedTextureHeader &header, void *dst);
+    // Single layer textures only
+    MipChain ReadCookedMipChain(const std::string &cooked);
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,72 @@
+#pragma once
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+#include <Core/FileWatcher.h>
+#include <RHI/Module.h>
+
+
+namespace Squid {
+namespace Renderer {
+
+    // One SPIR-V output of a shader source, as in Assets/Shaders/compile.bat. HLSL sources are compiled with DXC,
+    // GLSL sources (.vert, .frag, .comp) with glslc, which ignores entry and profile.
+    struct ShaderProgram {
+        std::string source;
+        std::string entry;
+        std::string profile;
+        std::string output;
+    };
+
+    // Watches the asset directory while the renderer runs. Changed shader sources are recompiled in the background
+    // and the pipelines using them are rebuilt in Tick, a failed compile keeps the old pipeline and logs the errors.
+    // Every other change except the compiled .spv files and their .tmp is published as an AssetReloadEvent.
+    class HotReload {
+    public:
+        HotReload(RHI::Device *device, const std::string &directory = "Assets");
+        ~HotReload();
+
+        // The pipeline has to stay at the same address, its shaders and id are replaced when a program is recompiled
+        void Watch(RHI::GraphicsPipelineHandle &pipeline, const ShaderProgram &vertex, const ShaderProgram &pixel);
+        void Watch(RHI::ComputePipelineHandle &pipeline, const ShaderProgram &compute);
+
+        // Swaps in finished compiles, call at a frame boundary before the frame records any command list
+        void Tick();
+
+    private:
+        static constexpr u32 INVALID_PROGRAM = ~0u;
+
+        struct CompileResult {
+            u32 program;
+            bool success = false;
+            std::string log;
+            std::string spirv;
+        };
+
+        struct WatchedPipeline {
+            RHI::GraphicsPipelineHandle *graphics = nullptr;
+            RHI::ComputePipelineHandle *compute = nullptr;
+            // Vertex and pixel, or compute
+            u32 programs[2] = {INVALID_PROGRAM, INVALID_PROGRAM};
+        };
+
+        u32 AddProgram(const ShaderProgram &program);
+        void StartCompile();
+        void Apply(std::vector<CompileResult> &results);
+        static CompileResult Compile(u32 index, const ShaderProgram &program);
+
+        RHI::Device *device;
+        Core::FileWatcher watcher;
+
+        std::vector<ShaderProgram> programs;
+        std::vector<WatchedPipeline> pipelines;
+
+        // Programs changed while the compile in flight was running
+        std::vector<u32> dirty_programs;
+        std::future<std::vector<CompileResult>> compile;
+        std::chrono::steady_clock::time_point change_time;
+    };
+
+} // namespace Renderer
+} // namespace Squid
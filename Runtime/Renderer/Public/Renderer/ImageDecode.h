@@ -0,0 +1,32 @@
+#pragma once
+#include <Core/Jobs/JobSystem.h>
+#include <Core/Types.h>
+
+#include <vector>
+
+namespace Squid {
+namespace Renderer {
+
+    // One encoded image of a batch and where its pixels go. ReadImageInfo fills in the size, the caller lays the
+    // images out by setting their offsets before DecodeImages runs.
+    struct ImageDecode {
+        const std::vector<u8> *file = nullptr;
+        // Four f32 channels instead of four u8 ones
+        bool hdr = false;
+        u32 width = 0;
+        u32 height = 0;
+        u64 offset = 0;
+
+        inline u64 GetDecodedSize() const { return u64(width) * height * (hdr ? 4 * sizeof(f32) : 4); }
+    };
+
+    // Reads the size from the header, throws when the file isn't an image stb can decode
+    void ReadImageInfo(ImageDecode &image);
+
+    // Decodes every image into destination at its offset, one job per image. The first failure is thrown once
+    // every image has finished, an image that doesn't match the size of its header fails.
+    void DecodeImages(
+        const std::vector<ImageDecode> &images, u8 *destination, Core::JobSystem &system = Core::GetJobSystem());
+
+} // namespace Renderer
+} // namespace Squid
@@ -1,26 +1,29 @@
 #pragma once
 #include <RHI/Module.h>
-#include <tiny_obj_loader.h>
+#include <Core/IO/VirtualFileSystem.h>
 #include <glm/glm.hpp>
 #include <stdio.h>
 #include <string.h>
 
-#define USE_STAGING_BUFFER 1
+#include "CookedMesh.h"
 
 namespace Squid {
 namespace Renderer {
 
+    // Packed GPU vertex, the normalized attributes expand to the float inputs of the vertex shader
     struct MeshVertex {
-        glm::vec3 position;
-        glm::vec3 normal;
-        glm::vec3 color;
-        glm::vec2 uv0;
-
-        bool operator==(const MeshVertex &other) const {
-            return position == other.position && color == other.color && uv0 == other.uv0;
-        }
+        glm::vec3 position; // FLOAT3
+        i8 normal[4];       // SNORM8_4, w unused
+        u8 color[4];        // UNORM8_4
+        u16 uv0[2];         // HALF2
+
+        bool operator==(const MeshVertex &other) const { return memcmp(this, &other, sizeof(MeshVertex)) == 0; }
     };
 
+    static_assert(sizeof(MeshVertex) == 24, "");
+
+    // Loads the cooked version of an OBJ file, cooking it first when missing or stale.
+    // The cooked file stays mapped until its streams are copied to the device.
     class Mesh {
     public:
         Mesh(const std::string &path);
@@ -29,26 +32,35 @@ namespace Renderer {
         void LoadOnDevice(const std::unique_ptr<RHI::Device> &device);
 
         inline uint32_t GetMemoryUsage() const {
-            uint32_t size = 0;
-            size += uint32_t(vertices.size() * sizeof(MeshVertex));
-            size += uint32_t(indices.size() * sizeof(uint16_t));
-            return size;
+            return uint32_t(
+                header.vertex_count * header.vertex_stride + header.index_count * header.index_stride +
+                header.meshlet_count * sizeof(CookedMeshlet));
         };
 
-        inline uint32_t GetVerticesCount() const { return static_cast<uint32_t>(indices.size()); }
+        inline uint32_t GetVerticesCount() const { return header.index_count; }
+        inline const MeshBounds &GetBounds() const { return header.bounds; }
+        inline const std::vector<CookedSubmesh> &GetSubmeshes() const { return submeshes; }
+        // Finest first, never empty
+        inline const std::vector<CookedLod> &GetLods() const { return lods; }
+        inline const std::vector<CookedMeshlet> &GetMeshlets() const { return meshlets; }
         inline const RHI::BufferHandle &GetVertexBuffer() const { return vertex_buffer; }
         inline const RHI::BufferHandle &GetIndexBuffer() const { return index_buffer; }
+        // CookedMeshlet array read by the culling pass
+        inline const RHI::BufferHandle &GetClusterBuffer() const { return cluster_buffer; }
 
     private:
-        uint32_t vertex_count;
-        uint32_t indicies_count;
+        CookedMeshHeader header;
+        std::vector<CookedSubmesh> submeshes;
+        std::vector<CookedLod> lods;
+        std::vector<CookedMeshlet> meshlets;
 
-        std::vector<MeshVertex> vertices;
-        std::vector<uint32_t> indices;
+        // Valid between construction and LoadOnDevice
+        Core::VfsFile file;
 
         // GPU Local Buffers
         RHI::BufferHandle vertex_buffer;
         RHI::BufferHandle index_buffer;
+        RHI::BufferHandle cluster_buffer;
     };
 
 } // namespace Renderer
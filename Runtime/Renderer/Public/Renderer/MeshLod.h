@@ -0,0 +1,19 @@
+#pragma once
+#include <Core/Types.h>
+
+#include "CookedMesh.h"
+
+namespace Squid {
+namespace Renderer {
+
+    // Pixels covered by one world unit at distance from a perspective camera
+    f32 GetProjectedScale(f32 viewport_height, f32 vertical_fov, f32 distance);
+
+    // Picks the coarsest LOD whose error projects to at most max_pixel_error pixels.
+    // Moving away from current needs the error to clear the threshold by the hysteresis fraction,
+    // so objects sitting on a transition distance don't flicker between two LODs.
+    u32 SelectLod(
+        const CookedLod *lods, u32 lod_count, f32 projected_scale, f32 max_pixel_error, f32 hysteresis, u32 current);
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,64 @@
+#pragma once
+#include <Core/Types.h>
+#include <cstddef>
+#include <vector>
+
+namespace Squid {
+namespace Renderer {
+
+    // Import time index and vertex reordering for triangle lists.
+    // Every pass works in place and keeps the set of triangles unchanged.
+
+    struct VertexCacheStats {
+        u32 vertices_transformed = 0;
+        f32 acmr = 0.0f; // transformed vertices per triangle, 0.5 is ideal on large meshes
+        f32 atvr = 0.0f; // transformed vertices per referenced vertex, 1.0 is ideal
+    };
+
+    struct MeshletRange {
+        u32 index_offset = 0;
+        u32 index_count = 0;
+        u32 vertex_count = 0;
+    };
+
+    // Simulates a FIFO post-transform cache of cache_size entries
+    VertexCacheStats AnalyzeVertexCache(const u32 *indices, size_t index_count, size_t vertex_count, u32 cache_size = 16);
+
+    // Forsyth's linear-speed vertex cache optimization
+    void OptimizeVertexCache(u32 *indices, size_t index_count, size_t vertex_count);
+
+    // Splits a cache optimized list into clusters at cache misses and draws the outward facing clusters first.
+    // A split is only taken while the cluster's ACMR stays under threshold times the ACMR of the whole list.
+    void OptimizeOverdraw(
+        u32 *indices,
+        size_t index_count,
+        const f32 *positions,
+        size_t vertex_count,
+        size_t vertex_stride,
+        f32 threshold = 1.05f);
+
+    // Greedily cuts the list, in order, into runs touching at most max_vertices unique vertices and max_triangles
+    // triangles. Run after the cache and overdraw passes so meshlets inherit their locality.
+    std::vector<MeshletRange> BuildMeshlets(
+        const u32 *indices, size_t index_count, size_t vertex_count, u32 max_vertices, u32 max_triangles);
+
+    // Quadric error edge collapse into destination, which may alias indices. Returns the simplified index count.
+    // Stops at target_index_count or skips collapses that would move the surface more than target_error, in
+    // position units, from the planes of the source triangles they sweep over. Borders and attribute seams stay in
+    // place, so the result reuses the source vertices. error receives the largest deviation introduced.
+    size_t SimplifyMesh(
+        u32 *destination,
+        const u32 *indices,
+        size_t index_count,
+        const f32 *positions,
+        size_t vertex_count,
+        size_t vertex_stride,
+        size_t target_index_count,
+        f32 target_error,
+        f32 *error = nullptr);
+
+    // Orders vertices by first use and drops unreferenced ones, returns the new vertex count
+    size_t OptimizeVertexFetch(void *vertices, u32 *indices, size_t index_count, size_t vertex_count, size_t vertex_size);
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <Core/Types.h>
+#include <RHI/Module.h>
+
+namespace Squid {
+namespace Renderer {
+
+    // CPU side mip chain, mips are tightly packed from the largest to 1x1
+    struct MipChain {
+        RHI::Format format = RHI::FORMAT_UNKNOWN;
+        u32 width = 0;
+        u32 height = 0;
+        u32 mip_count = 0;
+
+        std::vector<u8> data;
+        std::vector<u64> offsets;
+
+        inline const u8 *GetMip(u32 mip) const { return data.data() + offsets[mip]; }
+        inline u64 GetSize(u32 base_mip, u32 count) const {
+            return RHI::GetMipChainSize(format, width, height, base_mip, count);
+        }
+    };
+
+    // Box filtered chain from tightly packed pixels, supports RGBA8 and RGBA32F formats.
+    // SRGB data is averaged in encoded space, which is close enough for streamed previews.
+    MipChain BuildMipChain(const void *pixels, u32 width, u32 height, RHI::Format format);
+
+} // namespace Renderer
+} // namespace Squid
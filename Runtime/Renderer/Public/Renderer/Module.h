@@ -5,12 +5,18 @@
 #include <RHI/Module.h>
 #include <Core/Log.h>
 #include <Core/ECS/Scene.h>
+#include <Core/Events/EventDispatcher.h>
 
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/glm.hpp>
 
+#include "ClusterCuller.h"
+#include "HotReload.h"
 #include "Mesh.h"
+#include "MeshLod.h"
+#include "RenderSnapshot.h"
+#include "TextureStreamer.h"
 
 namespace Squid {
 namespace Renderer {
@@ -18,27 +24,27 @@ namespace Renderer {
     using Core::EngineContext;
     using Core::IModule;
 
-    struct UniformBufferObject {
-        glm::mat4 model;
-        glm::mat4 view;
-        glm::mat4 proj;
-        glm::vec3 camera_pos;
-        float padding0;
-    };
-
-    static_assert(sizeof(UniformBufferObject) == 3 * 64 + 16, "");
-
     class Module : public IModule {
     public:
         Module(EngineContext *ctx) : IModule(ctx) {}
         ~Module() override;
 
         bool Initialize() override;
-        void Event() override;
+        // Update and the render half back to back on the calling thread
         void Tick(float delta) override;
 
         void CreateRenderer(void *win);
 
+        // Simulation half of the frame: moves and updates the scene, culls, picks LODs and writes what the render
+        // half needs into the snapshot. Owns the scene, the camera and the viewport size.
+        void Update(RenderSnapshot &snapshot);
+
+        // Render half, may run on the render thread a frame behind Update. Owns the device and everything loaded
+        // on it, reads nothing but the snapshot from the simulation side.
+        void BeginFrame(RenderSnapshot &snapshot);
+        void Render(RenderSnapshot &snapshot);
+        void EndFrame();
+
         inline RHI::SwapchainHandle &GetSwapchain() { return this->swapchain; }
         inline void *GetWindow() const { return this->win; }
         inline std::unique_ptr<RHI::Device> &GetDevice() { return this->device; }
@@ -47,6 +53,9 @@ namespace Renderer {
         inline Core::SceneGraph *GetScene() { return &scene; };
         inline Core::Entity GetSceneRoot() { return root; };
 
+        // Entity under the viewport position, x and y in [0, 1] from the top left corner, INVALID_ENTITY if none
+        Core::Entity Pick(f32 x, f32 y) const;
+
         // Viewport dimensions
         inline u32 GetFrameHeight() const { return this->frame_height; }
         inline u32 GetFrameWidth() const { return this->frame_width; }
@@ -57,6 +66,7 @@ namespace Renderer {
             resize = true; // disable to disable resizing
         }
 
+        // Set by SetViewportSize, handed to the render half by Update
         bool resize = false;
         void ResizeRenderTargets();
 
@@ -64,6 +74,15 @@ namespace Renderer {
         void UpdateUBO();
         void CreateRenderTargets();
 
+        void OnWindowResize(const Core::WindowResizeEvent *events, u32 count);
+        void OnAssetReload(const Core::AssetReloadEvent *events, u32 count);
+
+        // Waiting for the next Update
+        bool swapchain_dirty = false;
+        std::vector<std::string> reloaded_assets;
+        // Used by Tick
+        RenderSnapshot tick_snapshot;
+
         u32 frame_height = 100;
         u32 frame_width = 100;
 
@@ -75,10 +94,19 @@ namespace Renderer {
 
         // Frame render resources
         std::unique_ptr<Mesh> mesh;
+        std::unique_ptr<ClusterCuller> culler;
+        u32 mesh_lod = 0;
+        static constexpr f32 LOD_MAX_PIXEL_ERROR = 1.0f;
+        static constexpr f32 LOD_HYSTERESIS = 0.25f;
+        std::unique_ptr<TextureStreamer> streamer;
+        RHI::TextureHandle glock_albedo;
+        RHI::TextureHandle glock_normal;
+        std::unique_ptr<HotReload> hot_reload;
 
         std::vector<RHI::DescriptorSetHandle> descriptor_set_handles;
         RHI::GraphicsPipelineHandle gfx_pipe;
         RHI::BufferHandle ubo_handle;
+        UniformBufferObject ubo = {};
 
         RHI::TextureHandle frame_composition;
         RHI::TextureHandle frame_ds;
@@ -88,6 +116,7 @@ namespace Renderer {
         Core::SceneGraph scene;
         Core::Entity root;
         Core::Entity model;
+        static constexpr f32 PICK_MAX_DISTANCE = 1000.0f;
         Core::TransformComponent t;
     };
 
@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Core/Memory/StlAllocator.h>
+#include <Core/Types.h>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace Squid {
+namespace Renderer {
+
+    struct UniformBufferObject {
+        glm::mat4 model;
+        glm::mat4 view;
+        glm::mat4 proj;
+        glm::vec3 camera_pos;
+        float padding0;
+    };
+
+    static_assert(sizeof(UniformBufferObject) == 3 * 64 + 16, "");
+
+    // One visible instance of the renderer's mesh
+    struct RenderDraw {
+        glm::mat4 world;
+        u32 lod;
+    };
+
+    // Everything the render half of a frame reads, written by Module::Update on the simulation thread. Snapshots are
+    // reused frame after frame. Per frame lists live in frame memory and are made anew by every Update.
+    struct RenderSnapshot {
+        // Camera and model transform as uploaded to the shaders
+        UniformBufferObject ubo = {};
+        Core::FrameVector<RenderDraw> draws{Core::GetFrameAllocator()};
+        // Projected size the streamed textures are requested at, 0 while nothing using them is visible
+        f32 texture_coverage = 0.0f;
+
+        bool rebuild_swapchain = false;
+        bool resize_render_targets = false;
+        // Changed files for the texture streamer
+        std::vector<std::string> reloaded_assets;
+    };
+
+} // namespace Renderer
+} // namespace Squid
@@ -1,74 +1,185 @@
 #pragma once
 #include <RHI/Module.h>
+#include <Core/IO/AsyncIo.h>
+#include <Core/Log.h>
+#include <Core/Memory/MemoryTracker.h>
 #include <Core/Profiling.h>
+#include <array>
+#include <cassert>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
-#include <stb_image.h>
+#include "CookedTexture.h"
+#include "ImageDecode.h"
 
 namespace Squid {
 namespace Renderer {
     using namespace Squid::RHI;
 
+    struct TextureImport {
+        // One file per layer, six for a cube map
+        std::vector<std::string> files;
+        std::string name;
+        Format format = FORMAT_R8G8B8A8_UNORM_SRGB;
+        TextureHandle::Type type = TextureHandle::Type::TEXTURE_2D;
+        // Block compressed formats load this file, cooked from the files first when missing or stale
+        std::string cooked;
+        // RGBA8 chains are blitted on the GPU, RGBA32F keeps one mip since linear blits of it are optional
+        bool generate_mips = true;
+    };
+
     class TextureImporter {
     private:
         CommandList transfer_list;
         Device *device;
         std::vector<BufferHandle> staging_buffers;
 
+        static constexpr u64 STAGING_ALIGNMENT = 16;
+
     public:
         TextureImporter(Device *device, CommandList list) : device(device), transfer_list(list) {}
 
-        TextureHandle FromFile(
-            const std::string &file,
-            const std::string &name,
-            Format format = FORMAT_R8G8B8A8_UNORM_SRGB,
+        // Reads all files in one batch, decodes them on the job system into one shared staging buffer and records
+        // every copy into the importer's list
+        std::vector<TextureHandle> FromFiles(
+            const std::vector<TextureImport> &imports,
             TextureHandle::Usage usage = TextureHandle::Usage::SHADER_RESOURCE_VIEW) {
 
             PROFILING_SCOPE
+            Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_ASSETS);
+
+            // Cooked textures are already in upload layout, everything else is decoded from its sources
+            std::vector<CookedTextureHeader> headers(imports.size());
+            std::vector<std::string> paths;
+            for (size_t i = 0; i < imports.size(); i++) {
+                const TextureImport &import = imports[i];
+                if (GetFormatInfo(import.format).block_width == 1) {
+                    assert(import.format == FORMAT_R32G32B32A32_FLOAT || GetFormatInfo(import.format).block_size == 4);
+                    paths.insert(paths.end(), import.files.begin(), import.files.end());
+                    continue;
+                }
+
+                if (IsCookedTextureStale(import.cooked, import.files, import.format)) {
+                    PROFILING_NAMED_SCOPE("Cook texture")
+                    LOG_INFO("cooking {}", import.cooked)
+                    CookTexture(import.files, import.cooked, import.format, import.type);
+                }
+
+                headers[i] = ReadCookedTextureHeader(import.cooked);
+                if (headers[i].format != import.format) {
+                    throw std::runtime_error("cooked texture format mismatch!");
+                }
+            }
 
-            // Load imgage to local memory
-            i32 width, height, channels;
-            stbi_uc *pixels = stbi_load(file.c_str(), &width, &height, &channels, 4);
-
-            u64 image_size = width * height * 4;
+            std::vector<std::vector<u8>> files;
+            {
+                PROFILING_NAMED_SCOPE("Read textures")
+                files = Core::ReadFiles(paths);
+            }
 
-            if (!pixels) {
-                throw std::runtime_error("failed to load texture image!");
+            // Sizes come from the headers so every layer knows its staging offset before decoding
+            std::vector<TextureHandle> textures(imports.size());
+            std::vector<u64> offsets(imports.size());
+            std::vector<u64> layer_sizes(imports.size());
+            std::vector<ImageDecode> images;
+            u64 staging_size = 0;
+
+            for (size_t i = 0; i < imports.size(); i++) {
+                const TextureImport &import = imports[i];
+                TextureHandle &texture = textures[i];
+                offsets[i] = staging_size;
+
+                if (GetFormatInfo(import.format).block_width > 1) {
+                    texture.width = headers[i].width;
+                    texture.height = headers[i].height;
+                    texture.layers = headers[i].layers;
+                    texture.type = TextureHandle::Type(headers[i].type);
+                    texture.mip_levels = headers[i].mip_count;
+                    layer_sizes[i] = headers[i].layer_size;
+                } else {
+                    assert(!import.files.empty());
+                    const bool hdr = import.format == FORMAT_R32G32B32A32_FLOAT;
+
+                    for (u32 layer = 0; layer < import.files.size(); layer++) {
+                        ImageDecode image;
+                        image.file = &files[images.size()];
+                        image.hdr = hdr;
+                        ReadImageInfo(image);
+
+                        if (layer > 0 && (image.width != texture.width || image.height != texture.height)) {
+                            throw std::runtime_error("texture layers differ in size!");
+                        }
+
+                        texture.width = image.width;
+                        texture.height = image.height;
+                        layer_sizes[i] = image.GetDecodedSize();
+                        image.offset = offsets[i] + layer * layer_sizes[i];
+                        images.push_back(image);
+                    }
+
+                    texture.layers = u32(import.files.size());
+                    texture.type = import.type;
+                    texture.mip_levels =
+                        import.generate_mips && !hdr ? GetMipCount(texture.width, texture.height) : 1;
+                }
+
+                texture.depth = 1;
+                texture.format = import.format;
+                texture.sample_count = 1;
+                texture.usage_flags = usage;
+                texture.size = layer_sizes[i] * texture.layers;
+                staging_size += (texture.size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
             }
 
-            // Create a staging cpu accessible GPU buffer
             BufferHandle staging_texture;
             staging_texture.cpu_access = true;
-            staging_texture.size = image_size;
+            staging_texture.size = staging_size;
             staging_texture.usage = BufferHandle::Usage::TRANSFER_SRC;
             device->LoadBuffer(staging_texture);
             staging_buffers.push_back(staging_texture);
 
-            // Fill the staging buffer
-            void *texture_data = device->MapBuffer(staging_texture);
-            memcpy(texture_data, pixels, image_size);
+            u8 *staging_data = (u8 *)device->MapBuffer(staging_texture);
+            {
+                PROFILING_NAMED_SCOPE("Decode textures")
+                DecodeImages(images, staging_data);
+
+                for (size_t i = 0; i < imports.size(); i++) {
+                    if (GetFormatInfo(imports[i].format).block_width > 1)
+                        ReadCookedTextureData(imports[i].cooked, headers[i], staging_data + offsets[i]);
+                }
+            }
             device->UnmapBuffer(staging_texture);
 
-            // Free local image memory
-            stbi_image_free(pixels);
-
-            // Create device local texture
-            TextureHandle texture;
-            texture.height = height;
-            texture.width = width;
-            texture.depth = 1;
-            texture.size = image_size;
-            texture.format = format;
-            texture.mip_levels = 1;
-            texture.sample_count = 1;
-            texture.usage_flags = usage;
-            device->LoadTexture(texture);
-            device->SetName(texture, name);
-
-            // Issue the copy command
-            device->Copy(transfer_list, staging_texture, texture);
-
-            return std::move(texture);
+            for (size_t i = 0; i < imports.size(); i++) {
+                TextureHandle &texture = textures[i];
+                device->LoadTexture(texture);
+                device->SetName(texture, imports[i].name);
+
+                // Cooked textures carry their whole chain, decoded ones upload mip 0 and blit the rest
+                const bool cooked = GetFormatInfo(texture.format).block_width > 1;
+                const u32 mip_count = cooked ? texture.mip_levels : 1;
+                device->Copy(transfer_list, staging_texture, texture, layer_sizes[i], 0, mip_count, offsets[i]);
+                if (!cooked)
+                    device->GenerateMips(transfer_list, texture);
+            }
+
+            return textures;
+        }
+
+        TextureHandle FromFile(
+            const std::string &file,
+            const std::string &name,
+            Format format = FORMAT_R8G8B8A8_UNORM_SRGB,
+            TextureHandle::Usage usage = TextureHandle::Usage::SHADER_RESOURCE_VIEW,
+            bool generate_mips = true) {
+
+            TextureImport import;
+            import.files = {file};
+            import.name = name;
+            import.format = format;
+            import.generate_mips = generate_mips;
+            return FromFiles({import}, usage).front();
         };
 
         TextureHandle FromEnvFile(
@@ -77,76 +188,38 @@ namespace Renderer {
             Format format = FORMAT_R32G32B32A32_FLOAT,
             TextureHandle::Usage usage = TextureHandle::Usage::SHADER_RESOURCE_VIEW) {
 
-            PROFILING_SCOPE
-
-            // SPEED: task group
-            // Load imgage to local memory
-            i32 hdr_width, hdr_height, hdr_channels;
-
-            f32 *face_data_pos_x = stbi_loadf(files[0].c_str(), &hdr_width, &hdr_height, &hdr_channels, 4);
-            f32 *face_data_neg_x = stbi_loadf(files[1].c_str(), &hdr_width, &hdr_height, &hdr_channels, 4);
-            f32 *face_data_pos_y = stbi_loadf(files[2].c_str(), &hdr_width, &hdr_height, &hdr_channels, 4);
-            f32 *face_data_neg_y = stbi_loadf(files[3].c_str(), &hdr_width, &hdr_height, &hdr_channels, 4);
-            f32 *face_data_pos_z = stbi_loadf(files[4].c_str(), &hdr_width, &hdr_height, &hdr_channels, 4);
-            f32 *face_data_neg_z = stbi_loadf(files[5].c_str(), &hdr_width, &hdr_height, &hdr_channels, 4);
-
-            u64 image_size = (hdr_width * hdr_height * 4);
-            u64 image_data_size = image_size * sizeof(float);
-
-            if (!face_data_pos_x[0] || !face_data_neg_x[0]) {
-                throw std::runtime_error("failed to load hdr texture image!");
-            }
-
-            // Create a staging cpu accessible GPU buffer
-            BufferHandle staging_texture;
-            staging_texture.cpu_access = true;
-            staging_texture.size = image_data_size * 6;
-            staging_texture.usage = BufferHandle::Usage::TRANSFER_SRC;
-            device->LoadBuffer(staging_texture);
-            staging_buffers.push_back(staging_texture);
+            TextureImport import;
+            import.files = {files.begin(), files.end()};
+            import.name = name;
+            import.format = format;
+            import.type = TextureHandle::Type::TEXTURE_CUBE;
+            return FromFiles({import}, usage).front();
+        };
 
-            // Fill the staging buffer
-            f32 *texture_hdr_data = (f32 *)device->MapBuffer(staging_texture);
-            memcpy(&texture_hdr_data[image_size * 0], face_data_pos_x, image_data_size);
-            memcpy(&texture_hdr_data[image_size * 1], face_data_neg_x, image_data_size);
-            memcpy(&texture_hdr_data[image_size * 2], face_data_pos_y, image_data_size);
-            memcpy(&texture_hdr_data[image_size * 3], face_data_neg_y, image_data_size);
-            memcpy(&texture_hdr_data[image_size * 4], face_data_pos_z, image_data_size);
-            memcpy(&texture_hdr_data[image_size * 5], face_data_neg_z, image_data_size);
-            device->UnmapBuffer(staging_texture);
+        // Loads the cooked block compressed version of the sources, cooking it first when missing or stale
+        TextureHandle FromCookedFile(
+            const std::vector<std::string> &sources,
+            const std::string &cooked,
+            const std::string &name,
+            Format format = FORMAT_BC7_UNORM_SRGB,
+            TextureHandle::Type type = TextureHandle::Type::TEXTURE_2D,
+            TextureHandle::Usage usage = TextureHandle::Usage::SHADER_RESOURCE_VIEW) {
 
-            // Free local image memory
-            stbi_image_free(face_data_pos_x);
-            stbi_image_free(face_data_neg_x);
-            stbi_image_free(face_data_pos_y);
-            stbi_image_free(face_data_neg_y);
-            stbi_image_free(face_data_pos_z);
-            stbi_image_free(face_data_neg_z);
-
-            // Create device local texture
-            TextureHandle texture;
-            texture.height = hdr_height;
-            texture.width = hdr_width;
-            texture.layers = 6;
-            texture.type = TextureHandle::Type::TEXTURE_CUBE;
-            texture.format = format; // 128bit alias 16byte format
-            texture.mip_levels = 1;
-            texture.layout = ImageLayout::TRANSFER_DST;
-            texture.sample_count = 1;
-            texture.usage_flags = usage;
-            device->LoadTexture(texture);
-            device->SetName(texture, name);
-
-            // Issue the copy command
-            device->Copy(transfer_list, staging_texture, texture, image_data_size);
-
-            return std::move(texture);
+            TextureImport import;
+            import.files = sources;
+            import.name = name;
+            import.format = format;
+            import.type = type;
+            import.cooked = cooked;
+            return FromFiles({import}, usage).front();
         };
 
         void Upload() {
             PROFILING_SCOPE
+            Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_ASSETS);
 
             device->QueueSubmit(QueueType::GRAPHICS, transfer_list);
+            device->Wait(transfer_list);
             for (const auto &buffer : staging_buffers) {
                 device->UnloadBuffer(buffer);
             }
@@ -154,4 +227,4 @@ namespace Renderer {
     };
 
 } // namespace Renderer
-} // namespace Squid
\ No newline at end of file
+} // namespace Squid
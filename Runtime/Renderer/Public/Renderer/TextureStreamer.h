@@ -0,0 +1,70 @@
+#pragma once
+#include <future>
+#include <string>
+#include <vector>
+#include <RHI/Module.h>
+
+#include "MipChain.h"
+
+namespace Squid {
+namespace Renderer {
+    using namespace Squid::RHI;
+
+    // Streams textures in from the smallest mip up. A texture is usable right after Stream() with a 1x1
+    // placeholder, the file is decoded and mipped in the background and higher mips are uploaded one per Tick.
+    class TextureStreamer {
+    public:
+        TextureStreamer(Device *device) : device(device) {}
+        ~TextureStreamer();
+
+        // Placeholder copy is recorded into list, which the caller submits. Its staging buffer is unloaded by a
+        // later Tick once the list is complete.
+        // Block compressed formats are read from the cooked file next to the source.
+        TextureHandle Stream(
+            const CommandList &list,
+            const std::string &file,
+            const std::string &name,
+            Format format = FORMAT_R8G8B8A8_UNORM_SRGB,
+            u32 placeholder = 0xff808080);
+
+        // Screen coverage in pixels along the larger axis, selects the finest mip worth having resident
+        void RequestCoverage(const TextureHandle &texture, f32 pixels);
+
+        // Decodes the file again and uploads it over the streamed textures made from it, returns false when
+        // nothing was streamed from it. The size has to stay the same, descriptor sets keep the old handle.
+        bool Reload(const std::string &file);
+
+        void Tick();
+
+        // Mips uploaded together with the first upload after decoding
+        static constexpr u32 TAIL_SIZE = 64;
+
+    private:
+        struct StreamedTexture {
+            TextureHandle handle;
+            std::string file;
+            std::future<MipChain> decode;
+            MipChain chain;
+
+            bool decoded = false;
+            u32 resident_mip;
+            u32 wanted_mip = 0;
+        };
+
+        // Staging buffer of a copy, unloaded once the list recording it has finished on the GPU
+        struct PendingStaging {
+            BufferHandle buffer;
+            CommandList list;
+        };
+
+        static std::future<MipChain> Decode(const std::string &file, Format format);
+        void UploadMips(StreamedTexture &texture, u32 base_mip, u32 mip_count);
+
+        Device *device;
+        std::vector<StreamedTexture> textures;
+        std::vector<PendingStaging> pending_staging;
+        CommandList upload_list;
+    };
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,528 @@
+#include <Renderer/BlockCompression.h>
+#include <Core/Jobs/JobSystem.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <half.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#define SQUID_BC_SSE
+#endif
+
+namespace Squid {
+namespace Renderer {
+
+    // Interpolation weights of the 4 bit index formats (BC6H, BC7)
+    static constexpr i32 bc_weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // LSB first bit packing used by every BC format
+    struct BlockWriter {
+        u8 *block;
+        u32 position = 0;
+
+        void Write(u32 value, u32 bits) {
+            for (u32 i = 0; i < bits; i++, position++) {
+                if ((value >> i) & 1)
+                    block[position >> 3] |= u8(1 << (position & 7));
+            }
+        }
+    };
+
+    // Candidate colors of a block stored as SoA so four entries are compared at once
+    struct BlockPalette {
+        alignas(16) f32 channels[4][16] = {};
+        u32 count = 0;
+
+        inline void Set(u32 entry, const f32 color[4]) {
+            for (u32 c = 0; c < 4; c++)
+                channels[c][entry] = color[c];
+        }
+    };
+
+    static u32 FindClosestEntry(const BlockPalette &palette, const f32 pixel[4]) {
+        alignas(16) f32 errors[16];
+
+#ifdef SQUID_BC_SSE
+        const __m128 r = _mm_set1_ps(pixel[0]);
+        const __m128 g = _mm_set1_ps(pixel[1]);
+        const __m128 b = _mm_set1_ps(pixel[2]);
+        const __m128 a = _mm_set1_ps(pixel[3]);
+
+        for (u32 i = 0; i < palette.count; i += 4) {
+            __m128 dr = _mm_sub_ps(_mm_load_ps(&palette.channels[0][i]), r);
+            __m128 dg = _mm_sub_ps(_mm_load_ps(&palette.channels[1][i]), g);
+            __m128 db = _mm_sub_ps(_mm_load_ps(&palette.channels[2][i]), b);
+            __m128 da = _mm_sub_ps(_mm_load_ps(&palette.channels[3][i]), a);
+
+            __m128 error = _mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg));
+            error = _mm_add_ps(error, _mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(da, da)));
+            _mm_store_ps(&errors[i], error);
+        }
+#else
+        for (u32 i = 0; i < palette.count; i++) {
+            errors[i] = 0.0f;
+            for (u32 c = 0; c < 4; c++) {
+                f32 d = palette.channels[c][i] - pixel[c];
+                errors[i] += d * d;
+            }
+        }
+#endif
+
+        u32 best = 0;
+        for (u32 i = 1; i < palette.count; i++) {
+            if (errors[i] < errors[best])
+                best = i;
+        }
+        return best;
+    }
+
+    // Endpoints along the principal axis of the block, channels past channel_count are ignored
+    static void FindBlockEndpoints(const f32 pixels[16][4], u32 channel_count, f32 e0[4], f32 e1[4]) {
+        f32 mean[4] = {};
+        f32 lo[4] = {FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX};
+        f32 hi[4] = {-FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+        for (u32 i = 0; i < 16; i++) {
+            for (u32 c = 0; c < channel_count; c++) {
+                mean[c] += pixels[i][c] / 16.0f;
+                lo[c] = std::min(lo[c], pixels[i][c]);
+                hi[c] = std::max(hi[c], pixels[i][c]);
+            }
+        }
+
+        f32 covariance[4][4] = {};
+        for (u32 i = 0; i < 16; i++) {
+            for (u32 x = 0; x < channel_count; x++) {
+                for (u32 y = 0; y < channel_count; y++) {
+                    covariance[x][y] += (pixels[i][x] - mean[x]) * (pixels[i][y] - mean[y]);
+                }
+            }
+        }
+
+        // Power iteration seeded with the covariance row of the channel with the largest variance
+        u32 widest = 0;
+        for (u32 c = 1; c < channel_count; c++) {
+            if (covariance[c][c] > covariance[widest][widest])
+                widest = c;
+        }
+
+        f32 axis[4] = {};
+        f32 length = 0.0f;
+        for (u32 c = 0; c < channel_count; c++) {
+            axis[c] = covariance[widest][c];
+            length += axis[c] * axis[c];
+        }
+
+        for (u32 iteration = 0; iteration < 8 && length > 0.0f; iteration++) {
+            f32 next[4] = {};
+            for (u32 x = 0; x < channel_count; x++) {
+                for (u32 y = 0; y < channel_count; y++) {
+                    next[x] += covariance[x][y] * axis[y];
+                }
+            }
+
+            f32 next_length = 0.0f;
+            for (u32 c = 0; c < channel_count; c++)
+                next_length += next[c] * next[c];
+
+            if (next_length <= FLT_EPSILON)
+                break;
+
+            next_length = std::sqrt(next_length);
+            for (u32 c = 0; c < channel_count; c++)
+                axis[c] = next[c] / next_length;
+            length = 1.0f;
+        }
+
+        f32 t_min = 0.0f;
+        f32 t_max = 0.0f;
+
+        if (length > 0.0f) {
+            f32 norm = 0.0f;
+            for (u32 c = 0; c < channel_count; c++)
+                norm += axis[c] * axis[c];
+            norm = std::sqrt(norm);
+            for (u32 c = 0; c < channel_count; c++)
+                axis[c] /= norm;
+
+            t_min = FLT_MAX;
+            t_max = -FLT_MAX;
+            for (u32 i = 0; i < 16; i++) {
+                f32 t = 0.0f;
+                for (u32 c = 0; c < channel_count; c++)
+                    t += (pixels[i][c] - mean[c]) * axis[c];
+                t_min = std::min(t_min, t);
+                t_max = std::max(t_max, t);
+            }
+        }
+
+        for (u32 c = 0; c < 4; c++) {
+            e0[c] = c < channel_count ? std::clamp(mean[c] + axis[c] * t_min, lo[c], hi[c]) : 0.0f;
+            e1[c] = c < channel_count ? std::clamp(mean[c] + axis[c] * t_max, lo[c], hi[c]) : 0.0f;
+        }
+    }
+
+    // == BC1 / BC3 color =======================================================
+
+    static u16 PackRGB565(const f32 color[4]) {
+        u32 r = u32(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+        u32 g = u32(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+        u32 b = u32(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+        return u16((r << 11) | (g << 5) | b);
+    }
+
+    static void UnpackRGB565(u16 packed, f32 color[4]) {
+        u32 r = (packed >> 11) & 31;
+        u32 g = (packed >> 5) & 63;
+        u32 b = packed & 31;
+        color[0] = f32((r << 3) | (r >> 2));
+        color[1] = f32((g << 2) | (g >> 4));
+        color[2] = f32((b << 3) | (b >> 2));
+        color[3] = 0.0f;
+    }
+
+    // Always 4 color mode, so it is valid for both BC1 and BC3
+    static void EncodeColorBlock(const u8 pixels[16 * 4], u8 *block) {
+        f32 colors[16][4];
+        for (u32 i = 0; i < 16; i++) {
+            colors[i][0] = pixels[i * 4 + 0];
+            colors[i][1] = pixels[i * 4 + 1];
+            colors[i][2] = pixels[i * 4 + 2];
+            colors[i][3] = 0.0f;
+        }
+
+        f32 e0[4], e1[4];
+        FindBlockEndpoints(colors, 3, e0, e1);
+
+        u16 c0 = PackRGB565(e1);
+        u16 c1 = PackRGB565(e0);
+        if (c0 < c1)
+            std::swap(c0, c1);
+
+        memset(block, 0, 8);
+        block[0] = u8(c0);
+        block[1] = u8(c0 >> 8);
+        block[2] = u8(c1);
+        block[3] = u8(c1 >> 8);
+
+        if (c0 == c1)
+            return;
+
+        f32 p0[4], p1[4], p2[4], p3[4];
+        UnpackRGB565(c0, p0);
+        UnpackRGB565(c1, p1);
+        for (u32 c = 0; c < 4; c++) {
+            p2[c] = (2.0f * p0[c] + p1[c]) / 3.0f;
+            p3[c] = (p0[c] + 2.0f * p1[c]) / 3.0f;
+        }
+
+        BlockPalette palette;
+        palette.count = 4;
+        palette.Set(0, p0);
+        palette.Set(1, p1);
+        palette.Set(2, p2);
+        palette.Set(3, p3);
+
+        BlockWriter writer = {block, 32};
+        for (u32 i = 0; i < 16; i++) {
+            writer.Write(FindClosestEntry(palette, colors[i]), 2);
+        }
+    }
+
+    void EncodeBC1Block(const u8 pixels[16 * 4], u8 *block) { EncodeColorBlock(pixels, block); }
+
+    // == BC4 / BC5 =============================================================
+
+    void EncodeBC4Block(const u8 pixels[16 * 4], u8 *block, u32 channel) {
+        u8 lo = 255;
+        u8 hi = 0;
+        for (u32 i = 0; i < 16; i++) {
+            lo = std::min(lo, pixels[i * 4 + channel]);
+            hi = std::max(hi, pixels[i * 4 + channel]);
+        }
+
+        memset(block, 0, 8);
+        block[0] = hi;
+        block[1] = lo;
+
+        // Equal endpoints select the 6 value mode, index 0 still decodes to the value
+        if (hi == lo)
+            return;
+
+        BlockPalette palette;
+        palette.count = 8;
+        for (u32 i = 0; i < 8; i++) {
+            f32 value = i == 0 ? hi : i == 1 ? lo : ((8.0f - i) * hi + (i - 1.0f) * lo) / 7.0f;
+            f32 entry[4] = {value, 0.0f, 0.0f, 0.0f};
+            palette.Set(i, entry);
+        }
+
+        BlockWriter writer = {block, 16};
+        for (u32 i = 0; i < 16; i++) {
+            f32 pixel[4] = {f32(pixels[i * 4 + channel]), 0.0f, 0.0f, 0.0f};
+            writer.Write(FindClosestEntry(palette, pixel), 3);
+        }
+    }
+
+    void EncodeBC3Block(const u8 pixels[16 * 4], u8 *block) {
+        EncodeBC4Block(pixels, block, 3);
+        EncodeColorBlock(pixels, block + 8);
+    }
+
+    void EncodeBC5Block(const u8 pixels[16 * 4], u8 *block) {
+        EncodeBC4Block(pixels, block, 0);
+        EncodeBC4Block(pixels, block + 8, 1);
+    }
+
+    // == BC7 ===================================================================
+
+    // Mode 6: single subset RGBA, 7 bit endpoints with a p-bit each and 4 bit indices
+    void EncodeBC7Block(const u8 pixels[16 * 4], u8 *block) {
+        f32 colors[16][4];
+        for (u32 i = 0; i < 16; i++) {
+            for (u32 c = 0; c < 4; c++)
+                colors[i][c] = pixels[i * 4 + c];
+        }
+
+        f32 endpoints[2][4];
+        FindBlockEndpoints(colors, 4, endpoints[0], endpoints[1]);
+
+        // Quantize each endpoint to 7 bits and pick the p-bit with the lower error
+        u32 quantized[2][4];
+        u32 pbits[2];
+        for (u32 e = 0; e < 2; e++) {
+            f32 best_error = FLT_MAX;
+            for (u32 p = 0; p < 2; p++) {
+                u32 q[4];
+                f32 error = 0.0f;
+                for (u32 c = 0; c < 4; c++) {
+                    q[c] = u32(std::clamp((endpoints[e][c] - p) * 0.5f + 0.5f, 0.0f, 127.0f));
+                    f32 d = f32((q[c] << 1) | p) - endpoints[e][c];
+                    error += d * d;
+                }
+
+                if (error < best_error) {
+                    best_error = error;
+                    pbits[e] = p;
+                    memcpy(quantized[e], q, sizeof(q));
+                }
+            }
+        }
+
+        i32 expanded[2][4];
+        for (u32 e = 0; e < 2; e++) {
+            for (u32 c = 0; c < 4; c++)
+                expanded[e][c] = i32((quantized[e][c] << 1) | pbits[e]);
+        }
+
+        BlockPalette palette;
+        palette.count = 16;
+        for (u32 i = 0; i < 16; i++) {
+            f32 entry[4];
+            for (u32 c = 0; c < 4; c++) {
+                entry[c] = f32(((64 - bc_weights4[i]) * expanded[0][c] + bc_weights4[i] * expanded[1][c] + 32) >> 6);
+            }
+            palette.Set(i, entry);
+        }
+
+        u32 indices[16];
+        for (u32 i = 0; i < 16; i++) {
+            indices[i] = FindClosestEntry(palette, colors[i]);
+        }
+
+        // Anchor index has an implicit zero msb, the weights are symmetric so swapping is lossless
+        if (indices[0] & 8) {
+            std::swap(quantized[0], quantized[1]);
+            std::swap(pbits[0], pbits[1]);
+            for (u32 i = 0; i < 16; i++)
+                indices[i] = 15 - indices[i];
+        }
+
+        memset(block, 0, 16);
+        BlockWriter writer = {block};
+        writer.Write(1 << 6, 7);
+        for (u32 c = 0; c < 4; c++) {
+            writer.Write(quantized[0][c], 7);
+            writer.Write(quantized[1][c], 7);
+        }
+        writer.Write(pbits[0], 1);
+        writer.Write(pbits[1], 1);
+        writer.Write(indices[0], 3);
+        for (u32 i = 1; i < 16; i++)
+            writer.Write(indices[i], 4);
+    }
+
+    // == BC6H ==================================================================
+
+    static i32 UnquantizeBC6H(i32 value) {
+        if (value == 0)
+            return 0;
+        if (value == 1023)
+            return 0xFFFF;
+        return ((value << 16) + 0x8000) >> 10;
+    }
+
+    // Decoded half bits of an interpolated, unquantized value
+    static i32 FinishBC6H(i32 value) { return (value * 31) >> 6; }
+
+    static u32 QuantizeBC6H(f32 half_bits) {
+        i32 guess = i32(half_bits / 31.0f);
+        i32 best = 0;
+        f32 best_error = FLT_MAX;
+
+        for (i32 q = std::max(guess - 1, 0); q <= std::min(guess + 1, 1023); q++) {
+            f32 error = std::abs(f32(FinishBC6H(UnquantizeBC6H(q))) - half_bits);
+            if (error < best_error) {
+                best_error = error;
+                best = q;
+            }
+        }
+        return u32(best);
+    }
+
+    // Mode 11: single region, 10 bit endpoints without transform and 4 bit indices.
+    // Endpoints are fitted on the half float bit patterns, which behave close to log space.
+    void EncodeBC6HBlock(const f32 pixels[16 * 4], u8 *block) {
+        f32 colors[16][4];
+        for (u32 i = 0; i < 16; i++) {
+            for (u32 c = 0; c < 3; c++) {
+                half_float::half value(std::clamp(pixels[i * 4 + c], 0.0f, 65504.0f));
+                u16 bits;
+                memcpy(&bits, &value, sizeof(bits));
+                colors[i][c] = f32(bits);
+            }
+            colors[i][3] = 0.0f;
+        }
+
+        f32 endpoints[2][4];
+        FindBlockEndpoints(colors, 3, endpoints[0], endpoints[1]);
+
+        u32 quantized[2][3];
+        i32 unquantized[2][3];
+        for (u32 e = 0; e < 2; e++) {
+            for (u32 c = 0; c < 3; c++) {
+                quantized[e][c] = QuantizeBC6H(endpoints[e][c]);
+                unquantized[e][c] = UnquantizeBC6H(i32(quantized[e][c]));
+            }
+        }
+
+        BlockPalette palette;
+        palette.count = 16;
+        for (u32 i = 0; i < 16; i++) {
+            f32 entry[4] = {};
+            for (u32 c = 0; c < 3; c++) {
+                i32 value = ((64 - bc_weights4[i]) * unquantized[0][c] + bc_weights4[i] * unquantized[1][c] + 32) >> 6;
+                entry[c] = f32(FinishBC6H(value));
+            }
+            palette.Set(i, entry);
+        }
+
+        u32 indices[16];
+        for (u32 i = 0; i < 16; i++) {
+            indices[i] = FindClosestEntry(palette, colors[i]);
+        }
+
+        if (indices[0] & 8) {
+            std::swap(quantized[0], quantized[1]);
+            for (u32 i = 0; i < 16; i++)
+                indices[i] = 15 - indices[i];
+        }
+
+        memset(block, 0, 16);
+        BlockWriter writer = {block};
+        writer.Write(0x03, 5);
+        for (u32 e = 0; e < 2; e++) {
+            for (u32 c = 0; c < 3; c++)
+                writer.Write(quantized[e][c], 10);
+        }
+        writer.Write(indices[0], 3);
+        for (u32 i = 1; i < 16; i++)
+            writer.Write(indices[i], 4);
+    }
+
+    // == Surfaces ==============================================================
+
+    // Blocks per job when a surface is split across the job system
+    static constexpr u32 SURFACE_GRAIN_BLOCKS = 256;
+
+    std::vector<u8> CompressSurface(const void *pixels, u32 width, u32 height, RHI::Format format) {
+        const RHI::FormatInfo info = RHI::GetFormatInfo(format);
+        if (info.block_width != 4) {
+            throw std::runtime_error("format is not block compressed!");
+        }
+
+        const bool is_float = format == RHI::FORMAT_BC6H_UF16;
+        void (*encode)(const u8 *, u8 *) = nullptr;
+
+        switch (format) {
+        case RHI::FORMAT_BC1_UNORM:
+        case RHI::FORMAT_BC1_UNORM_SRGB:
+            encode = [](const u8 *pixels, u8 *block) { EncodeBC1Block(pixels, block); };
+            break;
+        case RHI::FORMAT_BC3_UNORM:
+        case RHI::FORMAT_BC3_UNORM_SRGB:
+            encode = [](const u8 *pixels, u8 *block) { EncodeBC3Block(pixels, block); };
+            break;
+        case RHI::FORMAT_BC4_UNORM:
+            encode = [](const u8 *pixels, u8 *block) { EncodeBC4Block(pixels, block); };
+            break;
+        case RHI::FORMAT_BC5_UNORM:
+            encode = [](const u8 *pixels, u8 *block) { EncodeBC5Block(pixels, block); };
+            break;
+        case RHI::FORMAT_BC7_UNORM:
+        case RHI::FORMAT_BC7_UNORM_SRGB:
+            encode = [](const u8 *pixels, u8 *block) { EncodeBC7Block(pixels, block); };
+            break;
+        case RHI::FORMAT_BC6H_UF16:
+            break;
+        default:
+            throw std::runtime_error("unsupported block compression format!");
+        }
+
+        const u32 blocks_x = (width + 3) / 4;
+        const u32 blocks_y = (height + 3) / 4;
+        std::vector<u8> blocks(u64(blocks_x) * blocks_y * info.block_size);
+
+        // Rows of blocks are independent, small mips stay on the calling thread
+        const u32 grain = std::max(1u, SURFACE_GRAIN_BLOCKS / blocks_x);
+
+        Core::ParallelFor(
+            blocks_y,
+            grain,
+            [&](u32 begin, u32 end) {
+                for (u32 by = begin; by < end; by++) {
+                    for (u32 bx = 0; bx < blocks_x; bx++) {
+                        u8 *block = blocks.data() + (u64(by) * blocks_x + bx) * info.block_size;
+
+                        if (is_float) {
+                            f32 texels[16 * 4];
+                            for (u32 i = 0; i < 16; i++) {
+                                u32 x = std::min(bx * 4 + (i & 3), width - 1);
+                                u32 y = std::min(by * 4 + (i >> 2), height - 1);
+                                memcpy(&texels[i * 4], (const f32 *)pixels + (u64(y) * width + x) * 4, sizeof(f32) * 4);
+                            }
+                            EncodeBC6HBlock(texels, block);
+                        } else {
+                            u8 texels[16 * 4];
+                            for (u32 i = 0; i < 16; i++) {
+                                u32 x = std::min(bx * 4 + (i & 3), width - 1);
+                                u32 y = std::min(by * 4 + (i >> 2), height - 1);
+                                memcpy(&texels[i * 4], (const u8 *)pixels + (u64(y) * width + x) * 4, 4);
+                            }
+                            encode(texels, block);
+                        }
+                    }
+                }
+            },
+            "Compress Blocks");
+
+        return blocks;
+    }
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,192 @@
+#include <Renderer/ClusterCuller.h>
+#include <Core/IO/VirtualFileSystem.h>
+#include <Core/Log.h>
+#include <Core/Math/SimdMath.h>
+#include <Core/Profiling.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Squid {
+namespace Renderer {
+
+    ClusterCullConstants MakeClusterCullConstants(
+        const glm::mat4 &model, const glm::mat4 &view_projection, const glm::vec3 &camera, const CookedLod &lod) {
+
+        ClusterCullConstants constants = {};
+        constants.meshlet_offset = lod.meshlet_offset;
+        constants.meshlet_count = lod.meshlet_count;
+
+        // Planes pulled back into object space
+        Core::ExtractFrustumPlanes(view_projection * model, constants.planes);
+
+        constants.camera_position = glm::inverse(model) * glm::vec4(camera, 1.0f);
+        return constants;
+    }
+
+    u32 CullClusters(
+        const CookedMeshlet *meshlets, const ClusterCullConstants &constants, RHI::DrawIndexedIndirectCommand *draws) {
+
+        static constexpr u32 BATCH = 64;
+
+        const glm::vec3 camera = glm::vec3(constants.camera_position);
+        u32 visible_count = 0;
+
+        // Spheres are tested a batch at a time from streams, the cone test only runs on the survivors
+        f32 streams[4][BATCH];
+        u8 inside[BATCH];
+        const Core::SphereStreams spheres = {{streams[0], streams[1], streams[2]}, streams[3]};
+
+        for (u32 first = 0; first < constants.meshlet_count; first += BATCH) {
+            const u32 count = std::min(BATCH, constants.meshlet_count - first);
+            const CookedMeshlet *batch = meshlets + constants.meshlet_offset + first;
+
+            for (u32 i = 0; i < count; i++) {
+                streams[0][i] = batch[i].center[0];
+                streams[1][i] = batch[i].center[1];
+                streams[2][i] = batch[i].center[2];
+                streams[3][i] = batch[i].radius;
+            }
+
+            Core::TestSpheresFrustum(constants.planes, spheres, inside, count);
+
+            for (u32 i = 0; i < count; i++) {
+                const CookedMeshlet &meshlet = batch[i];
+                const glm::vec3 center(meshlet.center[0], meshlet.center[1], meshlet.center[2]);
+                const glm::vec3 axis(meshlet.cone_axis[0], meshlet.cone_axis[1], meshlet.cone_axis[2]);
+
+                const glm::vec3 view = center - camera;
+                const bool visible = inside[i] &&
+                                     glm::dot(view, axis) < meshlet.cone_cutoff * glm::length(view) + meshlet.radius;
+
+                RHI::DrawIndexedIndirectCommand &draw = draws[first + i];
+                draw.index_count = meshlet.index_count;
+                draw.instance_count = visible ? 1 : 0;
+                draw.first_index = meshlet.index_offset;
+                draw.vertex_offset = 0;
+                draw.first_instance = 0;
+
+                visible_count += visible ? 1 : 0;
+            }
+        }
+
+        return visible_count;
+    }
+
+    ClusterCuller::ClusterCuller(RHI::Device *device, const Mesh &mesh, const std::string &shader)
+        : device(device), mesh(mesh) {
+        using RHI::BufferHandle;
+
+        compute = Core::GetFileSystem().Exists(shader);
+        if (!compute) {
+            LOG_WARN("cluster cull shader {} is missing, culling on the CPU", shader)
+        }
+
+        // LOD 0 has the most meshlets
+        const u32 meshlet_count = mesh.GetLods()[0].meshlet_count;
+
+        for (FrameBuffers &buffers : frames) {
+            // Written by the compute pass or mapped by the CPU fallback
+            buffers.draw_buffer.cpu_access = !compute;
+            buffers.draw_buffer.size = std::max<u64>(meshlet_count, 1) * sizeof(RHI::DrawIndexedIndirectCommand);
+            buffers.draw_buffer.usage = (BufferHandle::Usage)(BufferHandle::Usage::STORAGE_BUFFER |
+                                                              BufferHandle::Usage::INDIRECT_BUFFER);
+            device->LoadBuffer(buffers.draw_buffer);
+            device->SetName(buffers.draw_buffer, "Cluster Draws");
+        }
+
+        if (!compute)
+            return;
+
+        RHI::Descriptor constants_descriptor;
+        constants_descriptor.type = RHI::Descriptor::Type::Uniform;
+        constants_descriptor.shader_stage = RHI::SHADER_STAGE_COMPUTE_STAGE;
+        constants_descriptor.count = 1;
+        constants_descriptor.binding = 0;
+
+        RHI::Descriptor clusters_descriptor;
+        clusters_descriptor.type = RHI::Descriptor::Type::Storage;
+        clusters_descriptor.shader_stage = RHI::SHADER_STAGE_COMPUTE_STAGE;
+        clusters_descriptor.count = 1;
+        clusters_descriptor.binding = 1;
+
+        RHI::Descriptor draws_descriptor;
+        draws_descriptor.type = RHI::Descriptor::Type::Storage;
+        draws_descriptor.shader_stage = RHI::SHADER_STAGE_COMPUTE_STAGE;
+        draws_descriptor.count = 1;
+        draws_descriptor.binding = 2;
+
+        for (FrameBuffers &buffers : frames) {
+            buffers.constants_buffer.cpu_access = true;
+            buffers.constants_buffer.size = sizeof(ClusterCullConstants);
+            buffers.constants_buffer.usage = BufferHandle::Usage::UNIFORM_BUFFER;
+            device->LoadBuffer(buffers.constants_buffer);
+            device->SetName(buffers.constants_buffer, "Cluster Cull UBO");
+
+            buffers.descriptor_set.descriptors = {constants_descriptor, clusters_descriptor, draws_descriptor};
+            device->LoadDescriptorSet(buffers.descriptor_set);
+
+            device->BindBuffer(buffers.descriptor_set, 0, buffers.constants_buffer);
+            device->BindBuffer(buffers.descriptor_set, 1, mesh.GetClusterBuffer());
+            device->BindBuffer(buffers.descriptor_set, 2, buffers.draw_buffer);
+        }
+
+        // The sets share one layout
+        pipeline.descriptor_sets = {frames[0].descriptor_set};
+        pipeline.compute_shader = Core::GetFileSystem().ReadTextFile(shader);
+        device->LoadPipeline(pipeline);
+    }
+
+    ClusterCuller::~ClusterCuller() {
+        if (compute)
+            device->UnloadPipeline(pipeline);
+
+        for (FrameBuffers &buffers : frames) {
+            if (compute) {
+                device->UnloadDescriptorSet(buffers.descriptor_set);
+                device->UnloadBuffer(buffers.constants_buffer);
+            }
+            device->UnloadBuffer(buffers.draw_buffer);
+        }
+    }
+
+    void ClusterCuller::Cull(
+        const RHI::CommandList &list,
+        u32 lod,
+        const glm::mat4 &model,
+        const glm::mat4 &view_projection,
+        const glm::vec3 &camera) {
+
+        PROFILING_SCOPE
+
+        // The frame that used this slot last has left the GPU, BeginFrameEXP waited for its fence
+        frame = Core::GetFrameAllocator().GetFrameIndex();
+        FrameBuffers &buffers = frames[frame];
+
+        this->lod = std::min(lod, u32(mesh.GetLods().size()) - 1);
+        const ClusterCullConstants constants =
+            MakeClusterCullConstants(model, view_projection, camera, mesh.GetLods()[this->lod]);
+
+        if (!compute) {
+            auto *draws = (RHI::DrawIndexedIndirectCommand *)device->MapBuffer(buffers.draw_buffer);
+            visible_count = CullClusters(mesh.GetMeshlets().data(), constants, draws);
+            device->UnmapBuffer(buffers.draw_buffer);
+            return;
+        }
+
+        void *constants_data = device->MapBuffer(buffers.constants_buffer);
+        memcpy(constants_data, &constants, sizeof(constants));
+        device->UnmapBuffer(buffers.constants_buffer);
+
+        device->BindPipelineState(list, pipeline);
+        device->BindDescriptorSet(list, pipeline, buffers.descriptor_set, 0);
+        device->Dispatch(list, (constants.meshlet_count + THREAD_GROUP_SIZE - 1) / THREAD_GROUP_SIZE, 1, 1);
+        device->Barrier(list, buffers.draw_buffer);
+    }
+
+    void ClusterCuller::Draw(const RHI::CommandList &list) {
+        device->DrawIndexedIndirect(list, frames[frame].draw_buffer, 0, mesh.GetLods()[lod].meshlet_count);
+    }
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,392 @@
+#include <Renderer/CookedMesh.h>
+#include <Renderer/Mesh.h>
+#include <Renderer/MeshOptimizer.h>
+#include <Core/IO/VirtualFileSystem.h>
+#include <Core/Log.h>
+#include <Core/Murmur.h>
+
+#include <tiny_obj_loader.h>
+#include <half.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace Squid {
+namespace Renderer {
+
+    static i8 PackSnorm8(f32 value) { return i8(roundf(std::clamp(value, -1.0f, 1.0f) * 127.0f)); }
+
+    static u8 PackUnorm8(f32 value) { return u8(roundf(std::clamp(value, 0.0f, 1.0f) * 255.0f)); }
+
+    static u16 PackHalf(f32 value) {
+        half_float::half packed(std::clamp(value, -65504.0f, 65504.0f));
+        u16 bits;
+        memcpy(&bits, &packed, sizeof(bits));
+        return bits;
+    }
+
+    static MeshBounds ComputeBounds(const std::vector<MeshVertex> &vertices, const u32 *indices, u32 index_count) {
+        MeshBounds bounds;
+        if (index_count == 0)
+            return bounds;
+
+        glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+        for (u32 i = 0; i < index_count; i++) {
+            min = glm::min(min, vertices[indices[i]].position);
+            max = glm::max(max, vertices[indices[i]].position);
+        }
+
+        glm::vec3 center = (min + max) * 0.5f;
+        f32 radius_squared = 0.0f;
+        for (u32 i = 0; i < index_count; i++) {
+            glm::vec3 delta = vertices[indices[i]].position - center;
+            radius_squared = std::max(radius_squared, glm::dot(delta, delta));
+        }
+
+        for (u32 axis = 0; axis < 3; axis++) {
+            bounds.min[axis] = min[axis];
+            bounds.max[axis] = max[axis];
+            bounds.center[axis] = center[axis];
+        }
+        bounds.radius = sqrtf(radius_squared);
+
+        return bounds;
+    }
+
+    static glm::vec3 TriangleNormal(const std::vector<MeshVertex> &vertices, const u32 *corners) {
+        const glm::vec3 &p0 = vertices[corners[0]].position;
+        return glm::cross(vertices[corners[1]].position - p0, vertices[corners[2]].position - p0);
+    }
+
+    // Normal cone from the winding normals, the OBJ normals decide which side is the front
+    static void ComputeMeshletCone(
+        const std::vector<MeshVertex> &vertices, const u32 *indices, u32 index_count, f32 winding, CookedMeshlet &meshlet) {
+
+        std::vector<glm::vec3> normals;
+        normals.reserve(index_count / 3);
+
+        glm::vec3 axis(0.0f);
+        for (u32 i = 0; i < index_count; i += 3) {
+            const glm::vec3 normal = TriangleNormal(vertices, &indices[i]) * winding;
+            const f32 length = glm::length(normal);
+            if (length > 0.0f) {
+                normals.push_back(normal / length);
+                axis += normals.back();
+            }
+        }
+
+        const f32 axis_length = glm::length(axis);
+        if (normals.empty() || axis_length <= 0.0f)
+            return;
+
+        axis = axis / axis_length;
+
+        f32 min_dot = 1.0f;
+        for (const auto &normal : normals) {
+            min_dot = std::min(min_dot, glm::dot(normal, axis));
+        }
+
+        for (u32 component = 0; component < 3; component++) {
+            meshlet.cone_axis[component] = axis[component];
+        }
+
+        // Past roughly 84 degrees of spread the cone rejects almost nothing, keep the default
+        if (min_dot > 0.1f)
+            meshlet.cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+    }
+
+    struct SubmeshRange {
+        u32 index_offset = 0;
+        u32 index_count = 0;
+    };
+
+    static u64 AlignStream(u64 offset) {
+        return (offset + COOKED_MESH_STREAM_ALIGNMENT - 1) & ~(COOKED_MESH_STREAM_ALIGNMENT - 1);
+    }
+
+    bool IsCookedMeshStale(const std::string &cooked, const std::string &source) {
+        // Packs ship without the sources, whatever they hold is final
+        if (Core::GetFileSystem().IsPacked(cooked))
+            return false;
+
+        std::error_code error;
+        auto cooked_time = std::filesystem::last_write_time(cooked, error);
+        if (error)
+            return true;
+
+        auto source_time = std::filesystem::last_write_time(source, error);
+        if (!error && source_time > cooked_time)
+            return true;
+
+        std::ifstream file(cooked, std::ios::binary);
+        CookedMeshHeader header;
+        file.read((char *)&header, sizeof(header));
+
+        return !file || header.magic != COOKED_MESH_MAGIC || header.version != COOKED_MESH_VERSION ||
+               header.vertex_stride != sizeof(MeshVertex);
+    }
+
+    void CookMeshFromObj(const std::string &source, const std::string &cooked) {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, source.c_str())) {
+            throw std::runtime_error("failed to load obj mesh for cooking!");
+        }
+
+        std::vector<MeshVertex> vertices;
+        std::vector<u32> indices;
+        std::vector<CookedSubmesh> submeshes;
+        std::unordered_map<MeshVertex, u32, MurmurHash<MeshVertex>> unique_vertices;
+
+        for (const auto &shape : shapes) {
+            CookedSubmesh submesh;
+            submesh.index_offset = u32(indices.size());
+            submesh.material = shape.mesh.material_ids.empty() ? 0 : u32(std::max(shape.mesh.material_ids[0], 0));
+
+            for (const auto &index : shape.mesh.indices) {
+                // Welded after packing, so vertices that quantize to the same bits are merged as well
+                MeshVertex vertex;
+                memset(&vertex, 0, sizeof(vertex));
+
+                vertex.position = {attrib.vertices[3 * index.vertex_index + 0],
+                                   attrib.vertices[3 * index.vertex_index + 1],
+                                   attrib.vertices[3 * index.vertex_index + 2]};
+
+                if (index.texcoord_index >= 0) {
+                    vertex.uv0[0] = PackHalf(attrib.texcoords[2 * index.texcoord_index + 0]);
+                    vertex.uv0[1] = PackHalf(1.0f - attrib.texcoords[2 * index.texcoord_index + 1]);
+                }
+
+                if (index.normal_index >= 0) {
+                    glm::vec3 normal = {attrib.normals[3 * index.normal_index + 0],
+                                        attrib.normals[3 * index.normal_index + 1],
+                                        attrib.normals[3 * index.normal_index + 2]};
+
+                    const f32 length = glm::length(normal);
+                    if (length > 0.0f)
+                        normal = normal / length;
+
+                    for (u32 axis = 0; axis < 3; axis++) {
+                        vertex.normal[axis] = PackSnorm8(normal[axis]);
+                    }
+                }
+
+                for (u32 channel = 0; channel < 4; channel++) {
+                    vertex.color[channel] = PackUnorm8(1.0f);
+                }
+
+                auto it = unique_vertices.find(vertex);
+                if (it == unique_vertices.end()) {
+                    it = unique_vertices.emplace(vertex, u32(vertices.size())).first;
+                    vertices.push_back(vertex);
+                }
+
+                indices.push_back(it->second);
+            }
+
+            submesh.index_count = u32(indices.size()) - submesh.index_offset;
+            submesh.bounds = ComputeBounds(vertices, indices.data() + submesh.index_offset, submesh.index_count);
+            submeshes.push_back(submesh);
+        }
+
+        if (indices.empty()) {
+            throw std::runtime_error("obj mesh has no triangles!");
+        }
+
+        // Submeshes are drawn separately, reorder their triangles independently
+        const VertexCacheStats before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        for (const auto &submesh : submeshes) {
+            u32 *submesh_indices = indices.data() + submesh.index_offset;
+            OptimizeVertexCache(submesh_indices, submesh.index_count, vertices.size());
+            OptimizeOverdraw(
+                submesh_indices,
+                submesh.index_count,
+                &vertices[0].position.x,
+                vertices.size(),
+                sizeof(MeshVertex));
+        }
+
+        const VertexCacheStats after = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        // Every LOD simplifies the previous one, appending its submeshes to the index list in the same order.
+        // Errors of the chain add up, so each LOD stores an upper bound against LOD 0.
+        std::vector<CookedLod> lods(1);
+        lods[0].index_count = u32(indices.size());
+
+        std::vector<std::vector<SubmeshRange>> lod_submeshes(1);
+        for (const auto &submesh : submeshes) {
+            lod_submeshes[0].push_back({submesh.index_offset, submesh.index_count});
+        }
+
+        const f32 max_error = ComputeBounds(vertices, indices.data(), u32(indices.size())).radius * MESH_LOD_MAX_ERROR;
+
+        while (lods.size() < MESH_MAX_LODS) {
+            const CookedLod &previous = lods.back();
+
+            // Errors add up across steps, each step may only spend what the levels before it left
+            const f32 error_budget = max_error - previous.error;
+            if (error_budget <= 0.0f) {
+                break;
+            }
+
+            CookedLod lod;
+            lod.index_offset = u32(indices.size());
+
+            std::vector<SubmeshRange> ranges;
+            f32 lod_error = 0.0f;
+
+            for (const auto &source_range : lod_submeshes.back()) {
+                SubmeshRange range;
+                range.index_offset = u32(indices.size());
+
+                const size_t target = source_range.index_count / 6 * 3;
+                indices.resize(indices.size() + source_range.index_count);
+
+                f32 error = 0.0f;
+                range.index_count = u32(SimplifyMesh(
+                    indices.data() + range.index_offset,
+                    indices.data() + source_range.index_offset,
+                    source_range.index_count,
+                    &vertices[0].position.x,
+                    vertices.size(),
+                    sizeof(MeshVertex),
+                    target,
+                    error_budget,
+                    &error));
+
+                indices.resize(range.index_offset + range.index_count);
+                OptimizeVertexCache(indices.data() + range.index_offset, range.index_count, vertices.size());
+
+                ranges.push_back(range);
+                lod_error = std::max(lod_error, error);
+            }
+
+            lod.index_count = u32(indices.size()) - lod.index_offset;
+            lod.error = previous.error + lod_error;
+
+            // Not worth a level when simplification stalls on borders, seams or the error limit
+            if (lod.index_count == 0 || lod.index_count > previous.index_count * 3 / 4) {
+                indices.resize(lod.index_offset);
+                break;
+            }
+
+            lods.push_back(lod);
+            lod_submeshes.push_back(ranges);
+        }
+
+        vertices.resize(
+            OptimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.size(), sizeof(MeshVertex)));
+
+        LOG_INFO(
+            "cooked {}: {} vertices, {} triangles, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+            source,
+            vertices.size(),
+            lods[0].index_count / 3,
+            before.acmr,
+            after.acmr,
+            before.atvr,
+            after.atvr)
+
+        for (size_t level = 1; level < lods.size(); level++) {
+            LOG_INFO(
+                "cooked {}: LOD {} has {} triangles, error {:.5f}",
+                source,
+                level,
+                lods[level].index_count / 3,
+                lods[level].error)
+        }
+
+        // Compare winding against the authored normals once, so the cones point out of the surface
+        f32 winding_agreement = 0.0f;
+        for (size_t i = 0; i < lods[0].index_count; i += 3) {
+            glm::vec3 normal(0.0f);
+            for (u32 corner = 0; corner < 3; corner++) {
+                const i8 *packed = vertices[indices[i + corner]].normal;
+                normal += glm::vec3(f32(packed[0]), f32(packed[1]), f32(packed[2]));
+            }
+            winding_agreement += glm::dot(TriangleNormal(vertices, &indices[i]), normal);
+        }
+        const f32 winding = winding_agreement < 0.0f ? -1.0f : 1.0f;
+
+        std::vector<CookedMeshlet> meshlets;
+
+        for (size_t level = 0; level < lods.size(); level++) {
+            lods[level].meshlet_offset = u32(meshlets.size());
+
+            for (size_t i = 0; i < lod_submeshes[level].size(); i++) {
+                const SubmeshRange &submesh = lod_submeshes[level][i];
+                const u32 *submesh_indices = indices.data() + submesh.index_offset;
+                auto ranges = BuildMeshlets(
+                    submesh_indices, submesh.index_count, vertices.size(), MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES);
+
+                if (level == 0) {
+                    submeshes[i].meshlet_offset = u32(meshlets.size());
+                    submeshes[i].meshlet_count = u32(ranges.size());
+                }
+
+                for (const auto &range : ranges) {
+                    CookedMeshlet meshlet;
+                    meshlet.index_offset = submesh.index_offset + range.index_offset;
+                    meshlet.index_count = range.index_count;
+                    meshlet.vertex_count = range.vertex_count;
+
+                    const u32 *meshlet_indices = indices.data() + meshlet.index_offset;
+                    const MeshBounds bounds = ComputeBounds(vertices, meshlet_indices, meshlet.index_count);
+                    memcpy(meshlet.center, bounds.center, sizeof(meshlet.center));
+                    meshlet.radius = bounds.radius;
+
+                    ComputeMeshletCone(vertices, meshlet_indices, meshlet.index_count, winding, meshlet);
+                    meshlets.push_back(meshlet);
+                }
+            }
+
+            lods[level].meshlet_count = u32(meshlets.size()) - lods[level].meshlet_offset;
+        }
+
+        LOG_INFO("cooked {}: {} meshlets", source, meshlets.size())
+
+        CookedMeshHeader header;
+        header.vertex_stride = sizeof(MeshVertex);
+        header.vertex_count = u32(vertices.size());
+        header.index_count = u32(indices.size());
+        header.submesh_count = u32(submeshes.size());
+        header.meshlet_count = u32(meshlets.size());
+        header.lod_count = u32(lods.size());
+        header.submesh_offset = sizeof(CookedMeshHeader);
+        header.lod_offset = header.submesh_offset + submeshes.size() * sizeof(CookedSubmesh);
+        header.vertex_offset = AlignStream(header.lod_offset + lods.size() * sizeof(CookedLod));
+        header.index_offset = AlignStream(header.vertex_offset + vertices.size() * sizeof(MeshVertex));
+        header.meshlet_offset = AlignStream(header.index_offset + indices.size() * sizeof(u32));
+        header.bounds = ComputeBounds(vertices, indices.data(), lods[0].index_count);
+
+        std::ofstream file(cooked, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open cooked mesh for writing!");
+        }
+
+        const char padding[COOKED_MESH_STREAM_ALIGNMENT] = {};
+        const u64 lod_end = header.lod_offset + lods.size() * sizeof(CookedLod);
+        const u64 vertex_end = header.vertex_offset + vertices.size() * sizeof(MeshVertex);
+        const u64 index_end = header.index_offset + indices.size() * sizeof(u32);
+
+        file.write((const char *)&header, sizeof(header));
+        file.write((const char *)submeshes.data(), submeshes.size() * sizeof(CookedSubmesh));
+        file.write((const char *)lods.data(), lods.size() * sizeof(CookedLod));
+        file.write(padding, header.vertex_offset - lod_end);
+        file.write((const char *)vertices.data(), vertices.size() * sizeof(MeshVertex));
+        file.write(padding, header.index_offset - vertex_end);
+        file.write((const char *)indices.data(), indices.size() * sizeof(u32));
+        file.write(padding, header.meshlet_offset - index_end);
+        file.write((const char *)meshlets.data(), meshlets.size() * sizeof(CookedMeshlet));
+    }
+
+} // namespace Renderer
+} // namespace Squid
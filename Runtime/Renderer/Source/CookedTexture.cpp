@@ -0,0 +1,239 @@
+#include <Renderer/CookedTexture.h>
+#include <Renderer/BlockCompression.h>
+#include <Core/IO/AsyncIo.h>
+#include <Core/IO/VirtualFileSystem.h>
+#include <Core/Jobs/JobSystem.h>
+
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include <stb_image.h>
+
+namespace Squid {
+namespace Renderer {
+
+    static constexpr u64 COOKED_TEXTURE_ALIGNMENT = 16;
+
+    // Packed cooked textures are read from the pack's mapping, loose ones through AsyncIo
+    static bool OpenPackedTexture(const std::string &cooked, Core::VfsFile &file) {
+        Core::VirtualFileSystem &file_system = Core::GetFileSystem();
+        if (!file_system.IsPacked(cooked))
+            return false;
+
+        file = file_system.Open(cooked);
+        if (!file.IsValid()) {
+            throw std::runtime_error("failed to open cooked texture!");
+        }
+        return true;
+    }
+
+    bool IsCookedTextureStale(
+        const std::string &cooked, const std::vector<std::string> &sources, RHI::Format format) {
+        // Packs ship without the sources, whatever they hold is final
+        if (Core::GetFileSystem().IsPacked(cooked))
+            return false;
+
+        std::error_code error;
+        auto cooked_time = std::filesystem::last_write_time(cooked, error);
+        if (error)
+            return true;
+
+        for (const auto &source : sources) {
+            auto source_time = std::filesystem::last_write_time(source, error);
+            if (!error && source_time > cooked_time)
+                return true;
+        }
+
+        std::ifstream file(cooked, std::ios::binary);
+        CookedTextureHeader header;
+        file.read((char *)&header, sizeof(header));
+
+        return !file || header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION ||
+               header.format != format;
+    }
+
+    void CookTexture(
+        const std::vector<std::string> &sources,
+        const std::string &cooked,
+        RHI::Format format,
+        RHI::TextureHandle::Type type) {
+
+        const bool hdr = format == RHI::FORMAT_BC6H_UF16;
+        const RHI::Format source_format = hdr ? RHI::FORMAT_R32G32B32A32_FLOAT : RHI::FORMAT_R8G8B8A8_UNORM;
+
+        CookedTextureHeader header;
+        header.format = format;
+        header.type = u8(type);
+        header.layers = u8(sources.size());
+
+        // All sources are read in one batch, the layers decode from memory
+        const std::vector<std::vector<u8>> files = Core::ReadFiles(sources);
+
+        i32 width, height, channels;
+        if (sources.empty() ||
+            !stbi_info_from_memory(files[0].data(), i32(files[0].size()), &width, &height, &channels)) {
+            throw std::runtime_error("failed to load texture image for cooking!");
+        }
+
+        header.width = width;
+        header.height = height;
+        header.mip_count = RHI::GetMipCount(width, height);
+        header.layer_size = RHI::GetMipChainSize(format, width, height, 0, header.mip_count);
+
+        // Layers are independent, decode and encode them in parallel. Every mip is split across the job system as
+        // well, so single layer textures use all threads too.
+        std::vector<std::vector<u8>> layers(sources.size());
+
+        Core::ParallelFor(
+            u32(sources.size()),
+            1,
+            [&](u32 begin, u32 end) {
+                for (u32 index = begin; index < end; index++) {
+                    const std::vector<u8> &source = files[index];
+
+                    i32 width, height, channels;
+                    void *pixels =
+                        hdr ? (void *)stbi_loadf_from_memory(
+                                  source.data(), i32(source.size()), &width, &height, &channels, 4)
+                            : (void *)stbi_load_from_memory(
+                                  source.data(), i32(source.size()), &width, &height, &channels, 4);
+
+                    if (!pixels) {
+                        throw std::runtime_error("failed to load texture image for cooking!");
+                    }
+
+                    if (header.width != u32(width) || header.height != u32(height)) {
+                        stbi_image_free(pixels);
+                        throw std::runtime_error("texture layers differ in size!");
+                    }
+
+                    MipChain chain = BuildMipChain(pixels, width, height, source_format);
+                    stbi_image_free(pixels);
+
+                    std::vector<u8> &layer = layers[index];
+                    layer.reserve(header.layer_size);
+
+                    for (u32 mip = 0; mip < chain.mip_count; mip++) {
+                        auto blocks = CompressSurface(
+                            chain.GetMip(mip),
+                            RHI::GetMipDimension(header.width, mip),
+                            RHI::GetMipDimension(header.height, mip),
+                            format);
+                        layer.insert(layer.end(), blocks.begin(), blocks.end());
+                    }
+                }
+            },
+            "Cook Texture Layer");
+
+        std::vector<CookedTextureMip> mips(header.mip_count);
+        u64 offset = 0;
+        for (u32 mip = 0; mip < header.mip_count; mip++) {
+            mips[mip].offset = offset;
+            mips[mip].size = RHI::GetMipSize(format, header.width, header.height, mip);
+            offset += mips[mip].size;
+        }
+
+        const u64 table_end = sizeof(CookedTextureHeader) + mips.size() * sizeof(CookedTextureMip);
+        header.data_offset = (table_end + COOKED_TEXTURE_ALIGNMENT - 1) & ~(COOKED_TEXTURE_ALIGNMENT - 1);
+
+        std::ofstream file(cooked, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open cooked texture for writing!");
+        }
+
+        const char padding[COOKED_TEXTURE_ALIGNMENT] = {};
+        file.write((const char *)&header, sizeof(header));
+        file.write((const char *)mips.data(), mips.size() * sizeof(CookedTextureMip));
+        file.write(padding, header.data_offset - table_end);
+
+        for (const auto &layer : layers) {
+            file.write((const char *)layer.data(), layer.size());
+        }
+    }
+
+    CookedTextureHeader ReadCookedTextureHeader(const std::string &cooked) {
+        Core::VfsFile packed;
+        if (OpenPackedTexture(cooked, packed)) {
+            CookedTextureHeader header;
+            if (packed.GetSize() < sizeof(header)) {
+                throw std::runtime_error("invalid cooked texture!");
+            }
+
+            memcpy(&header, packed.GetData(), sizeof(header));
+            if (header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION) {
+                throw std::runtime_error("invalid cooked texture!");
+            }
+            return header;
+        }
+
+        std::ifstream file(cooked, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open cooked texture!");
+        }
+
+        CookedTextureHeader header;
+        file.read((char *)&header, sizeof(header));
+
+        if (!file || header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION) {
+            throw std::runtime_error("invalid cooked texture!");
+        }
+
+        return header;
+    }
+
+    void ReadCookedTextureData(const std::string &cooked, const CookedTextureHeader &header, void *dst) {
+        const u64 size = header.layer_size * header.layers;
+
+        Core::VfsFile packed;
+        if (OpenPackedTexture(cooked, packed)) {
+            if (header.data_offset + size > packed.GetSize()) {
+                throw std::runtime_error("cooked texture is truncated!");
+            }
+
+            memcpy(dst, packed.GetData() + header.data_offset, size);
+            return;
+        }
+
+        Core::IoFile file(cooked);
+        if (!file.IsValid()) {
+            throw std::runtime_error("failed to open cooked texture!");
+        }
+
+        // Split into pieces that are all in flight at once, straight into dst
+        Core::AsyncIo &io = Core::GetAsyncIo();
+        Core::IoBatch batch;
+        io.Read(batch, file, header.data_offset, size, dst);
+        io.Wait(batch);
+
+        if (batch.HasFailed()) {
+            throw std::runtime_error("cooked texture is truncated!");
+        }
+    }
+
+    MipChain ReadCookedMipChain(const std::string &cooked) {
+        CookedTextureHeader header = ReadCookedTextureHeader(cooked);
+        assert(header.layers == 1);
+
+        MipChain chain;
+        chain.format = RHI::Format(header.format);
+        chain.width = header.width;
+        chain.height = header.height;
+        chain.mip_count = header.mip_count;
+        chain.data.resize(header.layer_size);
+        chain.offsets.resize(header.mip_count);
+
+        u64 offset = 0;
+        for (u32 mip = 0; mip < header.mip_count; mip++) {
+            chain.offsets[mip] = offset;
+            offset += RHI::GetMipSize(chain.format, header.width, header.height, mip);
+        }
+
+        ReadCookedTextureData(cooked, header, chain.data.data());
+        return chain;
+    }
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,258 @@
+#include <Renderer/HotReload.h>
+#include <Core/Events/EventDispatcher.h>
+#include <Core/FileSystem.h>
+#include <Core/Log.h>
+#include <Core/Profiling.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+
+namespace Squid {
+namespace Renderer {
+
+    namespace fs = std::filesystem;
+
+#ifdef SQUID_WIN32
+    static constexpr const char *DXC_PATH = "Tools/DXC/bin/dxc.exe";
+#else
+    static constexpr const char *DXC_PATH = "Tools/DXC/bin/dxc";
+#endif
+
+    static bool IsSamePath(const std::string &a, const std::string &b) {
+        return fs::path(a).lexically_normal() == fs::path(b).lexically_normal();
+    }
+
+    static std::string Quote(const std::string &text) { return "\"" + text + "\""; }
+
+    // SPIR-V and the temporary it is compiled to are written by Compile, they are not edits to report
+    static bool IsCompileOutput(const std::string &path) {
+        const fs::path extension = fs::path(path).extension();
+        return extension == ".spv" || extension == ".tmp";
+    }
+
+    // Runs command and collects what it wrote to stdout and stderr, returns the exit status
+    static int RunProcess(std::string command, std::string &output) {
+        command += " 2>&1";
+#ifdef SQUID_WIN32
+        // cmd strips the outer quotes of the whole line
+        FILE *pipe = _popen(Quote(command).c_str(), "r");
+#else
+        FILE *pipe = popen(command.c_str(), "r");
+#endif
+        if (!pipe) {
+            output = "failed to run " + command;
+            return -1;
+        }
+
+        char buffer[512];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+            output.append(buffer, read);
+        }
+
+#ifdef SQUID_WIN32
+        return _pclose(pipe);
+#else
+        return pclose(pipe);
+#endif
+    }
+
+    // The replacement is created under a fresh id next to the old pipeline, which is only destroyed once that worked
+    template <typename T>
+    static bool ReplacePipeline(RHI::Device *device, T &handle, T replacement) {
+        replacement.id = RHI::Handle().id;
+        try {
+            device->LoadPipeline(replacement);
+        } catch (const std::exception &error) {
+            LOG_ERROR("failed to create the reloaded pipeline, keeping the old one: {}", error.what())
+            return false;
+        }
+
+        device->UnloadPipeline(handle);
+        handle = std::move(replacement);
+        return true;
+    }
+
+    HotReload::HotReload(RHI::Device *device, const std::string &directory) : device(device), watcher(directory) {
+        watcher.Start();
+    }
+
+    HotReload::~HotReload() {
+        watcher.Stop();
+        if (compile.valid())
+            compile.wait();
+    }
+
+    u32 HotReload::AddProgram(const ShaderProgram &program) {
+        for (u32 i = 0; i < programs.size(); i++) {
+            if (IsSamePath(programs[i].output, program.output))
+                return i;
+        }
+
+        programs.push_back(program);
+        return u32(programs.size()) - 1;
+    }
+
+    void HotReload::Watch(
+        RHI::GraphicsPipelineHandle &pipeline, const ShaderProgram &vertex, const ShaderProgram &pixel) {
+        WatchedPipeline watched;
+        watched.graphics = &pipeline;
+        watched.programs[0] = AddProgram(vertex);
+        watched.programs[1] = AddProgram(pixel);
+        pipelines.push_back(watched);
+    }
+
+    void HotReload::Watch(RHI::ComputePipelineHandle &pipeline, const ShaderProgram &compute) {
+        WatchedPipeline watched;
+        watched.compute = &pipeline;
+        watched.programs[0] = AddProgram(compute);
+        pipelines.push_back(watched);
+    }
+
+    HotReload::CompileResult HotReload::Compile(u32 index, const ShaderProgram &program) {
+        CompileResult result;
+        result.program = index;
+
+        // Compiled next to the output and only moved over it on success, the old SPIR-V stays for the next start
+        const std::string temporary = program.output + ".tmp";
+
+        std::string command;
+        if (fs::path(program.source).extension() == ".hlsl") {
+            const std::string dxc = fs::exists(DXC_PATH) ? Quote(DXC_PATH) : std::string("dxc");
+            command = dxc + " -spirv -T " + program.profile + " -E " + program.entry + " " + Quote(program.source) +
+                      " -Fo " + Quote(temporary) + " -fvk-use-scalar-layout";
+        } else {
+            command = "glslc " + Quote(program.source) + " -o " + Quote(temporary);
+        }
+
+        std::error_code error;
+        fs::remove(temporary, error);
+
+        result.success = RunProcess(command, result.log) == 0 && fs::file_size(temporary, error) > 0 && !error;
+        if (result.success) {
+            result.spirv = Core::ReadTextFile(temporary.c_str());
+            fs::rename(temporary, program.output, error);
+        } else {
+            fs::remove(temporary, error);
+        }
+
+        return result;
+    }
+
+    void HotReload::StartCompile() {
+        std::vector<std::pair<u32, ShaderProgram>> batch;
+        for (u32 program : dirty_programs) {
+            batch.push_back({program, programs[program]});
+        }
+        dirty_programs.clear();
+
+        compile = std::async(std::launch::async, [batch = std::move(batch)]() {
+            std::vector<CompileResult> results;
+            for (const auto &[index, program] : batch) {
+                results.push_back(Compile(index, program));
+            }
+            return results;
+        });
+    }
+
+    void HotReload::Apply(std::vector<CompileResult> &results) {
+        std::vector<std::string *> compiled(programs.size(), nullptr);
+        for (auto &result : results) {
+            const ShaderProgram &program = programs[result.program];
+            if (!result.success) {
+                LOG_ERROR("{} {} failed to compile, keeping the old pipeline\n{}", program.source, program.entry,
+                          result.log)
+                continue;
+            }
+            compiled[result.program] = &result.spirv;
+        }
+
+        std::vector<WatchedPipeline *> rebuilt;
+        for (auto &pipeline : pipelines) {
+            for (u32 program : pipeline.programs) {
+                if (program != INVALID_PROGRAM && compiled[program]) {
+                    rebuilt.push_back(&pipeline);
+                    break;
+                }
+            }
+        }
+
+        if (rebuilt.empty())
+            return;
+
+        // Earlier frames may still be using the old pipelines
+        device->WaitIdle();
+
+        u32 reloaded = 0;
+        for (WatchedPipeline *pipeline : rebuilt) {
+            if (pipeline->graphics) {
+                RHI::GraphicsPipelineHandle replacement = *pipeline->graphics;
+                if (compiled[pipeline->programs[0]])
+                    replacement.vertex_shader = *compiled[pipeline->programs[0]];
+                if (compiled[pipeline->programs[1]])
+                    replacement.pixel_shader = *compiled[pipeline->programs[1]];
+
+                reloaded += ReplacePipeline(device, *pipeline->graphics, std::move(replacement)) ? 1 : 0;
+            } else {
+                const ShaderProgram &program = programs[pipeline->programs[0]];
+                RHI::ComputePipelineHandle replacement = *pipeline->compute;
+                replacement.compute_shader = *compiled[pipeline->programs[0]];
+                // glslc always names the entry point main
+                replacement.compute_entry = fs::path(program.source).extension() == ".hlsl" ? program.entry : "main";
+
+                reloaded += ReplacePipeline(device, *pipeline->compute, std::move(replacement)) ? 1 : 0;
+            }
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - change_time;
+        LOG_INFO("reloaded {} of {} pipelines, {} ms after the change", reloaded, rebuilt.size(),
+                 std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count())
+    }
+
+    void HotReload::Tick() {
+        PROFILING_SCOPE
+
+        std::vector<Core::FileChange> changes;
+        if (watcher.Poll(changes)) {
+            for (const auto &change : changes) {
+                if (IsCompileOutput(change.path))
+                    continue;
+
+                bool shader = false;
+                for (u32 i = 0; i < programs.size(); i++) {
+                    if (!IsSamePath(programs[i].source, change.path))
+                        continue;
+
+                    shader = true;
+                    if (change.status != Core::FileStatus::DELETED &&
+                        std::find(dirty_programs.begin(), dirty_programs.end(), i) == dirty_programs.end())
+                        dirty_programs.push_back(i);
+                }
+
+                if (shader) {
+                    // Latency is reported from the watcher's batch, which lags the save by its quiet period
+                    change_time = std::chrono::steady_clock::now();
+                } else {
+                    Core::AssetReloadEvent event;
+                    event.status = change.status;
+                    if (event.SetPath(change.path))
+                        Core::GetEventDispatcher().Publish(event);
+                    else
+                        LOG_WARN("{} is too long for an asset reload event", change.path)
+                }
+            }
+        }
+
+        if (compile.valid() && compile.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            std::vector<CompileResult> results = compile.get();
+            Apply(results);
+        }
+
+        if (!compile.valid() && !dirty_programs.empty())
+            StartCompile();
+    }
+
+} // namespace Renderer
+} // namespace Squid
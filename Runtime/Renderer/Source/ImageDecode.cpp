@@ -0,0 +1,54 @@
+#include <Renderer/ImageDecode.h>
+#include <Core/Profiling.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <stb_image.h>
+
+namespace Squid {
+namespace Renderer {
+
+    void ReadImageInfo(ImageDecode &image) {
+        i32 width, height, channels;
+        if (!stbi_info_from_memory(image.file->data(), i32(image.file->size()), &width, &height, &channels)) {
+            throw std::runtime_error("failed to read texture image info!");
+        }
+
+        image.width = u32(width);
+        image.height = u32(height);
+    }
+
+    void DecodeImages(const std::vector<ImageDecode> &images, u8 *destination, Core::JobSystem &system) {
+        PROFILING_SCOPE
+
+        Core::ParallelFor(
+            system,
+            u32(images.size()),
+            1,
+            [&](u32 begin, u32 end) {
+                for (u32 i = begin; i < end; i++) {
+                    const ImageDecode &image = images[i];
+                    const stbi_uc *file = image.file->data();
+                    const i32 file_size = i32(image.file->size());
+
+                    i32 width, height, channels;
+                    void *pixels;
+                    if (image.hdr)
+                        pixels = stbi_loadf_from_memory(file, file_size, &width, &height, &channels, 4);
+                    else
+                        pixels = stbi_load_from_memory(file, file_size, &width, &height, &channels, 4);
+
+                    if (!pixels || u32(width) != image.width || u32(height) != image.height) {
+                        stbi_image_free(pixels);
+                        throw std::runtime_error("failed to load texture image!");
+                    }
+
+                    memcpy(destination + image.offset, pixels, image.GetDecodedSize());
+                    stbi_image_free(pixels);
+                }
+            },
+            "Decode Image");
+    }
+
+} // namespace Renderer
+} // namespace Squid
@@ -1,62 +1,59 @@
 #include <Public/Renderer/Mesh.h>
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
-#include <unordered_map>
-
-namespace std {
-template <>
-struct hash<Squid::Renderer::MeshVertex> {
-    size_t operator()(Squid::Renderer::MeshVertex const &vertex) const {
-        return ((hash<glm::vec3>()(vertex.position) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^
-               (hash<glm::vec2>()(vertex.uv0) << 1);
-    }
-};
-} // namespace std
+#include <Core/Log.h>
+#include <Core/Memory/MemoryTracker.h>
+#include <Core/Profiling.h>
+#include <stdexcept>
 
 namespace Squid {
 namespace Renderer {
 
     Mesh::Mesh(const std::string &path) {
+        PROFILING_SCOPE
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_ASSETS);
 
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-        std::string warn, err;
-
-        bool res = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
+        const std::string cooked = GetCookedMeshPath(path);
 
-        std::unordered_map<MeshVertex, uint32_t> unique_vertices = {};
+        if (IsCookedMeshStale(cooked, path)) {
+            PROFILING_NAMED_SCOPE("Cook mesh")
+            LOG_INFO("cooking {}", cooked)
+            CookMeshFromObj(path, cooked);
+        }
 
-        for (const auto &shape : shapes) {
-            for (const auto &index : shape.mesh.indices) {
-                MeshVertex vertex = {};
-                vertex.position = {attrib.vertices[3 * index.vertex_index + 0],
-                                   attrib.vertices[3 * index.vertex_index + 1],
-                                   attrib.vertices[3 * index.vertex_index + 2]};
+        // Loose or straight from a pack's mapping
+        file = Core::GetFileSystem().Open(cooked);
+        if (!file.IsValid() || file.GetSize() < sizeof(CookedMeshHeader)) {
+            throw std::runtime_error("failed to map cooked mesh!");
+        }
 
-                vertex.uv0 = {attrib.texcoords[2 * index.texcoord_index + 0],
-                              1.0f - attrib.texcoords[2 * index.texcoord_index + 1]};
+        memcpy(&header, file.GetData(), sizeof(header));
 
-                vertex.color = {1.0f, 1.0f, 1.0f};
+        if (header.magic != COOKED_MESH_MAGIC || header.version != COOKED_MESH_VERSION ||
+            header.vertex_stride != sizeof(MeshVertex) || header.index_stride != sizeof(u32)) {
+            throw std::runtime_error("invalid cooked mesh!");
+        }
 
-                vertex.normal = {attrib.normals[3 * index.normal_index + 0], attrib.normals[3 * index.normal_index + 1],
-                                 attrib.normals[3 * index.normal_index + 2]};
+        if (header.lod_count == 0) {
+            throw std::runtime_error("cooked mesh has no LODs!");
+        }
 
-                vertices.push_back(vertex);
+        if (header.submesh_offset + u64(header.submesh_count) * sizeof(CookedSubmesh) > file.GetSize() ||
+            header.lod_offset + u64(header.lod_count) * sizeof(CookedLod) > file.GetSize() ||
+            header.vertex_offset + u64(header.vertex_count) * header.vertex_stride > file.GetSize() ||
+            header.index_offset + u64(header.index_count) * header.index_stride > file.GetSize() ||
+            header.meshlet_offset + u64(header.meshlet_count) * sizeof(CookedMeshlet) > file.GetSize()) {
+            throw std::runtime_error("cooked mesh is truncated!");
+        }
 
-                if (unique_vertices.count(vertex) == 0) {
-                    unique_vertices[vertex] = static_cast<uint32_t>(vertices.size());
-                    vertices.push_back(vertex);
-                }
+        const CookedSubmesh *mapped_submeshes = (const CookedSubmesh *)(file.GetData() + header.submesh_offset);
+        submeshes.assign(mapped_submeshes, mapped_submeshes + header.submesh_count);
 
-                indices.push_back(unique_vertices[vertex]);
-            }
-        }
+        const CookedLod *mapped_lods = (const CookedLod *)(file.GetData() + header.lod_offset);
+        lods.assign(mapped_lods, mapped_lods + header.lod_count);
 
-        for(const auto& vertex : vertices) {
-            
-        }
+        // Kept on the CPU as well for culling without the compute pass
+        const CookedMeshlet *mapped_meshlets = (const CookedMeshlet *)(file.GetData() + header.meshlet_offset);
+        meshlets.assign(mapped_meshlets, mapped_meshlets + header.meshlet_count);
     }
 
     static void ComputeTangentBasis(
@@ -107,17 +104,21 @@ namespace Renderer {
     void Mesh::LoadOnDevice(const std::unique_ptr<RHI::Device> &device) {
         using RHI::BufferHandle;
 
-        // TODO: check if already loaded
+        PROFILING_SCOPE
+
+        if (!file.IsValid()) {
+            throw std::runtime_error("mesh is already loaded on device!");
+        }
 
         // == VERTEX BUFFER ============================
         RHI::BufferHandle vertex_staging;
         vertex_staging.cpu_access = true;
-        vertex_staging.size = sizeof(vertices[0]) * vertices.size();
+        vertex_staging.size = u64(header.vertex_count) * header.vertex_stride;
         vertex_staging.usage = BufferHandle::Usage::TRANSFER_SRC;
         device->LoadBuffer(vertex_staging);
 
         void *vertex_data = device->MapBuffer(vertex_staging);
-        memcpy(vertex_data, vertices.data(), vertex_staging.size);
+        memcpy(vertex_data, file.GetData() + header.vertex_offset, vertex_staging.size);
         device->UnmapBuffer(vertex_staging);
 
         // Local vertex buffer handle
@@ -130,12 +131,12 @@ namespace Renderer {
         // == INDEX BUFFER ============================
         RHI::BufferHandle index_staging;
         index_staging.cpu_access = true;
-        index_staging.size = sizeof(indices[0]) * indices.size();
+        index_staging.size = u64(header.index_count) * header.index_stride;
         index_staging.usage = BufferHandle::Usage::TRANSFER_SRC;
         device->LoadBuffer(index_staging);
 
         void *index_data = device->MapBuffer(index_staging);
-        memcpy(index_data, indices.data(), index_staging.size);
+        memcpy(index_data, file.GetData() + header.index_offset, index_staging.size);
         device->UnmapBuffer(index_staging);
 
         // Local index buffer handle
@@ -145,21 +146,43 @@ namespace Renderer {
             (BufferHandle::Usage)(BufferHandle::Usage::TRANSFER_DST | BufferHandle::Usage::INDEX_BUFFER);
         device->LoadBuffer(this->index_buffer);
 
+        // == CLUSTER BUFFER ==========================
+        RHI::BufferHandle cluster_staging;
+        cluster_staging.cpu_access = true;
+        cluster_staging.size = u64(header.meshlet_count) * sizeof(CookedMeshlet);
+        cluster_staging.usage = BufferHandle::Usage::TRANSFER_SRC;
+        device->LoadBuffer(cluster_staging);
+
+        void *cluster_data = device->MapBuffer(cluster_staging);
+        memcpy(cluster_data, file.GetData() + header.meshlet_offset, cluster_staging.size);
+        device->UnmapBuffer(cluster_staging);
+
+        // Local cluster buffer handle
+        this->cluster_buffer.cpu_access = false;
+        this->cluster_buffer.size = cluster_staging.size;
+        this->cluster_buffer.usage =
+            (BufferHandle::Usage)(BufferHandle::Usage::TRANSFER_DST | BufferHandle::Usage::STORAGE_BUFFER);
+        device->LoadBuffer(this->cluster_buffer);
+
         // == TRANSFER WORK ===========================
         RHI::CommandList work = device->BeginTransferList();
         device->Copy(work, vertex_staging, this->vertex_buffer);
         device->Copy(work, index_staging, this->index_buffer);
+        device->Copy(work, cluster_staging, this->cluster_buffer);
         // device->PrerecordList(work);
         // TODO: Transfer Queue (RHI implementation change)
         device->QueueSubmit(RHI::QueueType::GRAPHICS, work);
-    }
+        device->Wait(work);
 
-    Mesh::~Mesh() {
-        vertices.clear();
-        vertices.shrink_to_fit();
-        indices.clear();
-        indices.shrink_to_fit();
+        device->UnloadBuffer(vertex_staging);
+        device->UnloadBuffer(index_staging);
+        device->UnloadBuffer(cluster_staging);
+
+        // Everything lives on the device now, drop the mapping
+        file = Core::VfsFile();
     }
 
+    Mesh::~Mesh() {}
+
 } // namespace Renderer
 } // namespace Squid
\ No newline at end of file
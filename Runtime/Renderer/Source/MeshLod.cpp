@@ -0,0 +1,48 @@
+#include <Renderer/MeshLod.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace Squid {
+namespace Renderer {
+
+    f32 GetProjectedScale(f32 viewport_height, f32 vertical_fov, f32 distance) {
+        // Inside the bounds everything is full detail
+        if (distance <= 0.0f)
+            return FLT_MAX;
+
+        return viewport_height / (2.0f * distance * tanf(vertical_fov * 0.5f));
+    }
+
+    u32 SelectLod(
+        const CookedLod *lods, u32 lod_count, f32 projected_scale, f32 max_pixel_error, f32 hysteresis, u32 current) {
+
+        assert(lod_count > 0);
+        current = std::min(current, lod_count - 1);
+
+        auto pixel_error = [&](u32 lod) { return lods[lod].error * projected_scale; };
+
+        // Errors grow with every LOD, the first one over the threshold ends the search
+        u32 target = 0;
+        while (target + 1 < lod_count && pixel_error(target + 1) <= max_pixel_error) {
+            target++;
+        }
+
+        if (target > current) {
+            // Coarser only once the new LOD is clearly good enough
+            while (target > current && pixel_error(target) > max_pixel_error * (1.0f - hysteresis)) {
+                target--;
+            }
+        } else if (target < current) {
+            // Finer only once the current LOD is clearly too coarse
+            if (pixel_error(current) <= max_pixel_error * (1.0f + hysteresis))
+                target = current;
+        }
+
+        return target;
+    }
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,737 @@
+#include <Renderer/MeshOptimizer.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace Squid {
+namespace Renderer {
+
+    // FIFO cache simulation with timestamps, a vertex is cached while fewer than cache_size misses happened since its
+    // own. Advancing the timestamp by more than cache_size flushes the cache.
+    class FifoCache {
+    public:
+        FifoCache(size_t vertex_count, u32 cache_size) : timestamps(vertex_count, 0), cache_size(cache_size) {}
+
+        inline bool Access(u32 vertex) {
+            if (timestamp - timestamps[vertex] > cache_size) {
+                timestamps[vertex] = timestamp++;
+                return true;
+            }
+            return false;
+        }
+
+        inline void Flush() { timestamp += cache_size + 1; }
+
+    private:
+        std::vector<u32> timestamps;
+        u32 cache_size;
+        u32 timestamp = cache_size + 1;
+    };
+
+    VertexCacheStats AnalyzeVertexCache(const u32 *indices, size_t index_count, size_t vertex_count, u32 cache_size) {
+        assert(index_count % 3 == 0);
+
+        VertexCacheStats stats;
+        FifoCache cache(vertex_count, cache_size);
+        std::vector<bool> referenced(vertex_count, false);
+        u32 referenced_count = 0;
+
+        for (size_t i = 0; i < index_count; i++) {
+            const u32 vertex = indices[i];
+            stats.vertices_transformed += cache.Access(vertex) ? 1 : 0;
+
+            if (!referenced[vertex]) {
+                referenced[vertex] = true;
+                referenced_count++;
+            }
+        }
+
+        if (index_count > 0) {
+            stats.acmr = f32(stats.vertices_transformed) / f32(index_count / 3);
+            stats.atvr = f32(stats.vertices_transformed) / f32(referenced_count);
+        }
+
+        return stats;
+    }
+
+    // == VERTEX CACHE =================================
+
+    // Scoring from Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    static constexpr i32 FORSYTH_CACHE_SIZE = 32;
+    static constexpr f32 FORSYTH_DECAY_POWER = 1.5f;
+    static constexpr f32 FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+    static constexpr f32 FORSYTH_VALENCE_SCALE = 2.0f;
+    static constexpr f32 FORSYTH_VALENCE_POWER = 0.5f;
+
+    static f32 ForsythVertexScore(i32 cache_position, u32 remaining_valence) {
+        if (remaining_valence == 0)
+            return -1.0f;
+
+        f32 score = 0.0f;
+        if (cache_position >= 0) {
+            if (cache_position < 3) {
+                // The last triangle's vertices get a fixed score so it is not simply repeated
+                score = FORSYTH_LAST_TRIANGLE_SCORE;
+            } else {
+                const f32 scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+                score = powf(1.0f - (cache_position - 3) * scale, FORSYTH_DECAY_POWER);
+            }
+        }
+
+        // Favor vertices with few triangles left so they are finished and leave the cache for good
+        score += FORSYTH_VALENCE_SCALE * powf(f32(remaining_valence), -FORSYTH_VALENCE_POWER);
+        return score;
+    }
+
+    void OptimizeVertexCache(u32 *indices, size_t index_count, size_t vertex_count) {
+        assert(index_count % 3 == 0);
+
+        const size_t triangle_count = index_count / 3;
+        if (triangle_count == 0)
+            return;
+
+        // Vertex to triangle adjacency, the live range of every list shrinks as triangles get emitted
+        std::vector<u32> valence(vertex_count, 0);
+        for (size_t i = 0; i < index_count; i++) {
+            valence[indices[i]]++;
+        }
+
+        std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+        for (size_t vertex = 0; vertex < vertex_count; vertex++) {
+            adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + valence[vertex];
+        }
+
+        std::vector<u32> adjacency(index_count);
+        {
+            std::vector<u32> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t i = 0; i < index_count; i++) {
+                adjacency[fill[indices[i]]++] = u32(i / 3);
+            }
+        }
+
+        std::vector<i32> cache_position(vertex_count, -1);
+        std::vector<f32> vertex_score(vertex_count);
+        for (size_t vertex = 0; vertex < vertex_count; vertex++) {
+            vertex_score[vertex] = ForsythVertexScore(-1, valence[vertex]);
+        }
+
+        std::vector<f32> triangle_score(triangle_count);
+        std::vector<bool> emitted(triangle_count, false);
+        for (size_t triangle = 0; triangle < triangle_count; triangle++) {
+            triangle_score[triangle] = vertex_score[indices[triangle * 3 + 0]] +
+                                       vertex_score[indices[triangle * 3 + 1]] +
+                                       vertex_score[indices[triangle * 3 + 2]];
+        }
+
+        std::vector<u32> result(index_count);
+        std::vector<u32> cache, next_cache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        next_cache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+        // With nothing adjacent to the cache the next unemitted triangle in input order starts a new strip
+        size_t scan = 0;
+        i64 best = 0;
+
+        for (size_t emit = 0; emit < triangle_count; emit++) {
+            if (best < 0) {
+                while (emitted[scan])
+                    scan++;
+                best = i64(scan);
+            }
+
+            const u32 triangle = u32(best);
+            const u32 *corners = &indices[triangle * 3];
+            emitted[triangle] = true;
+            memcpy(&result[emit * 3], corners, 3 * sizeof(u32));
+
+            // Drop the triangle from its vertices' live adjacency
+            for (u32 corner = 0; corner < 3; corner++) {
+                const u32 vertex = corners[corner];
+                u32 *begin = &adjacency[adjacency_offsets[vertex]];
+                u32 *end = begin + valence[vertex];
+                u32 *found = std::find(begin, end, triangle);
+                assert(found != end);
+                std::swap(*found, *(end - 1));
+                valence[vertex]--;
+            }
+
+            // Move the triangle's vertices to the front of the LRU cache
+            next_cache.assign(corners, corners + 3);
+            for (u32 vertex : cache) {
+                if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                    next_cache.push_back(vertex);
+            }
+            std::swap(cache, next_cache);
+
+            for (size_t position = 0; position < cache.size(); position++) {
+                cache_position[cache[position]] = position < FORSYTH_CACHE_SIZE ? i32(position) : -1;
+            }
+
+            // Rescore everything the cache touched, the best adjacent triangle is the next one to emit
+            best = -1;
+            f32 best_score = -1.0f;
+
+            for (u32 vertex : cache) {
+                const f32 score = ForsythVertexScore(cache_position[vertex], valence[vertex]);
+                const f32 delta = score - vertex_score[vertex];
+                vertex_score[vertex] = score;
+
+                const u32 *begin = &adjacency[adjacency_offsets[vertex]];
+                for (const u32 *it = begin; it != begin + valence[vertex]; it++) {
+                    triangle_score[*it] += delta;
+                }
+            }
+
+            for (u32 vertex : cache) {
+                const u32 *begin = &adjacency[adjacency_offsets[vertex]];
+                for (const u32 *it = begin; it != begin + valence[vertex]; it++) {
+                    if (triangle_score[*it] > best_score) {
+                        best_score = triangle_score[*it];
+                        best = i64(*it);
+                    }
+                }
+            }
+
+            // Vertices pushed past the cache have been scored as uncached above and can go
+            if (cache.size() > FORSYTH_CACHE_SIZE)
+                cache.resize(FORSYTH_CACHE_SIZE);
+        }
+
+        memcpy(indices, result.data(), index_count * sizeof(u32));
+    }
+
+    // == OVERDRAW =====================================
+
+    struct TriangleCluster {
+        u32 begin = 0;
+        u32 end = 0;
+        f32 sort_key = 0.0f;
+    };
+
+    void OptimizeOverdraw(
+        u32 *indices,
+        size_t index_count,
+        const f32 *positions,
+        size_t vertex_count,
+        size_t vertex_stride,
+        f32 threshold) {
+
+        assert(index_count % 3 == 0);
+
+        const size_t triangle_count = index_count / 3;
+        if (triangle_count < 2)
+            return;
+
+        const u32 cache_size = 16;
+        const f32 target_acmr = AnalyzeVertexCache(indices, index_count, vertex_count, cache_size).acmr * threshold;
+
+        // Cut the list wherever the cluster so far, replayed from a cold cache, is at least as good as the whole list.
+        // Every cluster then starts cold, so any cluster order stays within the threshold.
+        std::vector<TriangleCluster> clusters;
+        FifoCache cache(vertex_count, cache_size);
+        TriangleCluster cluster;
+        u32 cluster_misses = 0;
+
+        for (u32 triangle = 0; triangle < triangle_count; triangle++) {
+            for (u32 corner = 0; corner < 3; corner++) {
+                cluster_misses += cache.Access(indices[triangle * 3 + corner]) ? 1 : 0;
+            }
+
+            cluster.end = triangle + 1;
+            if (f32(cluster_misses) / f32(cluster.end - cluster.begin) <= target_acmr) {
+                clusters.push_back(cluster);
+                cluster.begin = cluster.end;
+                cluster_misses = 0;
+                cache.Flush();
+            }
+        }
+
+        if (cluster.end > cluster.begin)
+            clusters.push_back(cluster);
+
+        auto position = [&](u32 vertex) {
+            const f32 *p = (const f32 *)((const u8 *)positions + vertex * vertex_stride);
+            return p;
+        };
+
+        // Area weighted centroid and normal per cluster
+        std::vector<f32> cluster_data(clusters.size() * 7, 0.0f);
+        f32 mesh_centroid[3] = {};
+        f32 mesh_area = 0.0f;
+
+        for (size_t c = 0; c < clusters.size(); c++) {
+            f32 *data = &cluster_data[c * 7];
+
+            for (u32 triangle = clusters[c].begin; triangle < clusters[c].end; triangle++) {
+                const f32 *p0 = position(indices[triangle * 3 + 0]);
+                const f32 *p1 = position(indices[triangle * 3 + 1]);
+                const f32 *p2 = position(indices[triangle * 3 + 2]);
+
+                const f32 e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+                const f32 e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+                const f32 normal[3] = {
+                    e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                const f32 area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+                for (u32 axis = 0; axis < 3; axis++) {
+                    data[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * area;
+                    data[3 + axis] += normal[axis];
+                }
+                data[6] += area;
+            }
+
+            for (u32 axis = 0; axis < 3; axis++) {
+                mesh_centroid[axis] += data[axis];
+            }
+            mesh_area += data[6];
+
+            if (data[6] > 0.0f) {
+                for (u32 axis = 0; axis < 3; axis++) {
+                    data[axis] /= data[6];
+                }
+            }
+        }
+
+        if (mesh_area > 0.0f) {
+            for (u32 axis = 0; axis < 3; axis++) {
+                mesh_centroid[axis] /= mesh_area;
+            }
+        }
+
+        // Clusters facing away from the center occlude the rest, draw them first
+        for (size_t c = 0; c < clusters.size(); c++) {
+            const f32 *data = &cluster_data[c * 7];
+            const f32 length = sqrtf(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+
+            f32 key = 0.0f;
+            for (u32 axis = 0; axis < 3; axis++) {
+                key += (data[axis] - mesh_centroid[axis]) * data[3 + axis];
+            }
+            clusters[c].sort_key = length > 0.0f ? key / length : 0.0f;
+        }
+
+        std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster &a, const TriangleCluster &b) {
+            return a.sort_key > b.sort_key;
+        });
+
+        std::vector<u32> result;
+        result.reserve(index_count);
+        for (const auto &sorted : clusters) {
+            result.insert(result.end(), indices + sorted.begin * 3, indices + sorted.end * 3);
+        }
+
+        memcpy(indices, result.data(), index_count * sizeof(u32));
+    }
+
+    // == MESHLETS =====================================
+
+    std::vector<MeshletRange> BuildMeshlets(
+        const u32 *indices, size_t index_count, size_t vertex_count, u32 max_vertices, u32 max_triangles) {
+
+        assert(index_count % 3 == 0);
+        assert(max_vertices >= 3 && max_triangles >= 1);
+
+        std::vector<MeshletRange> meshlets;
+
+        // Vertices tagged with the current meshlet number are already part of it
+        std::vector<u32> owner(vertex_count, ~0u);
+        MeshletRange meshlet;
+        u32 meshlet_id = 0;
+
+        auto count_new_vertices = [&](const u32 *corners) {
+            u32 count = 0;
+            for (u32 corner = 0; corner < 3; corner++) {
+                const u32 vertex = corners[corner];
+                const bool seen = owner[vertex] == meshlet_id || (corner > 0 && vertex == corners[0]) ||
+                                  (corner > 1 && vertex == corners[1]);
+                count += seen ? 0 : 1;
+            }
+            return count;
+        };
+
+        for (size_t triangle = 0; triangle < index_count / 3; triangle++) {
+            const u32 *corners = &indices[triangle * 3];
+            u32 added = count_new_vertices(corners);
+
+            if (meshlet.vertex_count + added > max_vertices || meshlet.index_count / 3 + 1 > max_triangles) {
+                meshlets.push_back(meshlet);
+
+                meshlet = MeshletRange();
+                meshlet.index_offset = u32(triangle * 3);
+                meshlet_id++;
+                added = count_new_vertices(corners);
+            }
+
+            for (u32 corner = 0; corner < 3; corner++) {
+                owner[corners[corner]] = meshlet_id;
+            }
+
+            meshlet.vertex_count += added;
+            meshlet.index_count += 3;
+        }
+
+        if (meshlet.index_count > 0)
+            meshlets.push_back(meshlet);
+
+        return meshlets;
+    }
+
+    // == SIMPLIFICATION ================================
+
+    // Garland-Heckbert quadric, the summed squared distances to the planes of the surrounding triangles
+    // weighted by their area. Stores the symmetric matrix, the linear term and the constant.
+    struct Quadric {
+        f32 a00 = 0.0f, a11 = 0.0f, a22 = 0.0f, a10 = 0.0f, a20 = 0.0f, a21 = 0.0f;
+        f32 b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+        f32 c = 0.0f;
+        f32 weight = 0.0f;
+
+        void AddPlane(const f32 *normal, f32 distance, f32 plane_weight) {
+            a00 += plane_weight * normal[0] * normal[0];
+            a11 += plane_weight * normal[1] * normal[1];
+            a22 += plane_weight * normal[2] * normal[2];
+            a10 += plane_weight * normal[1] * normal[0];
+            a20 += plane_weight * normal[2] * normal[0];
+            a21 += plane_weight * normal[2] * normal[1];
+            b0 += plane_weight * distance * normal[0];
+            b1 += plane_weight * distance * normal[1];
+            b2 += plane_weight * distance * normal[2];
+            c += plane_weight * distance * distance;
+            weight += plane_weight;
+        }
+
+        void Add(const Quadric &other) {
+            a00 += other.a00, a11 += other.a11, a22 += other.a22;
+            a10 += other.a10, a20 += other.a20, a21 += other.a21;
+            b0 += other.b0, b1 += other.b1, b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        // Mean squared distance of p to the planes
+        f32 Error(const f32 *p) const {
+            const f32 rx = a00 * p[0] + a10 * p[1] + a20 * p[2];
+            const f32 ry = a10 * p[0] + a11 * p[1] + a21 * p[2];
+            const f32 rz = a20 * p[0] + a21 * p[1] + a22 * p[2];
+            const f32 error = rx * p[0] + ry * p[1] + rz * p[2] + 2.0f * (b0 * p[0] + b1 * p[1] + b2 * p[2]) + c;
+            return weight > 0.0f ? fabsf(error) / weight : 0.0f;
+        }
+    };
+
+    static void CrossProduct(const f32 *p0, const f32 *p1, const f32 *p2, f32 *normal) {
+        const f32 e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        const f32 e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    struct EdgeCollapse {
+        u32 from = 0;
+        u32 to = 0;
+        f32 error = 0.0f;
+    };
+
+    size_t SimplifyMesh(
+        u32 *destination,
+        const u32 *indices,
+        size_t index_count,
+        const f32 *positions,
+        size_t vertex_count,
+        size_t vertex_stride,
+        size_t target_index_count,
+        f32 target_error,
+        f32 *error) {
+
+        assert(index_count % 3 == 0);
+        assert(vertex_stride % sizeof(f32) == 0);
+
+        std::vector<u32> result(indices, indices + index_count);
+        if (error)
+            *error = 0.0f;
+
+        std::vector<bool> referenced(vertex_count, false);
+        for (size_t i = 0; i < index_count; i++) {
+            referenced[indices[i]] = true;
+        }
+
+        // Work in the unit cube so the f32 quadrics keep their precision on large meshes
+        f32 min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+        f32 max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        for (size_t vertex = 0; vertex < vertex_count; vertex++) {
+            const f32 *position = positions + vertex * (vertex_stride / sizeof(f32));
+            for (u32 axis = 0; axis < 3 && referenced[vertex]; axis++) {
+                min[axis] = std::min(min[axis], position[axis]);
+                max[axis] = std::max(max[axis], position[axis]);
+            }
+        }
+
+        f32 extent = std::max(max[0] - min[0], std::max(max[1] - min[1], max[2] - min[2]));
+        extent = extent > 0.0f ? extent : 1.0f;
+
+        std::vector<f32> scaled(vertex_count * 3, 0.0f);
+        for (size_t vertex = 0; vertex < vertex_count && index_count > 0; vertex++) {
+            const f32 *position = positions + vertex * (vertex_stride / sizeof(f32));
+            for (u32 axis = 0; axis < 3; axis++) {
+                scaled[vertex * 3 + axis] = (position[axis] - min[axis]) / extent;
+            }
+        }
+
+        // Vertices sharing a position with another one sit on an attribute seam, moving them would tear it open
+        std::vector<u32> by_position;
+        for (size_t vertex = 0; vertex < vertex_count; vertex++) {
+            if (referenced[vertex])
+                by_position.push_back(u32(vertex));
+        }
+
+        std::sort(by_position.begin(), by_position.end(), [&](u32 a, u32 b) {
+            return std::lexicographical_compare(&scaled[a * 3], &scaled[a * 3 + 3], &scaled[b * 3], &scaled[b * 3 + 3]);
+        });
+
+        std::vector<u32> position_id(vertex_count, 0);
+        std::vector<bool> locked(vertex_count, false);
+        for (size_t begin = 0, end = 0; begin < by_position.size(); begin = end) {
+            end = begin + 1;
+            while (end < by_position.size() &&
+                   memcmp(&scaled[by_position[begin] * 3], &scaled[by_position[end] * 3], 3 * sizeof(f32)) == 0) {
+                end++;
+            }
+
+            for (size_t i = begin; i < end; i++) {
+                position_id[by_position[i]] = by_position[begin];
+                locked[by_position[i]] = end - begin > 1;
+            }
+        }
+
+        // Edges without exactly one opposite twin are borders or non-manifold, their vertices stay in place
+        std::unordered_map<u64, u32> directed_edges;
+        auto edge_key = [&](u32 a, u32 b) { return (u64(position_id[a]) << 32) | position_id[b]; };
+
+        for (size_t i = 0; i < index_count; i += 3) {
+            for (u32 corner = 0; corner < 3; corner++) {
+                directed_edges[edge_key(indices[i + corner], indices[i + (corner + 1) % 3])]++;
+            }
+        }
+
+        for (size_t i = 0; i < index_count; i += 3) {
+            for (u32 corner = 0; corner < 3; corner++) {
+                const u32 a = indices[i + corner];
+                const u32 b = indices[i + (corner + 1) % 3];
+                auto twin = directed_edges.find(edge_key(b, a));
+                if (directed_edges[edge_key(a, b)] != 1 || twin == directed_edges.end() || twin->second != 1) {
+                    locked[a] = true;
+                    locked[b] = true;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertex_count);
+        // Source triangle planes, each vertex keeps the sorted ids of the ones its collapses swept over
+        std::vector<f32> planes(index_count / 3 * 4);
+        std::vector<std::vector<u32>> vertex_planes(vertex_count);
+        for (size_t i = 0; i < index_count; i += 3) {
+            const f32 *p0 = &scaled[indices[i + 0] * 3];
+            f32 normal[3];
+            CrossProduct(p0, &scaled[indices[i + 1] * 3], &scaled[indices[i + 2] * 3], normal);
+
+            const f32 length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length <= 0.0f)
+                continue;
+
+            for (u32 axis = 0; axis < 3; axis++) {
+                normal[axis] /= length;
+            }
+
+            const f32 distance = -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]);
+            for (u32 corner = 0; corner < 3; corner++) {
+                quadrics[indices[i + corner]].AddPlane(normal, distance, length * 0.5f);
+                vertex_planes[indices[i + corner]].push_back(u32(i / 3));
+            }
+
+            memcpy(&planes[i / 3 * 4], normal, 3 * sizeof(f32));
+            planes[i / 3 * 4 + 3] = distance;
+        }
+
+        // The quadric error is a mean, collapses are ordered by it but accepted by their largest deviation
+        const f32 deviation_limit = target_error / extent;
+        const f32 error_limit = deviation_limit * deviation_limit;
+        f32 max_deviation = 0.0f;
+
+        // Largest distance of the collapsed position to the planes around either end
+        auto deviation = [&](u32 from, u32 to) {
+            const f32 *p = &scaled[to * 3];
+            f32 largest = 0.0f;
+            for (const auto *ids : {&vertex_planes[from], &vertex_planes[to]}) {
+                for (const u32 id : *ids) {
+                    const f32 *plane = &planes[id * 4];
+                    largest = std::max(largest, fabsf(plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2] + plane[3]));
+                }
+            }
+            return largest;
+        };
+        std::vector<u32> merged_planes;
+
+        std::vector<u32> remap(vertex_count);
+        std::vector<bool> touched(vertex_count);
+        std::vector<u32> adjacency_offsets(vertex_count + 1);
+        std::vector<u32> adjacency;
+        std::vector<EdgeCollapse> collapses;
+
+        // Collapses stay valid while neither end moves, so every pass takes the cheapest independent ones
+        while (result.size() > target_index_count) {
+            std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+            for (const u32 vertex : result) {
+                adjacency_offsets[vertex + 1]++;
+            }
+            for (size_t vertex = 0; vertex < vertex_count; vertex++) {
+                adjacency_offsets[vertex + 1] += adjacency_offsets[vertex];
+            }
+
+            adjacency.resize(result.size());
+            std::vector<u32> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++) {
+                adjacency[fill[result[i]]++] = u32(i / 3);
+            }
+
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (u32 corner = 0; corner < 3; corner++) {
+                    const u32 a = result[i + corner];
+                    const u32 b = result[i + (corner + 1) % 3];
+
+                    for (const auto &[from, to] : {std::make_pair(a, b), std::make_pair(b, a)}) {
+                        if (locked[from])
+                            continue;
+
+                        Quadric combined = quadrics[from];
+                        combined.Add(quadrics[to]);
+                        collapses.push_back({from, to, combined.Error(&scaled[to * 3])});
+                    }
+                }
+            }
+
+            if (collapses.empty())
+                break;
+
+            std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse &a, const EdgeCollapse &b) {
+                return a.error < b.error;
+            });
+
+            for (size_t vertex = 0; vertex < vertex_count; vertex++) {
+                remap[vertex] = u32(vertex);
+            }
+            std::fill(touched.begin(), touched.end(), false);
+
+            // Flipping any remaining triangle around from rejects the collapse, positions follow this pass's remap
+            auto flips = [&](u32 from, u32 to) {
+                for (u32 k = adjacency_offsets[from]; k < adjacency_offsets[from + 1]; k++) {
+                    const u32 *corners = &result[adjacency[k] * 3];
+                    if (corners[0] == to || corners[1] == to || corners[2] == to)
+                        continue;
+
+                    const f32 *before[3], *after[3];
+                    for (u32 corner = 0; corner < 3; corner++) {
+                        before[corner] = &scaled[remap[corners[corner]] * 3];
+                        after[corner] = corners[corner] == from ? &scaled[to * 3] : before[corner];
+                    }
+
+                    f32 n0[3], n1[3];
+                    CrossProduct(before[0], before[1], before[2], n0);
+                    CrossProduct(after[0], after[1], after[2], n1);
+                    if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0f)
+                        return true;
+                }
+                return false;
+            };
+
+            size_t triangle_count = result.size() / 3;
+            size_t collapsed = 0;
+
+            for (const auto &collapse : collapses) {
+                // The mean squared distance never exceeds the largest one squared
+                if (collapse.error > error_limit || triangle_count * 3 <= target_index_count)
+                    break;
+
+                if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to))
+                    continue;
+
+                const f32 collapse_deviation = deviation(collapse.from, collapse.to);
+                if (collapse_deviation > deviation_limit)
+                    continue;
+
+                remap[collapse.from] = collapse.to;
+                touched[collapse.from] = true;
+                touched[collapse.to] = true;
+                quadrics[collapse.to].Add(quadrics[collapse.from]);
+                max_deviation = std::max(max_deviation, collapse_deviation);
+
+                std::vector<u32> &from_planes = vertex_planes[collapse.from];
+                std::vector<u32> &to_planes = vertex_planes[collapse.to];
+                merged_planes.clear();
+                std::set_union(from_planes.begin(), from_planes.end(), to_planes.begin(), to_planes.end(),
+                               std::back_inserter(merged_planes));
+                to_planes.swap(merged_planes);
+                from_planes = std::vector<u32>();
+
+                // An interior collapse removes the two triangles on the edge
+                triangle_count -= std::min<size_t>(triangle_count, 2);
+                collapsed++;
+            }
+
+            if (collapsed == 0)
+                break;
+
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3) {
+                const u32 a = remap[result[i + 0]];
+                const u32 b = remap[result[i + 1]];
+                const u32 c = remap[result[i + 2]];
+                if (a == b || b == c || c == a)
+                    continue;
+
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (error)
+            *error = max_deviation * extent;
+
+        memcpy(destination, result.data(), result.size() * sizeof(u32));
+        return result.size();
+    }
+
+    // == VERTEX FETCH =================================
+
+    size_t OptimizeVertexFetch(void *vertices, u32 *indices, size_t index_count, size_t vertex_count, size_t vertex_size) {
+        static constexpr u32 UNUSED = ~0u;
+
+        std::vector<u32> remap(vertex_count, UNUSED);
+        u32 next = 0;
+
+        for (size_t i = 0; i < index_count; i++) {
+            u32 &target = remap[indices[i]];
+            if (target == UNUSED)
+                target = next++;
+            indices[i] = target;
+        }
+
+        std::vector<u8> source((const u8 *)vertices, (const u8 *)vertices + vertex_count * vertex_size);
+        for (size_t vertex = 0; vertex < vertex_count; vertex++) {
+            if (remap[vertex] != UNUSED)
+                memcpy((u8 *)vertices + remap[vertex] * vertex_size, &source[vertex * vertex_size], vertex_size);
+        }
+
+        return next;
+    }
+
+} // namespace Renderer
+} // namespace Squid
@@ -0,0 +1,121 @@
+#include <Renderer/MipChain.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define SQUID_MIPCHAIN_SSE2
+#endif
+
+namespace Squid {
+namespace Renderer {
+
+    static void DownsampleRGBA8(const u8 *src, u32 src_w, u32 src_h, u8 *dst, u32 dst_w, u32 dst_h) {
+        for (u32 y = 0; y < dst_h; y++) {
+            const u32 y0 = y * 2 < src_h ? y * 2 : src_h - 1;
+            const u32 y1 = y * 2 + 1 < src_h ? y * 2 + 1 : src_h - 1;
+            const u8 *row0 = src + u64(y0) * src_w * 4;
+            const u8 *row1 = src + u64(y1) * src_w * 4;
+            u8 *out = dst + u64(y) * dst_w * 4;
+
+            u32 x = 0;
+#ifdef SQUID_MIPCHAIN_SSE2
+            // Two destination pixels per iteration from a 4x2 source footprint
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(2);
+            for (; x + 1 < dst_w && x * 2 + 3 < src_w; x += 2) {
+                __m128i a = _mm_loadu_si128((const __m128i *)(row0 + x * 8));
+                __m128i b = _mm_loadu_si128((const __m128i *)(row1 + x * 8));
+
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+                __m128i sum = _mm_unpacklo_epi64(lo, hi);
+                sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+                _mm_storel_epi64((__m128i *)(out + x * 4), _mm_packus_epi16(sum, zero));
+            }
+#endif
+            for (; x < dst_w; x++) {
+                const u32 x0 = x * 2 < src_w ? x * 2 : src_w - 1;
+                const u32 x1 = x * 2 + 1 < src_w ? x * 2 + 1 : src_w - 1;
+                for (u32 c = 0; c < 4; c++) {
+                    u32 sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+                    out[x * 4 + c] = u8((sum + 2) >> 2);
+                }
+            }
+        }
+    }
+
+    static void DownsampleRGBA32F(const f32 *src, u32 src_w, u32 src_h, f32 *dst, u32 dst_w, u32 dst_h) {
+        for (u32 y = 0; y < dst_h; y++) {
+            const u32 y0 = y * 2 < src_h ? y * 2 : src_h - 1;
+            const u32 y1 = y * 2 + 1 < src_h ? y * 2 + 1 : src_h - 1;
+            const f32 *row0 = src + u64(y0) * src_w * 4;
+            const f32 *row1 = src + u64(y1) * src_w * 4;
+            f32 *out = dst + u64(y) * dst_w * 4;
+
+            for (u32 x = 0; x < dst_w; x++) {
+                const u32 x0 = x * 2 < src_w ? x * 2 : src_w - 1;
+                const u32 x1 = x * 2 + 1 < src_w ? x * 2 + 1 : src_w - 1;
+#ifdef SQUID_MIPCHAIN_SSE2
+                __m128 sum = _mm_add_ps(_mm_loadu_ps(row0 + x0 * 4), _mm_loadu_ps(row0 + x1 * 4));
+                sum = _mm_add_ps(sum, _mm_add_ps(_mm_loadu_ps(row1 + x0 * 4), _mm_loadu_ps(row1 + x1 * 4)));
+                _mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+                for (u32 c = 0; c < 4; c++) {
+                    out[x * 4 + c] = (row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c]) * 0.25f;
+                }
+#endif
+            }
+        }
+    }
+
+    MipChain BuildMipChain(const void *pixels, u32 width, u32 height, RHI::Format format) {
+        const bool is_float = format == RHI::FORMAT_R32G32B32A32_FLOAT;
+        const bool is_byte = format == RHI::FORMAT_R8G8B8A8_UNORM || format == RHI::FORMAT_R8G8B8A8_UNORM_SRGB ||
+                             format == RHI::FORMAT_B8G8R8A8_UNORM || format == RHI::FORMAT_B8G8R8A8_UNORM_SRGB;
+
+        if (!is_float && !is_byte) {
+            throw std::runtime_error("unsupported mip chain format!");
+        }
+
+        MipChain chain;
+        chain.format = format;
+        chain.width = width;
+        chain.height = height;
+        chain.mip_count = RHI::GetMipCount(width, height);
+        chain.data.resize(chain.GetSize(0, chain.mip_count));
+        chain.offsets.resize(chain.mip_count);
+
+        u64 offset = 0;
+        for (u32 mip = 0; mip < chain.mip_count; mip++) {
+            chain.offsets[mip] = offset;
+            offset += RHI::GetMipSize(format, width, height, mip);
+        }
+
+        memcpy(chain.data.data(), pixels, RHI::GetMipSize(format, width, height, 0));
+
+        for (u32 mip = 1; mip < chain.mip_count; mip++) {
+            const u32 src_w = RHI::GetMipDimension(width, mip - 1);
+            const u32 src_h = RHI::GetMipDimension(height, mip - 1);
+            const u32 dst_w = RHI::GetMipDimension(width, mip);
+            const u32 dst_h = RHI::GetMipDimension(height, mip);
+
+            u8 *src = chain.data.data() + chain.offsets[mip - 1];
+            u8 *dst = chain.data.data() + chain.offsets[mip];
+
+            if (is_float) {
+                DownsampleRGBA32F((const f32 *)src, src_w, src_h, (f32 *)dst, dst_w, dst_h);
+            } else {
+                DownsampleRGBA8(src, src_w, src_h, dst, dst_w, dst_h);
+            }
+        }
+
+        return chain;
+    }
+
+} // namespace Renderer
+} // namespace Squid
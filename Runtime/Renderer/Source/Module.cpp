@@ -1,11 +1,13 @@
+#include <algorithm>
 #include <array>
 
 #include <Renderer/Module.h>
 #include <Renderer/TextureImporter.h>
 
 #include <Core/Log.h>
+#include <Core/Memory/MemoryTracker.h>
 #include <Core/Profiling.h>
-#include <Core/FileSystem.h>
+#include <Core/IO/VirtualFileSystem.h>
 #include <EditorCore/Module.h>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -15,11 +17,20 @@ namespace Squid {
 namespace Renderer {
 
     Module::~Module() {
+        Core::EventDispatcher &events = Core::GetEventDispatcher();
+        events.Unsubscribe<&Module::OnWindowResize>(this);
+        events.Unsubscribe<&Module::OnAssetReload>(this);
+
         // device->UnloadHandle(swapchain);
+        hot_reload.reset();
+        streamer.reset();
+        culler.reset();
         device.reset();
     };
 
     bool Module::Initialize() {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RENDERER);
+
         rhi = context->GetModule<RHI::Module>("RHI");
 
         scene = Core::SceneGraph();
@@ -35,10 +46,10 @@ namespace Renderer {
         auto mt2 = scene.transforms.Create(model2);
         auto mt3 = scene.transforms.Create(model3);
 
-        scene.transforms.GetComponent(root)->name = std::string("Root");
-        scene.transforms.GetComponent(model)->name = std::string("Model");
-        scene.transforms.GetComponent(model2)->name = std::string("Model2");
-        scene.transforms.GetComponent(model3)->name = std::string("Model3");
+        scene.names.Create(root)->name = std::string("Root");
+        scene.names.Create(model)->name = std::string("Model");
+        scene.names.Create(model2)->name = std::string("Model2");
+        scene.names.Create(model3)->name = std::string("Model3");
 
         scene.Attach(model, root);
         scene.Attach(model2, model);
@@ -54,34 +65,33 @@ namespace Renderer {
         float time =
             std::chrono::duration<float, std::chrono::seconds::period>(current_time - start_time).count() * 0.1;
 
-        UniformBufferObject ubo = {};
+        ubo = {};
 
+        // The model transform drives both the draw and its bounds in the scene BVH
         auto t = scene.transforms.GetComponent(model);
-        // t->Scale(glm::vec3(0, 0, 0));
-        t->scale_local = glm::vec3(15.0, 15.0, 15.0);
-        t->Rotate(glm::vec3(0.0f, 0.00, 0.001));
-        t->UpdateTransform();
-
-        // ubo.model = scene.transforms.GetComponent(model)->world;
-        ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        ubo.model = glm::scale(ubo.model, glm::vec3(2.0, 2.0, 2.0));
+        t->scale_local = glm::vec3(2.0f, 2.0f, 2.0f);
+        t->rotation_local = glm::angleAxis(time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        t->SetDirty();
+        scene.Update();
+
+        ubo.model = t->world;
         ubo.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
         ubo.proj = glm::perspective(glm::radians(45.0f), (float)frame_height / (float)frame_width, 0.1f, 1000.0f);
         ubo.proj[1][1] *= -1;
         ubo.camera_pos = glm::vec3(2.0f, 2.0f, 2.0f);
-
-        void *ubo_data = device->MapBuffer(ubo_handle);
-        memcpy(ubo_data, &ubo, sizeof(ubo));
-        device->UnmapBuffer(ubo_handle);
     }
 
     void Module::ResizeRenderTargets() {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RENDERER);
+
         device->UnloadTexture(frame_composition);
 
         device->LoadTexture(frame_composition);
     }
 
     void Module::CreateRenderer(void *win) {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RENDERER);
+
         this->win = win;
 
         auto adapters = rhi->EnumerateAdapters();
@@ -100,17 +110,38 @@ namespace Renderer {
 
         TextureImporter importer = TextureImporter(device.get(), transfer_list);
 
-        std::array<const std::string, 6> env_files = {"Assets/Textures/px_1k.hdr", "Assets/Textures/nx_1k.hdr",
-                                                      "Assets/Textures/py_1k.hdr", "Assets/Textures/ny_1k.hdr",
-                                                      "Assets/Textures/pz_1k.hdr", "Assets/Textures/nz_1k.hdr"};
-
-        RHI::TextureHandle env_map = importer.FromEnvFile(env_files, "Env map");
-
-        RHI::TextureHandle glock_albedo = importer.FromFile(
-            "Assets/Textures/Glock_01_Albedo.png", "Glock Albedo", RHI::FORMAT_R8G8B8A8_UNORM_SRGB); // sRGB space
-
-        RHI::TextureHandle glock_normal = importer.FromFile(
-            "Assets/Textures/Glock_01_Normal.png", "Glock Normal", RHI::FORMAT_R8G8B8A8_UNORM); // Linear space
+        // BC6H with a full mip chain instead of 96 MB of RGBA32F, devices without BC get the uncompressed cube
+        const bool compressed = device->IsFormatSupported(RHI::FORMAT_BC6H_UF16) &&
+                                device->IsFormatSupported(RHI::FORMAT_BC7_UNORM_SRGB) &&
+                                device->IsFormatSupported(RHI::FORMAT_BC7_UNORM);
+
+        // Textures needed before the first frame load in one batch, the six faces decode in parallel
+        TextureImport env_import;
+        env_import.files = {"Assets/Textures/px_1k.hdr", "Assets/Textures/nx_1k.hdr", "Assets/Textures/py_1k.hdr",
+                            "Assets/Textures/ny_1k.hdr", "Assets/Textures/pz_1k.hdr", "Assets/Textures/nz_1k.hdr"};
+        env_import.name = "Env map";
+        env_import.format = compressed ? RHI::FORMAT_BC6H_UF16 : RHI::FORMAT_R32G32B32A32_FLOAT;
+        env_import.type = RHI::TextureHandle::Type::TEXTURE_CUBE;
+        env_import.cooked = "Assets/Textures/env_1k.sqtex";
+
+        const std::vector<RHI::TextureHandle> startup_textures = importer.FromFiles({env_import});
+        const RHI::TextureHandle &env_map = startup_textures[0];
+
+        // Streamed from the 1x1 mip up, placeholders go out with the importer upload
+        streamer = std::make_unique<TextureStreamer>(device.get());
+
+        glock_albedo = streamer->Stream(
+            transfer_list,
+            "Assets/Textures/Glock_01_Albedo.png",
+            "Glock Albedo",
+            compressed ? RHI::FORMAT_BC7_UNORM_SRGB : RHI::FORMAT_R8G8B8A8_UNORM_SRGB); // sRGB space
+
+        glock_normal = streamer->Stream(
+            transfer_list,
+            "Assets/Textures/Glock_01_Normal.png",
+            "Glock Normal",
+            compressed ? RHI::FORMAT_BC7_UNORM : RHI::FORMAT_R8G8B8A8_UNORM,
+            0xffff8080); // Linear space, flat normal placeholder, BC5 needs z reconstruction in the shader
 
         importer.Upload();
 
@@ -210,36 +241,190 @@ namespace Renderer {
         gfx_pipe.vertex_layout.inputs[0].type = RHI::VertexType::FLOAT3;
         gfx_pipe.vertex_layout.inputs[0].offset = offsetof(MeshVertex, position);
         gfx_pipe.vertex_layout.inputs[1].binding = 1;
-        gfx_pipe.vertex_layout.inputs[1].type = RHI::VertexType::FLOAT3;
+        gfx_pipe.vertex_layout.inputs[1].type = RHI::VertexType::SNORM8_4;
         gfx_pipe.vertex_layout.inputs[1].offset = offsetof(MeshVertex, normal);
         gfx_pipe.vertex_layout.inputs[2].binding = 2;
-        gfx_pipe.vertex_layout.inputs[2].type = RHI::VertexType::FLOAT3;
+        gfx_pipe.vertex_layout.inputs[2].type = RHI::VertexType::UNORM8_4;
         gfx_pipe.vertex_layout.inputs[2].offset = offsetof(MeshVertex, color);
         gfx_pipe.vertex_layout.inputs[3].binding = 3;
-        gfx_pipe.vertex_layout.inputs[3].type = RHI::VertexType::FLOAT2;
+        gfx_pipe.vertex_layout.inputs[3].type = RHI::VertexType::HALF2;
         gfx_pipe.vertex_layout.inputs[3].offset = offsetof(MeshVertex, uv0);
-        gfx_pipe.vertex_shader = Core::ReadTextFile("Assets/Shaders/unlit.vert.spv");
-        gfx_pipe.pixel_shader = Core::ReadTextFile("Assets/Shaders/unlit.frag.spv");
+        gfx_pipe.vertex_shader = Core::GetFileSystem().ReadTextFile("Assets/Shaders/unlit.vert.spv");
+        gfx_pipe.pixel_shader = Core::GetFileSystem().ReadTextFile("Assets/Shaders/unlit.frag.spv");
         gfx_pipe.descriptor_sets = descriptor_set_handles;
         gfx_pipe.primitive_restart = false;
         device->LoadPipeline(gfx_pipe);
 
         mesh = std::make_unique<Mesh>("Assets/Models/Glock_01.obj");
         mesh->LoadOnDevice(device);
+
+        const MeshBounds &mesh_bounds = mesh->GetBounds();
+        Core::BoundsComponent *bounds = scene.bounds.GetComponent(model);
+        if (bounds == nullptr)
+            bounds = scene.bounds.Create(model);
+        bounds->SetLocalBounds(
+            glm::vec3(mesh_bounds.min[0], mesh_bounds.min[1], mesh_bounds.min[2]),
+            glm::vec3(mesh_bounds.max[0], mesh_bounds.max[1], mesh_bounds.max[2]));
+
+        culler = std::make_unique<ClusterCuller>(device.get(), *mesh, "Assets/Shaders/cluster_cull.comp.spv");
+
+        // Same programs as Assets/Shaders/compile.bat
+        hot_reload = std::make_unique<HotReload>(device.get());
+        hot_reload->Watch(
+            gfx_pipe,
+            {"Assets/Shaders/unlit.hlsl", "mainVS", "vs_6_4", "Assets/Shaders/unlit.vert.spv"},
+            {"Assets/Shaders/unlit.hlsl", "mainPS", "ps_6_4", "Assets/Shaders/unlit.frag.spv"});
+        if (RHI::ComputePipelineHandle *pipeline = culler->GetPipeline()) {
+            hot_reload->Watch(
+                *pipeline,
+                {"Assets/Shaders/cluster_cull.hlsl", "mainCS", "cs_6_4", "Assets/Shaders/cluster_cull.comp.spv"});
+        }
+
+        Core::EventDispatcher &events = Core::GetEventDispatcher();
+        events.Subscribe<&Module::OnWindowResize>(this);
+        events.Subscribe<&Module::OnAssetReload>(this);
+    }
+
+    Core::Entity Module::Pick(f32 x, f32 y) const {
+        // Any point on the far side of the pixel gives the direction from the camera
+        const glm::mat4 inverse_view_projection = glm::inverse(ubo.proj * ubo.view);
+        const glm::vec4 point = inverse_view_projection * glm::vec4(x * 2.0f - 1.0f, y * 2.0f - 1.0f, 1.0f, 1.0f);
+        const glm::vec3 direction = glm::vec3(point) / point.w - ubo.camera_pos;
+
+        return scene.RayCast(ubo.camera_pos, glm::normalize(direction), PICK_MAX_DISTANCE);
+    }
+
+    void Module::OnWindowResize(const Core::WindowResizeEvent *events, u32 count) {
+        // Only the last size matters, the swapchain takes it from the surface
+        swapchain_dirty = true;
     }
 
-    void Module::Event() {}
+    void Module::OnAssetReload(const Core::AssetReloadEvent *events, u32 count) {
+        for (u32 i = 0; i < count; i++) {
+            if (events[i].status != Core::FileStatus::DELETED)
+                reloaded_assets.push_back(events[i].path);
+        }
+    }
 
     void Module::Tick(float delta) {
+        Update(tick_snapshot);
+        BeginFrame(tick_snapshot);
+        Render(tick_snapshot);
+        EndFrame();
+    }
+
+    void Module::Update(RenderSnapshot &snapshot) {
         PROFILING_SCOPE
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RENDERER);
+
+        snapshot.rebuild_swapchain = swapchain_dirty;
+        snapshot.resize_render_targets = resize;
+        swapchain_dirty = false;
+        resize = false;
+
+        // The snapshot's old list was handled two frames ago, its capacity comes back for the next reloads
+        snapshot.reloaded_assets.swap(reloaded_assets);
+        reloaded_assets.clear();
 
         {
             PROFILING_NAMED_SCOPE("Upadate Renderer UBO")
             UpdateUBO();
         }
+        snapshot.ubo = ubo;
+
+        // Entities inside the camera frustum this frame
+        Core::FrameVector<Core::Entity> visible_entities(Core::GetFrameAllocator());
+        {
+            PROFILING_NAMED_SCOPE("Frustum Culling")
+
+            glm::vec4 planes[6];
+            Core::ExtractFrustumPlanes(ubo.proj * ubo.view, planes);
+            scene.CullFrustum(planes, visible_entities);
+        }
+
+        // The old list went away with its frame slot
+        snapshot.draws = Core::FrameVector<RenderDraw>(Core::GetFrameAllocator());
+        snapshot.texture_coverage = 0.0f;
+
+        // No texture requests, LOD selection or draws while the model is off screen
+        const bool model_visible =
+            std::find(visible_entities.begin(), visible_entities.end(), model) != visible_entities.end();
+        if (!model_visible)
+            return;
+
+        // Nearest point of the bounding sphere as seen from the snapshot camera, the LOD errors scale with the model
+        const MeshBounds &bounds = mesh->GetBounds();
+        const glm::vec3 center =
+            glm::vec3(ubo.model * glm::vec4(bounds.center[0], bounds.center[1], bounds.center[2], 1.0f));
+        const f32 scale = std::max(
+            glm::length(glm::vec3(ubo.model[0])),
+            std::max(glm::length(glm::vec3(ubo.model[1])), glm::length(glm::vec3(ubo.model[2]))));
+
+        const f32 distance = glm::length(center - ubo.camera_pos) - bounds.radius * scale;
+        const f32 projected_scale = GetProjectedScale(f32(frame_height), glm::radians(45.0f), distance) * scale;
+
+        // Textures are requested at the projected diameter of the bounds, full size with the camera inside them
+        snapshot.texture_coverage = distance > 0.0f ? 2.0f * bounds.radius * projected_scale : f32(frame_height);
+
+        {
+            PROFILING_NAMED_SCOPE("LOD Selection")
+
+            const auto &lods = mesh->GetLods();
+            mesh_lod = SelectLod(
+                lods.data(), u32(lods.size()), projected_scale, LOD_MAX_PIXEL_ERROR, LOD_HYSTERESIS, mesh_lod);
+        }
+
+        snapshot.draws.push_back({ubo.model, mesh_lod});
+    }
+
+    void Module::BeginFrame(RenderSnapshot &snapshot) {
+        PROFILING_SCOPE
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RENDERER);
+
+        if (snapshot.rebuild_swapchain)
+            device->RebuildSwapchain(swapchain);
+        if (snapshot.resize_render_targets)
+            ResizeRenderTargets();
+
+        device->BeginFrameEXP(swapchain);
+    }
+
+    void Module::EndFrame() { device->EndFrameEXP(swapchain); }
+
+    void Module::Render(RenderSnapshot &snapshot) {
+        PROFILING_SCOPE
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RENDERER);
+
+        // Pipelines and textures are swapped before anything of this frame is recorded
+        hot_reload->Tick();
+        for (const std::string &file : snapshot.reloaded_assets) {
+            if (streamer->Reload(file))
+                LOG_INFO("reloading {}", file)
+        }
+
+        void *ubo_data = device->MapBuffer(ubo_handle);
+        memcpy(ubo_data, &snapshot.ubo, sizeof(snapshot.ubo));
+        device->UnmapBuffer(ubo_handle);
+
+        {
+            PROFILING_NAMED_SCOPE("Texture Streaming")
+
+            if (snapshot.texture_coverage > 0.0f) {
+                streamer->RequestCoverage(glock_albedo, snapshot.texture_coverage);
+                streamer->RequestCoverage(glock_normal, snapshot.texture_coverage);
+            }
+            streamer->Tick();
+        }
+
+        // The culler handles a single instance so far
+        const RenderDraw *draw = snapshot.draws.empty() ? nullptr : &snapshot.draws[0];
+        const UniformBufferObject &camera = snapshot.ubo;
 
         // Main frame render
         auto list = device->BeginCommandListEXP();
+        if (draw)
+            culler->Cull(list, draw->lod, draw->world, camera.proj * camera.view, camera.camera_pos);
+
         device->BeginRenderPassEXP(list, composition_pass);
         // Draw stuff
         RHI::Viewport vp;
@@ -250,8 +435,6 @@ namespace Renderer {
         vp.min_depth = 0.0f;
         vp.max_depth = 1.0f;
 
-        LOG("{} {}", this->frame_height, this->frame_width)
-
         RHI::Rect sc;
         sc.height = 1000;
         sc.width = 1000;
@@ -264,7 +447,8 @@ namespace Renderer {
         device->BindViewports(list, 1, &vp);
         device->BindScissorRects(list, 1, &sc);
         device->BindDescriptorSet(list, gfx_pipe, descriptor_set_handles[0], 0);
-        device->DrawIndexed(list, mesh->GetVerticesCount(), 0, 0);
+        if (draw)
+            culler->Draw(list);
 
         device->EndRenderPass(list);
     }
@@ -0,0 +1,252 @@
+#include <Renderer/TextureStreamer.h>
+#include <Renderer/BlockCompression.h>
+#include <Renderer/CookedTexture.h>
+#include <Core/Log.h>
+#include <Core/Memory/MemoryTracker.h>
+#include <Core/Profiling.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <stb_image.h>
+
+namespace Squid {
+namespace Renderer {
+
+    TextureStreamer::~TextureStreamer() {
+        // Pending decodes are joined by the future destructors
+        for (const auto &pending : pending_staging) {
+            device->Wait(pending.list);
+            device->UnloadBuffer(pending.buffer);
+        }
+    }
+
+    TextureHandle TextureStreamer::Stream(
+        const CommandList &list, const std::string &file, const std::string &name, Format format, u32 placeholder) {
+
+        PROFILING_SCOPE
+
+        // Block compressed formats stream from the cooked file, which is (re)cooked in the background
+        const bool compressed = GetFormatInfo(format).block_width > 1;
+        const std::string cooked = GetCookedTexturePath(file);
+        const bool stale = compressed && IsCookedTextureStale(cooked, {file}, format);
+
+        assert(format != FORMAT_BC6H_UF16 && format != FORMAT_BC6H_SF16);
+        assert(compressed || GetFormatInfo(format).block_size == sizeof(u32));
+
+        i32 width, height, channels;
+        if (compressed && !stale) {
+            CookedTextureHeader header = ReadCookedTextureHeader(cooked);
+            width = header.width;
+            height = header.height;
+        } else if (!stbi_info(file.c_str(), &width, &height, &channels)) {
+            throw std::runtime_error("failed to read texture image info!");
+        }
+
+        TextureHandle texture;
+        texture.height = height;
+        texture.width = width;
+        texture.depth = 1;
+        texture.format = format;
+        texture.mip_levels = GetMipCount(width, height);
+        texture.sample_count = 1;
+        texture.usage_flags = TextureHandle::Usage::SHADER_RESOURCE_VIEW;
+        texture.size = GetMipChainSize(format, width, height, 0, texture.mip_levels);
+        device->LoadTexture(texture);
+        device->SetName(texture, name);
+
+        // Placeholder in the 1x1 mip so the texture can be bound straight away
+        const u32 last_mip = texture.mip_levels - 1;
+        std::vector<u8> placeholder_data = compressed
+                                               ? CompressSurface(&placeholder, 1, 1, format)
+                                               : std::vector<u8>((u8 *)&placeholder, (u8 *)&placeholder + sizeof(u32));
+
+        BufferHandle staging;
+        staging.cpu_access = true;
+        staging.size = placeholder_data.size();
+        staging.usage = BufferHandle::Usage::TRANSFER_SRC;
+        device->LoadBuffer(staging);
+        pending_staging.push_back({staging, list});
+
+        void *data = device->MapBuffer(staging);
+        memcpy(data, placeholder_data.data(), placeholder_data.size());
+        device->UnmapBuffer(staging);
+
+        device->Copy(list, staging, texture, 0, last_mip, 1);
+        device->SetTextureBaseMip(texture, last_mip);
+
+        StreamedTexture streamed;
+        streamed.handle = texture;
+        streamed.resident_mip = last_mip;
+        streamed.file = file;
+        streamed.decode = Decode(file, format);
+
+        textures.push_back(std::move(streamed));
+
+        return texture;
+    }
+
+    std::future<MipChain> TextureStreamer::Decode(const std::string &file, Format format) {
+        return std::async(std::launch::async, [file, format]() {
+            Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_ASSETS);
+
+            // Block compressed formats are (re)cooked when the source is newer than the cooked file
+            if (GetFormatInfo(format).block_width > 1) {
+                const std::string cooked = GetCookedTexturePath(file);
+                if (IsCookedTextureStale(cooked, {file}, format))
+                    CookTexture({file}, cooked, format);
+                return ReadCookedMipChain(cooked);
+            }
+
+            i32 width, height, channels;
+            stbi_uc *pixels = stbi_load(file.c_str(), &width, &height, &channels, 4);
+
+            if (!pixels) {
+                throw std::runtime_error("failed to load texture image!");
+            }
+
+            MipChain chain = BuildMipChain(pixels, width, height, format);
+            stbi_image_free(pixels);
+            return chain;
+        });
+    }
+
+    bool TextureStreamer::Reload(const std::string &file) {
+        const std::filesystem::path path = std::filesystem::path(file).lexically_normal();
+
+        bool found = false;
+        for (auto &texture : textures) {
+            if (std::filesystem::path(texture.file).lexically_normal() != path)
+                continue;
+
+            // A decode still running is waited for here, the new one replaces it
+            texture.decode = Decode(texture.file, texture.handle.format);
+            texture.decoded = false;
+            found = true;
+        }
+        return found;
+    }
+
+    void TextureStreamer::RequestCoverage(const TextureHandle &texture, f32 pixels) {
+        auto it = std::find_if(textures.begin(), textures.end(), [&texture](const StreamedTexture &streamed) {
+            return streamed.handle.id == texture.id;
+        });
+
+        if (it == textures.end())
+            return;
+
+        const u32 last_mip = it->handle.mip_levels - 1;
+        const f32 size = f32(std::max(it->handle.width, it->handle.height));
+
+        if (pixels <= 1.0f) {
+            it->wanted_mip = last_mip;
+            return;
+        }
+
+        const f32 mip = std::floor(std::log2(size / pixels));
+        it->wanted_mip = mip <= 0.0f ? 0 : std::min(u32(mip), last_mip);
+    }
+
+    void TextureStreamer::UploadMips(StreamedTexture &texture, u32 base_mip, u32 mip_count) {
+        const u64 size = texture.chain.GetSize(base_mip, mip_count);
+
+        BufferHandle staging;
+        staging.cpu_access = true;
+        staging.size = size;
+        staging.usage = BufferHandle::Usage::TRANSFER_SRC;
+        device->LoadBuffer(staging);
+        pending_staging.push_back({staging, upload_list});
+
+        void *data = device->MapBuffer(staging);
+        memcpy(data, texture.chain.GetMip(base_mip), size);
+        device->UnmapBuffer(staging);
+
+        device->Copy(upload_list, staging, texture.handle, 0, base_mip, mip_count);
+        texture.resident_mip = base_mip;
+    }
+
+    void TextureStreamer::Tick() {
+        PROFILING_SCOPE
+
+        // Uploads are fenced, staging buffers go once their copies are done
+        auto done =
+            std::remove_if(pending_staging.begin(), pending_staging.end(), [this](const PendingStaging &pending) {
+                if (!device->IsComplete(pending.list))
+                    return false;
+                device->UnloadBuffer(pending.buffer);
+                return true;
+            });
+        pending_staging.erase(done, pending_staging.end());
+
+        bool recording = false;
+        std::vector<StreamedTexture *> refined;
+
+        for (auto &texture : textures) {
+            if (!texture.decoded) {
+                if (texture.decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                    continue;
+
+                try {
+                    texture.chain = texture.decode.get();
+                } catch (const std::exception &e) {
+                    // A reload of a half written or broken file keeps what is resident
+                    LOG_ERROR("failed to decode {}: {}", texture.file, e.what())
+                    texture.decoded = true;
+                    continue;
+                }
+                texture.decoded = true;
+
+                if (texture.chain.width != texture.handle.width || texture.chain.height != texture.handle.height) {
+                    LOG_WARN("{} changed size, restart to pick it up", texture.file)
+                    texture.chain = MipChain();
+                    continue;
+                }
+
+                if (!recording) {
+                    upload_list = device->BeginTransferList();
+                    recording = true;
+                }
+
+                // Everything up to TAIL_SIZE at once, replacing the placeholder as well
+                u32 tail_mip = 0;
+                while (std::max(GetMipDimension(texture.handle.width, tail_mip),
+                                GetMipDimension(texture.handle.height, tail_mip)) > TAIL_SIZE) {
+                    tail_mip++;
+                }
+                tail_mip = std::max(tail_mip, texture.wanted_mip);
+                // A reload replaces everything already resident at once
+                tail_mip = std::min(tail_mip, texture.resident_mip);
+
+                UploadMips(texture, tail_mip, texture.handle.mip_levels - tail_mip);
+                refined.push_back(&texture);
+            } else if (texture.resident_mip > texture.wanted_mip && !texture.chain.data.empty()) {
+                if (!recording) {
+                    upload_list = device->BeginTransferList();
+                    recording = true;
+                }
+
+                // One mip per texture per tick to keep the upload cost flat
+                UploadMips(texture, texture.resident_mip - 1, 1);
+                refined.push_back(&texture);
+            }
+        }
+
+        if (!recording)
+            return;
+
+        // Later frames are submitted to the same queue and see the copies without waiting here
+        device->QueueSubmit(QueueType::GRAPHICS, upload_list);
+
+        for (auto texture : refined) {
+            device->SetTextureBaseMip(texture->handle, texture->resident_mip);
+
+            // Fully resident, the cpu copy is no longer needed
+            if (texture->resident_mip == 0)
+                texture->chain = MipChain();
+        }
+    }
+
+} // namespace Renderer
+} // namespace Squid
@@ -43,6 +43,11 @@ namespace RHI {
             unique_queues.insert(gfx);
         }
 
+        if (handle.usage & BufferHandle::Usage::INDIRECT_BUFFER) {
+            create_info.usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+            unique_queues.insert(gfx);
+        }
+
         if (handle.usage & BufferHandle::Usage::UNIFORM_BUFFER) {
             create_info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
             unique_queues.insert(compute);
@@ -1,4 +1,5 @@
 #include "DescriptorSet.h"
+#include <Core/Memory/StlAllocator.h>
 
 namespace Squid {
 namespace RHI {
@@ -46,6 +47,7 @@ namespace RHI {
                 break;
             }
 
+            binding_types[descriptor.binding] = descriptor_binding.descriptorType;
             descriptor_bindings.push_back(descriptor_binding);
         }
 
@@ -124,7 +126,7 @@ namespace RHI {
                 descriptor_write.dstBinding = binding.first;
                 descriptor_write.dstArrayElement = 0;
                 descriptor_write.dstSet = descriptor_sets[index];
-                descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                descriptor_write.descriptorType = binding_types[binding.first];
                 descriptor_write.descriptorCount = 1;
                 descriptor_write.pBufferInfo = &descriptor_buffer_info;
                 descriptor_write.pImageInfo = nullptr;
@@ -161,43 +163,47 @@ namespace RHI {
 
     VkDescriptorSet VulkanDescriptorSet::GetDescriptorSet(uint32_t index, std::unordered_map<uint64_t, std::unique_ptr<VulkanTexture>> &textures) {
         if (dirty_sets[index]) {
+            Core::ScratchScope scratch;
+
+            // Infos are reserved up front, writes keep pointers into them
+            Core::ScratchVector<VkDescriptorBufferInfo> buffer_infos(scratch.GetAllocator());
+            buffer_infos.reserve(buffer_bindings.size());
+
+            Core::ScratchVector<VkWriteDescriptorSet> writes(scratch.GetAllocator());
+            writes.reserve(buffer_bindings.size() + 1);
 
-            std::vector<VkDescriptorBufferInfo> buffer_infos;
             for (const auto binding : buffer_bindings) {
                 VkDescriptorBufferInfo buffer_info = {};
                 buffer_info.buffer = binding.second->GetBuffer();
                 buffer_info.offset = 0;
                 buffer_info.range = binding.second->GetSize();
                 buffer_infos.push_back(buffer_info);
-            }
 
-            std::vector<VkDescriptorImageInfo> image_infos;
-            for (const auto binding : texture_bindings) {
-                VkDescriptorImageInfo image_info = {};
-                image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                image_info.imageView = textures[binding.second]->GetView();
-                image_info.sampler = textures[binding.second]->GetSampler();
-                image_infos.push_back(image_info);
-                dirty_sets[index] = false;
-            }
-
-            std::vector<VkWriteDescriptorSet> writes;
-
-            if (buffer_infos.size() > 0) {
                 VkWriteDescriptorSet descriptor_write = {};
                 descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
                 descriptor_write.dstSet = descriptor_sets[index];
-                descriptor_write.dstBinding = 0;
+                descriptor_write.dstBinding = binding.first;
                 descriptor_write.dstArrayElement = 0;
-                descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                descriptor_write.descriptorCount = buffer_infos.size();
-                descriptor_write.pBufferInfo = buffer_infos.data();
+                descriptor_write.descriptorType = binding_types[binding.first];
+                descriptor_write.descriptorCount = 1;
+                descriptor_write.pBufferInfo = &buffer_infos.back();
                 descriptor_write.pImageInfo = nullptr;
                 descriptor_write.pTexelBufferView = nullptr;
 
                 writes.push_back(descriptor_write);
             }
 
+            Core::ScratchVector<VkDescriptorImageInfo> image_infos(scratch.GetAllocator());
+            image_infos.reserve(texture_bindings.size());
+            for (const auto binding : texture_bindings) {
+                VkDescriptorImageInfo image_info = {};
+                image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                image_info.imageView = textures[binding.second]->GetView();
+                image_info.sampler = textures[binding.second]->GetSampler();
+                image_infos.push_back(image_info);
+                dirty_sets[index] = false;
+            }
+
             if (image_infos.size() > 0) {
                 VkWriteDescriptorSet descriptor_write = {};
                 descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -242,5 +248,11 @@ namespace RHI {
         dirty_sets[2] = true;
     }
 
+    void VulkanDescriptorSet::MarkDirty() {
+        dirty_sets[0] = true;
+        dirty_sets[1] = true;
+        dirty_sets[2] = true;
+    }
+
 } // namespace RHI
 } // namespace Squid
@@ -15,6 +15,8 @@ namespace RHI {
 
         void SetBuffer(uint32_t binding, VulkanBuffer *buffer);
         void SetTexture(uint32_t binding, const TextureHandle &handle);
+        // Forces a rewrite of all sets, e.g. when a bound texture view was recreated
+        void MarkDirty();
         // void Free(VkDescriptorSet descriptor_set);
         void Update(uint32_t index, std::unordered_map<uint64_t, std::unique_ptr<VulkanTexture>> &textures);
         VkDescriptorSet GetDescriptorSet(uint32_t index, std::unordered_map<uint64_t, std::unique_ptr<VulkanTexture>> &textures);
@@ -37,6 +39,8 @@ namespace RHI {
         VkDescriptorSetLayout descriptor_layout;
 
         std::unordered_map<uint32_t, VulkanBuffer *> buffer_bindings;
+        // Layout type of every binding, buffers are written as uniform or storage accordingly
+        std::unordered_map<uint32_t, VkDescriptorType> binding_types;
         std::unordered_map<uint32_t, uint32_t> texture_bindings;
         std::shared_ptr<RawDevice> raw_device;
         VulkanDevice *device;
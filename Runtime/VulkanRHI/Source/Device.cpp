@@ -1,4 +1,6 @@
 #include "Device.h"
+#include <Core/Memory/LinearAllocator.h>
+#include <Core/Memory/MemoryTracker.h>
 
 namespace Squid {
 namespace RHI {
@@ -39,10 +41,26 @@ namespace RHI {
             queue_create_infos.push_back(create_info);
         }
 
+        // Block compressed formats are used by cooked textures
+        VkPhysicalDeviceFeatures supported_features;
+        vkGetPhysicalDeviceFeatures(physical, &supported_features);
+
+        VkPhysicalDeviceFeatures enabled_features = {};
+        enabled_features.textureCompressionBC = supported_features.textureCompressionBC;
+        texture_compression_bc = supported_features.textureCompressionBC;
+
+        if (!supported_features.textureCompressionBC) {
+            LOG_WARN("BC texture compression is not supported by the device, textures fall back to uncompressed")
+        }
+
+        // Cluster culling draws every meshlet through one indirect call
+        enabled_features.multiDrawIndirect = supported_features.multiDrawIndirect;
+        multi_draw_indirect = supported_features.multiDrawIndirect;
+
         VkDeviceCreateInfo create_info = {};
         create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
-        create_info.pEnabledFeatures = nullptr;
+        create_info.pEnabledFeatures = &enabled_features;
         create_info.enabledLayerCount = 0;
         create_info.ppEnabledLayerNames = nullptr;
         create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
@@ -86,6 +104,8 @@ namespace RHI {
     // == Load handles ====================================================================
 
     void VulkanDevice::LoadSwapchain(const SwapchainHandle &handle) {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         assert(handle.id != INVALID_HANDLE_ID);
 
         auto swapchain = std::make_unique<VulkanSwapchain>(handle.window_handle, raw_instance, raw_device);
@@ -122,6 +142,8 @@ namespace RHI {
     };
 
     void VulkanDevice::LoadRenderTarget(const RenderTargetHandle &handle) {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         assert(handle.id != INVALID_HANDLE_ID);
 
         auto render_target = std::make_unique<VulkanRenderTarget>(raw_device, VkFormat::VK_FORMAT_UNDEFINED);
@@ -129,18 +151,27 @@ namespace RHI {
     };
 
     void VulkanDevice::LoadBuffer(const BufferHandle &handle) {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         assert(handle.id != INVALID_HANDLE_ID);
         auto queue_families = std::make_tuple(gfx_queue, compute_queue, transfer_queue);
         buffers.insert(std::pair(handle.id, std::make_unique<VulkanBuffer>(handle, queue_families, raw_device)));
     };
 
     void VulkanDevice::LoadTexture(const TextureHandle &handle) {
-    
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
+        if (GetFormatInfo(handle.format).block_width > 1 && !texture_compression_bc) {
+            throw std::runtime_error("block compressed textures are not supported by the device!");
+        }
+
         assert(handle.id != INVALID_HANDLE_ID);
         textures.insert(std::pair(handle.id, std::make_unique<VulkanTexture>(handle, raw_device)));
     };
 
     void VulkanDevice::LoadPipeline(const ComputePipelineHandle &handle) {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         assert(handle.id != INVALID_HANDLE_ID);
 
         std::vector<VkDescriptorSetLayout> layouts;
@@ -154,6 +185,8 @@ namespace RHI {
     };
 
     void VulkanDevice::LoadPipeline(const GraphicsPipelineHandle &handle) {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         assert(handle.id != INVALID_HANDLE_ID);
 
         VkRenderPass render_pass;
@@ -182,11 +215,15 @@ namespace RHI {
     };
 
     void VulkanDevice::LoadDescriptorSet(const DescriptorSetHandle &handle) {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         assert(handle.id != INVALID_HANDLE_ID);
         descriptor_sets.insert(std::pair(handle.id, std::make_unique<VulkanDescriptorSet>(handle, raw_device)));
     };
 
     void VulkanDevice::LoadRenderPass(const RenderPassHandle &handle) {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         assert(handle.id != INVALID_HANDLE_ID);
 
         VkResult res;
@@ -573,7 +610,7 @@ namespace RHI {
             uint32_t counter = 0;
 
             CommandList cmd;
-            while (context->active_commandlists.pop_front(cmd)) {
+            while (context->active_commandlists.Pop(cmd)) {
                 res = vkEndCommandBuffer(GetCommandBuffer(cmd));
                 assert(res == VK_SUCCESS);
 
@@ -581,7 +618,7 @@ namespace RHI {
                 cmds[counter] = cmd;
                 counter++;
 
-                context->free_commandlists.push_back(cmd);
+                context->free_commandlists.Push(cmd);
             }
 
             // Submit all used cmd list to queue
@@ -605,7 +642,7 @@ namespace RHI {
     };
 
     void VulkanDevice::ResizeTexture(const TextureHandle &handle, u32 width, u32 height) {
-        LOG("resize texture")
+        LOG_DEBUG_EVERY(1000, "resize texture")
 
         auto &context = swap_contexts[current_backbuffer_id];
 
@@ -616,6 +653,20 @@ namespace RHI {
         // descriptor_sets[texture_binding.first]->SetTexture(texture_binding.second, handle);
     };
 
+    void VulkanDevice::SetTextureBaseMip(const TextureHandle &handle, u32 base_mip) {
+        assert(this->HasTexture(handle));
+
+        textures[handle.id]->SetBaseMip(handle, base_mip);
+
+        // Sets holding the old view are rewritten on their next use
+        auto range = texture_bindings.equal_range(handle.id);
+        for (auto it = range.first; it != range.second; ++it) {
+            auto set = descriptor_sets.find(it->second.first);
+            if (set != descriptor_sets.end())
+                set->second->MarkDirty();
+        }
+    }
+
     void *VulkanDevice::MapBuffer(const BufferHandle &handle) {
         assert(this->HasBuffer(handle));
 
@@ -641,6 +692,7 @@ namespace RHI {
         assert(this->HasTexture(texture));
 
         descriptor_sets[set.id]->SetTexture(binding, texture);
+        texture_bindings.insert(std::pair(texture.id, std::pair(set.id, binding)));
     }
 
     // == Device methods ========================================================
@@ -655,6 +707,20 @@ namespace RHI {
             it->second = swapchains[handle.id]->GetRenderTarget();
     };
 
+    bool VulkanDevice::IsFormatSupported(Format format) const {
+        if (GetFormatInfo(format).block_width > 1 && !texture_compression_bc)
+            return false;
+
+        VkFormatProperties format_props;
+        vkGetPhysicalDeviceFormatProperties(raw_device->physical, ConvertFormat(format), &format_props);
+        return (format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+    }
+
+    void VulkanDevice::WaitIdle() {
+        VkResult res = vkDeviceWaitIdle(raw_device->device);
+        assert(res == VK_SUCCESS);
+    }
+
     void VulkanDevice::QueueSubmit(QueueType queue, const CommandList &list) {
         auto cmd_buffer = GetCommandBuffer(list);
 
@@ -694,13 +760,36 @@ namespace RHI {
         }
 
         if (list.transfer) {
-            vkQueueSubmit(selected_queue, 1, &submit_info, VK_NULL_HANDLE);
-            vkQueueWaitIdle(selected_queue);
+            assert(transfer_serials[list.id] == list._transfer_serial);
+            vkQueueSubmit(selected_queue, 1, &submit_info, transfer_fences[list.id]);
+            transfer_submitted[list.id] = true;
         } else {
             vkQueueSubmit(selected_queue, 1, &submit_info, context->frame_resources[context->current_frame].fence);
         }
     };
 
+    bool VulkanDevice::IsComplete(const CommandList &list) {
+        assert(list.transfer);
+
+        // The slot was recorded again, which waited for this list first
+        if (transfer_serials[list.id] != list._transfer_serial)
+            return true;
+
+        return transfer_submitted[list.id] &&
+               vkGetFenceStatus(raw_device->device, transfer_fences[list.id]) == VK_SUCCESS;
+    }
+
+    void VulkanDevice::Wait(const CommandList &list) {
+        assert(list.transfer);
+
+        if (transfer_serials[list.id] != list._transfer_serial)
+            return;
+
+        assert(transfer_submitted[list.id]);
+        VkResult res = vkWaitForFences(raw_device->device, 1, &transfer_fences[list.id], VK_TRUE, UINT64_MAX);
+        assert(res == VK_SUCCESS);
+    }
+
     CommandList VulkanDevice::BeginCommandListEXP() {
         assert(current_backbuffer_id != INVALID_HANDLE_ID);
 
@@ -710,7 +799,7 @@ namespace RHI {
         auto &context = swap_contexts[current_backbuffer_id];
 
         // if there is no free commnd buffer then create one
-        if (!context->free_commandlists.pop_front(cmd)) {
+        if (!context->free_commandlists.Pop(cmd)) {
             cmd.id = context->commandlist_count.fetch_add(1);
             assert(cmd.id < COMMANDLIST_COUNT);
 
@@ -748,27 +837,41 @@ namespace RHI {
         res = vkBeginCommandBuffer(GetFrameResources().cmd_buffers[cmd.id], &begin_info);
         assert(res == VK_SUCCESS);
 
-        context->active_commandlists.push_back(cmd);
+        context->active_commandlists.Push(cmd);
         return cmd;
     };
 
     CommandList VulkanDevice::BeginTransferList() {
 
+        const uint32_t slot = transfer_serial % TRANSFER_LIST_COUNT;
+
         CommandList list;
         list.transfer = true;
-        list.id = 0;
+        list.id = slot;
+        list._transfer_serial = ++transfer_serial;
+
+        if (transfer_buffers[slot] == VK_NULL_HANDLE) {
+            transfer_buffers[slot] = transfer_list_allocator->Allocate();
 
-        // transfer_lists
-        if (transfer_buffers[0] == VK_NULL_HANDLE) {
-            transfer_buffers[0] = transfer_list_allocator->Allocate();
+            VkFenceCreateInfo fence_info = {};
+            fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            vkCreateFence(raw_device->device, &fence_info, nullptr, &transfer_fences[slot]);
         }
 
+        // Only blocks with every slot still in flight
+        if (transfer_submitted[slot]) {
+            vkWaitForFences(raw_device->device, 1, &transfer_fences[slot], VK_TRUE, UINT64_MAX);
+            vkResetFences(raw_device->device, 1, &transfer_fences[slot]);
+            transfer_submitted[slot] = false;
+        }
+        transfer_serials[slot] = list._transfer_serial;
+
         VkCommandBufferBeginInfo begin_info = {};
         begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
         begin_info.pInheritanceInfo = nullptr;
 
-        vkBeginCommandBuffer(transfer_buffers[0], &begin_info);
+        vkBeginCommandBuffer(transfer_buffers[slot], &begin_info);
 
         return list;
     };
@@ -882,7 +985,8 @@ namespace RHI {
     void VulkanDevice::BindScissorRects(const CommandList &cmd, uint32_t rects_count, const Rect *rects) {
         auto cmd_buffer = GetCommandBuffer(cmd);
 
-        std::vector<VkRect2D> scissor_rects(rects_count);
+        Core::ScratchScope scratch;
+        VkRect2D *scissor_rects = scratch.Allocate<VkRect2D>(rects_count);
         for (uint32_t i = 0; i < rects_count; i++) {
             scissor_rects[i].offset.x = rects[i].x;
             scissor_rects[i].offset.y = rects[i].y;
@@ -890,13 +994,14 @@ namespace RHI {
             scissor_rects[i].extent.width = rects[i].width;
         }
 
-        vkCmdSetScissor(cmd_buffer, 0, rects_count, scissor_rects.data());
+        vkCmdSetScissor(cmd_buffer, 0, rects_count, scissor_rects);
     };
 
     void VulkanDevice::BindViewports(const CommandList &cmd, uint32_t viewports_count, const Viewport *viewports) {
         auto cmd_buffer = GetCommandBuffer(cmd);
 
-        std::vector<VkViewport> vk_viewports(viewports_count);
+        Core::ScratchScope scratch;
+        VkViewport *vk_viewports = scratch.Allocate<VkViewport>(viewports_count);
         for (uint32_t i = 0; i < viewports_count; i++) {
             vk_viewports[i].x = static_cast<float>(viewports[i].x);
             vk_viewports[i].y = static_cast<float>(viewports[i].y);
@@ -906,7 +1011,7 @@ namespace RHI {
             vk_viewports[i].maxDepth = viewports[i].max_depth;
         }
 
-        vkCmdSetViewport(cmd_buffer, 0, viewports_count, vk_viewports.data());
+        vkCmdSetViewport(cmd_buffer, 0, viewports_count, vk_viewports);
     };
 
     void VulkanDevice::BindVertexBuffer(const CommandList &cmd, const BufferHandle &vertex_buffer, uint32_t slot) {
@@ -956,6 +1061,29 @@ namespace RHI {
         vkCmdBindPipeline(cmd_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, gfx_pipelines[pso.id]->get_pipeline());
     };
 
+    void VulkanDevice::BindDescriptorSet(
+        const CommandList &cmd, const ComputePipelineHandle &pso, const DescriptorSetHandle &set, u32 index) {
+        assert(current_backbuffer_id != INVALID_HANDLE_ID);
+        assert(this->HasPipeline(pso));
+        assert(this->HasDescriptorSet(set));
+
+        auto cmd_buffer = GetCommandBuffer(cmd);
+
+        auto allocated =
+            descriptor_sets[set.id]->GetDescriptorSet(this->swap_contexts[current_backbuffer_id]->current_frame, textures);
+
+        vkCmdBindDescriptorSets(
+            cmd_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipelines[pso.id]->get_layout(), index, 1, &allocated,
+            0, nullptr);
+    };
+
+    void VulkanDevice::BindPipelineState(const CommandList &cmd, const ComputePipelineHandle &pso) {
+        assert(this->HasPipeline(pso));
+
+        auto cmd_buffer = GetCommandBuffer(cmd);
+        vkCmdBindPipeline(cmd_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipelines[pso.id]->get_pipeline());
+    };
+
     // == Draw, Dispatch ==============================================================
     void VulkanDevice::DrawIndexed(
         const CommandList &cmd, uint32_t index_count, uint32_t start_index, uint32_t vertex_offset) {
@@ -964,6 +1092,29 @@ namespace RHI {
         vkCmdDrawIndexed(cmd_buffer, index_count, 1, start_index, vertex_offset, 0);
     };
 
+    void VulkanDevice::DrawIndexedIndirect(
+        const CommandList &cmd, const BufferHandle &args, u64 offset, u32 draw_count, u32 stride) {
+        assert(this->HasBuffer(args));
+        assert(args.usage & BufferHandle::Usage::INDIRECT_BUFFER);
+
+        auto cmd_buffer = GetCommandBuffer(cmd);
+        VkBuffer buffer = buffers[args.id]->GetBuffer();
+
+        if (multi_draw_indirect) {
+            vkCmdDrawIndexedIndirect(cmd_buffer, buffer, offset, draw_count, stride);
+        } else {
+            for (u32 i = 0; i < draw_count; i++) {
+                vkCmdDrawIndexedIndirect(cmd_buffer, buffer, offset + u64(i) * stride, 1, stride);
+            }
+        }
+    };
+
+    void VulkanDevice::Dispatch(const CommandList &cmd, u32 thread_group_x, u32 thread_group_y, u32 thread_group_z) {
+        auto cmd_buffer = GetCommandBuffer(cmd);
+
+        vkCmdDispatch(cmd_buffer, thread_group_x, thread_group_y, thread_group_z);
+    };
+
     // == Resource Copies ===========================================================
 
     void VulkanDevice::Copy(const CommandList &cmd, const BufferHandle &src, const BufferHandle &dst) {
@@ -983,45 +1134,135 @@ namespace RHI {
         vkCmdCopyBuffer(cmd_buffer, src_buffer, dst_buffer, 1, &copy_region);
     };
 
-    void
-    VulkanDevice::Copy(const CommandList &cmd, const BufferHandle &src, const TextureHandle &dst, u64 layer_offset) {
+    void VulkanDevice::Copy(
+        const CommandList &cmd,
+        const BufferHandle &src,
+        const TextureHandle &dst,
+        u64 layer_offset,
+        u32 base_mip,
+        u32 mip_count,
+        u64 buffer_offset) {
         assert(this->HasBuffer(src));
         assert(this->HasTexture(dst));
+        assert(base_mip + mip_count <= dst.mip_levels);
 
         auto cmd_buffer = GetCommandBuffer(cmd);
 
         auto src_buffer = buffers[src.id]->GetBuffer();
         auto dst_texture = textures[dst.id]->GetImage();
 
-        this->Transition(cmd_buffer, dst_texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        VkImageSubresourceRange range = {};
+        range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        range.baseMipLevel = base_mip;
+        range.levelCount = mip_count;
+        range.baseArrayLayer = 0;
+        range.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+        this->Transition(
+            cmd_buffer, dst_texture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range);
 
         std::vector<VkBufferImageCopy> copies;
-        copies.reserve(dst.layers);
+        copies.reserve(dst.layers * mip_count);
 
         for (auto i = 0; i < dst.layers; i++) {
-            VkBufferImageCopy copy_region = {};
-            copy_region.bufferOffset = i * layer_offset;
-            copy_region.bufferImageHeight = 0;
-            copy_region.bufferRowLength = 0;
+            u64 offset = buffer_offset + i * layer_offset;
 
-            copy_region.imageExtent = {dst.width, dst.height, 1};
-            copy_region.imageOffset = {0, 0, 0};
+            for (u32 mip = base_mip; mip < base_mip + mip_count; mip++) {
+                VkBufferImageCopy copy_region = {};
+                copy_region.bufferOffset = offset;
+                copy_region.bufferImageHeight = 0;
+                copy_region.bufferRowLength = 0;
 
-            copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; // Colour attachment
-            copy_region.imageSubresource.baseArrayLayer = i;                     // 0
-            copy_region.imageSubresource.layerCount = 1;
-            copy_region.imageSubresource.mipLevel = 0;
+                copy_region.imageExtent = {GetMipDimension(dst.width, mip), GetMipDimension(dst.height, mip), 1};
+                copy_region.imageOffset = {0, 0, 0};
 
-            copies.push_back(copy_region);
+                copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; // Colour attachment
+                copy_region.imageSubresource.baseArrayLayer = i;                     // 0
+                copy_region.imageSubresource.layerCount = 1;
+                copy_region.imageSubresource.mipLevel = mip;
+
+                copies.push_back(copy_region);
+                offset += GetMipSize(dst.format, dst.width, dst.height, mip);
+            }
         }
 
         vkCmdCopyBufferToImage(
             cmd_buffer, src_buffer, dst_texture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copies.size(), copies.data());
 
         this->Transition(
-            cmd_buffer, dst_texture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            cmd_buffer,
+            dst_texture,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            range);
     };
 
+    void VulkanDevice::GenerateMips(const CommandList &cmd, const TextureHandle &handle) {
+        assert(this->HasTexture(handle));
+
+        if (handle.mip_levels <= 1)
+            return;
+
+        VkFormatProperties format_props;
+        vkGetPhysicalDeviceFormatProperties(raw_device->physical, ConvertFormat(handle.format), &format_props);
+
+        if (!(format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) {
+            throw std::runtime_error("texture format does not support linear blitting!");
+        }
+
+        auto cmd_buffer = GetCommandBuffer(cmd);
+        auto image = textures[handle.id]->GetImage();
+
+        VkImageSubresourceRange range = {};
+        range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        range.baseArrayLayer = 0;
+        range.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        range.levelCount = 1;
+
+        // Mip 0 is expected to be uploaded already
+        range.baseMipLevel = 0;
+        this->Transition(
+            cmd_buffer, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, range);
+
+        for (u32 mip = 1; mip < handle.mip_levels; mip++) {
+            range.baseMipLevel = mip;
+            this->Transition(
+                cmd_buffer, image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, range);
+
+            VkImageBlit blit = {};
+            blit.srcOffsets[0] = {0, 0, 0};
+            blit.srcOffsets[1] = {
+                i32(GetMipDimension(handle.width, mip - 1)), i32(GetMipDimension(handle.height, mip - 1)), 1};
+            blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.srcSubresource.mipLevel = mip - 1;
+            blit.srcSubresource.baseArrayLayer = 0;
+            blit.srcSubresource.layerCount = handle.type == TextureHandle::Type::TEXTURE_CUBE ? 6 : handle.layers;
+            blit.dstOffsets[0] = {0, 0, 0};
+            blit.dstOffsets[1] = {i32(GetMipDimension(handle.width, mip)), i32(GetMipDimension(handle.height, mip)), 1};
+            blit.dstSubresource = blit.srcSubresource;
+            blit.dstSubresource.mipLevel = mip;
+
+            vkCmdBlitImage(
+                cmd_buffer,
+                image,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1,
+                &blit,
+                VK_FILTER_LINEAR);
+
+            // Written mip becomes the source of the next one
+            this->Transition(
+                cmd_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, range);
+        }
+
+        range.baseMipLevel = 0;
+        range.levelCount = handle.mip_levels;
+        this->Transition(
+            cmd_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range);
+    }
+
     void VulkanDevice::Barrier(const CommandList &cmd, const TextureHandle &handle, ImageLayout new_layout_in) {
         assert(this->HasTexture(handle));
 
@@ -1100,8 +1341,41 @@ namespace RHI {
         vkCmdPipelineBarrier(cmd_buffer, source_stage, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
     }
 
+    void VulkanDevice::Barrier(const CommandList &cmd, const BufferHandle &handle) {
+        assert(this->HasBuffer(handle));
+
+        auto cmd_buffer = GetCommandBuffer(cmd);
+
+        VkBufferMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask =
+            VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffers[handle.id]->GetBuffer();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(
+            cmd_buffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+            0,
+            0,
+            nullptr,
+            1,
+            &barrier,
+            0,
+            nullptr);
+    }
+
     void VulkanDevice::Transition(
-        VkCommandBuffer cmd_buffer, VkImage image, VkImageLayout old_layout, VkImageLayout new_layout) {
+        VkCommandBuffer cmd_buffer,
+        VkImage image,
+        VkImageLayout old_layout,
+        VkImageLayout new_layout,
+        const VkImageSubresourceRange &range) {
 
         VkImageMemoryBarrier barrier = {};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -1110,11 +1384,7 @@ namespace RHI {
         barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.image = image;
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
-        barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
+        barrier.subresourceRange = range;
 
         VkPipelineStageFlags source_stage;
         VkPipelineStageFlags destination_stage;
@@ -1131,6 +1401,29 @@ namespace RHI {
             barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
             barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
+            source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        } else if (
+            old_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL &&
+            new_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+            source_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        } else if (
+            old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && new_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+            source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        } else if (
+            old_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL &&
+            new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
             source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
             destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
         } else {
@@ -1150,6 +1443,10 @@ namespace RHI {
                 vkDestroyFence(raw_device->device, swap.second->frame_resources[i].fence, nullptr);
             }
         }
+        for (auto fence : transfer_fences) {
+            if (fence != VK_NULL_HANDLE)
+                vkDestroyFence(raw_device->device, fence, nullptr);
+        }
     }
 
 } // namespace RHI
@@ -97,32 +97,59 @@ namespace RHI {
             u32 index) override;
         void BindPipelineState(const CommandList &cmd, const GraphicsPipelineHandle &pso) override;
 
+        void BindDescriptorSet(
+            const CommandList &cmd,
+            const ComputePipelineHandle &pso,
+            const DescriptorSetHandle &set,
+            u32 index) override;
+        void BindPipelineState(const CommandList &cmd, const ComputePipelineHandle &pso) override;
+
         // == Draw, Dispatch ==============================================================
         void DrawIndexed(
             const CommandList &cmd, uint32_t index_count, uint32_t start_index, uint32_t vertex_offset) override;
+        void DrawIndexedIndirect(
+            const CommandList &cmd, const BufferHandle &args, u64 offset, u32 draw_count, u32 stride) override;
+        void Dispatch(const CommandList &cmd, u32 thread_group_x, u32 thread_group_y, u32 thread_group_z) override;
 
         // == Resource Copies ===========================================================
 
         void Copy(const CommandList &cmd, const BufferHandle &dst, const BufferHandle &src) override;
-        void Copy(const CommandList &cmd, const BufferHandle &dst, const TextureHandle &src, u64 layer_offset) override;
+        void Copy(
+            const CommandList &cmd,
+            const BufferHandle &dst,
+            const TextureHandle &src,
+            u64 layer_offset,
+            u32 base_mip,
+            u32 mip_count,
+            u64 buffer_offset) override;
+        void GenerateMips(const CommandList &cmd, const TextureHandle &handle) override;
 
         void BindBuffer(const DescriptorSetHandle &set, uint32_t binding, const BufferHandle &buffer) override;
         void BindTexture(const DescriptorSetHandle &set, uint32_t bindng, const TextureHandle &handle) override;
 
         void Barrier(const CommandList &cmd, const TextureHandle &handle, ImageLayout new_layout) override;
+        void Barrier(const CommandList &cmd, const BufferHandle &handle) override;
 
         void *MapBuffer(const BufferHandle &handle) override;
         void UnmapBuffer(const BufferHandle &handle) override;
 
         void QueueSubmit(QueueType queue, const CommandList &list) override;
+        bool IsComplete(const CommandList &list) override;
+        void Wait(const CommandList &list) override;
 
         void RebuildSwapchain(const SwapchainHandle &handle) override;
         void ResizeTexture(const TextureHandle &handle, u32 width, u32 height) override;
+        void SetTextureBaseMip(const TextureHandle &handle, u32 base_mip) override;
+
+        bool IsFormatSupported(Format format) const override;
+
+        void WaitIdle() override;
 
         ~VulkanDevice();
 
     private:
         constexpr static uint32_t COMMANDLIST_MAX_COUNT = 16;
+        constexpr static uint32_t TRANSFER_LIST_COUNT = 4;
 
         inline VkCommandBuffer GetCommandBuffer(const CommandList &list) {
             if (list.transfer) {
@@ -141,7 +168,12 @@ namespace RHI {
             return context->frame_resources[context->current_frame];
         }
 
-        void Transition(VkCommandBuffer cmd_buffer, VkImage image, VkImageLayout old_layout, VkImageLayout new_layout);
+        void Transition(
+            VkCommandBuffer cmd_buffer,
+            VkImage image,
+            VkImageLayout old_layout,
+            VkImageLayout new_layout,
+            const VkImageSubresourceRange &range);
 
         // Selected queue families
         uint32_t gfx_queue;
@@ -160,7 +192,8 @@ namespace RHI {
 
         // Utility mappings
         std::unordered_map<u64, VkRenderPass> render_passes;
-        std::unordered_map<u32, std::pair<u64, u32>> texture_bindings;
+        // texture id -> (descriptor set id, binding)
+        std::unordered_multimap<u32, std::pair<u64, u32>> texture_bindings;
 
         // Swapchain and backbuffer render taraget mapping is 1 <-> 1
         // backbuffer_id -> Swapchain Context
@@ -169,7 +202,12 @@ namespace RHI {
 
         std::unique_ptr<VulkanFboCache> fbo_cache;
         std::unique_ptr<VulkanCommandAllocator> transfer_list_allocator;
-        VkCommandBuffer transfer_buffers[4] = {VK_NULL_HANDLE};
+        VkCommandBuffer transfer_buffers[TRANSFER_LIST_COUNT] = {VK_NULL_HANDLE};
+        // Transfer lists are recorded round robin, a slot waits for its fence before it is recorded again
+        VkFence transfer_fences[TRANSFER_LIST_COUNT] = {VK_NULL_HANDLE};
+        uint32_t transfer_serials[TRANSFER_LIST_COUNT] = {0};
+        bool transfer_submitted[TRANSFER_LIST_COUNT] = {false};
+        uint32_t transfer_serial = 0;
 
         // Offscreen command buffers
         // One for each command list
@@ -181,6 +219,11 @@ namespace RHI {
         std::shared_ptr<RawInstance> raw_instance;
         std::shared_ptr<RawDevice> raw_device;
 
+        // Without multiDrawIndirect every indirect draw is issued on its own
+        bool multi_draw_indirect = false;
+        // Without textureCompressionBC no BC format can be loaded
+        bool texture_compression_bc = false;
+
         uint64_t id;
     };
 
@@ -1,11 +1,14 @@
 #define VMA_IMPLEMENTATION
 #include "Module.h"
 #include <Core/Log.h>
+#include <Core/Memory/MemoryTracker.h>
 
 namespace Squid {
 namespace RHI {
 
     std::unique_ptr<Device> VulkanAdapter::CreateDevice() {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         uint32_t families_count = 0;
         vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &families_count, nullptr);
 
@@ -93,6 +96,8 @@ namespace RHI {
     }
 
     bool VulkanModule::Initialize() {
+        Core::MemoryTagScope memory_tag(Core::MEMORY_TAG_RHI);
+
         // Create instence here
         VkInstance instance = VK_NULL_HANDLE;
 
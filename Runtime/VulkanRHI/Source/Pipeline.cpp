@@ -16,14 +16,45 @@ namespace RHI {
         }
     }
 
+    VkFormat convert_vertex_type(VertexType type) {
+        switch (type) {
+        case VertexType::FLOAT:
+            return VK_FORMAT_R32_SFLOAT;
+        case VertexType::FLOAT2:
+            return VK_FORMAT_R32G32_SFLOAT;
+        case VertexType::FLOAT3:
+            return VK_FORMAT_R32G32B32_SFLOAT;
+        case VertexType::FLOAT4:
+            return VK_FORMAT_R32G32B32A32_SFLOAT;
+        case VertexType::HALF2:
+            return VK_FORMAT_R16G16_SFLOAT;
+        case VertexType::HALF4:
+            return VK_FORMAT_R16G16B16A16_SFLOAT;
+        case VertexType::SNORM8_4:
+            return VK_FORMAT_R8G8B8A8_SNORM;
+        case VertexType::UNORM8_4:
+            return VK_FORMAT_R8G8B8A8_UNORM;
+        case VertexType::SNORM16_2:
+            return VK_FORMAT_R16G16_SNORM;
+        case VertexType::SNORM16_4:
+            return VK_FORMAT_R16G16B16A16_SNORM;
+        case VertexType::UNORM10_10_10_2:
+            return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+        default:
+            return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    // VK_NULL_HANDLE when the code isn't valid SPIR-V
     VkShaderModule create_shader_module(const std::string &code, VkDevice device) {
-        VkShaderModule shader_module;
+        VkShaderModule shader_module = VK_NULL_HANDLE;
 
         VkShaderModuleCreateInfo create_info = {};
         create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
         create_info.codeSize = code.size();
         create_info.pCode = reinterpret_cast<const uint32_t *>(code.data());
-        vkCreateShaderModule(device, &create_info, nullptr, &shader_module);
+        if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module) != VK_SUCCESS)
+            return VK_NULL_HANDLE;
 
         return shader_module;
     };
@@ -46,12 +77,16 @@ namespace RHI {
 
         // Pipeline
         auto compute_module = create_shader_module(handle.compute_shader, raw_device->device);
+        if (compute_module == VK_NULL_HANDLE) {
+            vkDestroyPipelineLayout(raw_device->device, pipeline_layout, nullptr);
+            throw std::runtime_error("failed to create compute shader module!");
+        }
 
         VkPipelineShaderStageCreateInfo shader_info = {};
         shader_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shader_info.module = compute_module;
         shader_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-        shader_info.pName = "main";
+        shader_info.pName = handle.compute_entry.c_str();
 
         VkComputePipelineCreateInfo pipeline_info = {};
         pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -59,8 +94,15 @@ namespace RHI {
         pipeline_info.layout = pipeline_layout;
         pipeline_info.stage = shader_info;
 
-        vkCreateComputePipelines(raw_device->device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline);
+        const VkResult result =
+            vkCreateComputePipelines(raw_device->device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline);
         vkDestroyShaderModule(raw_device->device, compute_module, nullptr);
+
+        // Nothing is left behind, the caller can keep using the pipeline it meant to replace
+        if (result != VK_SUCCESS) {
+            vkDestroyPipelineLayout(raw_device->device, pipeline_layout, nullptr);
+            throw std::runtime_error("failed to create compute pipeline!");
+        }
     }
 
     VulkanComputePipeline::~VulkanComputePipeline() {
@@ -79,42 +121,19 @@ namespace RHI {
         : VulkanPipeline(raw_device) {
         uint32_t layout_size = 0;
 
-        static_assert(sizeof(float) == 4);
-        static_assert(sizeof(float) * 2 == 8);
-        static_assert(sizeof(float) * 3 == 12);
-        static_assert(sizeof(float) * 4 == 16);
-
         auto count = handle.vertex_layout.input_count;
 
         std::vector<VkVertexInputAttributeDescription> vertex_attributes(handle.vertex_layout.input_count);
 
         for (auto i = 0; i < count; i++) {
+            const VertexInput &input = handle.vertex_layout.inputs[i];
 
             vertex_attributes[i].binding = 0;
             vertex_attributes[i].location = i;
+            vertex_attributes[i].format = convert_vertex_type(input.type);
+            vertex_attributes[i].offset = input.offset;
 
-            switch (handle.vertex_layout.inputs[i].type) {
-            case VertexType::FLOAT:
-                layout_size += 4;
-                vertex_attributes[i].format = VK_FORMAT_R32_SFLOAT;
-                vertex_attributes[i].offset = handle.vertex_layout.inputs[i].offset;
-                break;
-            case VertexType::FLOAT2:
-                layout_size += 8;
-                vertex_attributes[i].format = VK_FORMAT_R32G32_SFLOAT;
-                vertex_attributes[i].offset = handle.vertex_layout.inputs[i].offset;
-                break;
-            case VertexType::FLOAT3:
-                layout_size += 12;
-                vertex_attributes[i].format = VK_FORMAT_R32G32B32_SFLOAT;
-                vertex_attributes[i].offset = handle.vertex_layout.inputs[i].offset;
-                break;
-            case VertexType::FLOAT4:
-                layout_size += 16;
-                vertex_attributes[i].format = VK_FORMAT_R8G8B8A8_UNORM;
-                vertex_attributes[i].offset = handle.vertex_layout.inputs[i].offset;
-                break;
-            }
+            layout_size += GetVertexTypeSize(input.type);
         }
 
         VkVertexInputBindingDescription binding_description = {};
@@ -283,7 +302,14 @@ namespace RHI {
         pipeline_info.renderPass = render_pass;
         pipeline_info.subpass = 0;
 
-        vkCreateGraphicsPipelines(raw_device->device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline);
+        const bool modules_created = (handle.vertex_shader.empty() || vertex_module != VK_NULL_HANDLE) &&
+                                     (handle.pixel_shader.empty() || pixel_module != VK_NULL_HANDLE);
+
+        VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+        if (modules_created) {
+            result =
+                vkCreateGraphicsPipelines(raw_device->device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline);
+        }
 
         if (pixel_module != VK_NULL_HANDLE) {
             vkDestroyShaderModule(raw_device->device, pixel_module, nullptr);
@@ -292,6 +318,12 @@ namespace RHI {
         if (vertex_module != VK_NULL_HANDLE) {
             vkDestroyShaderModule(raw_device->device, vertex_module, nullptr);
         }
+
+        // Nothing is left behind, the caller can keep using the pipeline it meant to replace
+        if (result != VK_SUCCESS) {
+            vkDestroyPipelineLayout(raw_device->device, pipeline_layout, nullptr);
+            throw std::runtime_error("failed to create graphics pipeline!");
+        }
     }
 
     VulkanGraphicsPipeline::~VulkanGraphicsPipeline() {
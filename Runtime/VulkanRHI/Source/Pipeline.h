@@ -35,8 +35,8 @@ namespace Squid { namespace RHI {
         ~VulkanGraphicsPipeline();
 
     private:
-        VkShaderModule vertex_module;
-        VkShaderModule pixel_module;
+        VkShaderModule vertex_module = VK_NULL_HANDLE;
+        VkShaderModule pixel_module = VK_NULL_HANDLE;
     };
 
 }} // namespace Squid::RHI
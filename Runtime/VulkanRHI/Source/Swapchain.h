@@ -4,14 +4,15 @@
 #include "CommandAllocator.h"
 #include <pch.h>
 
-#include <Core/RingBuffer.h>
+#include <Core/Jobs/LockFreeQueue.h>
+#include <Core/Memory/FrameAllocator.h>
 
 namespace Squid {
 namespace RHI {
 
     // TODO: move this constants to a global place
-    // BACKBUFFER_COUNT must be larger than 1
-    static constexpr uint32_t BACKBUFFER_COUNT = 3;
+    // BACKBUFFER_COUNT must be larger than 1, frame allocations live as long as a backbuffer is in flight
+    static constexpr uint32_t BACKBUFFER_COUNT = Core::MAX_FRAMES_IN_FLIGHT;
     static constexpr uint32_t COMMANDLIST_COUNT = 16;
 
     struct FrameResources {
@@ -34,8 +35,8 @@ namespace RHI {
 
         // Thread safe cmd list managers
         std::atomic<uint8_t> commandlist_count;
-        Core::RingBuffer<CommandList, COMMANDLIST_COUNT> free_commandlists;
-        Core::RingBuffer<CommandList, COMMANDLIST_COUNT> active_commandlists;
+        Core::MpmcQueue<CommandList, COMMANDLIST_COUNT> free_commandlists;
+        Core::MpmcQueue<CommandList, COMMANDLIST_COUNT> active_commandlists;
 
         // Per swapchain image resources
         FrameResources frame_resources[BACKBUFFER_COUNT];
@@ -108,7 +108,7 @@ namespace RHI {
         sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
         sampler_info.mipLodBias = 0.0f;
         sampler_info.minLod = 0.0f;
-        sampler_info.maxLod = 0.0f;
+        sampler_info.maxLod = static_cast<float>(handle.mip_levels);
 
         vkCreateSampler(raw_device->device, &sampler_info, nullptr, &sampler);
 
@@ -118,13 +118,30 @@ namespace RHI {
         if (handle.usage_flags & TextureHandle::DEPTH_STENCIL_VIEW)
             CreateSubresource(handle, ResourceView::DSV, 0, -1, 0, -1);
 
-        if (handle.usage_flags & TextureHandle::SHADER_RESOURCE_VIEW)
+        if (handle.usage_flags & TextureHandle::SHADER_RESOURCE_VIEW) {
             CreateSubresource(handle, ResourceView::SRV, 0, -1, 0, -1);
+            base_mip_srvs.assign(std::max(uint32_t(handle.mip_levels), 1u), VK_NULL_HANDLE);
+            base_mip_srvs[0] = srv;
+        }
 
         if (handle.usage_flags & TextureHandle::UNORDERED_ACCESS_VIEW)
             CreateSubresource(handle, ResourceView::UAV, 0, -1, 0, -1);
     }
 
+    void VulkanTexture::SetBaseMip(const TextureHandle &handle, uint32_t base_mip) {
+        assert(base_mip < handle.mip_levels);
+
+        assert(base_mip < base_mip_srvs.size());
+
+        if (base_mip_srvs[base_mip] == VK_NULL_HANDLE) {
+            srv = VK_NULL_HANDLE;
+            CreateSubresource(handle, ResourceView::SRV, 0, -1, base_mip, -1);
+            base_mip_srvs[base_mip] = srv;
+        }
+
+        srv = base_mip_srvs[base_mip];
+    }
+
     int VulkanTexture::CreateSubresource(
         const TextureHandle &handle,
         ResourceView type,
@@ -287,7 +304,12 @@ namespace RHI {
         LOG("destroying image and resource views")
         vkDestroySampler(raw_device->device, sampler, nullptr);
 
-        if (srv)
+        // The srv is one of the base mip views
+        for (auto x : base_mip_srvs) {
+            if (x)
+                vkDestroyImageView(raw_device->device, x, nullptr);
+        }
+        if (srv && base_mip_srvs.empty())
             vkDestroyImageView(raw_device->device, srv, nullptr);
         if (uav)
             vkDestroyImageView(raw_device->device, uav, nullptr);
@@ -15,6 +15,10 @@ namespace RHI {
         inline VkImageView GetView() const { return srv; };
         inline VkSampler GetSampler() const { return sampler; };
 
+        // Points the srv at the view starting at base_mip. Views are created once per base mip and live as long as
+        // the texture, so frames in flight keep a valid view and streaming back and forth creates nothing new.
+        void SetBaseMip(const TextureHandle &handle, uint32_t base_mip);
+
     private:
         int CreateSubresource(
             const TextureHandle &handle,
@@ -39,6 +43,9 @@ namespace RHI {
 		std::vector<VkImageView> subresources_rtv;
 		std::vector<VkImageView> subresources_dsv;
 
+        // Srvs by base mip, null until first used, srv is one of them
+        std::vector<VkImageView> base_mip_srvs;
+
         VkSampler sampler;
 
         std::shared_ptr<RawDevice> raw_device;
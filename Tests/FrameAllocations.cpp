@@ -0,0 +1,147 @@
+// Runs the device independent half of the engine loop for a number of frames and fails when a frame after the warm-up
+// touches the heap. The engine loop itself only warns, this is the check that keeps frames allocation free.
+// Usage: Test-FrameAllocations [frames]
+#include <Core/ECS/Scene.h>
+#include <Core/Events/EventDispatcher.h>
+#include <Core/Jobs/FramePipeline.h>
+#include <Core/Jobs/JobSystem.h>
+#include <Core/Memory/AllocationCounter.h>
+#include <Core/Memory/FrameAllocator.h>
+#include <Core/Memory/MemoryTracker.h>
+#include <Core/Profiling.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace Squid;
+
+// Same warm-up the engine loop allows before it starts warning
+static constexpr u64 WARMUP_FRAMES = 120;
+static constexpr u64 DEFAULT_FRAMES = 1000;
+
+static constexpr u32 ENTITY_COUNT = 4096;
+// Every fourth entity is the child of the one before it
+static constexpr u32 CHILD_STRIDE = 4;
+static constexpr u32 MOVED_PER_FRAME = 256;
+
+// What the render half reads, like the renderer's snapshot the per frame list lives in frame memory
+struct Snapshot {
+    Core::FrameVector<glm::mat4> draws{Core::GetFrameAllocator()};
+};
+
+static void OnMouseMotion(void *user_data, const Core::MouseMotionEvent *events, u32 count) {
+    i32 &delta = *static_cast<i32 *>(user_data);
+    for (u32 i = 0; i < count; i++) {
+        delta += events[i].delta_x;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (!Core::IsCountingAllocations()) {
+        fprintf(stderr, "built without SQUID_COUNT_ALLOCATIONS, nothing is counted!\n");
+        return 1;
+    }
+
+    const u64 frames = argc > 1 ? strtoull(argv[1], nullptr, 10) : DEFAULT_FRAMES;
+
+    // The main loop creates the job system first so the main thread owns queue 0
+    Core::JobSystem &jobs = Core::GetJobSystem();
+    Core::EventDispatcher &events = Core::GetEventDispatcher();
+
+    Core::SceneGraph scene;
+    std::vector<Core::Entity> entities(ENTITY_COUNT);
+    std::vector<Core::Entity> children, parents;
+    for (u32 i = 0; i < ENTITY_COUNT; i++) {
+        entities[i] = Core::CreateEntity();
+        Core::TransformComponent *transform = scene.transforms.Create(entities[i]);
+        transform->translation_local = glm::vec3(f32(i % 64), f32(i / 64), 0.0f);
+
+        scene.bounds.Create(entities[i])->SetLocalBounds(glm::vec3(-0.5f), glm::vec3(0.5f));
+        if (i % CHILD_STRIDE != 0) {
+            children.push_back(entities[i]);
+            parents.push_back(entities[i - 1]);
+        }
+    }
+    scene.AttachBulk(children.data(), parents.data(), children.size());
+
+    i32 mouse_delta = 0;
+    events.Subscribe<Core::MouseMotionEvent>(&OnMouseMotion, &mouse_delta);
+
+    Snapshot snapshots[Core::FramePipeline::BUFFER_COUNT];
+    f32 rendered = 0.0f;
+    Core::FramePipeline pipeline([&](u32 index) {
+        PROFILING_NAMED_SCOPE("Render")
+        Core::GetFrameAllocator().BeginFrame();
+
+        const Snapshot &snapshot = snapshots[index];
+        Core::ParallelFor(u32(snapshot.draws.size()), 64, [&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; i++) {
+                rendered += snapshot.draws[i][3][0] * 0.0f;
+            }
+        });
+    });
+
+    glm::vec4 planes[6] = {{1.0f, 0.0f, 0.0f, 1.0f},  {-1.0f, 0.0f, 0.0f, 48.0f}, {0.0f, 1.0f, 0.0f, 1.0f},
+                           {0.0f, -1.0f, 0.0f, 48.0f}, {0.0f, 0.0f, 1.0f, 1.0f},  {0.0f, 0.0f, -1.0f, 1.0f}};
+
+    u64 failed_frames = 0;
+    for (u64 frame = 0; frame < WARMUP_FRAMES + frames; frame++) {
+        const u64 heap_allocations = Core::GetHeapAllocationCount();
+        {
+            PROFILING_SCOPE
+
+            // Input arrives from the platform and from worker threads
+            events.Publish(Core::MouseMotionEvent{0, 0, 1, 0, 0});
+            Core::JobCounter counter;
+            jobs.Run(counter, [&events]() { events.Publish(Core::MouseMotionEvent{0, 0, -1, 0, 0}); }, "Publish");
+            jobs.Wait(counter);
+            events.Dispatch(Core::EVENT_PHASE_FRAME_START);
+
+            // Moves a window of entities, their subtrees and bounds follow
+            const f32 time = f32(frame) * 0.01f;
+            for (u32 i = 0; i < MOVED_PER_FRAME; i++) {
+                Core::TransformComponent *transform =
+                    scene.transforms.GetComponent(entities[(frame * MOVED_PER_FRAME + i) % ENTITY_COUNT]);
+                transform->rotation_local.z = sinf(time);
+                transform->rotation_local.w = cosf(time);
+                transform->SetDirty();
+            }
+            scene.Update();
+
+            Core::FrameVector<Core::Entity> visible(Core::GetFrameAllocator());
+            scene.CullFrustum(planes, visible);
+
+            Snapshot &snapshot = snapshots[pipeline.GetWriteIndex()];
+            snapshot.draws = Core::FrameVector<glm::mat4>(Core::GetFrameAllocator());
+            snapshot.draws.reserve(visible.size());
+            for (const Core::Entity entity : visible) {
+                snapshot.draws.push_back(scene.transforms.GetComponent(entity)->world);
+            }
+
+            events.Dispatch(Core::EVENT_PHASE_FRAME_END);
+            pipeline.Submit();
+            Core::SampleMemoryStats();
+        }
+
+        const u64 allocations = Core::GetHeapAllocationCount() - heap_allocations;
+        if (frame >= WARMUP_FRAMES && allocations > 0) {
+            if (failed_frames++ < 10)
+                fprintf(stderr, "frame %llu made %llu heap allocations\n", (unsigned long long)frame,
+                        (unsigned long long)allocations);
+        }
+    }
+
+    pipeline.Flush();
+    events.Unsubscribe<Core::MouseMotionEvent>(&OnMouseMotion, &mouse_delta);
+
+    if (failed_frames > 0) {
+        fprintf(stderr, "%llu of %llu frames allocated\n", (unsigned long long)failed_frames,
+                (unsigned long long)frames);
+        return 1;
+    }
+
+    printf("%llu frames without heap allocations\n", (unsigned long long)frames);
+    return 0;
+}